@@ -0,0 +1,186 @@
+/*=====================================================================
+  message_parser.h - Näyttöaseman viestien jäsennys
+
+  Kenttätaulukko ja parseMessage(): jokainen UART-rivi päälaitteelta
+  ("KEY:VALUE,KEY2:VALUE2,..." tai CLEAR / ALERT: / CLEARALERT)
+  päivittää kentät, hälytyksen ja pakettihäviön SEQ-numeroista.
+
+  Ei näyttökoodia (LovyanGFX) - sama tiedosto käännetään myös
+  isäntäkoneella: Roboter_Gruppe_9/host/bench_hotpath.cpp mittaa
+  parseMessage()-kutsun keston ja muistinvaraukset.
+=======================================================================*/
+
+#ifndef MESSAGE_PARSER_H
+#define MESSAGE_PARSER_H
+
+#include <Arduino.h>
+
+// =============== DATA STORAGE ================================
+#define MAX_FIELDS 20
+struct DataField {
+  String key;
+  String value;
+  unsigned long lastUpdate;
+};
+
+DataField fields[MAX_FIELDS];
+int fieldCount = 0;
+
+String alertMessage = "";
+bool alertActive = false;
+
+// Pakettihäviön seuranta (packet loss tracking)
+int lastReceivedSeq = -1;       // Viimeisin vastaanotettu sekvenssinnumero
+int expectedSeq = 0;            // Odotettu seuraava sekvenssinnumero
+int totalPacketsExpected = 0;   // Odotetut paketit yhteensä
+int totalPacketsReceived = 0;   // Vastaanotetut paketit yhteensä
+int totalPacketsLost = 0;       // Menetetyt paketit yhteensä
+float packetLossPercent = 0.0;  // Pakettihäviöprosentti
+
+// Aikaleiman tallennus
+unsigned long lastPacketTime = 0;  // Milloin viimeisin paketti saapui
+String currentTimestamp = "00:00"; // Nykyinen aikaleima (esim. "12:34")
+
+// =============== FUNCTION PROTOTYPES ================================
+String getFieldValue(String key);
+void setFieldValue(String key, String value);
+void clearAllFields();
+
+// =============== MESSAGE PARSING ================================
+void parseMessage(String message) {
+  // Handle special commands
+  if (message == "CLEAR") {
+    clearAllFields();
+    Serial.println("🗑️  Cleared all fields");
+    return;
+  }
+
+  if (message.startsWith("ALERT:")) {
+    alertMessage = message.substring(6);
+    alertActive = true;
+    Serial.print("🚨 ALERT: ");
+    Serial.println(alertMessage);
+    return;
+  }
+
+  if (message == "CLEARALERT") {
+    alertActive = false;
+    alertMessage = "";
+    Serial.println("✅ Alert cleared");
+    return;
+  }
+
+  // Parse CSV format: KEY:VALUE,KEY2:VALUE2,...
+  int startPos = 0;
+  int receivedSeq = -1;
+
+  while (startPos < message.length()) {
+    // Find next comma
+    int commaPos = message.indexOf(',', startPos);
+    if (commaPos == -1) commaPos = message.length();
+
+    // Extract key:value pair
+    String pair = message.substring(startPos, commaPos);
+    int colonPos = pair.indexOf(':');
+
+    if (colonPos > 0) {
+      String key = pair.substring(0, colonPos);
+      String value = pair.substring(colonPos + 1);
+      key.trim();
+      value.trim();
+
+      setFieldValue(key, value);
+
+      // Tallenna sekvenssinnumero pakettihäviön laskentaa varten
+      if (key == "SEQ") {
+        receivedSeq = value.toInt();
+      }
+    }
+
+    startPos = commaPos + 1;
+  }
+
+  // Laske pakettihäviö sekvenssinnumeroiden perusteella
+  if (receivedSeq >= 0) {
+    if (lastReceivedSeq == -1) {
+      // Ensimmäinen paketti
+      lastReceivedSeq = receivedSeq;
+      expectedSeq = receivedSeq + 1;
+      totalPacketsReceived = 1;
+      totalPacketsExpected = 1;
+    } else {
+      // Laske kuinka monta pakettia odotettiin
+      int packetsExpectedSinceLastn = receivedSeq - lastReceivedSeq;
+
+      if (packetsExpectedSinceLastn > 0) {
+        totalPacketsExpected += packetsExpectedSinceLastn;
+        totalPacketsReceived += 1;  // Saimme yhden paketin
+
+        // Jos sekvenssinnumero hyppäsi, paketit puuttuvat
+        if (packetsExpectedSinceLastn > 1) {
+          int lostPackets = packetsExpectedSinceLastn - 1;
+          totalPacketsLost += lostPackets;
+          Serial.print("⚠️  Lost packets detected: ");
+          Serial.print(lostPackets);
+          Serial.print(" (SEQ ");
+          Serial.print(lastReceivedSeq + 1);
+          Serial.print(" to ");
+          Serial.print(receivedSeq - 1);
+          Serial.println(")");
+        }
+
+        lastReceivedSeq = receivedSeq;
+        expectedSeq = receivedSeq + 1;
+      }
+    }
+
+    // Laske pakettihäviöprosentti
+    if (totalPacketsExpected > 0) {
+      packetLossPercent = (float)totalPacketsLost / (float)totalPacketsExpected * 100.0;
+    }
+  }
+
+  // Päivitä aikaleima
+  lastPacketTime = millis();
+  unsigned long seconds = millis() / 1000;
+  int minutes = (seconds / 60) % 60;
+  int secs = seconds % 60;
+  currentTimestamp = String(minutes) + ":" + (secs < 10 ? "0" : "") + String(secs);
+}
+
+// =============== DATA FIELD MANAGEMENT ================================
+String getFieldValue(String key) {
+  for (int i = 0; i < fieldCount; i++) {
+    if (fields[i].key == key) {
+      return fields[i].value;
+    }
+  }
+  return "";
+}
+
+void setFieldValue(String key, String value) {
+  // Update existing field
+  for (int i = 0; i < fieldCount; i++) {
+    if (fields[i].key == key) {
+      fields[i].value = value;
+      fields[i].lastUpdate = millis();
+      return;
+    }
+  }
+
+  // Add new field if space available
+  if (fieldCount < MAX_FIELDS) {
+    fields[fieldCount].key = key;
+    fields[fieldCount].value = value;
+    fields[fieldCount].lastUpdate = millis();
+    fieldCount++;
+  }
+}
+
+void clearAllFields() {
+  fieldCount = 0;
+  alertActive = false;
+  alertMessage = "";
+}
+
+#endif // MESSAGE_PARSER_H
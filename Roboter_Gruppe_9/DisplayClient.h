@@ -55,8 +55,9 @@ public:
 
   /**
    * Initialize serial connection to display
+   * @param settleMs Wait before the test message (0 = send at once)
    */
-  void begin() {
+  void begin(unsigned long settleMs = 500) {
     // ✅ CRITICAL FIX: Set pinMode() BEFORE serial->begin()
     // Required when using &Serial2 with custom pins (GPIO 23)
     // Based on working Robot_Sender.ino implementation
@@ -85,7 +86,7 @@ public:
     Serial.println(baudrate);
 
     // Send test message
-    delay(500);
+    if (settleMs) delay(settleMs);
     serial->println("STATUS:Display connected");
   }
 
@@ -16,6 +16,7 @@
   Role Detection:
   - Receiver: GPIO16 connected to GPIO17 (jumper wire)
   - Sender:   GPIO16 floating (no connection)
+  - Relay:    GPIO16 connected to 3V3 (ENABLE_RELAY, relay.h)
   - Note: GPIO16 and GPIO17 are physically next to each other
 
   Kill-Switch:
@@ -34,7 +35,31 @@
 #include "structs.h"
 #include "functions.h"
 #include "lora_handler.h"
+#include "telemetry_frame.h"
+#include "telemetry_batch.h"
+#include "ack_slot.h"
+#include "reliable_link.h"
+#include "tx_queue.h"
+#include "mac_layer.h"
+#include "time_sync.h"
+#if ENABLE_ADAPTIVE_SF
+  #include "adaptive_sf.h"  // Closed-loop SF selection (two-phase switch)
+#endif
+#if ENABLE_TX_POWER_CONTROL
+  #include "tx_power.h"  // Closed-loop AT+CRFOP (sender)
+#endif
+#if ENABLE_SEND_ON_CHANGE
+  #include "uplink_policy.h"  // Event uplinks + heartbeat (sender)
+#endif
+#if ENABLE_RELAY
+  #include "relay.h"  // Store-and-forward repeater role
+#endif
 #include "health_monitor.h"
+#include "fast_boot.h"  // Boot timeline, radio check instead of reset
+#include "timer_wheel.h"  // Periodic jobs, sleep until the next one
+#if ENABLE_GATEWAY_MODE
+  #include "node_table.h"  // Per-sender state for the fleet receiver
+#endif
 #include "display_sender.h"  // TFT display station support
 
 // Feature modules - Refactored to use wrapper modules
@@ -50,6 +75,36 @@
   #include "detailed_telemetry.h"  // Unified packet stats + system telemetry
 #endif
 
+#if ENABLE_TASK_SPLIT
+  #include "task_split.h"  // Radio / sensor / UI FreeRTOS tasks
+#endif
+
+#if ENABLE_SLEEP_SENDER
+  #include "sleep_cycle.h"  // Duty-cycled battery sender, RTC-retained state
+#endif
+
+// Binary frame types map 1:1 onto FrameKind (frame_dispatch.h)
+static_assert(FRAME_TYPE_TELEMETRY - 0x80 == FRAME_KIND_TELEMETRY &&
+              FRAME_TYPE_ACK - 0x80 == FRAME_KIND_ACK &&
+              FRAME_TYPE_BATCH - 0x80 == FRAME_KIND_BATCH &&
+              FRAME_TYPE_RELIABLE - 0x80 == FRAME_KIND_RELIABLE &&
+              FRAME_TYPE_REL_ACK - 0x80 == FRAME_KIND_REL_ACK &&
+              FRAME_TYPE_BEACON - 0x80 == FRAME_KIND_BEACON &&
+              FRAME_TYPE_FEC_PARITY - 0x80 == FRAME_KIND_FEC_PARITY &&
+              FRAME_TYPE_ALERT - 0x80 == FRAME_KIND_ALERT &&
+              FRAME_TYPE_COMMAND - 0x80 == FRAME_KIND_COMMAND, "frame type order");
+#if ENABLE_ADAPTIVE_SF
+static_assert(FRAME_TYPE_ADR_CMD - 0x80 == FRAME_KIND_ADR_CMD &&
+              FRAME_TYPE_ADR_ACCEPT - 0x80 == FRAME_KIND_ADR_ACCEPT, "frame type order");
+#endif
+#if ENABLE_RELAY
+static_assert(FRAME_TYPE_RELAY - 0x80 == FRAME_KIND_RELAY &&
+              FRAME_TYPE_RELAY_ACK - 0x80 == FRAME_KIND_RELAY_ACK, "frame type order");
+#endif
+#if ENABLE_ENCRYPTION
+static_assert(FRAME_TYPE_SECURE - 0x80 == FRAME_KIND_SECURE, "frame type order");
+#endif
+
 // =============== KILL-SWITCH CONFIG ================================
 // GPIO 12 is a strapping pin on ESP32 - use GPIO 13 instead!
 #define KILLSWITCH_GND_PIN 14
@@ -59,6 +114,7 @@
 
 // =============== GLOBALS ================================
 bool bRECEIVER = 0;  // Auto-detected
+bool bRELAY = 0;     // Auto-detected (ENABLE_RELAY)
 uint8_t MY_LORA_ADDRESS = 0;
 uint8_t TARGET_LORA_ADDRESS = 0;
 
@@ -67,6 +123,23 @@ DeviceState remote;
 TimingData timing;
 SpinnerData spinner;
 HealthMonitor health;  // Connection watchdog & health monitoring
+LinkRecovery linkRecovery;  // Tiered module check after LOST (receiver)
+BootTimeline boot;          // Boot phase timestamps (fast_boot.h)
+TimerWheel timers;          // Periodic jobs (timer_wheel.h)
+IdleStats loopIdle;         // loop() wakeups and sleep share
+bool sleepWoke = false;     // Deep-sleep timer wake: state restored, no banners
+#if ENABLE_SLEEP_SENDER
+RTC_DATA_ATTR SleepRetained sleepRtc;  // Sender: survives deep sleep
+SleepCycle sleepCycle;      // Sender: this wake
+#endif
+
+#if ENABLE_TASK_SPLIT
+SpscQueue<SensorEvent, TASK_SENSOR_QUEUE_SIZE> sensorEvents;  // Sensor task → radio task
+SeqLock<UiSnapshot> uiState;        // Radio task → UI task
+TaskStats radioTaskStats;           // loop()
+TaskStats sensorTaskStats;
+TaskStats uiTaskStats;
+#endif
 
 // Kill-switch state
 unsigned long killSwitchPressStart = 0;
@@ -76,13 +149,93 @@ unsigned long lastKillSwitchDebug = 0;
 int ackReceived = 0;         // Number of ACKs received (sender)
 unsigned long lastAckTime = 0;  // Last ACK timestamp (sender)
 
+// Payload buffer size (legacy ASCII is the larger format)
+#define LEGACY_PAYLOAD_MAX 64
+
+// ACK length until the first ACK is seen (then learned), and the
+// longest one the format can produce (ASCII grows with SEQ/COUNT digits)
+#if TELEMETRY_BINARY_FORMAT
+  #define ACK_LENGTH_GUESS 7
+  #define ACK_LENGTH_MAX TELEMETRY_FRAME_MAX
+#else
+  #define ACK_LENGTH_GUESS 48
+  #define ACK_LENGTH_MAX (LEGACY_PAYLOAD_MAX - 1)
+#endif
+
+// Non-blocking transmit state (AT+SEND completes via callback)
+bool txInFlight = false;            // Telemetry/ACK AT+SEND queued
+bool txAckRequested = false;        // Frame in flight asks for an ACK (sender)
+bool txDeferred = false;            // Telemetry held back by duty cycle
+
+// Scheduled ACK slot (ack_slot.h)
+AckSlot ackSlot;                    // Sender RX window
+AckSchedule ackSchedule;            // Receiver ACK timing
+
+TxQueue txQueue;                    // Sender: alerts/commands by priority
+TxqItem txqSending;                 // Copy of the entry in the current AT+SEND
+unsigned long txqSendingAt = 0;     // When it went to the radio (alert latency)
+
+#if ENABLE_RELIABLE_LINK
+ReliableSender relTx;               // Alerts/commands awaiting confirmation (sender)
+ReliableReceiver relRx;             // Seen reliable messages (receiver)
+uint8_t relInFlightSeq = 0;         // Reliable frame in the current AT+SEND
+#endif
+
+#if ENABLE_TELEMETRY_BATCH
+TelemetryBatch batch;               // Sender snapshot buffer
+#endif
+
+#if ENABLE_GATEWAY_MODE
+NodeTable nodeTable;                // Receiver: one entry per sender
+#endif
+uint16_t ackAddress = 0;            // Receiver: sender the pending ACK answers
+
+#if ENABLE_TX_MAC
+TxMac txMac;                        // Sender uplink timing (mac_layer.h)
+#endif
+#if ENABLE_SEND_ON_CHANGE
+UplinkPolicy uplinkPolicy;          // Sender: snapshot of the last uplink
+UplinkReason uplinkReason = UPLINK_NONE;  // Why the next uplink goes
+#endif
+#if ENABLE_TIME_SYNC
+TimeSync timeSync;                  // Sender: receiver clock estimate
+unsigned long lastBeacon = 0;       // Receiver: last beacon queued
+#endif
+#if ENABLE_MAC_TDMA
+bool ackTdma = false;               // Receiver: pending ACK carries a TDMA correction
+int16_t ackTdmaShift = 0;
+#endif
+#if ENABLE_ADAPTIVE_SF
+AdaptiveSF adr;                     // Both roles: SF in use and switch state
+bool ackAdrInFlight = false;        // Receiver: AT+SEND in flight is an ADR_CMD
+#endif
+#if ENABLE_RELAY
+RelayQueue relayQueue;              // Relay: frames waiting for the next hop
+bool ackRelay = false;              // Receiver/relay: pending ACK is a RELAY_ACK
+uint8_t ackRelaySource = 0;         // Envelope it confirms
+uint8_t ackRelaySeq = 0;
+#endif
+#if ENABLE_TX_POWER_CONTROL
+TxPowerControl txPower;             // Sender: power level and energy log
+uint32_t txPowerAirtime = 0;        // Sender: air time of the uplink in flight
+#if ENABLE_TASK_SPLIT
+std::atomic<unsigned long> txPowerSampleAt(0);  // Sender: set by radio, taken by sensor task
+#else
+unsigned long txPowerSampleAt = 0;  // Sender: mid-uplink current reading due
+#endif
+unsigned long txPowerIdleAt = 0;    // Sender: last idle current reading
+float txPowerVolts = TXP_SUPPLY_V;  // Sender: last INA219 bus voltage
+int16_t ackLinkRssi = 0;            // Receiver: uplink the pending ACK answers
+int8_t ackLinkSnr = 0;
+#endif
+
 // =============== KILL-SWITCH FUNCTIONS ================================
 
 void initKillSwitch() {
   pinMode(KILLSWITCH_GND_PIN, OUTPUT);
   digitalWrite(KILLSWITCH_GND_PIN, LOW);
   pinMode(KILLSWITCH_READ_PIN, INPUT_PULLUP);
-  delay(100);  // Longer delay for pin stabilization
+  delay(BOOT_SETTLE_MS);  // Pin stabilization
 
   Serial.println("✓ Kill-switch initialized: GPIO13↔14, hold 3s to restart");
 
@@ -145,15 +298,19 @@ void executeRestart(const char* reason) {
   #endif
 }
 
-void processRemoteKillSwitch(String payload) {
-  // Check for remote kill-switch commands
-  if (payload.indexOf("CMD:RESTART") >= 0) {
-    Serial.println("\n⚠️  REMOTE RESTART COMMAND RECEIVED!");
-    executeRestart("Remote command");
-  }
-  else if (payload.indexOf("CMD:STOP") >= 0) {
-    Serial.println("\n⚠️  REMOTE STOP COMMAND RECEIVED!");
-    Serial.println("(Feature not yet implemented)");
+void processRemoteKillSwitch(const char* command, uint8_t len) {
+  // Check for remote kill-switch commands (one pass, frame_dispatch.h)
+  switch (remoteCommand(command, len)) {
+    case REMOTE_CMD_RESTART:
+      Serial.println("\n⚠️  REMOTE RESTART COMMAND RECEIVED!");
+      executeRestart("Remote command");
+      break;
+    case REMOTE_CMD_STOP:
+      Serial.println("\n⚠️  REMOTE STOP COMMAND RECEIVED!");
+      Serial.println("(Feature not yet implemented)");
+      break;
+    default:
+      break;
   }
 }
 
@@ -167,42 +324,782 @@ void updateSpinner() {
   }
 }
 
-void parsePayload(String payload) {
-  // Parse: SEQ:x,LED:x,TOUCH:x,SPIN:x,COUNT:x
-  int seqIdx = payload.indexOf("SEQ:");
-  int ledIdx = payload.indexOf("LED:");
-  int touchIdx = payload.indexOf("TOUCH:");
-  int spinIdx = payload.indexOf("SPIN:");
+// Apply decoded telemetry (binary frame or legacy ASCII) to a peer's state
+void applyTelemetry(DeviceState& peer, const TelemetryFrame& frame) {
+  if (frame.fields & FIELD_SEQ)   peer.sequenceNumber = frame.seq;
+  if (frame.fields & FIELD_LED)   peer.ledState = frame.led;
+  if (frame.fields & FIELD_TOUCH) peer.touchState = frame.touch;
+  if (frame.fields & FIELD_SPIN)  peer.spinnerIndex = frame.spinner;  // 0-3
+  if (frame.type == FRAME_TYPE_TELEMETRY) {
+    peer.keepaliveMs = frame.keepaliveS * 1000UL;  // Watchdog timeouts follow
+  }
+}
+
+// Sender address: fixed, or derived from the chip MAC for a fleet
+uint8_t senderAddress() {
+  #if LORA_SENDER_ADDRESS_AUTO
+    uint64_t mac = ESP.getEfuseMac();
+    uint8_t hash = 0;
+    for (uint8_t i = 0; i < 6; i++) hash = hash * 31 + (uint8_t)(mac >> (8 * i));
+    return 4 + hash % 250;  // 4-253: receiver (1) and display (3) stay free
+  #else
+    return LORA_SENDER_ADDRESS;
+  #endif
+}
+
+// Build telemetry/ACK payload from local state in the configured format.
+// ACKs announce the receiver's slot offset.
+uint8_t buildTelemetryPayload(uint8_t* out, uint8_t type, bool ackRequest = false) {
+  uint16_t slotOffset = (type == FRAME_TYPE_ACK) ? ackSchedule.offset : 0;
+  #if ENABLE_SEND_ON_CHANGE
+  uint16_t keepaliveS = (type == FRAME_TYPE_TELEMETRY) ? UPLINK_KEEPALIVE_S : 0;
+  #elif ENABLE_SLEEP_SENDER
+  uint16_t keepaliveS = (type == FRAME_TYPE_TELEMETRY) ? SLEEP_KEEPALIVE_S : 0;
+  #else
+  uint16_t keepaliveS = 0;
+  #endif
+  #if TELEMETRY_BINARY_FORMAT
+    #if ENABLE_MAC_TDMA
+    bool tdma = ackTdma;
+    int16_t tdmaShift = ackTdmaShift;
+    #else
+    bool tdma = false;
+    int16_t tdmaShift = 0;
+    #endif
+    #if ENABLE_TX_POWER_CONTROL
+    bool link = true;  // ACK reports the answered uplink's RSSI/SNR
+    int16_t linkRssi = ackLinkRssi;
+    int8_t linkSnr = ackLinkSnr;
+    #else
+    bool link = false;
+    int16_t linkRssi = 0;
+    int8_t linkSnr = 0;
+    #endif
+    return encodeTelemetryFrame(out, type, local.sequenceNumber,
+                                local.ledState, local.touchState,
+                                local.spinnerIndex, local.messageCount,
+                                ackRequest, slotOffset, tdma, tdmaShift,
+                                link, linkRssi, linkSnr, keepaliveS);
+  #else
+    // Legacy ASCII: [ACK,]SEQ:x,LED:x,TOUCH:x,SPIN:x,COUNT:x[,REQ:1][,SLOT:x][,KA:x]
+    int n = snprintf((char*)out, LEGACY_PAYLOAD_MAX, "%sSEQ:%d,LED:%d,TOUCH:%d,SPIN:%d,COUNT:%d",
+                     type == FRAME_TYPE_ACK ? "ACK," : "",
+                     local.sequenceNumber, local.ledState, local.touchState,
+                     local.spinnerIndex, local.messageCount);
+    if (n > 0 && ackRequest) {
+      n += snprintf((char*)out + n, LEGACY_PAYLOAD_MAX - n, ",REQ:1");
+    }
+    if (n > 0 && slotOffset > 0) {
+      n += snprintf((char*)out + n, LEGACY_PAYLOAD_MAX - n, ",SLOT:%u", slotOffset);
+    }
+    if (n > 0 && keepaliveS > 0) {
+      n += snprintf((char*)out + n, LEGACY_PAYLOAD_MAX - n, ",KA:%u", keepaliveS);
+    }
+    return (n > 0 && n < LEGACY_PAYLOAD_MAX) ? n : 0;
+  #endif
+}
+
+// Sender: next telemetry uplink may go (fixed cadence, mac_layer.h,
+// or send-on-change with heartbeat)
+bool uplinkDue() {
+  #if ENABLE_SEND_ON_CHANGE
+    unsigned long now = millis();
+    uplinkReason = uplinkPolicyDue(uplinkPolicy, local, now);
+    #if ENABLE_TX_MAC
+      // Heartbeats follow the MAC (jitter, backoff), events go at once
+      if (uplinkReason == UPLINK_HEARTBEAT) uplinkReason = UPLINK_NONE;
+      if (macDue(txMac, now)) uplinkReason = UPLINK_HEARTBEAT;
+    #endif
+    #if ENABLE_ADAPTIVE_SF
+      // New SF unconfirmed: keep sending until the receiver has heard one
+      if (uplinkReason == UPLINK_NONE && adrWantsAck(adr) &&
+          now - uplinkPolicy.lastSend >= UPLINK_MIN_GAP) {
+        uplinkReason = UPLINK_EVENT;
+      }
+    #endif
+    return uplinkReason != UPLINK_NONE;
+  #elif ENABLE_TX_MAC
+    return macDue(txMac, millis());
+  #elif ENABLE_SLEEP_SENDER
+    return !sleepCycle.uplinkQueued;  // One uplink per wake
+  #else
+    return millis() - timing.lastSend >= SEND_INTERVAL;
+  #endif
+}
+
+// Sender: uplink queued - start the next interval
+void uplinkSent(uint8_t payloadLength) {
+  timing.lastSend = millis();
+  #if ENABLE_SLEEP_SENDER
+    sleepCycle.uplinkQueued = true;
+  #endif
+  #if ENABLE_SEND_ON_CHANGE
+    uplinkPolicySent(uplinkPolicy, local, millis(), uplinkReason);
+  #endif
+  #if ENABLE_TX_MAC
+    macOnSend(txMac, millis(), loraAirtimeMs(loraUplinkLength(payloadLength)));
+  #endif
+  #if ENABLE_MAC_TDMA && ENABLE_TIME_SYNC
+    if (timeSyncSlotKnown(timeSync)) {
+      // Beacon clock: next own slot at least half a frame away
+      uint32_t frame = (uint32_t)timeSync.slotCount * timeSync.slotMs;
+      macOnSlot(txMac, timeSyncNextSlot(timeSync, millis() + frame / 2));
+    }
+  #endif
+}
+
+// =============== TRANSMIT POWER CONTROL ================================
+#if ENABLE_TX_POWER_CONTROL
+// Sender: uplink queued - energy is booked on +OK, current sampled mid-air
+void txPowerUplinkQueued(uint8_t frameLength) {
+  txPowerAirtime = loraAirtimeMs(frameLength);
+  txPowerSampleAt = millis() + txPowerAirtime / 2;
+}
+
+// Sender: uplink on air (+OK)
+void txPowerUplinkDone() {
+  txPowerOnUplink(txPower, txPowerAirtime, txPowerVolts);
+}
+
+// Sender: a reading counts only if the radio is still in the state it
+// was taken for (on air / between uplinks)
+void txPowerOnCurrent(bool onAir, float milliamps, float volts) {
+  if (volts > 0) txPowerVolts = volts;
+  if (onAir == txInFlight) txPowerOnCurrentSample(txPower, milliamps, onAir);
+}
+
+// Sender: INA219 reading in the middle of the uplink, else once a second.
+// The INA219 belongs to whoever runs the sensors: loop(), or the sensor
+// task with ENABLE_TASK_SPLIT, which hands it over as SENSOR_EVENT_CURRENT
+void txPowerSampleCurrent() {
+  #if ENABLE_CURRENT_MONITOR
+    unsigned long due = txPowerSampleAt;
+    bool onAir = due && (long)(millis() - due) >= 0;
+    if (onAir) {
+      txPowerSampleAt = 0;
+    } else if (millis() - txPowerIdleAt >= 1000) {
+      txPowerIdleAt = millis();
+    } else {
+      return;
+    }
+    float milliamps = sampleCurrent_mA();
+    #if ENABLE_TASK_SPLIT
+      SensorEvent event = {SENSOR_EVENT_CURRENT, false, false, false, 0, onAir, milliamps, current.voltage};
+      spscPush(sensorEvents, event);  // Full: the next reading follows
+    #else
+      txPowerOnCurrent(onAir, milliamps, current.voltage);
+    #endif
+  #endif
+}
+
+// Sender: power may only go down once ADR has reached its fastest SF
+bool txPowerMayStepDown() {
+  #if ENABLE_ADAPTIVE_SF
+    return adr.sf == ADR_SF_MIN && adr.phase == ADR_IDLE;
+  #else
+    return true;
+  #endif
+}
+#endif
+
+// =============== TIME BEACONS ================================
+#if ENABLE_TIME_SYNC
+void onBeaconSent(ATResult result, const char* response, void* ctx) {
+  txInFlight = false;
+  if (result != AT_RESULT_OK) {
+    Serial.println("❌ Beacon send failed");
+  }
+}
+
+// Receiver: broadcast millis() and the slot map (node table order)
+bool sendBeacon() {
+  uint8_t map[BEACON_MAP_MAX];
+  uint8_t mapLen = 0;
+  #if ENABLE_GATEWAY_MODE
+    for (uint8_t i = 0; i < nodeTable.count && mapLen < BEACON_MAP_MAX; i++) {
+      map[mapLen++] = nodeTable.nodes[i].address;
+    }
+  #endif
+
+  uint8_t frame[BEACON_FRAME_MAX];
+  uint8_t length = encodeBeacon(frame, millis(), TDMA_SLOT_COUNT, TDMA_SLOT_MS, map, mapLen);
+  if (!loraCanSend(length)) return false;
+  return sendLoRaMessage(frame, length, LORA_BROADCAST_ADDR, onBeaconSent);
+}
+
+// Sender: beacon heard → update the clock fit
+void receiveBeacon(const RcvView& packet) {
+  if (packet.sender != TARGET_LORA_ADDRESS) return;  // Another network's receiver
+  if (!timeSyncOnBeacon(timeSync, loraRxTime, packet.data, packet.len,
+                        MY_LORA_ADDRESS, loraAirtimeMs(packet.len))) return;
+  Serial.print("🕐 Beacon #");
+  Serial.print(timeSync.beacons);
+  Serial.print(": drift ");
+  Serial.print(timeSync.drift * 1e6, 1);
+  Serial.print(" ppm, residual ");
+  Serial.print(timeSync.lastResidual);
+  Serial.print(" ms, slot ");
+  Serial.println(timeSync.mySlot);
+}
+#endif
+
+// =============== ADAPTIVE DATA RATE ================================
+#if ENABLE_ADAPTIVE_SF
+// Sender: ACCEPT left at the old SF → module switches now
+void onAdrAcceptSent(ATResult result, const char* response, void* ctx) {
+  txInFlight = false;
+  if (result != AT_RESULT_OK) {
+    Serial.print("❌ ADR accept send failed - staying on SF");
+    Serial.println(adr.sf);
+  }
+  adrAcceptSent(adr, result == AT_RESULT_OK);
+}
+
+// Sender: confirm the receiver's command (old SF, no ACK slot)
+bool sendAdrAccept() {
+  uint8_t frame[ADR_FRAME_LEN];
+  uint8_t length = adrEncode(frame, FRAME_TYPE_ADR_ACCEPT, adr.txid, adr.targetSF);
+  if (!loraCanSend(length)) return false;
+  if (!sendLoRaMessage(frame, length, TARGET_LORA_ADDRESS, onAdrAcceptSent)) return false;
+  Serial.print("📤 ADR accept: SF");
+  Serial.print(adr.sf);
+  Serial.print(" → SF");
+  Serial.println(adr.targetSF);
+  return true;
+}
+#endif
+
+// Sender: every ACK_INTERVAL-th message asks for an ACK
+bool ackRequestDue() {
+  #if ENABLE_SLEEP_SENDER && !SLEEP_ACK_WINDOW
+    return false;  // Radio goes to sleep right after the uplink
+  #else
+    return (local.messageCount + 1) % ACK_INTERVAL == 0;
+  #endif
+}
+
+// Sender: uplink just left the air (+OK) → expect the ACK in its slot.
+// The window opens for an ACK as long as the last one and stays open
+// until the longest ACK of the format has ended - a hit closes it
+// early, so only a miss pays for the margin. A window sized from the
+// last ACK alone closed too early once a counter gained a digit, and
+// the next uplink went out over the ACK (no ACK was ever learned again).
+void scheduleAckSlot(uint8_t ackLength, uint8_t ackMaxLength) {
+  ackSlotSchedule(ackSlot, millis(),
+                  loraAirtimeMs(ackLength),
+                  loraAirtimeMs(ackMaxLength > ackLength ? ackMaxLength : ackLength),
+                  ACK_SLOT_GUARD);
+}
+
+// =============== PRIORITY TRANSMIT ================================
+// Alert latency target: one air time of this build's longest uplink
+uint32_t alertTargetMs() {
+  #if ENABLE_TELEMETRY_BATCH
+    return loraAirtimeMs(loraUplinkLength(BATCH_FRAME_MAX));
+  #elif TELEMETRY_BINARY_FORMAT
+    return loraAirtimeMs(loraUplinkLength(TELEMETRY_FRAME_MAX));
+  #else
+    return loraAirtimeMs(loraUplinkLength(LEGACY_PAYLOAD_MAX));
+  #endif
+}
+
+void onQueuedSent(ATResult result, const char* response, void* ctx) {
+  txInFlight = false;
+
+  if (result != AT_RESULT_OK) {
+    Serial.print("❌ Alert/command send failed: ");
+    Serial.println(result == AT_RESULT_TIMEOUT ? "timeout" : response);
+    // Back in line with its first queue time - the age stays honest
+    txqRequeue(txQueue, txqSending);
+    return;
+  }
+
+  txqOnSent(txQueue, txqSending.prio);
+  if (txqSending.prio == TXQ_ALARM) {
+    txqOnAlarmSent(txQueue, txqSending.queuedAt, txqSendingAt, alertTargetMs());
+  }
+}
+
+// Sender: hand the most urgent alert/command to the radio
+bool sendQueued() {
+  TxqItem* it = txqFront(txQueue);
+  if (!it) return false;
+
+  unsigned long now = millis();
+  uint8_t frame[TXQ_FRAME_MAX + 5];
+  memcpy(frame, it->data, it->len);
+  uint8_t length = it->len;
+  if (it->prio == TXQ_ALARM) {
+    length = txqStampAlert(frame, length, now - it->queuedAt);
+  }
+  if (!loraCanSend(length)) return false;  // Duty cycle - stays queued
+
+  if (!sendLoRaMessage(frame, length, TARGET_LORA_ADDRESS, onQueuedSent)) return false;
+  txInFlight = true;
+  txqSending = *it;
+  txqSendingAt = now;
+
+  if (it->prio == TXQ_ALARM) {
+    Serial.print("📤 ALERT (");
+    Serial.print(now - it->queuedAt);
+    Serial.println(" ms after detection)");
+  } else {
+    Serial.println("📤 CMD");
+  }
+  txqRemove(txQueue, it);  // Counted on +OK (onQueuedSent)
+  return true;
+}
+
+// Receiver: alert banner (queued alert or reliable channel)
+void printRemoteAlarm(uint8_t method, uint32_t alertCount) {
+  Serial.println("╔════════════════════════════════════════╗");
+  Serial.println("║  🚨 REMOTE FIRE ALARM! 🚨              ║");
+  Serial.println("╚════════════════════════════════════════╝");
+  Serial.print("  Detection method: ");
+  Serial.print((method & REL_ALERT_AUDIO) ? "AUDIO " : "");
+  Serial.println((method & REL_ALERT_LIGHT) ? "LIGHT" : "");
+  Serial.print("  Alert count: ");
+  Serial.println(alertCount);
+}
+
+// Receiver: unconfirmed alert frame (tx_queue.h)
+void receiveAlert(const RcvView& packet) {
+  uint8_t method;
+  uint32_t alertCount, ageMs;
+  if (txqDecodeAlert(packet.data, packet.len, method, alertCount, ageMs)) {
+    printRemoteAlarm(method, alertCount);
+    uint32_t airMs = loraAirtimeMs(packet.len);
+    Serial.print("  Latency: ");
+    Serial.print(ageMs + airMs);
+    Serial.print(" ms (queued ");
+    Serial.print(ageMs);
+    Serial.print(" + air ");
+    Serial.print(airMs);
+    Serial.println(" ms)");
+  }
+}
+
+// Receiver: unconfirmed command frame (tx_queue.h)
+void receiveCommand(const RcvView& packet) {
+  if (!isCommandFrame(packet.data, packet.len)) return;
+  Serial.print("📥 Remote command: ");
+  Serial.write((const uint8_t*)packet.data + 1, packet.len - 1);
+  Serial.println();
+  processRemoteKillSwitch(packet.data + 1, packet.len - 1);
+}
+
+// =============== RELIABLE DELIVERY ================================
+#if ENABLE_RELIABLE_LINK
+void onReliableSent(ATResult result, const char* response, void* ctx) {
+  txInFlight = false;
+
+  if (result != AT_RESULT_OK) {
+    Serial.print("❌ Reliable send failed: ");
+    Serial.println(result == AT_RESULT_TIMEOUT ? "timeout" : response);
+    return;  // Not counted as a try - resent on the next pass
+  }
+
+  RelEntry* e = relFind(relTx, relInFlightSeq);
+  if (e) relMarkSent(relTx, *e);
+  scheduleAckSlot(REL_ACK_LEN, REL_ACK_LEN);  // Answer is always a bitmap ACK
+}
+
+// Sender: transmit the most urgent pending alert/command (gaps first)
+bool sendReliable() {
+  RelEntry* e = relNextToSend(relTx, REL_RETRY_MS);
+  if (!e) return false;
+
+  uint8_t frame[REL_FRAME_MAX];
+  uint8_t length = relEncode(relTx, *e, frame);
+  if (!loraCanSend(length)) return false;  // Duty cycle - stays queued
+
+  if (!sendLoRaMessage(frame, length, TARGET_LORA_ADDRESS, onReliableSent)) return false;
+  txInFlight = true;
+  relInFlightSeq = e->seq;
+  if (e->kind == REL_KIND_ALERT && e->tries == 0) {
+    txqOnAlarmSent(txQueue, e->queuedAt, millis(), alertTargetMs());
+  }
+
+  Serial.print("📤 Reliable #");
+  Serial.print(e->seq);
+  Serial.print(e->kind == REL_KIND_ALERT ? " ALERT" : " CMD");
+  if (e->tries > 0) {
+    Serial.print(" (retry ");
+    Serial.print(e->tries);
+    Serial.print(")");
+  }
+  Serial.println();
+  return true;
+}
+
+// Sender: remote command typed on Serial ("CMD:...")
+bool queueReliableCommand(const char* command, uint8_t len) {
+  return relQueue(relTx, REL_KIND_COMMAND, (const uint8_t*)command, len);
+}
+
+// Receiver: first copy of a reliable message → act on it
+void deliverReliable(ReliableReceiver& rx, const RcvView& packet) {
+  const uint8_t* p = (const uint8_t*)packet.data;
+  if (!relAccept(rx, p[1], p[2])) {
+    Serial.println("ℹ️  Reliable duplicate (ACK was lost) - re-ACKing");
+    return;
+  }
+
+  uint8_t kind = p[3];
+  const uint8_t* data = p + REL_HEADER_LEN;
+  uint8_t len = packet.len - REL_HEADER_LEN;
+
+  if (kind == REL_KIND_ALERT && len >= 2) {
+    const uint8_t* q = data + 1;
+    uint32_t alertCount = 0;
+    getVarint(q, data + len, alertCount);
+    printRemoteAlarm(data[0], alertCount);
+  } else if (kind == REL_KIND_COMMAND) {
+    Serial.print("📥 Remote command: ");
+    Serial.write(data, len);
+    Serial.println();
+    processRemoteKillSwitch((const char*)data, len);
+  }
+}
+#endif
+
+// Fire alarm detected (fire_alarm_detector.h) → alert to receiver,
+// ahead of everything else the sender has to send
+#if ENABLE_AUDIO_DETECTION || ENABLE_LIGHT_DETECTION
+void queueFireAlert(bool audio, bool light, unsigned long alertCount) {
+  if (bRECEIVER || bRELAY) return;  // Receiver shows alarms locally only
+
+  uint8_t method = (audio ? REL_ALERT_AUDIO : 0) | (light ? REL_ALERT_LIGHT : 0);
+  #if ENABLE_RELIABLE_LINK
+  uint8_t alert[6];
+  alert[0] = method;
+  uint8_t len = 1 + putVarint(alert + 1, alertCount);
+  if (!relQueue(relTx, REL_KIND_ALERT, alert, len)) {
+    Serial.println("❌ Alert queue full - alert lost!");
+  }
+  #else
+  uint8_t alert[TXQ_FRAME_MAX];
+  uint8_t len = txqEncodeAlert(alert, method, alertCount);
+  txqPush(txQueue, TXQ_ALARM, alert, len, millis());  // Full queue merges alerts
+  #endif
+}
+
+void onFireAlarmAlert(bool audio, bool light, unsigned long alertCount) {
+  #if ENABLE_TASK_SPLIT
+    // Sensor task: the radio task queues it (applySensorEvents())
+    SensorEvent event = {SENSOR_EVENT_FIRE_ALARM, false, audio, light, alertCount};
+    if (!spscPush(sensorEvents, event)) {
+      Serial.println("❌ Sensor queue full - alert lost!");
+    }
+  #else
+    queueFireAlert(audio, light, alertCount);
+  #endif
+}
+#endif
+
+// =============== BATCHED UPLINK ================================
+#if ENABLE_TELEMETRY_BATCH
+// Fields this build can fill in
+#define BATCH_FIELDS \
+  (((ENABLE_BATTERY_MONITOR || ENABLE_CURRENT_MONITOR) ? BATCH_FIELD_BATTERY : 0) | \
+   (ENABLE_CURRENT_MONITOR ? BATCH_FIELD_CURRENT : 0) | \
+   (ENABLE_AUDIO_DETECTION ? BATCH_FIELD_AUDIO : 0) | \
+   (ENABLE_LIGHT_DETECTION ? BATCH_FIELD_LIGHT : 0))
+
+// Snapshot local state + last sensor readings (no sensor I/O here)
+void takeBatchSample() {
+  BatchSample s = {};
+  s.timestamp = millis();
+  s.seq = local.sequenceNumber++;  // One sequence number per sample
+  s.led = local.ledState;
+  s.touch = local.touchState;
+  s.spinner = local.spinnerIndex;
+
+  #if ENABLE_CURRENT_MONITOR
+    s.batteryMv = current.voltage * 1000;
+    s.currentMa10 = current.current_mA * 10;
+  #elif ENABLE_BATTERY_MONITOR
+    s.batteryMv = battery.voltage * 1000;
+  #endif
+  #if ENABLE_AUDIO_DETECTION
+    s.audioRms = audio.currentRMS;
+  #endif
+  #if ENABLE_LIGHT_DETECTION
+    s.light = light.clear;
+  #endif
+
+  batchAdd(batch, s);
+}
+#endif
+
+// Receiver: one record per batched sample
+// Format: DATA_SAMPLE,TIMESTAMP,ROLE,RSSI,SNR,SEQ,MSG_COUNT,CONN_STATE,PACKET_LOSS,LED,TOUCH,BATT_V,CURRENT_MA,AUDIO_RMS,LIGHT
+void printSampleCSV(const BatchSample& s, DeviceState& peer, HealthMonitor& peerHealth) {
+  Serial.print("DATA_SAMPLE,");
+  Serial.print(s.timestamp);
+  Serial.print(",RX,");
+  Serial.print(peer.rssi);
+  Serial.print(",");
+  Serial.print(peer.snr);
+  Serial.print(",");
+  Serial.print(s.seq);
+  Serial.print(",");
+  Serial.print(peer.messageCount);
+  Serial.print(",");
+  Serial.print(getConnectionStateString(peerHealth.state));
+  Serial.print(",");
+  Serial.print(getPacketLoss(peerHealth), 2);
+  Serial.print(",");
+  Serial.print(s.led);
+  Serial.print(",");
+  Serial.print(s.touch);
+  Serial.print(",");
+  Serial.print(s.batteryMv / 1000.0, 3);
+  Serial.print(",");
+  Serial.print(s.currentMa10 / 10.0, 1);
+  Serial.print(",");
+  Serial.print(s.audioRms);
+  Serial.print(",");
+  Serial.println(s.light);
+}
+
+// Unpack a batch frame into per-sample records: peer state, packet
+// tracking and CSV per sample. Returns number of samples.
+uint8_t receiveTelemetryBatch(const RcvView& packet, DeviceState& peer, HealthMonitor& peerHealth) {
+  BatchSample samples[BATCH_MAX_SAMPLES];
+  uint8_t count = decodeTelemetryBatch((const uint8_t*)packet.data, packet.len,
+                                       samples, BATCH_MAX_SAMPLES, millis());
+
+  for (uint8_t i = 0; i < count; i++) {
+    const BatchSample& s = samples[i];
+    peer.sequenceNumber = s.seq;
+    peer.ledState = s.led;
+    peer.touchState = s.touch;
+    peer.spinnerIndex = s.spinner;
+    if (loraRxRecovered) {
+      trackRecoveredPacket(peerHealth, s.seq);  // FEC: loss already counted
+    } else {
+      trackPacket(peerHealth, s.seq);
+    }
+
+    #if ENABLE_CSV_OUTPUT
+      printSampleCSV(s, peer, peerHealth);
+    #endif
+  }
+  return count;
+}
+
+// =============== FRAME HANDLERS ================================
+// One handler per frame kind and role, picked from a compile-time
+// table after receiveLoRaPacket() has classified the frame once
+// (frame_dispatch.h). Each handler still validates with its decoder.
+
+// Receiver: per-packet state the handlers fill in
+struct ReceiverRx {
+  RcvView packet;
+  DeviceState* peer;             // remote, or the sender's node entry
+  HealthMonitor* peerHealth;
+  ReliableReceiver* peerRel;     // ENABLE_RELIABLE_LINK only
+  bool received;                 // Counts as a message from peer
+  bool ackRequested;             // Answer in the ACK slot
+};
+
+void rxTelemetry(ReceiverRx& rx) {
+  TelemetryFrame frame;
+  if (!decodeTelemetry(rx.packet.data, rx.packet.len, frame)) return;
+  applyTelemetry(*rx.peer, frame);
+  if (loraRxRecovered) {
+    trackRecoveredPacket(*rx.peerHealth, rx.peer->sequenceNumber);  // FEC: loss already counted
+  } else {
+    trackPacket(*rx.peerHealth, rx.peer->sequenceNumber);
+  }
+  rx.received = true;
+  rx.ackRequested = frame.ackRequest;
+}
+
+void rxBatch(ReceiverRx& rx) {
+  // Batch: per-sample state, packet tracking and CSV
+  rx.received = receiveTelemetryBatch(rx.packet, *rx.peer, *rx.peerHealth) > 0;
+  rx.ackRequested = batchAckRequested(rx.packet.data, rx.packet.len);
+}
+
+#if ENABLE_RELIABLE_LINK
+void rxReliable(ReceiverRx& rx) {
+  if (!isReliableFrame(rx.packet.data, rx.packet.len)) return;
+  // Alert/command: always answered (bitmap ACK), never telemetry
+  deliverReliable(*rx.peerRel, rx.packet);
+  ackAddress = rx.packet.sender;
+  #if ENABLE_MAC_TDMA
+    ackTdma = false;  // Bitmap ACK - no telemetry fields
+  #endif
+  ackScheduleAt(ackSchedule, loraRxTime);
+}
+#endif
+
+// Unconfirmed - no ACK slot
+void rxAlert(ReceiverRx& rx) {
+  receiveAlert(rx.packet);
+}
+
+void rxCommand(ReceiverRx& rx) {
+  receiveCommand(rx.packet);
+}
 
-  // Parse sequence number
-  if (seqIdx >= 0) {
-    int comma = payload.indexOf(',', seqIdx);
-    if (comma < 0) comma = payload.length();
-    remote.sequenceNumber = payload.substring(seqIdx + 4, comma).toInt();
+#if ENABLE_ADAPTIVE_SF
+void rxAdrAccept(ReceiverRx& rx) {
+  uint8_t txid, sf;
+  if (adrDecode(rx.packet.data, rx.packet.len, FRAME_TYPE_ADR_ACCEPT, txid, sf)) {
+    adrOnAccept(adr, txid, sf);  // txid ties it to our command
   }
+}
+#endif
 
-  if (ledIdx >= 0) {
-    int comma = payload.indexOf(',', ledIdx);
-    if (comma < 0) comma = payload.length();
-    remote.ledState = payload.substring(ledIdx + 4, comma).toInt();
+constexpr FrameRoute<ReceiverRx> receiverRouteList[] = {
+  {FRAME_KIND_TELEMETRY, rxTelemetry},
+  {FRAME_KIND_ACK, rxTelemetry},
+  {FRAME_KIND_BATCH, rxBatch},
+  #if ENABLE_RELIABLE_LINK
+  {FRAME_KIND_RELIABLE, rxReliable},
+  #endif
+  {FRAME_KIND_ALERT, rxAlert},
+  {FRAME_KIND_COMMAND, rxCommand},
+  #if ENABLE_ADAPTIVE_SF
+  {FRAME_KIND_ADR_ACCEPT, rxAdrAccept},
+  #endif
+};
+constexpr FrameHandler<ReceiverRx> receiverRoutes[FRAME_KIND_COUNT] =
+  FRAME_ROUTE_TABLE(receiverRouteList);
+
+// Sender: answers from the receiver
+#if ENABLE_TIME_SYNC
+void txBeacon(RcvView& packet) {
+  if (isBeaconFrame(packet.data, packet.len)) {
+    receiveBeacon(packet);  // Clock only, not an ACK
   }
+}
+#endif
 
-  if (touchIdx >= 0) {
-    int comma = payload.indexOf(',', touchIdx);
-    if (comma < 0) comma = payload.length();
-    remote.touchState = payload.substring(touchIdx + 6, comma).toInt();
+#if ENABLE_ADAPTIVE_SF
+// Command takes the place of the state ACK
+void txAdrCommand(RcvView& packet) {
+  uint8_t adrTxid, adrSF;
+  if (!adrDecode(packet.data, packet.len, FRAME_TYPE_ADR_CMD, adrTxid, adrSF)) return;
+  if (packet.sender == TARGET_LORA_ADDRESS && ackSlotMatch(ackSlot, 0, ackSlot.ackLength)) {
+    #if ENABLE_PACKET_STATS
+      recordAckReceived();
+    #endif
+    #if ENABLE_TX_MAC
+      macOnAck(txMac);
+    #endif
+    #if ENABLE_TX_POWER_CONTROL
+      txPowerOnAck(txPower);
+    #endif
+    adrOnAck(adr);
+    adrOnCommand(adr, adrTxid, adrSF);
+    updateRSSI(health, remote.rssi);
   }
+}
+#endif
 
-  if (spinIdx >= 0) {
-    int comma = payload.indexOf(',', spinIdx);
-    if (comma < 0) comma = payload.length();
-    remote.spinnerIndex = payload.substring(spinIdx + 5, comma).toInt();
-    // Bounds check to prevent buffer overflow!
-    if (remote.spinnerIndex < 0 || remote.spinnerIndex >= 4) {
-      remote.spinnerIndex = 0;
+#if ENABLE_RELIABLE_LINK
+// Bitmap ACK - not a state ACK
+void txRelAck(RcvView& packet) {
+  uint8_t relSession, relTop;
+  uint32_t relBitmap;
+  if (!decodeRelAck(packet.data, packet.len, relSession, relTop, relBitmap)) return;
+  if (relSession == relTx.session) {
+    relOnAck(relTx, relTop, relBitmap);
+    if (ackSlotMatch(ackSlot, 0, ackSlot.ackLength)) {
+      #if ENABLE_PACKET_STATS
+        recordAckReceived();
+      #endif
+      #if ENABLE_TX_MAC
+        macOnAck(txMac);
+      #endif
+      #if ENABLE_ADAPTIVE_SF
+        adrOnAck(adr);
+      #endif
+      #if ENABLE_TX_POWER_CONTROL
+        txPowerOnAck(txPower);
+      #endif
     }
+    Serial.print("✓ Reliable ACK (top #");
+    Serial.print(relTop);
+    Serial.print(", delivered: ");
+    Serial.print(relTx.delivered);
+    Serial.print(", pending: ");
+    Serial.print(relTx.count);
+    Serial.println(")");
+    updateRSSI(health, remote.rssi);
   }
 }
+#endif
+
+// State ACK: matched to the slot, receiver state applied
+void txAck(RcvView& packet) {
+  TelemetryFrame frame;
+  if (!decodeTelemetry(packet.data, packet.len, frame) || frame.type != FRAME_TYPE_ACK) return;
+  uint16_t announced = (frame.fields & FIELD_SLOT) ? frame.slotOffset : 0;
+  if (ackSlotMatch(ackSlot, announced, packet.len)) {
+    ackReceived++;
+    lastAckTime = millis();
+    Serial.print("✓ ACK #");
+    Serial.print(ackReceived);
+    Serial.print(" received (RSSI: ");
+    Serial.print(remote.rssi);
+    Serial.println(" dBm)");
+    #if ENABLE_PACKET_STATS
+      recordAckReceived();  // Track ACK success rate
+    #endif
+    #if ENABLE_ADAPTIVE_SF
+      adrOnAck(adr);  // Confirms a new SF
+    #endif
+    #if ENABLE_TX_POWER_CONTROL
+      txPowerOnAck(txPower);
+      if (frame.fields & FIELD_LINK) {
+        txPowerOnReport(txPower, frame.linkRssi, frame.linkSnr, txPowerMayStepDown());
+      }
+    #endif
+    #if ENABLE_TX_MAC
+      macOnAck(txMac);
+      bool beaconSlot = false;
+      #if ENABLE_TIME_SYNC
+        beaconSlot = timeSyncSlotKnown(timeSync);  // Beacon clock is absolute
+      #endif
+      if ((frame.fields & FIELD_TDMA) && !beaconSlot) {
+        macOnTdma(txMac, frame.tdmaShift);  // Receiver moves us into our slot
+      }
+    #endif
+  } else {
+    Serial.println("⚠️  Late ACK (outside slot)");
+  }
+
+  applyTelemetry(remote, frame);  // Apply receiver state carried in ACK
+  // Update health monitoring for sender too
+  updateRSSI(health, remote.rssi);
+  trackPacket(health, remote.sequenceNumber);
+
+  // Record packet in detailed telemetry (SNR, timing, etc.)
+  #if ENABLE_PACKET_STATS
+    recordPacketReceived(remote.rssi, remote.snr, remote.sequenceNumber);
+    if (loraRxRecovered) recordFecCorrected(1);
+  #endif
+}
+
+constexpr FrameRoute<RcvView> senderRouteList[] = {
+  {FRAME_KIND_ACK, txAck},
+  #if ENABLE_RELIABLE_LINK
+  {FRAME_KIND_REL_ACK, txRelAck},
+  #endif
+  #if ENABLE_TIME_SYNC
+  {FRAME_KIND_BEACON, txBeacon},
+  #endif
+  #if ENABLE_ADAPTIVE_SF
+  {FRAME_KIND_ADR_CMD, txAdrCommand},
+  #endif
+};
+constexpr FrameHandler<RcvView> senderRoutes[FRAME_KIND_COUNT] =
+  FRAME_ROUTE_TABLE(senderRouteList);
 
 // =============== LCD HELPER FUNCTIONS ================================
 
@@ -239,12 +1136,14 @@ char getSignalIcon(int rssi) {
 // =============== LCD DISPLAY VERSIONS ================================
 // Uncomment ONE version at a time to use it
 
-void updateLCD() {
+void updateLCD(const UiSnapshot& ui) {
+  const DeviceState& remote = ui.remote;
   if (millis() - timing.lastLCD >= 100) {
     timing.lastLCD = millis();
 
     // Check for connection timeout (10 seconds)
-    bool connectionLost = (bRECEIVER && millis() - remote.lastMessageTime > 10000);
+    unsigned long noSignalTimeout = watchdogLostTimeout(remote) > 10000 ? watchdogLostTimeout(remote) : 10000;
+    bool connectionLost = (bRECEIVER && millis() - remote.lastMessageTime > noSignalTimeout);
 
     if (connectionLost) {
       // Connection lost warning
@@ -260,24 +1159,27 @@ void updateLCD() {
 
     // VERSION 1: WIDE VISUAL BAR + RSSI (RECOMMENDED) ⭐
     // Uncomment this version:
-  //  updateLCD_Version1_WideBar();
+  //  updateLCD_Version1_WideBar(ui);
 
     // VERSION 2: COMPACT WITH NUMBERS
     // Uncomment this version:
-     updateLCD_Version2_Compact();
+     updateLCD_Version2_Compact(ui);
 
     // VERSION 3: DETAILED INFO
     // Uncomment this version:
-    // updateLCD_Version3_Detailed();
+    // updateLCD_Version3_Detailed(ui);
 
     // VERSION 4: ORIGINAL (Status only, no signal)
     // Uncomment this version:
-    // updateLCD_Version4_Original();
+    // updateLCD_Version4_Original(ui);
   }
 }
 
 // =============== VERSION 1: WIDE VISUAL BAR ⭐ ================================
-void updateLCD_Version1_WideBar() {
+void updateLCD_Version1_WideBar(const UiSnapshot& ui) {
+  const DeviceState& local = ui.local;
+  const DeviceState& remote = ui.remote;
+  const HealthMonitor& health = ui.health;
   // Line 1: Connection status + signal bar + count + remote spinner
   lcd.setCursor(0, 0);
 
@@ -307,7 +1209,10 @@ void updateLCD_Version1_WideBar() {
 }
 
 // =============== VERSION 2: COMPACT ================================
-void updateLCD_Version2_Compact() {
+void updateLCD_Version2_Compact(const UiSnapshot& ui) {
+  const DeviceState& local = ui.local;
+  const DeviceState& remote = ui.remote;
+  const HealthMonitor& health = ui.health;
   // Line 1: Connection + signal bar + RSSI + remote spinner
   lcd.setCursor(0, 0);
 
@@ -340,7 +1245,9 @@ void updateLCD_Version2_Compact() {
 }
 
 // =============== VERSION 3: DETAILED INFO ================================
-void updateLCD_Version3_Detailed() {
+void updateLCD_Version3_Detailed(const UiSnapshot& ui) {
+  const DeviceState& local = ui.local;
+  const DeviceState& remote = ui.remote;
   // Line 1: RSSI + SNR + signal icon + count
   lcd.setCursor(0, 0);
   lcd.print("RX:");
@@ -366,7 +1273,9 @@ void updateLCD_Version3_Detailed() {
 }
 
 // =============== VERSION 4: ORIGINAL (No signal info) ================================
-void updateLCD_Version4_Original() {
+void updateLCD_Version4_Original(const UiSnapshot& ui) {
+  const DeviceState& local = ui.local;
+  const DeviceState& remote = ui.remote;
   // Line 1: Remote status
   lcd.setCursor(0, 0);
   lcd.print("REM:");
@@ -457,10 +1366,75 @@ void printStatus() {
     Serial.print(remote.rssi);
     Serial.print(" dBm, SNR: ");
     Serial.println(remote.snr);
+    #if ENABLE_GATEWAY_MODE
+    Serial.print("Nodes: ");
+    Serial.print(nodeTable.count);
+    Serial.print("/");
+    Serial.print(GATEWAY_MAX_NODES);
+    Serial.print(", online: ");
+    Serial.print(nodeTableOnline(nodeTable));
+    Serial.print(", rejected: ");
+    Serial.println(nodeTable.rejected);
+    #endif
+    #if ENABLE_BIDIRECTIONAL
+    Serial.print("ACKs TX: ");
+    Serial.print(ackSchedule.sent);
+    Serial.print(", dropped (slot missed): ");
+    Serial.println(ackSchedule.dropped);
+    #endif
+    #if ENABLE_RELIABLE_LINK
+    unsigned long relReceived = relRx.received;
+    unsigned long relDuplicates = relRx.duplicates;
+    #if ENABLE_GATEWAY_MODE
+    for (uint8_t i = 0; i < nodeTable.count; i++) {
+      relReceived += nodeTable.nodes[i].rel.received;
+      relDuplicates += nodeTable.nodes[i].rel.duplicates;
+    }
+    #endif
+    Serial.print("Reliable RX: ");
+    Serial.print(relReceived);
+    Serial.print(", duplicates: ");
+    Serial.println(relDuplicates);
+    #endif
+    #if ENABLE_ADAPTIVE_SF
+    printAdaptiveSFStatus(adr);
+    #endif
+    #if ENABLE_RELAY
+    Serial.print("Relayed RX duplicates: ");
+    Serial.println(loraRelayCache.duplicates);
+    #endif
+  } else if (bRELAY) {
+    #if ENABLE_RELAY
+    Serial.println("--- RELAY ---");
+    Serial.print("Next hop: ");
+    Serial.print(TARGET_LORA_ADDRESS);
+    Serial.print(", hop ACKs: ");
+    Serial.print(ackSlot.hits);
+    Serial.print("/");
+    Serial.print(ackSlot.hits + ackSlot.misses);
+    Serial.print(", ACKs TX: ");
+    Serial.println(ackSchedule.sent);
+    Serial.print("Airtime: ");
+    Serial.print(loraAirtimeTotalMs);
+    Serial.print(" ms (");
+    Serial.print(loraDutyCyclePercent(), 2);
+    Serial.println("% duty)");
+    printRelayStatus(relayQueue, loraRelayCache);
+    #endif
   } else {
     Serial.println("--- SENDER ---");
     Serial.print("Messages TX: ");
     Serial.println(local.messageCount);
+    Serial.print("Airtime: ");
+    Serial.print(loraAirtimeTotalMs);
+    Serial.print(" ms (");
+    Serial.print(loraDutyCyclePercent(), 2);
+    Serial.print("% duty)");
+    #if ENABLE_DUTY_CYCLE_LIMIT
+    Serial.print(", deferred: ");
+    Serial.print(loraDutyCycle.packetsDeferred);
+    #endif
+    Serial.println();
     #if ENABLE_BIDIRECTIONAL
     Serial.print("ACKs RX: ");
     Serial.print(ackReceived);
@@ -470,25 +1444,590 @@ void printStatus() {
       Serial.print("s ago)");
     }
     Serial.println();
+    Serial.print("ACK slots: ");
+    Serial.print(ackSlot.hits);
+    Serial.print("/");
+    Serial.print(ackSlot.hits + ackSlot.misses);
+    Serial.print(" (");
+    Serial.print(ackSlotHitRate(ackSlot), 1);
+    Serial.print("%), late: ");
+    Serial.print(ackSlot.late);
+    Serial.print(", listen: ");
+    Serial.print(ackSlot.listenMs);
+    Serial.print(" ms, offset: ");
+    Serial.print(ackSlot.offset);
+    Serial.println(" ms");
     #endif
+    #if ENABLE_TIME_SYNC
+    Serial.print("Time sync: ");
+    if (timeSync.valid) {
+      Serial.print(timeSync.beacons);
+      Serial.print(" beacons, drift ");
+      Serial.print(timeSync.drift * 1e6, 1);
+      Serial.print(" ppm, last ");
+      Serial.print((millis() - timeSync.refLocal) / 1000);
+      Serial.println("s ago");
+    } else {
+      Serial.println("no beacon yet");
+    }
+    #endif
+    #if ENABLE_ADAPTIVE_SF
+    printAdaptiveSFStatus(adr);
+    #endif
+    #if ENABLE_TX_POWER_CONTROL
+    printTxPowerStatus(txPower);
+    #endif
+    #if ENABLE_SEND_ON_CHANGE
+    Serial.print("Uplinks: ");
+    Serial.print(uplinkPolicy.events);
+    Serial.print(" events, ");
+    Serial.print(uplinkPolicy.heartbeats);
+    Serial.print(" heartbeats (every ");
+    Serial.print(HEARTBEAT_INTERVAL / 1000);
+    Serial.println(" s)");
+    #endif
+    #if ENABLE_TX_MAC
+    Serial.print("MAC backoffs: ");
+    Serial.print(txMac.backoffs);
+    Serial.print(" (");
+    Serial.print(txMac.backoffMs);
+    Serial.print(" ms)");
+    #if ENABLE_MAC_TDMA
+    Serial.print(", TDMA: ");
+    Serial.print(txMac.tdmaSynced ? "in slot" : "searching");
+    Serial.print(", last shift ");
+    Serial.print(txMac.tdmaLastShift);
+    Serial.print(" ms");
+    #endif
+    Serial.println();
+    #endif
+    #if ENABLE_RELIABLE_LINK
+    Serial.print("Reliable: ");
+    Serial.print(relTx.delivered);
+    Serial.print("/");
+    Serial.print(relTx.queued);
+    Serial.print(" delivered, pending: ");
+    Serial.print(relTx.count);
+    Serial.print(", retx: ");
+    Serial.print(relTx.retransmits);
+    Serial.print(", failed: ");
+    Serial.println(relTx.failed);
+    #endif
+    txqPrintStatus(txQueue, alertTargetMs());
   }
+  #if ENABLE_ENCRYPTION
+  printEncryptionStats(loraEnc, loraParams, TELEMETRY_FRAME_MAX);
+  #endif
 
   Serial.print("Local LED: ");
   Serial.print(local.ledState);
   Serial.print(", Touch: ");
   Serial.println(local.touchState);
+  #if ENABLE_TASK_SPLIT
+  Serial.println("Tasks:");
+  printTaskStats(radioTaskStats);
+  printTaskStats(sensorTaskStats);
+  printTaskStats(uiTaskStats);
+  Serial.print("  sensor queue dropped ");
+  Serial.print(sensorEvents.dropped);
+  Serial.print(", snapshot retries ");
+  Serial.println(uiState.retries);
+  #else
+  printIdleStats(loopIdle);
+  #endif
+  printTimerWheelStats(timers);
   Serial.println("============================");
 }
 
+// =============== SENSING AND UI ================================
+// Run in loop(), or in their own tasks with ENABLE_TASK_SPLIT (task_split.h)
+
+// Touch sample every 200 ms
+void sampleTouch() {
+  if (millis() - timing.lastSensor < 200) return;
+  timing.lastSensor = millis();
+  unsigned long value = touchRead(TOUCH_PIN);
+  bool touched = (value <= 500);
+  #if ENABLE_TASK_SPLIT
+    SensorEvent event = {SENSOR_EVENT_TOUCH, touched, false, false, value};
+    spscPush(sensorEvents, event);  // Full: the next sample follows in 200 ms
+  #else
+    local.touchValue = value;
+    local.touchState = touched;
+  #endif
+}
+
+void sensorStep() {
+  sampleTouch();
+
+  #if ENABLE_BATTERY_MONITOR || ENABLE_CURRENT_MONITOR
+    checkSensors();  // Unified battery + current monitoring
+  #endif
+
+  #if ENABLE_AUDIO_DETECTION || ENABLE_LIGHT_DETECTION
+    checkFireAlarm();  // Unified audio + light detection
+  #endif
+
+  #if ENABLE_TASK_SPLIT && ENABLE_TX_POWER_CONTROL
+    if (!bRECEIVER && !bRELAY) txPowerSampleCurrent();
+  #endif
+}
+
+// Copy of what the LCD and the display station show
+void takeUiSnapshot(UiSnapshot& ui) {
+  ui.local = local;
+  ui.remote = remote;
+  ui.health = health;
+  #if ENABLE_GATEWAY_MODE
+    ui.nodesOnline = nodeTableOnline(nodeTable);
+    ui.nodeCount = nodeTable.count;
+  #else
+    ui.nodesOnline = 0;
+    ui.nodeCount = 0;
+  #endif
+}
+
+void uiStep(const UiSnapshot& ui) {
+  if (bRECEIVER) updateLCD(ui);
+  if (!bRELAY) sendDisplayUpdate(ui);  // Send update to display station (if enabled)
+}
+
+#if ENABLE_TASK_SPLIT
+// Radio task: sensor samples and fire alarms into the protocol state
+void applySensorEvents() {
+  SensorEvent event;
+  while (spscPop(sensorEvents, event)) {
+    switch (event.kind) {
+      case SENSOR_EVENT_TOUCH:
+        local.touchValue = event.value;
+        local.touchState = event.touchState;
+        break;
+      case SENSOR_EVENT_FIRE_ALARM:
+        #if ENABLE_AUDIO_DETECTION || ENABLE_LIGHT_DETECTION
+          queueFireAlert(event.audio, event.light, event.value);
+        #endif
+        break;
+      case SENSOR_EVENT_CURRENT:
+        #if ENABLE_TX_POWER_CONTROL
+          txPowerOnCurrent(event.onAir, event.milliamps, event.volts);
+        #endif
+        break;
+    }
+  }
+}
+
+void sensorTask(void* arg) {
+  TickType_t wake = xTaskGetTickCount();
+  for (;;) {
+    taskRunBegin(sensorTaskStats);
+    sensorStep();
+    taskRunEnd(sensorTaskStats);
+    taskWaitNext(wake, TASK_SENSOR_PERIOD_MS);
+  }
+}
+
+void uiTask(void* arg) {
+  TickType_t wake = xTaskGetTickCount();
+  UiSnapshot ui;
+  for (;;) {
+    taskRunBegin(uiTaskStats);
+    seqlockRead(uiState, ui);
+    uiStep(ui);
+    taskRunEnd(uiTaskStats);
+    taskWaitNext(wake, TASK_UI_PERIOD_MS);
+  }
+}
+
+// Called last in setup(): from here on loop() is the radio task only
+void startTasks() {
+  spscInit(sensorEvents);
+  seqlockInit(uiState);
+  UiSnapshot ui;
+  takeUiSnapshot(ui);
+  seqlockWrite(uiState, ui);
+
+  taskStatsInit(radioTaskStats, "radio", xPortGetCoreID(), TASK_RADIO_PERIOD_MS);
+  taskStatsInit(sensorTaskStats, "sensor", TASK_SENSOR_CORE, TASK_SENSOR_PERIOD_MS);
+  taskStatsInit(uiTaskStats, "ui", TASK_UI_CORE, TASK_UI_PERIOD_MS);
+
+  bool ok = taskStart(sensorTask, "sensor", TASK_SENSOR_STACK, 1, TASK_SENSOR_CORE) &&
+            taskStart(uiTask, "ui", TASK_UI_STACK, 1, TASK_UI_CORE);
+  Serial.print(ok ? "🧵 Tasks: radio core " : "❌ Task start failed - radio core ");
+  Serial.print(radioTaskStats.core);
+  Serial.print(", sensor core ");
+  Serial.print(TASK_SENSOR_CORE);
+  Serial.print(", ui core ");
+  Serial.println(TASK_UI_CORE);
+}
+#endif
+
+// =============== PERIODIC JOBS ================================
+// Timers in the wheel (timer_wheel.h); loop() only runs what is due
+
+void printHealthReports() {
+  #if ENABLE_GATEWAY_MODE
+    printNodeTable(nodeTable);
+  #else
+    printHealthReport(health, remote);
+  #endif
+  printLinkRecoveryStats(linkRecovery);
+}
+
+// PC data logging (both roles)
+void printDataOutput() {
+  #if ENABLE_CSV_OUTPUT
+    printDataCSV();
+    #if ENABLE_GATEWAY_MODE
+      if (bRECEIVER) printNodeTableCSV(nodeTable);
+    #endif
+  #endif
+
+  #if ENABLE_JSON_OUTPUT
+    printDataJSON();
+  #endif
+}
+
+void onSpinnerTimer(void* ctx) { updateSpinner(); }
+void onStatusTimer(void* ctx) { printStatus(); }
+void onHealthReportTimer(void* ctx) { printHealthReports(); }
+void onDataOutputTimer(void* ctx) { printDataOutput(); }
+#if ENABLE_PACKET_STATS
+void onPacketStatsTimer(void* ctx) { printDetailedReport(health); }
+#endif
+
+#if !ENABLE_TASK_SPLIT
+void onTouchTimer(void* ctx) { sampleTouch(); }
+#if ENABLE_BATTERY_MONITOR || ENABLE_CURRENT_MONITOR
+void onSensorsTimer(void* ctx) { checkSensors(); }
+#endif
+#if ENABLE_AUDIO_DETECTION || ENABLE_LIGHT_DETECTION
+void onFireAlarmTimer(void* ctx) { checkFireAlarm(); }
+#endif
+
+void onUiTimer(void* ctx) {
+  UiSnapshot ui;
+  takeUiSnapshot(ui);
+  uiStep(ui);
+}
+#endif
+
+// End of setup(): reports start one period later, like the millis()
+// checks they replace; sensing and UI run in the first loop()
+void startTimers() {
+  timerWheelInit(timers);
+  idleStatsInit(loopIdle);
+
+  timerAdd(timers, "spinner", 150, 150, onSpinnerTimer);
+  timerAdd(timers, "status", 5000, 5000, onStatusTimer);
+  if (bRECEIVER) timerAdd(timers, "health", 30000, 30000, onHealthReportTimer);
+  timerAdd(timers, "data out", DATA_OUTPUT_INTERVAL, DATA_OUTPUT_INTERVAL, onDataOutputTimer);
+  #if ENABLE_PACKET_STATS
+    if (bRECEIVER) {
+      timerAdd(timers, "pkt stats", PACKET_STATS_INTERVAL, PACKET_STATS_INTERVAL, onPacketStatsTimer);
+    }
+  #endif
+
+  #if !ENABLE_TASK_SPLIT
+    timerAdd(timers, "touch", 0, 200, onTouchTimer);
+    #if ENABLE_BATTERY_MONITOR || ENABLE_CURRENT_MONITOR
+      timerAdd(timers, "sensors", 0, 1000, onSensorsTimer);  // Own intervals inside
+    #endif
+    #if ENABLE_AUDIO_DETECTION || ENABLE_LIGHT_DETECTION
+      timerAdd(timers, "fire alarm", 0, FIRE_ALARM_POLL_MS, onFireAlarmTimer);
+    #endif
+    // Receiver redraws the LCD, the sender only feeds the display station
+    if (bRECEIVER) timerAdd(timers, "ui", 0, 100, onUiTimer);
+    else if (!bRELAY) timerAdd(timers, "ui", 0, DISPLAY_UPDATE_INTERVAL, onUiTimer);
+  #endif
+
+  #if ENABLE_IDLE_SLEEP
+    idleSleepBegin();
+  #endif
+}
+
+// Radio mid-exchange: poll at IDLE_BUSY_POLL_MS as before
+bool radioBusy() {
+  if (!atIsIdle(loraAT) || loraRxPending || txInFlight) return true;
+  if (ackSlotBusy(ackSlot) || ackSchedule.pending) return true;
+  if (txQueue.count > 0 || linkRecoveryActive(linkRecovery)) return true;
+  #if ENABLE_RELAY
+    if (relayQueue.count > 0) return true;
+  #endif
+  #if ENABLE_FEC
+    if (loraFecParityDue()) return true;
+  #endif
+  #if ENABLE_ADAPTIVE_SF
+    if (adr.phase == ADR_ACCEPTING) return true;
+  #endif
+  return false;
+}
+
+// Sender: ms until the next telemetry uplink may go (touch changes come
+// from the touch timer, which wakes loop() anyway)
+unsigned long uplinkWaitMs() {
+  unsigned long now = millis();
+  long wait;
+  #if ENABLE_TELEMETRY_BATCH
+    wait = (long)(timing.lastSend + BATCH_SAMPLE_INTERVAL - now);
+  #elif ENABLE_TX_MAC
+    wait = (long)(txMac.nextSend - now);
+  #elif ENABLE_SEND_ON_CHANGE
+    wait = (long)(uplinkPolicy.lastSend + HEARTBEAT_INTERVAL - now);
+  #else
+    wait = (long)(timing.lastSend + SEND_INTERVAL - now);
+  #endif
+  return wait > 0 ? wait : 0;
+}
+
+// ms from now until `at` (0 = due)
+unsigned long waitUntil(unsigned long at, unsigned long now) {
+  long wait = (long)(at - now);
+  return wait > 0 ? wait : 0;
+}
+
+// Next WEAK/LOST step of a link without new messages (TIMER_NEVER: LOST)
+unsigned long watchdogWaitMs(const DeviceState& link, unsigned long now) {
+  unsigned long since = now - link.lastMessageTime;
+  if (since <= watchdogWeakTimeout(link)) {
+    return waitUntil(link.lastMessageTime + watchdogWeakTimeout(link) + 1, now);
+  }
+  if (since <= watchdogLostTimeout(link)) {
+    return waitUntil(link.lastMessageTime + watchdogLostTimeout(link) + 1, now);
+  }
+  return TIMER_NEVER;
+}
+
+// ms until one of the protocol timeouts loop() checks falls due: beacon,
+// watchdog and recovery attempt, ADR verify/fallback (receiver), reliable
+// retry and idle current reading (sender). They live in their modules'
+// state, so they are read from there like uplinkWaitMs() does
+unsigned long protocolWaitMs() {
+  unsigned long now = millis();
+  unsigned long wait = TIMER_NEVER;
+
+  if (bRECEIVER) {
+    #if ENABLE_TIME_SYNC
+      wait = min(wait, waitUntil(lastBeacon + BEACON_INTERVAL, now));
+    #endif
+
+    wait = min(wait, watchdogWaitMs(remote, now));
+    if (health.state == CONN_LOST) {
+      unsigned long interval = watchdogCfg.recoveryInterval;
+      if (health.recoveryAttempts >= watchdogCfg.maxRecoveryAttempts && interval < 60000) {
+        interval = 60000;  // Background retries (attemptRecovery())
+      }
+      wait = min(wait, waitUntil(health.lastRecoveryAttempt + interval, now));
+    }
+    #if ENABLE_GATEWAY_MODE
+      for (uint8_t i = 0; i < nodeTable.count; i++) {
+        wait = min(wait, watchdogWaitMs(nodeTable.nodes[i].state, now));
+      }
+    #endif
+
+    #if ENABLE_ADAPTIVE_SF
+      if ((adr.phase == ADR_PROPOSED && !adr.commandDue) || adr.phase == ADR_VERIFY) {
+        wait = min(wait, waitUntil(adr.phaseSince + ADR_VERIFY_MS + 1, now));
+      } else if (adr.phase == ADR_IDLE && adr.sf != SF_MAX) {
+        wait = min(wait, waitUntil(remote.lastMessageTime + ADR_FALLBACK_MS + 1, now));
+      }
+    #endif
+  } else if (!bRELAY) {
+    #if ENABLE_RELIABLE_LINK
+      for (uint8_t i = 0; i < relTx.count; i++) {
+        const RelEntry& e = relEntry(relTx, i);
+        if (e.done) continue;
+        if (e.gap || e.tries == 0) return 0;
+        wait = min(wait, waitUntil(e.sentAt + REL_RETRY_MS, now));
+      }
+    #endif
+
+    #if ENABLE_TX_POWER_CONTROL && ENABLE_CURRENT_MONITOR
+      wait = min(wait, waitUntil(txPowerIdleAt + 1000, now));
+    #endif
+  }
+  return wait;
+}
+
+// How long loop() may sleep: next timer, uplink or protocol timeout,
+// at most IDLE_MAX_SLEEP_MS
+unsigned long loopSleepMs() {
+  #if ENABLE_IDLE_SLEEP && LORA_RX_UART_EVENT
+    if (radioBusy()) return IDLE_BUSY_POLL_MS;
+    unsigned long wait = timerWheelNextMs(timers);
+    if (wait > IDLE_MAX_SLEEP_MS) wait = IDLE_MAX_SLEEP_MS;
+    if (!bRECEIVER && !bRELAY) {
+      unsigned long uplink = uplinkWaitMs();
+      if (uplink < wait) wait = uplink;
+    }
+    // Due but held back (duty cycle, radio not free yet): poll as busy
+    unsigned long protocol = protocolWaitMs();
+    if (protocol < wait) wait = protocol > 0 ? protocol : IDLE_BUSY_POLL_MS;
+    return wait;
+  #else
+    return 10;  // No UART wakeup on older cores: fixed poll as before
+  #endif
+}
+
+// =============== SLEEPING SENDER ================================
+#if ENABLE_SLEEP_SENDER
+#if ENABLE_CURRENT_MONITOR
+// The INA219 slept too: the sleep is booked at SLEEP_CURRENT_UA, not
+// integrated at the last awake reading
+void sleepCurrentMonitorWake(unsigned long sleepMs) {
+  current.energyUsed_mAh += SLEEP_CURRENT_UA / 1000.0f * sleepMs / 3600000.0f;
+  current.lastCheck = 0;  // First reading at once
+}
+#endif
+
+// Deep-sleep wake, before the radio starts: SF, duty cycle, AES counter
+// (the module itself kept its settings in AT+MODE=1)
+void sleepRestoreRadio() {
+  const SleepRetained& r = sleepRtc;
+  loraParams = r.params;
+  loraDutyCycle = r.dutyCycle;
+  sleepRebase(loraDutyCycle.lastRefill, r);  // Refilled for the time asleep
+  #if ENABLE_ENCRYPTION
+    if (r.encReady) {
+      encResume(loraEnc, loraEncKey, MY_LORA_ADDRESS, LORA_NETWORK_ID,
+                r.encTxCounter, r.encTxReserved);
+    }
+  #endif
+}
+
+// Deep-sleep wake, end of setup(): over what the modules just initialized
+void sleepRestoreState() {
+  const SleepRetained& r = sleepRtc;
+  local = r.local;
+  sleepRebase(local.lastMessageTime, r);
+  #if ENABLE_ADAPTIVE_SF
+    adr = r.adr;
+    sleepRebase(adr.phaseSince, r);
+    sleepRebase(adr.lastChange, r);
+  #endif
+  #if ENABLE_TX_POWER_CONTROL
+    txPower = r.txPower;
+    sleepRebase(txPower.lastChange, r);
+  #endif
+  #if ENABLE_PACKET_STATS || ENABLE_EXTENDED_TELEMETRY
+    pktStats = r.pktStats;
+    sleepRebase(pktStats.lastPacketTime, r);
+    sleepRebase(pktStats.lastReport, r);
+  #endif
+  #if ENABLE_CURRENT_MONITOR
+    current = r.current;
+    sleepRebase(current.lastReset, r);
+    sleepCurrentMonitorWake(r.sleepMs);
+  #endif
+}
+
+void sleepSave(unsigned long sleepMs) {
+  SleepRetained& r = sleepRtc;
+  r.savedAtMs = millis();
+  r.sleepMs = sleepMs;
+  r.local = local;
+  r.params = loraParams;
+  r.dutyCycle = loraDutyCycle;
+  #if ENABLE_ENCRYPTION
+    r.encReady = loraEnc.ready;
+    r.encTxCounter = loraEnc.txCounter;
+    r.encTxReserved = loraEnc.txReserved;
+  #endif
+  #if ENABLE_ADAPTIVE_SF
+    r.adr = adr;
+  #endif
+  #if ENABLE_TX_POWER_CONTROL
+    r.txPower = txPower;
+  #endif
+  #if ENABLE_PACKET_STATS || ENABLE_EXTENDED_TELEMETRY
+    r.pktStats = pktStats;
+  #endif
+  #if ENABLE_CURRENT_MONITOR
+    r.current = current;
+  #endif
+}
+
+// Book the cycle and sleep. Deep sleep ends in setup(); light sleep
+// returns here and starts the next cycle.
+void sleepNow() {
+  unsigned long awakeMs = millis() - sleepCycle.startMs;
+  unsigned long sleepMs = sleepDurationMs(awakeMs);
+  sleepBook(sleepRtc, sleepCycle, loraParams.sf, awakeMs, sleepMs);
+
+  Serial.print("😴 Cycle ");
+  Serial.print(sleepRtc.cycles);
+  Serial.print(": awake ");
+  Serial.print(awakeMs);
+  Serial.print(" ms (");
+  Serial.print(sleepCycle.awake_mAh * 1000.0f, 1);
+  Serial.print(" µAh), sleeping ");
+  Serial.print(sleepMs);
+  Serial.println(" ms");
+  if (sleepRtc.cycles % SLEEP_REPORT_CYCLES == 0) printSleepEnergy(sleepRtc);
+
+  #if ENABLE_CURRENT_MONITOR
+    ina219.powerSave(true);
+  #endif
+  #if SLEEP_LIGHT
+    sleepEnter(sleepMs);
+    #if ENABLE_CURRENT_MONITOR
+      ina219.powerSave(false);
+      sleepCurrentMonitorWake(sleepMs);
+    #endif
+    if (!sleepRadioWake()) Serial.println("⚠️  LoRa: no answer to AT+MODE=0");
+    sleepCycleInit(sleepCycle);
+  #else
+    sleepSave(sleepMs);
+    sleepEnter(sleepMs);
+  #endif
+}
+
+// Sender, every loop(): sleep once the uplink is answered and the radio
+// is idle (ACK slot closed, alerts sent, ADR switch done), or after
+// SLEEP_MAX_AWAKE_MS whatever is left
+void sleepPoll() {
+  sleepSampleCurrent(sleepCycle);
+  bool overdue = millis() - sleepCycle.startMs >= SLEEP_MAX_AWAKE_MS;
+
+  if (sleepCycle.phase == SLEEP_AWAKE) {
+    bool done = sleepCycle.uplinkDone || txDeferred;  // Deferred: next wake
+    bool idle = !txInFlight && !ackSlotBusy(ackSlot) && atIsIdle(loraAT) && txQueue.count == 0;
+    #if ENABLE_ADAPTIVE_SF
+      idle = idle && adr.phase != ADR_ACCEPTING;
+    #endif
+    if (done && idle) {
+      sleepRadioOff(sleepCycle);
+    } else if (overdue) {
+      Serial.println("⚠️  Sleep: awake limit reached - sleeping anyway");
+      sleepRadioOff(sleepCycle);
+    }
+  } else if (sleepCycle.phase == SLEEP_READY) {
+    sleepNow();
+  }
+}
+#endif
+
 // =============== SETUP ================================
 void setup() {
+  bootInit(boot);
   Serial.begin(115200);
-  delay(2000);
+  #if !ENABLE_FAST_BOOT
+    delay(2000);
+  #endif
+  bootMark(boot, BOOT_SERIAL);
 
-  Serial.println("\n\n\n");
-  Serial.println("╔════════════════════════════╗");
-  Serial.println("║  ZignalMeister 2000        ║");
-  Serial.println("╚════════════════════════════╝");
+  #if ENABLE_SLEEP_SENDER
+    // Awake time of this cycle counts from here
+    sleepCycleInit(sleepCycle);
+    if (!sleepRetainedValid(sleepRtc)) sleepRetainedInit(sleepRtc);
+    else sleepWoke = sleepTimerWake();
+  #endif
+
+  if (!sleepWoke) {
+    Serial.println("\n\n\n");
+    Serial.println("╔════════════════════════════╗");
+    Serial.println("║  ZignalMeister 2000        ║");
+    Serial.println("╚════════════════════════════╝");
+  }
 
   // Initialize kill-switch first
   initKillSwitch();
@@ -496,77 +2035,165 @@ void setup() {
   // Auto-detect role
   pinMode(MODE_GND_PIN, OUTPUT);
   digitalWrite(MODE_GND_PIN, LOW);
+  #if ENABLE_RELAY
+    // Relay: GPIO16 tied to 3V3 reads HIGH even against the pull-down
+    pinMode(MODE_SELECT_PIN, INPUT_PULLDOWN);
+    delay(BOOT_SETTLE_MS);
+    bRELAY = (digitalRead(MODE_SELECT_PIN) == HIGH);
+  #endif
   pinMode(MODE_SELECT_PIN, INPUT_PULLUP);
-  delay(100);
+  delay(BOOT_SETTLE_MS);
   
   bRECEIVER = (digitalRead(MODE_SELECT_PIN) == LOW);
+  bootMark(boot, BOOT_ROLE);
 
   // ============================================
   // DEBUG: Show pin state and role detection
   // ============================================
-  Serial.println("\n╔════════════════════════════╗");
-  Serial.println("║   MODE DETECTION DEBUG    ║");
-  Serial.println("╠════════════════════════════╣");
-  Serial.print("║ MODE_GND_PIN (");
-  Serial.print(MODE_GND_PIN);
-  Serial.println(") -> LOW     ║");
-  Serial.print("║ MODE_SELECT_PIN (");
-  Serial.print(MODE_SELECT_PIN);
-  Serial.print("): ");
-  int pinReading = digitalRead(MODE_SELECT_PIN);
-  if (pinReading == LOW) {
-    Serial.println("LOW  ║");
-  } else {
-    Serial.println("HIGH ║");
+  if (!sleepWoke) {
+    Serial.println("\n╔════════════════════════════╗");
+    Serial.println("║   MODE DETECTION DEBUG    ║");
+    Serial.println("╠════════════════════════════╣");
+    Serial.print("║ MODE_GND_PIN (");
+    Serial.print(MODE_GND_PIN);
+    Serial.println(") -> LOW     ║");
+    Serial.print("║ MODE_SELECT_PIN (");
+    Serial.print(MODE_SELECT_PIN);
+    Serial.print("): ");
+    int pinReading = digitalRead(MODE_SELECT_PIN);
+    if (pinReading == LOW) {
+      Serial.println("LOW  ║");
+    } else {
+      Serial.println("HIGH ║");
+    }
+    Serial.println("╚════════════════════════════╝");
   }
-  Serial.println("╚════════════════════════════╝");
 
   if (bRECEIVER) {
     Serial.println("\n>>> RECEIVER MODE");
     Serial.println(">>> Expected: GPIO 16 connected to GPIO 17 (jumper wire)");
     MY_LORA_ADDRESS = LORA_RECEIVER_ADDRESS;
-    TARGET_LORA_ADDRESS = LORA_SENDER_ADDRESS;
+    TARGET_LORA_ADDRESS = LORA_SENDER_ADDRESS;  // Gateway: ACK goes to each packet's sender
+  } else if (bRELAY) {
+    Serial.println("\n>>> RELAY MODE");
+    Serial.println(">>> Expected: GPIO 16 connected to 3V3 (jumper wire)");
+    MY_LORA_ADDRESS = LORA_RELAY_ADDRESS;
+    TARGET_LORA_ADDRESS = RELAY_NEXT_HOP;
   } else {
     Serial.println("\n>>> SENDER MODE");
     Serial.println(">>> Expected: GPIO 16 floating (no connection)");
-    MY_LORA_ADDRESS = LORA_SENDER_ADDRESS;
-    TARGET_LORA_ADDRESS = LORA_RECEIVER_ADDRESS;
-  }
-
-  Serial.println("\n╔════════════════════════════╗");
-  Serial.println("║   LoRa CONFIGURATION      ║");
-  Serial.println("╠════════════════════════════╣");
-  Serial.print("║ My Address:     ");
-  Serial.print(MY_LORA_ADDRESS);
-  Serial.println("          ║");
-  Serial.print("║ Target Address: ");
-  Serial.print(TARGET_LORA_ADDRESS);
-  Serial.println("          ║");
-  Serial.print("║ Network ID:     ");
-  Serial.print(LORA_NETWORK_ID);
-  Serial.println("          ║");
-  Serial.println("╚════════════════════════════╝");
+    MY_LORA_ADDRESS = senderAddress();
+    TARGET_LORA_ADDRESS = LORA_UPLINK_VIA ? LORA_UPLINK_VIA : LORA_RECEIVER_ADDRESS;
+  }
+  if (bRECEIVER || bRELAY) sleepWoke = false;  // Jumper changed while asleep
+
+  if (!sleepWoke) {
+    Serial.println("\n╔════════════════════════════╗");
+    Serial.println("║   LoRa CONFIGURATION      ║");
+    Serial.println("╠════════════════════════════╣");
+    Serial.print("║ My Address:     ");
+    Serial.print(MY_LORA_ADDRESS);
+    Serial.println("          ║");
+    Serial.print("║ Target Address: ");
+    Serial.print(TARGET_LORA_ADDRESS);
+    Serial.println("          ║");
+    Serial.print("║ Network ID:     ");
+    Serial.print(LORA_NETWORK_ID);
+    Serial.println("          ║");
+    Serial.println("╚════════════════════════════╝");
+  }
   
   // Initialize pins
   pinMode(LED_PIN, OUTPUT);
   
   // Initialize structs
-  // DeviceState: ledState, ledCount, touchState, touchValue, messageCount, lastMessageTime, sequenceNumber, spinnerIndex, rssi, snr
-  local = {LOW, 0, false, 0, 0, 0, 0, 0, 0, 0};   // 10 fields - added snr
-  remote = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};         // 10 fields - added snr
-  timing = {0, 0, 0, 0, 0, 0, 0, 0};               // 8 fields
+  // DeviceState: ledState, ledCount, touchState, touchValue, messageCount, lastMessageTime, sequenceNumber, keepaliveMs, spinnerIndex, rssi, snr
+  local = {LOW, 0, false, 0, 0, 0, 0, 0, 0, 0, 0};   // 11 fields - added keepaliveMs
+  remote = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};         // 11 fields - added keepaliveMs
+  timing = {0, 0, 0, 0, 0};                           // 5 fields
   spinner = {{'<', '^', '>', 'v'}, 0, 0};
   
   // Initialize health monitor (BOTH roles - needed for PC data logging!)
   initHealthMonitor(health);
+  linkRecoveryInit(linkRecovery);
+
+  ackSlotInit(ackSlot, ACK_SLOT_OFFSET, ACK_LENGTH_GUESS);
+  ackScheduleInit(ackSchedule, ACK_SLOT_OFFSET);
+  ackAddress = TARGET_LORA_ADDRESS;
+
+  #if ENABLE_TIME_SYNC
+    timeSyncInit(timeSync);
+  #endif
+
+  #if ENABLE_TX_MAC
+    #if ENABLE_MAC_TDMA
+      macInit(txMac, TDMA_FRAME_MS, millis());
+      // Slot holds uplink, ACK offset and ACK - otherwise neighbours collide
+      uint32_t slotNeed = loraAirtimeMs(loraUplinkLength(TELEMETRY_FRAME_MAX)) +
+                          ACK_SLOT_OFFSET + loraAirtimeMs(TELEMETRY_FRAME_MAX) + ACK_SLOT_GUARD;
+      if (slotNeed > TDMA_SLOT_MS) {
+        Serial.print("⚠️  TDMA_SLOT_MS too short for this SF: need ");
+        Serial.print(slotNeed);
+        Serial.println(" ms");
+      }
+    #elif ENABLE_TELEMETRY_BATCH
+      macInit(txMac, 0, millis());  // Batches go when full - MAC adds backoff only
+    #elif ENABLE_SEND_ON_CHANGE
+      macInit(txMac, HEARTBEAT_INTERVAL, millis());  // Heartbeats only
+    #else
+      macInit(txMac, SEND_INTERVAL, millis());
+    #endif
+  #endif
+
+  #if ENABLE_SEND_ON_CHANGE
+    uplinkPolicyInit(uplinkPolicy, local, millis());
+  #endif
+
+  #if ENABLE_GATEWAY_MODE
+    nodeTableInit(nodeTable);
+  #endif
+
+  #if ENABLE_RELAY
+    relayQueueInit(relayQueue);
+    relayCacheInit(loraRelayCache);
+  #endif
+
+  txqInit(txQueue);
+
+  #if ENABLE_RELIABLE_LINK
+    relSenderInit(relTx, (uint8_t)esp_random());  // New session every boot
+    relReceiverInit(relRx);
+  #endif
+
+  #if ENABLE_TELEMETRY_BATCH
+    batchInit(batch, BATCH_FIELDS);
+    // Packets arrive once per batch, not every 2 s
+    watchdogCfg.weakTimeout += BATCH_MAX_LATENCY;
+    watchdogCfg.lostTimeout += 2 * BATCH_MAX_LATENCY;
+  #endif
+
+  bootMark(boot, BOOT_STATE);
 
   // Initialize LoRa
-  if (!initLoRa(MY_LORA_ADDRESS, LORA_NETWORK_ID)) {
-    Serial.println("\n❌ LoRa init failed!");
-    Serial.println("⚠️  Continuing anyway - kill-switch still works!");
-    Serial.println("💡 Connect GPIO 13↔14 and hold 3s to restart\n");
-    // Don't freeze - let kill-switch work even if LoRa fails!
-  }
+  #if ENABLE_SLEEP_SENDER
+    if (sleepWoke) {
+      sleepRestoreRadio();  // SF, duty cycle, AES counter from RTC memory
+      sleepRadioStart(boot, MY_LORA_ADDRESS, LORA_NETWORK_ID);
+    } else {
+      bootRadioStart(boot, MY_LORA_ADDRESS, LORA_NETWORK_ID);
+    }
+  #elif ENABLE_FAST_BOOT
+    // Settings are read back in the AT queue while the rest starts
+    bootRadioStart(boot, MY_LORA_ADDRESS, LORA_NETWORK_ID);
+  #else
+    if (!initLoRa(MY_LORA_ADDRESS, LORA_NETWORK_ID)) {
+      Serial.println("\n❌ LoRa init failed!");
+      Serial.println("⚠️  Continuing anyway - kill-switch still works!");
+      Serial.println("💡 Connect GPIO 13↔14 and hold 3s to restart\n");
+      // Don't freeze - let kill-switch work even if LoRa fails!
+    }
+    bootMark(boot, BOOT_RADIO_READY);
+  #endif
 
   // LCD for receiver
   if (bRECEIVER) {
@@ -574,24 +2201,38 @@ void setup() {
     // Initialize lastMessageTime to current time to prevent false "NO SIGNAL" at startup
     remote.lastMessageTime = millis();
   }
+  bootRadioPoll(boot);
 
   // Display station (UART-based, works for both sender and receiver)
   initDisplaySender();
+  bootRadioPoll(boot);
 
   // Feature modules initialization - Refactored to use wrapper modules
   #if ENABLE_BATTERY_MONITOR || ENABLE_CURRENT_MONITOR
     initSensors();  // Unified battery + current monitoring
+    bootRadioPoll(boot);
   #endif
 
   #if ENABLE_AUDIO_DETECTION || ENABLE_LIGHT_DETECTION
     initFireAlarmDetector();  // Unified audio + light detection
+    bootRadioPoll(boot);
   #endif
 
   #if ENABLE_PACKET_STATS || ENABLE_EXTENDED_TELEMETRY
     initDetailedTelemetry();  // Unified packet stats + system telemetry
   #endif
+  bootMark(boot, BOOT_PERIPHERALS);
+
+  #if ENABLE_FAST_BOOT
+    // Nothing may reach AT+SEND before the module is verified
+    if (!bootRadioFinish(boot)) {
+      Serial.println("\n❌ LoRa check failed - the watchdog retries (receiver)");
+      Serial.println("💡 Connect GPIO 13↔14 and hold 3s to restart\n");
+    }
+  #endif
 
   #if ENABLE_MANUAL_AT_COMMANDS
+  if (!sleepWoke) {
     Serial.println("\n🛠️  Manual AT Commands: ENABLED");
     Serial.println("   Type AT commands in Serial Monitor to test LoRa module:");
     Serial.println("   - AT (test connection)");
@@ -600,68 +2241,415 @@ void setup() {
     Serial.println("   - AT+NETWORKID? (get network ID)");
     Serial.println("   - AT+PARAMETER? (get LoRa parameters)");
     Serial.println("   - AT+RESET (reset module)");
+  }
+  #endif
+
+  #if ENABLE_ADAPTIVE_SF
+    adrInit(adr, loraParams.sf);  // Both ends start (and fall back) at SF12
+  #endif
+
+  #if ENABLE_TX_POWER_CONTROL
+    txPowerInit(txPower);
+    if (!bRECEIVER && !bRELAY && !sleepWoke) {  // A sleeping module keeps its power
+      char cmd[16];
+      snprintf(cmd, sizeof(cmd), "AT+CRFOP=%d", TXP_MAX_DBM);
+      atEnqueue(loraAT, cmd, 1000);  // Start from full power
+    }
+  #endif
+
+  // First uplink in the first loop(), not SEND_INTERVAL after boot
+  timing.lastSend = millis() - SEND_INTERVAL;
+
+  #if ENABLE_SLEEP_SENDER
+    if (sleepWoke) sleepRestoreState();  // Over what the modules just initialized
+  #endif
+
+  #if ENABLE_TASK_SPLIT
+    startTasks();
   #endif
+  startTimers();
 
-  Serial.println("\n✓ Setup complete!\n");
+  bootMark(boot, BOOT_SETUP_DONE);
+  if (!sleepWoke) {
+    printBootTimeline(boot);
+    Serial.println("\n✓ Setup complete!\n");
+  }
 }
 
 // =============== MANUAL AT COMMAND HANDLER ================================
 #if ENABLE_MANUAL_AT_COMMANDS
+void onManualATDone(ATResult result, const char* response, void* ctx) {
+  Serial.print("[AT] << ");
+  if (result == AT_RESULT_TIMEOUT) {
+    Serial.println("<no response>");
+  } else {
+    Serial.println(response);
+  }
+}
+
 void handleManualATCommands() {
   // Check if user typed something in Serial Monitor
   if (Serial.available()) {
     String command = Serial.readStringUntil('\n');
     command.trim();
 
+    // Remote command → reliable channel or priority queue, not the module
+    if (!bRECEIVER && !bRELAY && command.startsWith("CMD:")) {
+      Serial.print("\n[CMD] >> ");
+      Serial.println(command);
+      #if ENABLE_RELIABLE_LINK
+      bool queued = queueReliableCommand(command.c_str(), command.length());
+      #else
+      uint8_t frame[TXQ_FRAME_MAX];
+      bool queued = command.length() < TXQ_FRAME_MAX;
+      if (queued) {
+        frame[0] = FRAME_TYPE_COMMAND;
+        memcpy(frame + 1, command.c_str(), command.length());
+        queued = txqPush(txQueue, TXQ_COMMAND, frame, command.length() + 1, millis());
+      }
+      #endif
+      if (!queued) {
+        Serial.println("[CMD] << <queue full or too long>");
+      }
+      return;
+    }
+
     if (command.length() > 0) {
       Serial.print("\n[AT] >> ");
       Serial.println(command);
 
-      // Send command directly to LoRa module
-      String response = sendLoRaCommand(command, 2000);
-
-      Serial.print("[AT] << ");
-      if (response.length() > 0) {
-        Serial.println(response);
-      } else {
-        Serial.println("<no response>");
+      // Queue command - answer is printed by onManualATDone()
+      if (!atEnqueue(loraAT, command.c_str(), command.length(), 2000, onManualATDone)) {
+        Serial.println("[AT] << <queue full>");
       }
     }
   }
 }
 #endif
 
+// =============== TRANSMIT COMPLETION CALLBACKS ================================
+
+// Sender telemetry: AT+SEND answered (+OK arrives after air time)
+void onTelemetrySent(ATResult result, const char* response, void* ctx) {
+  txInFlight = false;
+  #if ENABLE_SLEEP_SENDER
+    sleepCycle.uplinkDone = true;  // Failed too: the next wake tries again
+  #endif
+
+  if (result != AT_RESULT_OK) {
+    Serial.print("❌ LoRa send failed: ");
+    Serial.println(result == AT_RESULT_TIMEOUT ? "timeout" : response);
+    return;
+  }
+
+  local.messageCount++;
+  local.sequenceNumber++;  // Increment sequence number
+  bootFirstPacket(boot, "sent");
+  #if ENABLE_TX_POWER_CONTROL
+    txPowerUplinkDone();
+  #endif
+
+  // ACK requested: schedule the RX slot (advanced in loop(), never blocks)
+  if (txAckRequested) {
+    scheduleAckSlot(ackSlot.ackLength, ACK_LENGTH_MAX);
+  }
+}
+
+#if ENABLE_TELEMETRY_BATCH
+// Sender batch: samples leave the buffer only after +OK
+void onBatchSent(ATResult result, const char* response, void* ctx) {
+  txInFlight = false;
+
+  if (result != AT_RESULT_OK) {
+    batchAbort(batch);  // Retry with the next frame
+    Serial.print("❌ LoRa batch send failed: ");
+    Serial.println(result == AT_RESULT_TIMEOUT ? "timeout" : response);
+    return;
+  }
+
+  batchCommit(batch);
+  local.messageCount++;
+  bootFirstPacket(boot, "sent");
+  #if ENABLE_TX_POWER_CONTROL
+    txPowerUplinkDone();
+  #endif
+
+  if (txAckRequested) {
+    scheduleAckSlot(ackSlot.ackLength, ACK_LENGTH_MAX);
+  }
+}
+#endif
+
+#if ENABLE_FEC
+// Sender parity frame: AT+SEND answered (nothing to retry - best effort)
+void onParitySent(ATResult result, const char* response, void* ctx) {
+  txInFlight = false;
+  if (result != AT_RESULT_OK) {
+    Serial.println("❌ FEC parity send failed");
+  }
+}
+#endif
+
+// Receiver ACK: AT+SEND answered
+void onAckSent(ATResult result, const char* response, void* ctx) {
+  txInFlight = false;
+
+  if (result == AT_RESULT_OK) {
+    local.messageCount++;
+    local.sequenceNumber++;
+    Serial.println("✓ ACK sent");
+    #if ENABLE_ADAPTIVE_SF
+      if (ackAdrInFlight) adrCommandSent(adr);  // ACCEPT timeout starts now
+    #endif
+  } else {
+    Serial.println("❌ ACK send failed");
+  }
+}
+
+#if ENABLE_BIDIRECTIONAL
+// Receiver (and relay): send the pending ACK in its slot (no delay() -
+// loop keeps running)
+void pollScheduledAck() {
+  AckScheduleEvent ackEvent = ackSchedulePoll(ackSchedule, ACK_SLOT_GUARD);
+  #if ENABLE_RELAY
+  bool relayAck = ackRelay;
+  if (ackEvent != ACK_WAIT) ackRelay = false;
+  #endif
+  if (ackEvent == ACK_SEND_NOW) {
+    // ACK includes receiver's current state + slot offset
+    uint8_t ackPayload[LEGACY_PAYLOAD_MAX];
+    uint8_t ackLength;
+    #if ENABLE_RELAY
+    if (relayAck) {
+      ackLength = relayEncodeAck(ackPayload, ackRelaySource, ackRelaySeq);  // Hop confirmed
+    } else
+    #endif
+    #if ENABLE_RELIABLE_LINK
+    ReliableReceiver* ackRel = &relRx;
+    #if ENABLE_GATEWAY_MODE
+    NodeEntry* ackNode = nodeLookup(nodeTable, ackAddress);
+    if (ackNode) ackRel = &ackNode->rel;
+    #endif
+    if (ackRel->ackDue) {
+      ackLength = relEncodeAck(*ackRel, ackPayload);  // Bitmap of reliable seqs
+    } else
+    #endif
+    #if ENABLE_ADAPTIVE_SF
+    if (adr.commandDue) {
+      ackLength = adrEncode(ackPayload, FRAME_TYPE_ADR_CMD, adr.txid, adr.targetSF);
+    } else
+    #endif
+    ackLength = buildTelemetryPayload(ackPayload, FRAME_TYPE_ACK);
+    #if ENABLE_ADAPTIVE_SF
+      ackAdrInFlight = (ackPayload[0] == FRAME_TYPE_ADR_CMD);
+    #endif
+
+    Serial.print("📤 Sending ACK (#");
+    Serial.print(remote.messageCount);
+    Serial.println(")...");
+
+    if (sendLoRaMessage(ackPayload, ackLength, ackAddress, onAckSent)) {
+      txInFlight = true;
+    } else {
+      Serial.println("❌ ACK send failed");  // Queue full or duty cycle
+    }
+  } else if (ackEvent == ACK_DROPPED) {
+    // Sender's window already closed - a late ACK would only collide
+    Serial.println("⚠️  ACK slot missed - ACK dropped");
+  }
+}
+#endif
+
+// =============== RELAY ================================
+#if ENABLE_RELAY
+// Receiver/relay: an envelope (new or resent) arrived - confirm the hop
+// in its slot. Runs before the frame is looked at: a duplicate still
+// needs its RELAY_ACK.
+void scheduleRelayAck() {
+  if (!loraRelayAckDue) return;
+  loraRelayAckDue = false;
+  ackRelay = true;
+  ackRelaySource = loraRelayPath.source;
+  ackRelaySeq = loraRelayPath.seq;
+  ackAddress = loraRelayVia;
+  ackScheduleAt(ackSchedule, loraRxTime);
+}
+
+// Relay: forwarded frame left the air → RELAY_ACK slot
+void onRelaySent(ATResult result, const char* response, void* ctx) {
+  txInFlight = false;
+  if (result != AT_RESULT_OK) {
+    Serial.println("❌ Relay send failed");
+    relayOnAckMissed(relayQueue);  // Counts as a try
+    return;
+  }
+  local.messageCount++;
+  ackSlotSchedule(ackSlot, millis(), loraAirtimeMs(RELAY_ACK_LEN),
+                  loraAirtimeMs(RELAY_ACK_LEN), ACK_SLOT_GUARD);
+}
+
+// RELAY role: take frames in, forward them one hop, answer far senders
+void relayLoop() {
+  RcvView packet;
+  TelemetryFrame frame;
+  bool gotPacket = receiveLoRaPacket(remote, packet);
+  scheduleRelayAck();
+
+  uint8_t ackSource, ackSeq;
+  if (gotPacket && loraRxKind == FRAME_KIND_RELAY_ACK) {
+    // Next hop confirmed the frame in flight
+    if (relayDecodeAck(packet.data, packet.len, ackSource, ackSeq) &&
+        packet.sender == TARGET_LORA_ADDRESS && ackSlotMatch(ackSlot, 0, RELAY_ACK_LEN) &&
+        relayOnAck(relayQueue, ackSource, ackSeq)) {
+      Serial.print("✓ Hop ACK (node ");
+      Serial.print(ackSource);
+      Serial.print(", queued: ");
+      Serial.print(relayQueue.count);
+      Serial.println(")");
+    }
+  } else if (gotPacket && loraRxRelayed) {
+    // Upstream relay: one more hop (envelope was unwrapped on receive)
+    relayForward(relayQueue, loraRelayPath, packet.rssi);
+    printRelayPath(loraRelayPath, loraRelayVia, packet.rssi);
+  } else if (gotPacket) {
+    // Far sender: new envelope; its ACK request is answered here
+    relayWrap(relayQueue, packet.sender, (const uint8_t*)packet.data, packet.len, packet.rssi);
+    bool ackRequested = false;
+    if (loraRxKind == FRAME_KIND_BATCH) {
+      ackRequested = batchAckRequested(packet.data, packet.len);
+    } else if (loraRxKind == FRAME_KIND_TELEMETRY &&
+               decodeTelemetry(packet.data, packet.len, frame)) {
+      ackRequested = frame.ackRequest;
+    }
+    if (ackRequested) {
+      ackRelay = false;
+      ackAddress = packet.sender;
+      #if ENABLE_TX_POWER_CONTROL
+        ackLinkRssi = packet.rssi;  // Far sender's power loop sees hop 1
+        ackLinkSnr = packet.snr;
+      #endif
+      ackScheduleAt(ackSchedule, loraRxTime);
+    }
+  }
+
+  // Hop not confirmed: resend (or give up after RELAY_MAX_TRIES)
+  if (ackSlotPoll(ackSlot) == SLOT_EVENT_MISSED) {
+    Serial.println("⌛ Hop ACK slot closed - resend");
+    relayOnAckMissed(relayQueue);
+  }
+
+  pollScheduledAck();
+
+  // Oldest frame to the next hop once the radio is free (ACKs first -
+  // their slot is fixed)
+  RelayEntry* entry = relayFront(relayQueue);
+  if (entry && !txInFlight && !ackSlotBusy(ackSlot) && !ackSchedule.pending &&
+      loraCanSend(entry->len)) {
+    if (sendLoRaMessage(entry->data, entry->len, TARGET_LORA_ADDRESS, onRelaySent)) {
+      txInFlight = true;
+      entry->tries++;
+
+      // Toggle LED on every forward (synced with LoRa)
+      local.ledState = !local.ledState;
+      digitalWrite(LED_PIN, local.ledState);
+    }
+  }
+}
+#endif
+
 // =============== LOOP ================================
 void loop() {
+  #if ENABLE_TASK_SPLIT
+  taskRunBegin(radioTaskStats);
+  #endif
+
   // Check kill-switch every loop (highest priority!)
   checkKillSwitch();
 
+  // LoRa AT engine: UART bytes in, completions out (never blocks)
+  loraPoll();
+
   // Manual AT commands (for debugging LoRa module)
   #if ENABLE_MANUAL_AT_COMMANDS
   handleManualATCommands();
   #endif
 
-  // Spinner
-  updateSpinner();
+  // Spinner, sensors, LCD, status and reports: whatever timer is due
+  timerWheelRun(timers);
 
   // LED is now synced with LoRa transmission/reception (removed independent blink)
   // Sender: LED toggles when message sent
   // Receiver: LED toggles when message received
 
-  // Touch sensor
-  if (millis() - timing.lastSensor >= 200) {
-    timing.lastSensor = millis();
-    local.touchValue = touchRead(TOUCH_PIN);
-    local.touchState = (local.touchValue <= 500);
-  }
+  // Sensor task: its samples and alerts
+  #if ENABLE_TASK_SPLIT
+  applySensorEvents();
+  #endif
   
   // Role-specific
   if (bRECEIVER) {
     // RECEIVER: Listen
-    String payload;
-    if (receiveLoRaMessage(remote, payload)) {
-      parsePayload(payload);
-      remote.messageCount++;
+    RcvView packet;
+    bool received = false;
+    bool ackRequested = false;
+    bool gotPacket = receiveLoRaPacket(remote, packet);
+    #if ENABLE_RELAY
+    scheduleRelayAck();  // Relayed: the hop is confirmed, not the far sender
+    #endif
+
+    // Per-sender state: the single remote/health pair, or the node's entry
+    DeviceState* peer = &remote;
+    HealthMonitor* peerHealth = &health;
+    #if ENABLE_RELIABLE_LINK
+    ReliableReceiver* peerRel = &relRx;
+    #endif
+    #if ENABLE_GATEWAY_MODE
+    NodeEntry* node = gotPacket ? nodeFindOrAdd(nodeTable, packet.sender) : nullptr;
+    if (node) {
+      node->state.rssi = remote.rssi;
+      node->state.snr = remote.snr;
+      node->state.lastMessageTime = remote.lastMessageTime;
+      peer = &node->state;
+      peerHealth = &node->health;
+      #if ENABLE_RELIABLE_LINK
+      peerRel = &node->rel;
+      #endif
+    } else {
+      gotPacket = false;  // Table full - not answered, not tracked
+    }
+    #endif
+
+    if (gotPacket) {
+      bootFirstPacket(boot, "received");
+
+      // One table lookup per frame (frame_dispatch.h)
+      ReceiverRx rx = {packet, peer, peerHealth, nullptr, false, false};
+      #if ENABLE_RELIABLE_LINK
+      rx.peerRel = peerRel;
+      #endif
+      frameDispatch(receiverRoutes, loraRxKind, rx);
+      received = rx.received;
+      ackRequested = rx.ackRequested;
+      #if ENABLE_RELAY
+      if (loraRxRelayed) {
+        ackRequested = false;  // First relay has answered the far sender
+        printRelayPath(loraRelayPath, loraRelayVia, packet.rssi);
+      }
+      #endif
+    }
+
+    if (received) {
+      peer->messageCount++;
+      #if ENABLE_GATEWAY_MODE
+        // LCD and display station show the sender heard last
+        remote.sequenceNumber = peer->sequenceNumber;
+        remote.ledState = peer->ledState;
+        remote.touchState = peer->touchState;
+        remote.spinnerIndex = peer->spinnerIndex;
+        remote.keepaliveMs = peer->keepaliveMs;
+        remote.messageCount++;
+        updateRSSI(*peerHealth, peer->rssi);
+      #endif
 
       // Toggle LED on message reception (synced with LoRa)
       local.ledState = !local.ledState;
@@ -669,161 +2657,256 @@ void loop() {
       local.ledCount++;
       if (local.ledCount >= 80) local.ledCount = 0;
 
-      // Update health monitoring
+      // Update health monitoring (packets tracked per sample above)
       updateRSSI(health, remote.rssi);
-      trackPacket(health, remote.sequenceNumber);
+
+      #if ENABLE_ADAPTIVE_SF
+        adrOnUplink(adr, packet.snr, health);  // SNR window, confirms a new SF
+      #endif
 
       // Record packet in detailed telemetry (SNR, timing, etc.)
       #if ENABLE_PACKET_STATS
         recordPacketReceived(remote.rssi, remote.snr, remote.sequenceNumber);
       #endif
 
-      #if ENABLE_BIDIRECTIONAL
-      // Send ACK every ACK_INTERVAL messages
-      if (remote.messageCount % ACK_INTERVAL == 0) {
-        // ACK includes receiver's current state
-        String ackPayload = "ACK," +
-                            String("SEQ:") + String(local.sequenceNumber) +
-                            ",LED:" + String(local.ledState) +
-                            ",TOUCH:" + String(local.touchState) +
-                            ",SPIN:" + String(local.spinnerIndex);
-
-        Serial.print("📤 Sending ACK (#");
-        Serial.print(remote.messageCount);
-        Serial.println(")...");
-
-        delay(50);  // Small delay before sending (LoRa turnaround time)
-        if (sendLoRaMessage(ackPayload, TARGET_LORA_ADDRESS)) {
-          local.messageCount++;
-          local.sequenceNumber++;
-          Serial.println("✓ ACK sent");
-        } else {
-          Serial.println("❌ ACK send failed");
-        }
+      // ACK requested: slot starts ACK_SLOT_OFFSET after the +RCV line
+      // (not for FEC-rebuilt frames - their slot has long passed)
+      if (ENABLE_BIDIRECTIONAL && ackRequested && !loraRxRecovered) {
+        ackAddress = packet.sender;
+        #if ENABLE_RELAY
+          ackRelay = false;
+        #endif
+        #if ENABLE_TX_POWER_CONTROL
+          ackLinkRssi = packet.rssi;  // Sender's power loop reads these
+          ackLinkSnr = packet.snr;
+        #endif
+        #if ENABLE_MAC_TDMA
+          // Where did the uplink start in our frame? → sender's correction
+          uint8_t tdmaSlot = 0;
+          #if ENABLE_GATEWAY_MODE
+            tdmaSlot = node - nodeTable.nodes;
+          #endif
+          ackTdma = true;
+          ackTdmaShift = macTdmaShift(tdmaSlot, loraRxTime - loraAirtimeMs(packet.len));
+        #endif
+        ackScheduleAt(ackSchedule, loraRxTime);
       }
-      #endif
     }
 
+    #if ENABLE_BIDIRECTIONAL
+    pollScheduledAck();
+    #endif
+
+    #if ENABLE_ADAPTIVE_SF
+    adrReceiverPoll(adr, health, remote.lastMessageTime);
+    #endif
+
+    #if ENABLE_TIME_SYNC
+    // Beacon when the radio is free (ACKs have priority - their slot is fixed)
+    if (millis() - lastBeacon >= BEACON_INTERVAL && !txInFlight && !ackSchedule.pending) {
+      if (sendBeacon()) {
+        txInFlight = true;
+        lastBeacon = millis();
+      }
+    }
+    #endif
+
     // Update connection state (watchdog)
     updateConnectionState(health, remote);
+    #if ENABLE_GATEWAY_MODE
+      nodeTableUpdate(nodeTable);
+    #endif
 
-    // Attempt recovery if connection lost
+    // Attempt recovery if connection lost (non-blocking, tiered)
     if (health.state == CONN_LOST) {
-      attemptRecovery(health, MY_LORA_ADDRESS, LORA_NETWORK_ID);
+      attemptRecovery(health, linkRecovery, MY_LORA_ADDRESS, LORA_NETWORK_ID);
     }
+    pollRecovery(health, linkRecovery);
 
-    updateLCD();
+  } else if (bRELAY) {
+    #if ENABLE_RELAY
+    relayLoop();
+    #endif
 
-    if (millis() - timing.lastCheck >= 5000) {
-      timing.lastCheck = millis();
-      printStatus();
+  } else {
+    // Alerts and commands go before everything else (tx_queue.h)
+    if (!txInFlight && !ackSlotBusy(ackSlot)) {
+      #if ENABLE_RELIABLE_LINK
+      sendReliable();
+      #else
+      sendQueued();
+      #endif
     }
 
-    // Print health report every 30 seconds
-    if (millis() - timing.lastHealthReport >= 30000) {
-      timing.lastHealthReport = millis();
-      printHealthReport(health, remote);
+    #if ENABLE_ADAPTIVE_SF
+    // ADR accept at the old SF - the switch waits for its +OK
+    if (adr.phase == ADR_ACCEPTING && !txInFlight && !ackSlotBusy(ackSlot)) {
+      if (sendAdrAccept()) txInFlight = true;
     }
+    #endif
 
-    // Send update to display station (if enabled)
-    sendDisplayUpdate();
+    #if ENABLE_FEC
+    // Parity right after its group (rebuilds lost frames on the receiver)
+    if (!txInFlight && !ackSlotBusy(ackSlot) && loraFecParityDue()) {
+      if (sendLoRaParity(TARGET_LORA_ADDRESS, onParitySent)) {
+        txInFlight = true;
+      }
+    }
+    #endif
 
-  } else {
-    // SENDER: Send every 2 seconds
-    if (millis() - timing.lastSend >= 2000) {
+    #if ENABLE_TELEMETRY_BATCH
+    // SENDER (batched): snapshot every BATCH_SAMPLE_INTERVAL, send when
+    // the batch is full or its oldest sample reaches BATCH_MAX_LATENCY
+    if (millis() - timing.lastSend >= BATCH_SAMPLE_INTERVAL) {
       timing.lastSend = millis();
+      takeBatchSample();
+    }
 
-      // Toggle LED on message transmission (synced with LoRa)
-      local.ledState = !local.ledState;
-      digitalWrite(LED_PIN, local.ledState);
-      local.ledCount++;
-      if (local.ledCount >= 80) local.ledCount = 0;
-
-      // Include sequence number in payload
-      String payload = "SEQ:" + String(local.sequenceNumber) +
-                       ",LED:" + String(local.ledState) +
-                       ",TOUCH:" + String(local.touchState) +
-                       ",SPIN:" + String(local.spinnerIndex) +
-                       ",COUNT:" + String(local.messageCount);
-
-      if (sendLoRaMessage(payload, TARGET_LORA_ADDRESS)) {
-        local.messageCount++;
-        local.sequenceNumber++;  // Increment sequence number
-
-        #if ENABLE_BIDIRECTIONAL
-        // Listen for ACK/response for a short time
-        unsigned long listenStart = millis();
-        while (millis() - listenStart < LISTEN_TIMEOUT) {
-          String response;
-          if (receiveLoRaMessage(remote, response)) {
-            // Process received ACK or data
-            if (response.indexOf("ACK") >= 0) {
-              ackReceived++;
-              lastAckTime = millis();
-              Serial.print("✓ ACK #");
-              Serial.print(ackReceived);
-              Serial.print(" received (RSSI: ");
-              Serial.print(remote.rssi);
-              Serial.println(" dBm)");
-              parsePayload(response);  // Parse any data in ACK
-              // Update health monitoring for sender too
-              updateRSSI(health, remote.rssi);
-              trackPacket(health, remote.sequenceNumber);
-
-              // Record packet in detailed telemetry (SNR, timing, etc.)
-              #if ENABLE_PACKET_STATS
-                recordPacketReceived(remote.rssi, remote.snr, remote.sequenceNumber);
-                recordAckReceived();  // Track ACK success rate
-              #endif
-            }
-            break;  // Got response, stop listening
-          }
-          delay(10);
+    // A full or aged batch is the cadence - the MAC only adds its
+    // jitter/backoff (timing.lastSend is the sample clock here)
+    bool batchMacDue = true;
+    #if ENABLE_TX_MAC
+      batchMacDue = macDue(txMac, millis());
+    #endif
+    if (!txInFlight && !ackSlotBusy(ackSlot) && batchMacDue &&
+        batchReady(batch, BATCH_SAMPLES, BATCH_MAX_LATENCY)) {
+      // Batches are rare and carry many samples: every one asks for an ACK
+      uint8_t payload[BATCH_FRAME_MAX];
+      uint8_t payloadLength = encodeTelemetryBatch(batch, payload, BATCH_FRAME_MAX,
+                                                   ENABLE_BIDIRECTIONAL);
+
+      if (!loraCanSend(loraUplinkLength(payloadLength))) {
+        // Duty cycle: keep buffering, the next frame carries more samples
+        batchAbort(batch);
+        if (!txDeferred) {
+          txDeferred = true;
+          Serial.print("⏳ Duty cycle: next batch in ");
+          Serial.print(loraSendWait(loraUplinkLength(payloadLength)));
+          Serial.println(" ms");
+        }
+      } else {
+        txDeferred = false;
+
+        // Toggle LED on message transmission (synced with LoRa)
+        local.ledState = !local.ledState;
+        digitalWrite(LED_PIN, local.ledState);
+        local.ledCount++;
+        if (local.ledCount >= 80) local.ledCount = 0;
+
+        if (sendLoRaUplink(payload, payloadLength, TARGET_LORA_ADDRESS, onBatchSent)) {
+          #if ENABLE_TX_MAC
+            macOnSend(txMac, millis(), loraAirtimeMs(loraUplinkLength(payloadLength)));
+          #endif
+          #if ENABLE_TX_POWER_CONTROL
+            txPowerUplinkQueued(loraUplinkLength(payloadLength));
+          #endif
+          txInFlight = true;
+          txAckRequested = ENABLE_BIDIRECTIONAL;
+          Serial.print("📤 Batch: ");
+          Serial.print(batch.inFlight);
+          Serial.print(" samples, ");
+          Serial.print(payloadLength);
+          Serial.println(" bytes");
+        } else {
+          batchAbort(batch);
         }
-        #endif
       }
     }
+    #else
+    // SENDER: Send every SEND_INTERVAL (previous AT+SEND and ACK slot
+    // must be finished - both scale with the real air time)
+    if (uplinkDue() && !txInFlight && !ackSlotBusy(ackSlot)) {
+      // Include sequence number in payload (binary frame or legacy ASCII)
+      bool wantAck = ENABLE_BIDIRECTIONAL && ackRequestDue();
+      #if ENABLE_ADAPTIVE_SF
+        wantAck = wantAck || adrWantsAck(adr);  // New SF unconfirmed: every uplink asks
+      #endif
+      uint8_t payload[LEGACY_PAYLOAD_MAX];
+      uint8_t payloadLength = buildTelemetryPayload(payload, FRAME_TYPE_TELEMETRY, wantAck);
+
+      if (!loraCanSend(loraUplinkLength(payloadLength))) {
+        // Duty-cycle budget exhausted: hold back, the next attempt
+        // carries the newest state (snapshots coalesce, nothing queues)
+        if (!txDeferred) {
+          txDeferred = true;
+          Serial.print("⏳ Duty cycle: next TX in ");
+          Serial.print(loraSendWait(loraUplinkLength(payloadLength)));
+          Serial.println(" ms");
+        }
+      } else {
+        txDeferred = false;
+
+        // Toggle LED on message transmission (synced with LoRa) - the
+        // frame carries the new state, rebuild (length is unchanged)
+        local.ledState = !local.ledState;
+        payloadLength = buildTelemetryPayload(payload, FRAME_TYPE_TELEMETRY, wantAck);
+
+        // Queued only - counters update in onTelemetrySent()
+        if (sendLoRaUplink(payload, payloadLength, TARGET_LORA_ADDRESS, onTelemetrySent)) {
+          uplinkSent(payloadLength);
+          txInFlight = true;
+          txAckRequested = wantAck;
+          #if ENABLE_TX_POWER_CONTROL
+            txPowerUplinkQueued(loraUplinkLength(payloadLength));
+          #endif
+          digitalWrite(LED_PIN, local.ledState);
+          local.ledCount++;
+          if (local.ledCount >= 80) local.ledCount = 0;
+        } else {
+          local.ledState = !local.ledState;  // AT queue full: the next loop() tries again
+        }
+      }
+    }
+    #endif
 
-    // Send update to display station (if enabled)
-    sendDisplayUpdate();
+    #if ENABLE_TX_POWER_CONTROL && !ENABLE_TASK_SPLIT
+    txPowerSampleCurrent();  // Else in the sensor task
+    #endif
 
-    if (millis() - timing.lastCheck >= 5000) {
-      timing.lastCheck = millis();
-      printStatus();
+    #if ENABLE_BIDIRECTIONAL
+    // ACK slot: window opens/closes on schedule, never blocks
+    if (ackSlotPoll(ackSlot) == SLOT_EVENT_MISSED) {
+      Serial.println("⌛ ACK slot closed - no ACK");
+      #if ENABLE_TX_MAC
+        macOnAckMissed(txMac);  // Collision or fade: spread out the next uplink
+      #endif
+      #if ENABLE_TX_POWER_CONTROL
+        txPowerOnAckMissed(txPower);  // Power back up before ADR gives up
+      #endif
+      #if ENABLE_ADAPTIVE_SF
+        adrOnAckMissed(adr);  // Fallback to SF12 if the link is gone
+      #endif
+      #if ENABLE_PACKET_STATS
+        recordAckTimeout();  // Track ACK success rate
+      #endif
     }
-  }
 
-  // PC Data Logging (both roles)
-  if (millis() - timing.lastDataOutput >= DATA_OUTPUT_INTERVAL) {
-    timing.lastDataOutput = millis();
+    // ACKs are matched to the slot; a late one never counts for the next packet
+    RcvView packet;
+    if (receiveLoRaPacket(remote, packet)) {
+      frameDispatch(senderRoutes, loraRxKind, packet);  // frame_dispatch.h
+    }
 
-    #if ENABLE_CSV_OUTPUT
-      printDataCSV();
+    #if ENABLE_PACKET_STATS
+      recordFecUncorrectable(loraFecTakeLost());
+    #endif
     #endif
 
-    #if ENABLE_JSON_OUTPUT
-      printDataJSON();
+    #if ENABLE_SLEEP_SENDER
+    sleepPoll();  // Uplink answered, radio idle: AT+MODE=1 and sleep
     #endif
   }
 
-  // Feature modules monitoring - Refactored to use wrapper modules
-  #if ENABLE_BATTERY_MONITOR || ENABLE_CURRENT_MONITOR
-    checkSensors();  // Unified battery + current monitoring
-  #endif
-
-  #if ENABLE_AUDIO_DETECTION || ENABLE_LIGHT_DETECTION
-    checkFireAlarm();  // Unified audio + light detection
-  #endif
+  #if ENABLE_TASK_SPLIT
+  // LCD and display station run in the UI task - hand over a copy
+  UiSnapshot ui;
+  takeUiSnapshot(ui);
+  seqlockWrite(uiState, ui);
 
-  #if ENABLE_PACKET_STATS || ENABLE_EXTENDED_TELEMETRY
-    // Detailed telemetry prints reports automatically based on intervals
-    // For receiver: print periodic report with health monitor data
-    #if defined(ENABLE_PACKET_STATS) && defined(bRECEIVER)
-      if (bRECEIVER) {
-        printDetailedReport(health);
-      }
-    #endif
+  taskRunEnd(radioTaskStats);
+  static TickType_t radioWake = xTaskGetTickCount();
+  taskWaitNext(radioWake, TASK_RADIO_PERIOD_MS);
+  #else
+  idleWait(loopIdle, loopSleepMs());
   #endif
-
-  delay(10);
 }
\ No newline at end of file
@@ -0,0 +1,184 @@
+/*=====================================================================
+  ack_slot.h - Scheduled ACK Slot (RX window instead of busy-listen)
+
+  Before: the sender listened after EVERY packet for at least
+  LISTEN_TIMEOUT, although the receiver ACKs only every ACK_INTERVAL
+  packets, and the receiver blocked loop() with delay() before the ACK.
+
+  Now the ACK has a fixed place in time:
+
+    sender   |== TX ==|+OK            [=== RX slot ===]
+    receiver |== RX ==|+RCV --offset--|== ACK TX ==|
+                      ^ t0            ^ t0 + offset
+
+  1. Sender sets the ACK request bit (FRAME_FLAG_ACK_REQ /
+     BATCH_FLAG_ACK_REQ) on every ACK_INTERVAL-th frame only
+  2. Receiver schedules the ACK exactly ACK_SLOT_OFFSET after the
+     +RCV line (loop() keeps running) and announces the offset in
+     every ACK frame (slot field)
+  3. Sender expects the ACK at
+       t0 + offset + airtime(ACK)
+     and opens its RX window only ±ACK_SLOT_GUARD around it. No new
+     TX until the slot has closed (half-duplex: it would collide)
+  4. ACK in window → hit, window closed empty → miss.
+     A late ACK is counted, never matched to the next packet.
+
+  Both ends see t0 at the same moment (end of the uplink on air), so
+  only UART/loop latency needs guard time - not the whole air time.
+  If the receiver cannot start its ACK within the guard, it drops it:
+  the sender has already given up and may be transmitting.
+
+  Pure C++ (no String, no heap) - host-testable.
+=======================================================================*/
+
+#ifndef ACK_SLOT_H
+#define ACK_SLOT_H
+
+#include <Arduino.h>
+
+// =============== SENDER: RX SLOT ================================
+enum AckSlotState {
+  SLOT_IDLE,     // No ACK expected
+  SLOT_WAITING,  // ACK requested, window not open yet
+  SLOT_OPEN      // Listening for the ACK
+};
+
+enum AckSlotEvent {
+  SLOT_EVENT_NONE,
+  SLOT_EVENT_OPENED,
+  SLOT_EVENT_MISSED   // Window closed without ACK
+};
+
+struct AckSlot {
+  AckSlotState state;
+  unsigned long opensAt;     // millis() window start
+  unsigned long closesAt;    // millis() window end
+  uint16_t offset;           // Receiver's announced slot offset (ms)
+  uint8_t ackLength;         // Last ACK frame length (air time estimate)
+
+  // Statistics
+  unsigned long slots;       // Windows scheduled
+  unsigned long hits;        // ACK inside the window
+  unsigned long early;       // ACK before the window opened (still a hit)
+  unsigned long misses;      // Window closed empty
+  unsigned long late;        // ACK with no window open
+  unsigned long listenMs;    // Total time spent in open windows
+};
+
+inline void ackSlotInit(AckSlot& slot, uint16_t offset, uint8_t ackLength) {
+  slot.state = SLOT_IDLE;
+  slot.opensAt = 0;
+  slot.closesAt = 0;
+  slot.offset = offset;
+  slot.ackLength = ackLength;
+  slot.slots = 0;
+  slot.hits = 0;
+  slot.early = 0;
+  slot.misses = 0;
+  slot.late = 0;
+  slot.listenMs = 0;
+}
+
+// Uplink finished at txDone (+OK). ackMinMs/ackMaxMs bound the ACK air
+// time (last ACK length / longest ACK the format allows).
+inline void ackSlotSchedule(AckSlot& slot, unsigned long txDone, uint32_t ackMinMs,
+                            uint32_t ackMaxMs, uint16_t guard) {
+  unsigned long expected = slot.offset + ackMinMs;
+  slot.opensAt = txDone + (expected > guard ? expected - guard : 0);
+  slot.closesAt = txDone + slot.offset + ackMaxMs + guard;
+  slot.state = SLOT_WAITING;
+  slot.slots++;
+}
+
+// Sender must not transmit while an ACK is due
+inline bool ackSlotBusy(const AckSlot& slot) {
+  return slot.state != SLOT_IDLE;
+}
+
+// Advance the window (call every loop)
+inline AckSlotEvent ackSlotPoll(AckSlot& slot) {
+  unsigned long now = millis();
+  if (slot.state == SLOT_WAITING && (long)(now - slot.opensAt) >= 0) {
+    slot.state = SLOT_OPEN;
+    return SLOT_EVENT_OPENED;
+  }
+  if (slot.state == SLOT_OPEN && (long)(now - slot.closesAt) >= 0) {
+    slot.state = SLOT_IDLE;
+    slot.misses++;
+    slot.listenMs += slot.closesAt - slot.opensAt;
+    return SLOT_EVENT_MISSED;
+  }
+  return SLOT_EVENT_NONE;
+}
+
+// An ACK arrived. Learns the announced offset and ACK length; returns
+// true if it answers the pending slot.
+inline bool ackSlotMatch(AckSlot& slot, uint16_t announcedOffset, uint8_t ackLength) {
+  if (announcedOffset > 0) slot.offset = announcedOffset;
+  slot.ackLength = ackLength;
+
+  if (slot.state == SLOT_IDLE) {
+    slot.late++;
+    return false;
+  }
+  if (slot.state == SLOT_WAITING) {
+    slot.early++;
+  } else {
+    slot.listenMs += millis() - slot.opensAt;
+  }
+  slot.state = SLOT_IDLE;
+  slot.hits++;
+  return true;
+}
+
+inline float ackSlotHitRate(const AckSlot& slot) {
+  unsigned long done = slot.hits + slot.misses;
+  return done > 0 ? (100.0f * slot.hits) / done : 0.0f;
+}
+
+// =============== RECEIVER: ACK SCHEDULE ================================
+enum AckScheduleEvent {
+  ACK_WAIT,      // Nothing to send yet
+  ACK_SEND_NOW,  // Slot reached - transmit the ACK
+  ACK_DROPPED    // Slot passed beyond the guard - sender stopped listening
+};
+
+struct AckSchedule {
+  bool pending;
+  unsigned long dueAt;       // millis() the ACK goes on air
+  uint16_t offset;           // Announced slot offset (ms)
+
+  // Statistics
+  unsigned long sent;
+  unsigned long dropped;
+};
+
+inline void ackScheduleInit(AckSchedule& s, uint16_t offset) {
+  s.pending = false;
+  s.dueAt = 0;
+  s.offset = offset;
+  s.sent = 0;
+  s.dropped = 0;
+}
+
+// Request received; rxTime = millis() of the +RCV line
+inline void ackScheduleAt(AckSchedule& s, unsigned long rxTime) {
+  s.pending = true;
+  s.dueAt = rxTime + s.offset;
+}
+
+inline AckScheduleEvent ackSchedulePoll(AckSchedule& s, uint16_t guard) {
+  if (!s.pending) return ACK_WAIT;
+  long lateness = (long)(millis() - s.dueAt);
+  if (lateness < 0) return ACK_WAIT;
+
+  s.pending = false;
+  if (lateness > guard) {
+    s.dropped++;
+    return ACK_DROPPED;
+  }
+  s.sent++;
+  return ACK_SEND_NOW;
+}
+
+#endif // ACK_SLOT_H
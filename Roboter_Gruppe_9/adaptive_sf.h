@@ -1,76 +1,54 @@
 /*=====================================================================
-  adaptive_sf.h - Adaptive Spreading Factor
+  adaptive_sf.h - Adaptive Data Rate (closed-loop SF selection)
 
   FEATURE 9: Adaptive Spreading Factor
 
-  Automatically adjusts LoRa spreading factor based on signal quality.
-  Optimizes throughput vs. range trade-off dynamically.
-
-  How it works:
-  1. Monitor RSSI continuously
-  2. If RSSI > -80 dBm (good signal) → Decrease SF (faster speed)
-  3. If RSSI < -105 dBm (weak signal) → Increase SF (better range)
-  4. Wait for stabilization before next adjustment
-  5. Both devices must sync SF changes
-
-  Benefits:
-  - Maximum speed at close range (SF7 = 11× faster than SF12)
-  - Maintains link at long range (SF12 = max sensitivity)
-  - Automatic optimization as distance changes
-  - Reduced air time (less collisions)
-  - Better battery life (shorter TX time at close range)
-
-  Trade-offs:
-  - Complexity: Both devices must coordinate
-  - Packet loss during SF transition
-  - Not suitable for rapidly moving devices
-  - Requires bi-directional communication
-
-  Spreading Factor Table:
-  SF  | Speed    | Range  | Air Time | Sensitivity
-  ----|----------|--------|----------|-------------
-  7   | 5.5 kbps | 2 km   | 41 ms    | -123 dBm
-  8   | 3.1 kbps | 3 km   | 72 ms    | -126 dBm
-  9   | 1.8 kbps | 4 km   | 144 ms   | -129 dBm
-  10  | 1.0 kbps | 5 km   | 288 ms   | -132 dBm
-  11  | 0.5 kbps | 7 km   | 577 ms   | -134.5 dBm
-  12  | 0.3 kbps | 10 km  | 991 ms   | -137 dBm
-
-  RSSI Thresholds (configurable):
-  - RSSI > -80 dBm: Excellent → Try SF-1
-  - RSSI -80 to -105: Good → Maintain current SF
-  - RSSI < -105 dBm: Weak → Try SF+1
-
-  Configuration:
-  - ADAPTIVE_SF_RSSI_GOOD: Threshold to decrease SF (-80 default)
-  - ADAPTIVE_SF_RSSI_WEAK: Threshold to increase SF (-105 default)
-  - SF_CHANGE_COOLDOWN: Min time between changes (30s default)
-  - SF_CHANGE_SAMPLES: Required samples before change (10 default)
-
-  Synchronization:
-  - Sender announces SF change via special packet
-  - Receiver acknowledges and switches
-  - Both wait for confirmation before using new SF
-  - If sync fails, revert to SF12 (safest)
-
-  Testing:
-  1. Set ENABLE_ADAPTIVE_SF true in config.h
-  2. Upload to both devices
-  3. Start at close range (should use SF7-8)
-  4. Move apart (SF increases)
-  5. Move together (SF decreases)
-  6. Check serial for SF change messages
-
-  Performance:
-  - Close range (RSSI -50): SF7 → 11× faster
-  - Medium range (RSSI -90): SF10 → 3× faster
-  - Long range (RSSI -115): SF12 → max reliability
-
-  Safety:
-  - Always start at SF12 (maximum range)
-  - If communication fails, revert to SF12
-  - Never go below SF7 (minimum allowed)
-  - Never go above SF12 (maximum allowed)
+  The receiver measures the uplink and picks the fastest spreading
+  factor that still keeps ADR_MARGIN_DB of link margin. The switch is a
+  two-phase commit over the ACK slot, and any timeout brings both ends
+  back to SF12 where they always meet again.
+
+  Link margin (SX1276 demodulation floor per SF, BW125, airtime.h):
+
+    SF  | SNR floor | Air time (5 B) | 1% duty cycle
+    ----|-----------|----------------|--------------
+    7   |  -7.5 dB  |  27 ms         |  3 s
+    8   | -10.0 dB  |  54 ms         |  5 s
+    9   | -12.5 dB  | 108 ms         | 11 s
+    10  | -15.0 dB  | 216 ms         | 22 s
+    11  | -17.5 dB  | 431 ms         | 43 s
+    12  | -20.0 dB  | 697 ms         | 70 s
+
+    margin(sf) = SNR - floor(sf)
+
+  SNR does not depend on the SF (same RSSI, same noise), so the worst
+  SNR of the last ADR_SAMPLES uplinks predicts the margin at every SF.
+  Decision (receiver, every uplink after ADR_COOLDOWN_MS):
+  - Fastest SF with margin ≥ ADR_MARGIN_DB (+ ADR_HYSTERESIS_DB to
+    speed up - no flapping at the edge)
+  - Loss since the last switch (HealthMonitor counters) above
+    ADR_LOSS_MAX_PCT → one SF slower, and never faster
+
+  Two-phase switch:
+
+    receiver                          sender
+    ─ PROPOSED ──► ADR_CMD (ACK slot) ─►  (old SF)
+                   ◄── ADR_ACCEPT ──── after +OK: switch → VERIFY
+    switch → VERIFY
+    first uplink at new SF → IDLE     first ACK at new SF → IDLE
+
+  Fallback to SF12:
+  - Receiver: ACCEPT or first uplink missing for ADR_VERIFY_MS, or
+    nothing heard for ADR_FALLBACK_MS at SF < 12
+  - Sender: ADR_VERIFY_TRIES ACK slots missed after the switch, or
+    ADR_FALLBACK_MISSES in a row at SF < 12
+  - Telemetry instead of ACCEPT (command lost or declined) → receiver
+    aborts and stays
+
+  Frames (binary, 3 bytes): | 0 type 0x88 CMD / 0x89 ACCEPT | 1 txid | 2 sf |
+
+  Single link only - one receiver radio cannot listen on several SFs
+  (not available in gateway mode). Needs ENABLE_BIDIRECTIONAL.
 =======================================================================*/
 
 #ifndef ADAPTIVE_SF_H
@@ -78,353 +56,293 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "structs.h"
+#include "lora_handler.h"  // atEnqueue(loraAT), loraParams, airtime model
 
-// Adaptive SF configuration
 #define SF_MIN 7
 #define SF_MAX 12
-#define SF_CHANGE_COOLDOWN 30000     // 30 seconds between changes
-#define SF_CHANGE_SAMPLES 10         // Samples required before change
-#define SF_SYNC_TIMEOUT 5000         // 5 seconds to confirm SF change
-
-// Adaptive SF state
-struct AdaptiveSFState {
-  int currentSF;                    // Current spreading factor
-  int targetSF;                     // Target SF (during transition)
-  int rssiSamples[SF_CHANGE_SAMPLES]; // Recent RSSI samples
-  int sampleIndex;                  // Current sample index
-  int sampleCount;                  // Number of samples collected
-  unsigned long lastChange;         // Last SF change time
-  int changeCount;                  // Total SF changes
-  bool isChanging;                  // Currently changing SF
-  unsigned long changeStartTime;    // SF change start time
-  bool isEnabled;                   // Feature enabled flag
-};
-
-AdaptiveSFState adaptiveSF = {12, 12, {0}, 0, 0, 0, 0, false, 0, false};
-
-// Initialize adaptive SF
-void initAdaptiveSF() {
-  #if ENABLE_ADAPTIVE_SF
-    adaptiveSF.currentSF = 12;  // Start with maximum range
-    adaptiveSF.targetSF = 12;
-    adaptiveSF.sampleIndex = 0;
-    adaptiveSF.sampleCount = 0;
-    adaptiveSF.lastChange = millis();
-    adaptiveSF.changeCount = 0;
-    adaptiveSF.isChanging = false;
-    adaptiveSF.isEnabled = true;
-
-    Serial.println("📡 Adaptive Spreading Factor enabled");
-    Serial.print("  Initial SF: SF");
-    Serial.println(adaptiveSF.currentSF);
-    Serial.print("  Good RSSI threshold: ");
-    Serial.print(ADAPTIVE_SF_RSSI_GOOD);
-    Serial.println(" dBm");
-    Serial.print("  Weak RSSI threshold: ");
-    Serial.print(ADAPTIVE_SF_RSSI_WEAK);
-    Serial.println(" dBm");
-    Serial.print("  Cooldown: ");
-    Serial.print(SF_CHANGE_COOLDOWN / 1000);
-    Serial.println(" seconds");
-    Serial.println("  ⚠️  Both devices must have this enabled!");
-  #endif
-}
+#define ADR_SAMPLES 16               // Uplink SNRs per decision
 
-// Add RSSI sample
-void addRSSISample(int rssi) {
-  #if ENABLE_ADAPTIVE_SF
-    // Store sample
-    adaptiveSF.rssiSamples[adaptiveSF.sampleIndex] = rssi;
-    adaptiveSF.sampleIndex = (adaptiveSF.sampleIndex + 1) % SF_CHANGE_SAMPLES;
-
-    if (adaptiveSF.sampleCount < SF_CHANGE_SAMPLES) {
-      adaptiveSF.sampleCount++;
-    }
-  #endif
-}
+#define FRAME_TYPE_ADR_CMD    0x88
+#define FRAME_TYPE_ADR_ACCEPT 0x89
+#define ADR_FRAME_LEN 3
 
-// Calculate average RSSI from samples
-float getAverageRSSI() {
-  #if ENABLE_ADAPTIVE_SF
-    if (adaptiveSF.sampleCount == 0) return 0;
+enum AdrPhase {
+  ADR_IDLE,
+  ADR_PROPOSED,    // Receiver: command pending / sent, waiting for ACCEPT
+  ADR_ACCEPTING,   // Sender: ACCEPT queued at the old SF
+  ADR_VERIFY       // Both: running on the new SF, not yet confirmed
+};
 
-    long sum = 0;
-    for (int i = 0; i < adaptiveSF.sampleCount; i++) {
-      sum += adaptiveSF.rssiSamples[i];
-    }
+struct AdaptiveSF {
+  uint8_t sf;                      // SF in use (module follows via AT+PARAMETER)
+  uint8_t targetSF;                // SF of the running transaction
+  AdrPhase phase;
+  uint8_t txid;
+  unsigned long phaseSince;
+  bool commandDue;                 // Receiver: next ACK slot carries ADR_CMD
+  uint8_t misses;                  // Sender: ACK slots missed in a row
+
+  // Receiver decision window (reset on every switch)
+  int8_t snr[ADR_SAMPLES];
+  uint8_t snrHead;
+  uint8_t snrCount;
+  unsigned long windowReceived;    // HealthMonitor counters at window start
+  unsigned long windowLost;
+  unsigned long lastChange;
+
+  // Statistics
+  unsigned long changes;
+  unsigned long fallbacks;
+  unsigned long aborted;
+};
 
-    return (float)sum / (float)adaptiveSF.sampleCount;
-  #else
-    return 0;
-  #endif
+inline void adrInit(AdaptiveSF& a, uint8_t sf) {
+  memset(&a, 0, sizeof(a));
+  a.sf = sf;
+  a.targetSF = sf;
+  a.lastChange = millis();
 }
 
-// Determine optimal SF based on RSSI
-int determineOptimalSF(float avgRSSI) {
-  #if ENABLE_ADAPTIVE_SF
-    int optimalSF = adaptiveSF.currentSF;
-
-    // Strong signal → decrease SF (faster speed)
-    if (avgRSSI > ADAPTIVE_SF_RSSI_GOOD) {
-      if (adaptiveSF.currentSF > SF_MIN) {
-        optimalSF = adaptiveSF.currentSF - 1;
-      }
-    }
-    // Weak signal → increase SF (better range)
-    else if (avgRSSI < ADAPTIVE_SF_RSSI_WEAK) {
-      if (adaptiveSF.currentSF < SF_MAX) {
-        optimalSF = adaptiveSF.currentSF + 1;
-      }
-    }
+// =============== FRAMES ================================
+inline uint8_t adrEncode(uint8_t* out, uint8_t type, uint8_t txid, uint8_t sf) {
+  out[0] = type;
+  out[1] = txid;
+  out[2] = sf;
+  return ADR_FRAME_LEN;
+}
 
-    return optimalSF;
-  #else
-    return 12;
-  #endif
+inline bool adrDecode(const char* data, uint8_t len, uint8_t type,
+                      uint8_t& txid, uint8_t& sf) {
+  if (len != ADR_FRAME_LEN || (uint8_t)data[0] != type) return false;
+  txid = (uint8_t)data[1];
+  sf = (uint8_t)data[2];
+  return sf >= SF_MIN && sf <= SF_MAX;
 }
 
-// Apply SF change to LoRa module
-bool applySpreadingFactor(int sf) {
-  #if ENABLE_ADAPTIVE_SF
-    Serial.print("📡 Applying SF");
+// =============== MODULE ================================
+inline void onAdrParameterSet(ATResult result, const char* response, void* ctx) {
+  uint8_t sf = (uint8_t)(uintptr_t)ctx;
+  if (result != AT_RESULT_OK) {
+    Serial.print("❌ AT+PARAMETER SF");
     Serial.print(sf);
-    Serial.println("...");
-
-    // Build AT command
-    // AT+PARAMETER=SF,BW,CR,PREAMBLE
-    // SF: 7-12, BW: 7=125kHz, CR: 1=4/5, PREAMBLE: 4
-    String cmd = "AT+PARAMETER=" + String(sf) + ",7,1,4";
-
-    extern HardwareSerial LoRaSerial;
-    LoRaSerial.println(cmd);
-    delay(100);
-
-    // Check response
-    if (LoRaSerial.available()) {
-      String response = LoRaSerial.readStringUntil('\n');
-      response.trim();
-
-      if (response == "+OK") {
-        Serial.print("✓ SF changed to SF");
-        Serial.println(sf);
-        return true;
-      } else {
-        Serial.print("❌ SF change failed: ");
-        Serial.println(response);
-        return false;
-      }
-    }
+    Serial.println(" failed");
+    return;  // Peer times out and both meet at SF12
+  }
+  uint32_t oldAirtime = loraAirtimeMs(5);
+  loraParams.sf = sf;  // Airtime model, ACK slot and AT+SEND timeouts follow
+  Serial.print("📡 SF");
+  Serial.print(sf);
+  Serial.print(" active (5 B air time ");
+  Serial.print(oldAirtime);
+  Serial.print(" → ");
+  Serial.print(loraAirtimeMs(5));
+  Serial.println(" ms)");
+}
 
+// Queue AT+PARAMETER behind anything already queued (an ACCEPT still
+// leaves at the old SF)
+inline bool adrSetSF(AdaptiveSF& a, uint8_t sf) {
+  char cmd[32];
+  snprintf(cmd, sizeof(cmd), "AT+PARAMETER=%u,%u,%u,%u",
+           sf, loraParams.bw, loraParams.cr, loraParams.preamble);
+  if (!atEnqueue(loraAT, cmd, 1000, onAdrParameterSet, (void*)(uintptr_t)sf)) {
     return false;
-  #else
-    return false;
-  #endif
+  }
+  a.sf = sf;
+  a.lastChange = millis();
+  a.snrCount = 0;
+  a.snrHead = 0;
+  a.misses = 0;
+  return true;
 }
 
-// Send SF change announcement to remote device
-void announceSpreadingFactorChange(int newSF) {
-  #if ENABLE_ADAPTIVE_SF
-    Serial.print("→ Announcing SF change to SF");
-    Serial.println(newSF);
-
-    String announcement = "CMD:SF_CHANGE:" + String(newSF);
-
-    extern void sendLoRaMessage(String payload, int address);
-    sendLoRaMessage(announcement, LORA_SENDER_ADDRESS);
-  #endif
+inline void adrFallback(AdaptiveSF& a, const char* reason) {
+  Serial.print("⚠️  ADR: ");
+  Serial.print(reason);
+  Serial.println(" → SF12");
+  a.phase = ADR_IDLE;
+  a.commandDue = false;
+  a.fallbacks++;
+  if (a.sf != SF_MAX) adrSetSF(a, SF_MAX);
 }
 
-// Process SF change announcement from remote
-void processSpreadingFactorChange(String payload) {
-  #if ENABLE_ADAPTIVE_SF
-    // Parse CMD:SF_CHANGE:X
-    int sfIdx = payload.indexOf("CMD:SF_CHANGE:");
-    if (sfIdx >= 0) {
-      int newSF = payload.substring(sfIdx + 14).toInt();
-
-      if (newSF >= SF_MIN && newSF <= SF_MAX) {
-        Serial.print("📡 Remote requests SF change to SF");
-        Serial.println(newSF);
-
-        // Apply change
-        if (applySpreadingFactor(newSF)) {
-          adaptiveSF.currentSF = newSF;
-          adaptiveSF.targetSF = newSF;
-
-          // Send ACK
-          String ack = "CMD:SF_ACK:" + String(newSF);
-          extern void sendLoRaMessage(String payload, int address);
-          sendLoRaMessage(ack, LORA_SENDER_ADDRESS);
-        }
-      } else {
-        Serial.print("❌ Invalid SF: ");
-        Serial.println(newSF);
-      }
-    }
-  #endif
+// =============== RECEIVER: DECISION ================================
+inline void adrAddSample(AdaptiveSF& a, int8_t snr) {
+  a.snr[a.snrHead] = snr;
+  a.snrHead = (a.snrHead + 1) % ADR_SAMPLES;
+  if (a.snrCount < ADR_SAMPLES) a.snrCount++;
 }
 
-// Update adaptive SF (call regularly with current RSSI)
-void updateAdaptiveSF(int currentRSSI) {
-  #if ENABLE_ADAPTIVE_SF
-    unsigned long now = millis();
-
-    // Skip if currently changing
-    if (adaptiveSF.isChanging) {
-      // Check for timeout
-      if (now - adaptiveSF.changeStartTime > SF_SYNC_TIMEOUT) {
-        Serial.println("⚠️  SF change timeout, reverting to SF12");
-        applySpreadingFactor(12);
-        adaptiveSF.currentSF = 12;
-        adaptiveSF.targetSF = 12;
-        adaptiveSF.isChanging = false;
-      }
-      return;
-    }
-
-    // Skip if in cooldown
-    if (now - adaptiveSF.lastChange < SF_CHANGE_COOLDOWN) {
-      return;
-    }
-
-    // Add RSSI sample
-    addRSSISample(currentRSSI);
+// Loss since the window started (percent)
+inline float adrRecentLoss(const AdaptiveSF& a, const HealthMonitor& health) {
+  unsigned long received = health.packetsReceived - a.windowReceived;
+  unsigned long lost = health.packetsLost - a.windowLost;
+  return received + lost ? 100.0f * lost / (received + lost) : 0.0f;
+}
 
-    // Need enough samples
-    if (adaptiveSF.sampleCount < SF_CHANGE_SAMPLES) {
-      return;
+// Fastest SF that keeps the target margin (current SF if undecided)
+inline uint8_t adrDecide(AdaptiveSF& a, const HealthMonitor& health) {
+  if (a.snrCount < ADR_SAMPLES) return a.sf;
+  if (millis() - a.lastChange < ADR_COOLDOWN_MS) return a.sf;
+
+  int8_t worst = a.snr[0];
+  for (uint8_t i = 1; i < a.snrCount; i++) {
+    if (a.snr[i] < worst) worst = a.snr[i];
+  }
+
+  uint8_t target = SF_MAX;
+  for (uint8_t sf = ADR_SF_MIN; sf <= SF_MAX; sf++) {
+    float need = ADR_MARGIN_DB + (sf < a.sf ? ADR_HYSTERESIS_DB : 0);
+    if (worst - loraSnrFloor(sf) >= need) {
+      target = sf;
+      break;
     }
+  }
 
-    // Calculate average RSSI
-    float avgRSSI = getAverageRSSI();
-
-    // Determine optimal SF
-    int optimalSF = determineOptimalSF(avgRSSI);
-
-    // Check if change needed
-    if (optimalSF != adaptiveSF.currentSF) {
-      Serial.println("\n╔════ ADAPTIVE SF ════╗");
-      Serial.print("║ Current SF:  SF");
-      Serial.println(adaptiveSF.currentSF);
-      Serial.print("║ Avg RSSI:    ");
-      Serial.print(avgRSSI, 1);
-      Serial.println(" dBm");
-      Serial.print("║ Target SF:   SF");
-      Serial.println(optimalSF);
-
-      if (avgRSSI > ADAPTIVE_SF_RSSI_GOOD) {
-        Serial.println("║ Reason:      Strong signal → Faster speed");
-      } else {
-        Serial.println("║ Reason:      Weak signal → Better range");
-      }
-
-      Serial.println("╚═════════════════════╝");
-
-      // Start SF change process
-      adaptiveSF.targetSF = optimalSF;
-      adaptiveSF.isChanging = true;
-      adaptiveSF.changeStartTime = now;
-
-      // Announce to remote device
-      announceSpreadingFactorChange(optimalSF);
-
-      // Apply locally
-      if (applySpreadingFactor(optimalSF)) {
-        adaptiveSF.currentSF = optimalSF;
-        adaptiveSF.lastChange = now;
-        adaptiveSF.changeCount++;
-
-        // Reset samples
-        adaptiveSF.sampleCount = 0;
-        adaptiveSF.sampleIndex = 0;
-      }
-
-      adaptiveSF.isChanging = false;
-    }
-  #endif
+  if (adrRecentLoss(a, health) > ADR_LOSS_MAX_PCT) {
+    // Margin looks fine but packets are lost (interference, fading)
+    if (target <= a.sf) target = a.sf < SF_MAX ? a.sf + 1 : SF_MAX;
+  }
+  return target;
 }
 
-// Get current SF
-int getCurrentSF() {
-  #if ENABLE_ADAPTIVE_SF
-    return adaptiveSF.currentSF;
-  #else
-    return 12;
-  #endif
+// Receiver, every loop: start a transaction or run the timeouts
+inline void adrReceiverPoll(AdaptiveSF& a, const HealthMonitor& health,
+                            unsigned long lastMessageTime) {
+  unsigned long now = millis();
+
+  if (a.phase == ADR_PROPOSED && !a.commandDue && now - a.phaseSince > ADR_VERIFY_MS) {
+    adrFallback(a, "no ACCEPT");  // Sender may have switched already
+    return;
+  }
+  if (a.phase == ADR_VERIFY && now - a.phaseSince > ADR_VERIFY_MS) {
+    adrFallback(a, "no uplink at new SF");
+    return;
+  }
+  if (a.phase == ADR_IDLE && a.sf != SF_MAX && now - lastMessageTime > ADR_FALLBACK_MS) {
+    adrFallback(a, "link silent");
+    return;
+  }
+  if (a.phase != ADR_IDLE) return;
+
+  uint8_t target = adrDecide(a, health);
+  if (target == a.sf) return;
+
+  Serial.print("📡 ADR: SF");
+  Serial.print(a.sf);
+  Serial.print(" → SF");
+  Serial.print(target);
+  Serial.print(" proposed (loss ");
+  Serial.print(adrRecentLoss(a, health), 1);
+  Serial.println("%)");
+
+  a.targetSF = target;
+  a.txid++;
+  a.phase = ADR_PROPOSED;
+  a.commandDue = true;  // Goes out in the next ACK slot
+  a.windowReceived = health.packetsReceived;
+  a.windowLost = health.packetsLost;
 }
 
-// Get SF change count
-int getSFChangeCount() {
-  #if ENABLE_ADAPTIVE_SF
-    return adaptiveSF.changeCount;
-  #else
-    return 0;
-  #endif
+// Receiver: ADR_CMD left in the ACK slot - ACCEPT timeout starts now
+inline void adrCommandSent(AdaptiveSF& a) {
+  a.commandDue = false;
+  a.phaseSince = millis();
 }
 
-// Print adaptive SF status
-void printAdaptiveSFStatus() {
-  #if ENABLE_ADAPTIVE_SF
-    Serial.println("\n╔═══════ ADAPTIVE SF STATUS ═══════╗");
-    Serial.print("║ Current SF:      SF");
-    Serial.println(adaptiveSF.currentSF);
-
-    if (adaptiveSF.sampleCount > 0) {
-      Serial.print("║ Avg RSSI:        ");
-      Serial.print(getAverageRSSI(), 1);
-      Serial.println(" dBm");
-    }
-
-    Serial.print("║ Changes:         ");
-    Serial.println(adaptiveSF.changeCount);
-
-    Serial.print("║ Time since last: ");
-    Serial.print((millis() - adaptiveSF.lastChange) / 1000);
-    Serial.println(" s");
-
-    Serial.print("║ Samples:         ");
-    Serial.print(adaptiveSF.sampleCount);
-    Serial.print(" / ");
-    Serial.println(SF_CHANGE_SAMPLES);
+// Receiver: uplink (telemetry/batch) heard at the current SF
+inline void adrOnUplink(AdaptiveSF& a, int8_t snr, const HealthMonitor& health) {
+  if (a.phase == ADR_PROPOSED && !a.commandDue) {
+    a.phase = ADR_IDLE;  // Sender never got (or declined) the command
+    a.aborted++;
+    a.lastChange = millis();  // Cooldown before the next try
+    Serial.println("⚠️  ADR: no ACCEPT, sender stays - aborted");
+  } else if (a.phase == ADR_VERIFY) {
+    a.phase = ADR_IDLE;
+    a.changes++;
+    a.windowReceived = health.packetsReceived;
+    a.windowLost = health.packetsLost;
+    Serial.print("✓ ADR: SF");
+    Serial.print(a.sf);
+    Serial.println(" confirmed");
+  }
+  adrAddSample(a, snr);
+}
 
-    if (adaptiveSF.isChanging) {
-      Serial.println("║ Status:          ⏳ CHANGING");
-    } else {
-      Serial.println("║ Status:          ✓ STABLE");
-    }
+// Receiver: sender accepted → switch (commit point)
+inline void adrOnAccept(AdaptiveSF& a, uint8_t txid, uint8_t sf) {
+  if (a.phase != ADR_PROPOSED || txid != a.txid || sf != a.targetSF) return;
+  if (!adrSetSF(a, sf)) {
+    adrFallback(a, "AT queue full");
+    return;
+  }
+  a.phase = ADR_VERIFY;
+  a.phaseSince = millis();
+}
 
-    Serial.println("╚══════════════════════════════════╝\n");
-  #endif
+// =============== SENDER ================================
+// ADR_CMD arrived in the ACK slot
+inline void adrOnCommand(AdaptiveSF& a, uint8_t txid, uint8_t sf) {
+  if (a.phase == ADR_VERIFY) return;  // Finish the running switch first
+  a.txid = txid;
+  a.targetSF = sf;
+  a.phase = ADR_ACCEPTING;
+  a.phaseSince = millis();
 }
 
-// Force SF (override adaptive)
-void forceSpreadingFactor(int sf) {
-  #if ENABLE_ADAPTIVE_SF
-    if (sf < SF_MIN || sf > SF_MAX) {
-      Serial.println("❌ Invalid SF (must be 7-12)");
-      return;
-    }
+// ACCEPT left at the old SF (+OK) → switch (commit point)
+inline void adrAcceptSent(AdaptiveSF& a, bool ok) {
+  if (a.phase != ADR_ACCEPTING) return;
+  if (!ok || !adrSetSF(a, a.targetSF)) {
+    a.phase = ADR_IDLE;  // Receiver sees our telemetry and aborts
+    return;
+  }
+  a.phase = ADR_VERIFY;
+  a.phaseSince = millis();
+}
 
-    Serial.print("⚠️  Forcing SF to SF");
-    Serial.println(sf);
+// Every uplink asks for an ACK until the new SF is confirmed
+inline bool adrWantsAck(const AdaptiveSF& a) {
+  return a.phase == ADR_VERIFY;
+}
 
-    if (applySpreadingFactor(sf)) {
-      adaptiveSF.currentSF = sf;
-      adaptiveSF.targetSF = sf;
-      adaptiveSF.lastChange = millis();
+inline void adrOnAck(AdaptiveSF& a) {
+  a.misses = 0;
+  if (a.phase == ADR_VERIFY) {
+    a.phase = ADR_IDLE;
+    a.changes++;
+    Serial.print("✓ ADR: SF");
+    Serial.print(a.sf);
+    Serial.println(" confirmed");
+  }
+}
 
-      // Announce to remote
-      announceSpreadingFactorChange(sf);
-    }
-  #endif
+inline void adrOnAckMissed(AdaptiveSF& a) {
+  a.misses++;
+  if (a.phase == ADR_VERIFY && a.misses >= ADR_VERIFY_TRIES) {
+    adrFallback(a, "no ACK at new SF");
+  } else if (a.phase == ADR_IDLE && a.sf != SF_MAX && a.misses >= ADR_FALLBACK_MISSES) {
+    adrFallback(a, "ACKs missing");
+  }
 }
 
-// Reset to SF12 (safest, maximum range)
-void resetToMaxRange() {
-  #if ENABLE_ADAPTIVE_SF
-    Serial.println("🔄 Resetting to SF12 (max range)");
-    forceSpreadingFactor(12);
-  #endif
+// =============== STATUS ================================
+inline void printAdaptiveSFStatus(const AdaptiveSF& a) {
+  Serial.print("ADR: SF");
+  Serial.print(a.sf);
+  Serial.print(", changes ");
+  Serial.print(a.changes);
+  Serial.print(", fallbacks ");
+  Serial.print(a.fallbacks);
+  Serial.print(", aborted ");
+  Serial.print(a.aborted);
+  if (a.phase != ADR_IDLE) {
+    Serial.print(" (switching to SF");
+    Serial.print(a.targetSF);
+    Serial.print(")");
+  }
+  Serial.println();
 }
 
 #endif // ADAPTIVE_SF_H
@@ -39,6 +39,7 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "frame_dispatch.h"
 
 // Command statistics
 struct CommandStats {
@@ -46,7 +47,7 @@ struct CommandStats {
   int commandsExecuted;
   int commandsRejected;
   unsigned long lastCommandTime;
-  String lastCommand;
+  char lastCommand[16];          // Verb of the last command
 };
 
 CommandStats cmdStats = {0, 0, 0, 0, ""};
@@ -101,180 +102,182 @@ void blinkLED(int times) {
   }
 }
 
-// Process advanced remote command
-void processAdvancedCommand(String payload) {
+// Process advanced remote command ("CMD:VERB[:arg]", one pass through
+// the verb table of frame_dispatch.h - no String scans)
+void processAdvancedCommand(const char* payload, uint8_t len) {
   #if ENABLE_ADVANCED_COMMANDS
     // Check if this is a command
-    if (payload.indexOf("CMD:") < 0) {
+    if (len < 5 || memcmp(payload, "CMD:", 4) != 0) {
       return;  // Not a command
     }
 
     cmdStats.commandsReceived++;
     cmdStats.lastCommandTime = millis();
 
-    // Extract command (everything after CMD:)
-    int cmdStart = payload.indexOf("CMD:");
-    String command = payload.substring(cmdStart + 4);
-
-    // Remove trailing data
-    int commaPos = command.indexOf(',');
-    if (commaPos >= 0) {
-      command = command.substring(0, commaPos);
-    }
-    command.trim();
-
-    cmdStats.lastCommand = command;
+    // Verb (everything after CMD: up to ':' or ',')
+    uint8_t verbLen = remoteCommandVerbLength(payload, len);
+    if (verbLen > sizeof(cmdStats.lastCommand) - 1) verbLen = sizeof(cmdStats.lastCommand) - 1;
+    memcpy(cmdStats.lastCommand, payload + 4, verbLen);
+    cmdStats.lastCommand[verbLen] = '\0';
 
     Serial.print("📡 Remote command received: ");
-    Serial.println(command);
-
-    // STATUS - Send full status report
-    if (command == "STATUS") {
-      String status = buildStatusReport();
-      Serial.println("→ Sending status report");
-      // Send via LoRa (function must be implemented in main code)
-      extern void sendLoRaMessage(String payload, int address);
-      sendLoRaMessage(status, LORA_SENDER_ADDRESS);
-      cmdStats.commandsExecuted++;
-    }
-
-    // RESET_STATS - Reset counters
-    else if (command == "RESET_STATS") {
-      extern HealthMonitor health;
-      health.packetsReceived = 0;
-      health.packetsLost = 0;
-      health.rssiSum = 0;
-      health.rssiCount = 0;
-      Serial.println("✓ Statistics reset");
-      cmdStats.commandsExecuted++;
-    }
+    Serial.println(cmdStats.lastCommand);
 
-    // PING - Simple connectivity test
-    else if (command == "PING") {
-      Serial.println("→ Responding to PING with PONG");
-      extern void sendLoRaMessage(String payload, int address);
-      sendLoRaMessage("PONG", LORA_SENDER_ADDRESS);
-      cmdStats.commandsExecuted++;
-    }
+    long arg = -1;
+    remoteCommandArg(payload, len, arg);
 
-    // SET_POWER:X - Set TX power
-    else if (command.startsWith("SET_POWER:")) {
-      int power = command.substring(10).toInt();
-      if (power >= 0 && power <= 20) {
-        extern HardwareSerial LoRaSerial;
-        String cmd = "AT+CRFOP=" + String(power);
-        LoRaSerial.println(cmd);
-        delay(50);
-        Serial.print("✓ TX power set to ");
-        Serial.print(power);
-        Serial.println(" dBm");
+    switch (remoteCommand(payload, len)) {
+      // STATUS - Send full status report
+      case REMOTE_CMD_STATUS: {
+        String status = buildStatusReport();
+        Serial.println("→ Sending status report");
+        // Send via LoRa (function must be implemented in main code)
+        extern void sendLoRaMessage(String payload, int address);
+        sendLoRaMessage(status, LORA_SENDER_ADDRESS);
         cmdStats.commandsExecuted++;
-      } else {
-        Serial.println("❌ Invalid power (0-20 dBm)");
-        cmdStats.commandsRejected++;
+        break;
       }
-    }
 
-    // SET_SF:X - Set spreading factor
-    else if (command.startsWith("SET_SF:")) {
-      int sf = command.substring(7).toInt();
-      if (sf >= 7 && sf <= 12) {
-        extern HardwareSerial LoRaSerial;
-        String cmd = "AT+PARAMETER=" + String(sf) + ",7,1,4";
-        LoRaSerial.println(cmd);
-        delay(50);
-        Serial.print("✓ Spreading factor set to SF");
-        Serial.println(sf);
+      // RESET_STATS - Reset counters
+      case REMOTE_CMD_RESET_STATS: {
+        extern HealthMonitor health;
+        health.packetsReceived = 0;
+        health.packetsLost = 0;
+        health.rssiSum = 0;
+        health.rssiCount = 0;
+        Serial.println("✓ Statistics reset");
         cmdStats.commandsExecuted++;
-      } else {
-        Serial.println("❌ Invalid SF (7-12)");
-        cmdStats.commandsRejected++;
+        break;
       }
-    }
 
-    // SET_INTERVAL:X - Set send interval
-    else if (command.startsWith("SET_INTERVAL:")) {
-      int interval = command.substring(13).toInt();
-      if (interval >= 100 && interval <= 60000) {
-        #if ENABLE_RUNTIME_CONFIG
-          extern RuntimeConfig runtimeCfg;
-          runtimeCfg.sendInterval = interval;
-        #endif
-        Serial.print("✓ Send interval set to ");
-        Serial.print(interval);
-        Serial.println(" ms");
+      // PING - Simple connectivity test
+      case REMOTE_CMD_PING: {
+        Serial.println("→ Responding to PING with PONG");
+        extern void sendLoRaMessage(String payload, int address);
+        sendLoRaMessage("PONG", LORA_SENDER_ADDRESS);
         cmdStats.commandsExecuted++;
-      } else {
-        Serial.println("❌ Invalid interval (100-60000 ms)");
-        cmdStats.commandsRejected++;
+        break;
       }
-    }
 
-    // LED_ON - Turn LED on
-    else if (command == "LED_ON") {
-      digitalWrite(LED_PIN, HIGH);
-      Serial.println("✓ LED turned ON");
-      cmdStats.commandsExecuted++;
-    }
-
-    // LED_OFF - Turn LED off
-    else if (command == "LED_OFF") {
-      digitalWrite(LED_PIN, LOW);
-      Serial.println("✓ LED turned OFF");
-      cmdStats.commandsExecuted++;
-    }
-
-    // LED_BLINK:X - Blink LED X times
-    else if (command.startsWith("LED_BLINK:")) {
-      int times = command.substring(10).toInt();
-      if (times >= 1 && times <= 20) {
-        Serial.print("✓ Blinking LED ");
-        Serial.print(times);
-        Serial.println(" times");
-        blinkLED(times);
+      // SET_POWER:X - Set TX power
+      case REMOTE_CMD_SET_POWER:
+        if (arg >= 0 && arg <= 20) {
+          extern HardwareSerial LoRaSerial;
+          LoRaSerial.print("AT+CRFOP=");
+          LoRaSerial.println(arg);
+          delay(50);
+          Serial.print("✓ TX power set to ");
+          Serial.print(arg);
+          Serial.println(" dBm");
+          cmdStats.commandsExecuted++;
+        } else {
+          Serial.println("❌ Invalid power (0-20 dBm)");
+          cmdStats.commandsRejected++;
+        }
+        break;
+
+      // SET_SF:X - Set spreading factor
+      case REMOTE_CMD_SET_SF:
+        if (arg >= 7 && arg <= 12) {
+          extern HardwareSerial LoRaSerial;
+          LoRaSerial.print("AT+PARAMETER=");
+          LoRaSerial.print(arg);
+          LoRaSerial.println(",7,1,4");
+          delay(50);
+          Serial.print("✓ Spreading factor set to SF");
+          Serial.println(arg);
+          cmdStats.commandsExecuted++;
+        } else {
+          Serial.println("❌ Invalid SF (7-12)");
+          cmdStats.commandsRejected++;
+        }
+        break;
+
+      // SET_INTERVAL:X - Set send interval
+      case REMOTE_CMD_SET_INTERVAL:
+        if (arg >= 100 && arg <= 60000) {
+          #if ENABLE_RUNTIME_CONFIG
+            extern RuntimeConfig runtimeCfg;
+            runtimeCfg.sendInterval = arg;
+          #endif
+          Serial.print("✓ Send interval set to ");
+          Serial.print(arg);
+          Serial.println(" ms");
+          cmdStats.commandsExecuted++;
+        } else {
+          Serial.println("❌ Invalid interval (100-60000 ms)");
+          cmdStats.commandsRejected++;
+        }
+        break;
+
+      // LED_ON - Turn LED on
+      case REMOTE_CMD_LED_ON:
+        digitalWrite(LED_PIN, HIGH);
+        Serial.println("✓ LED turned ON");
         cmdStats.commandsExecuted++;
-      } else {
-        Serial.println("❌ Invalid blink count (1-20)");
-        cmdStats.commandsRejected++;
-      }
-    }
-
-    // GET_RSSI - Request RSSI report
-    else if (command == "GET_RSSI") {
-      extern DeviceState remote;
-      String response = "RSSI:" + String(remote.rssi) + ",SNR:" + String(remote.snr);
-      Serial.println("→ Sending RSSI report");
-      extern void sendLoRaMessage(String payload, int address);
-      sendLoRaMessage(response, LORA_SENDER_ADDRESS);
-      cmdStats.commandsExecuted++;
-    }
+        break;
 
-    // GET_BATTERY - Request battery voltage
-    else if (command == "GET_BATTERY") {
-      #if ENABLE_BATTERY_MONITOR
-        extern BatteryStatus battery;
-        String response = "BATTERY:" + String(battery.voltage, 2) + "V";
-        Serial.println("→ Sending battery report");
+      // LED_OFF - Turn LED off
+      case REMOTE_CMD_LED_OFF:
+        digitalWrite(LED_PIN, LOW);
+        Serial.println("✓ LED turned OFF");
+        cmdStats.commandsExecuted++;
+        break;
+
+      // LED_BLINK:X - Blink LED X times
+      case REMOTE_CMD_LED_BLINK:
+        if (arg >= 1 && arg <= 20) {
+          Serial.print("✓ Blinking LED ");
+          Serial.print(arg);
+          Serial.println(" times");
+          blinkLED(arg);
+          cmdStats.commandsExecuted++;
+        } else {
+          Serial.println("❌ Invalid blink count (1-20)");
+          cmdStats.commandsRejected++;
+        }
+        break;
+
+      // GET_RSSI - Request RSSI report
+      case REMOTE_CMD_GET_RSSI: {
+        extern DeviceState remote;
+        String response = "RSSI:" + String(remote.rssi) + ",SNR:" + String(remote.snr);
+        Serial.println("→ Sending RSSI report");
         extern void sendLoRaMessage(String payload, int address);
         sendLoRaMessage(response, LORA_SENDER_ADDRESS);
         cmdStats.commandsExecuted++;
-      #else
-        Serial.println("⚠ Battery monitoring disabled");
-        cmdStats.commandsRejected++;
-      #endif
-    }
+        break;
+      }
 
-    // RESTART - Reboot device (already implemented in main code)
-    else if (command == "RESTART") {
-      Serial.println("🔴 RESTART command - handled by main code");
-      // Don't increment counter here, main code handles it
-    }
+      // GET_BATTERY - Request battery voltage
+      case REMOTE_CMD_GET_BATTERY: {
+        #if ENABLE_BATTERY_MONITOR
+          extern BatteryStatus battery;
+          String response = "BATTERY:" + String(battery.voltage, 2) + "V";
+          Serial.println("→ Sending battery report");
+          extern void sendLoRaMessage(String payload, int address);
+          sendLoRaMessage(response, LORA_SENDER_ADDRESS);
+          cmdStats.commandsExecuted++;
+        #else
+          Serial.println("⚠ Battery monitoring disabled");
+          cmdStats.commandsRejected++;
+        #endif
+        break;
+      }
 
-    // Unknown command
-    else {
-      Serial.print("❌ Unknown command: ");
-      Serial.println(command);
-      cmdStats.commandsRejected++;
+      // RESTART / STOP - Handled by main code (processRemoteKillSwitch())
+      case REMOTE_CMD_RESTART:
+      case REMOTE_CMD_STOP:
+        Serial.println("🔴 Kill-switch command - handled by main code");
+        // Don't increment counter here, main code handles it
+        break;
+
+      // Unknown command
+      default:
+        Serial.print("❌ Unknown command: ");
+        Serial.println(cmdStats.lastCommand);
+        cmdStats.commandsRejected++;
+        break;
     }
 
   #endif
@@ -0,0 +1,200 @@
+/*=====================================================================
+  airtime.h - LoRa Time-on-Air Model & Duty-Cycle Budget
+
+  1. Airtime model (Semtech AN1200.13 / SX1276 datasheet formula)
+
+     Tsym     = 2^SF / BW
+     Tpre     = (Npreamble + 4.25) × Tsym
+     Npayload = 8 + max(ceil((8PL - 4SF + 28 + 16CRC - 20IH)
+                             / (4(SF - 2DE))) × (CR + 4), 0)
+     Tair     = Tpre + Npayload × Tsym
+
+     RYLR896: explicit header (IH=0), CRC on, low data rate
+     optimisation (DE=1) automatically when Tsym ≥ 16 ms (SF11/12 @125k)
+
+     All functions are constexpr - constants like the ACK window can
+     be computed at compile time.
+
+     SF12 / BW125 / CR4/5 / preamble 4:
+       PL  5 bytes →  697 ms     PL 20 bytes → 1188 ms
+       PL 10 bytes →  861 ms     PL 40 bytes → 1844 ms
+
+  2. Duty-cycle budget (token bucket)
+
+     EU 868 MHz g1 sub-band: 1% duty cycle → 36 s airtime per hour.
+     Tokens are microseconds of airtime:
+     - Refill: DUTY_CYCLE_PERMILLE µs per elapsed ms (10 = 1%)
+     - Burst:  DUTY_CYCLE_BURST_MS of airtime may be spent at once
+     - Send only if the bucket holds the packet's airtime
+
+     Deferred sends are simply retried later with fresh data, so
+     telemetry snapshots coalesce instead of queueing up.
+
+     NOTE: 2 s send interval at SF12 is ~35% duty cycle! With the
+     limit enabled the effective rate at SF12 is ~1 packet / 70 s.
+
+  3. Link budget (SX1276 datasheet)
+
+     SNR floor   = -7.5 - 2.5 × (SF - 7) dB   (SF7 -7.5 ... SF12 -20)
+     Sensitivity = -174 + 10·log10(BW) + NF 6 dB + SNR floor
+                   (BW125: SF7 -124.5 dBm ... SF12 -137 dBm)
+
+     SNR stops rising around +10 dB on a strong link, so the margin
+     used by adaptive_sf.h / tx_power.h is the smaller of the SNR and
+     RSSI margins.
+=======================================================================*/
+
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include <Arduino.h>
+
+// =============== RADIO PARAMETERS ================================
+// Mirrors AT+PARAMETER=<SF>,<BW>,<CR>,<Preamble>
+struct LoRaParams {
+  uint8_t sf;        // 7-12
+  uint8_t bw;        // RYLR896 code: 7=125kHz, 8=250kHz, 9=500kHz
+  uint8_t cr;        // 1-4 → 4/5 .. 4/8
+  uint8_t preamble;  // Programmed preamble length
+};
+
+// RYLR896 bandwidth code → Hz
+constexpr uint32_t loraBandwidthHz(uint8_t bw) {
+  return bw == 0 ? 7800 :
+         bw == 1 ? 10400 :
+         bw == 2 ? 15600 :
+         bw == 3 ? 20800 :
+         bw == 4 ? 31250 :
+         bw == 5 ? 41700 :
+         bw == 6 ? 62500 :
+         bw == 7 ? 125000 :
+         bw == 8 ? 250000 : 500000;
+}
+
+// Symbol time in microseconds
+constexpr uint32_t loraSymbolUs(uint8_t sf, uint8_t bw) {
+  return (uint32_t)(((uint64_t)1000000 << sf) / loraBandwidthHz(bw));
+}
+
+// Low data rate optimisation (mandatory above 16 ms symbols)
+constexpr uint8_t loraLowDataRate(uint8_t sf, uint8_t bw) {
+  return loraSymbolUs(sf, bw) >= 16000 ? 1 : 0;
+}
+
+constexpr int32_t loraCeilDiv(int32_t num, int32_t den) {
+  return num <= 0 ? 0 : (num + den - 1) / den;
+}
+
+// Number of payload symbols (explicit header, CRC on)
+constexpr uint32_t loraPayloadSymbols(uint8_t payloadLen, uint8_t sf, uint8_t bw, uint8_t cr) {
+  return 8 + loraCeilDiv(8 * (int32_t)payloadLen - 4 * sf + 28 + 16,
+                         4 * (sf - 2 * loraLowDataRate(sf, bw))) * (cr + 4);
+}
+
+// Time on air in microseconds
+constexpr uint32_t loraAirtimeUs(uint8_t payloadLen, uint8_t sf, uint8_t bw,
+                                 uint8_t cr, uint8_t preamble) {
+  return ((4 * (uint32_t)preamble + 17) * loraSymbolUs(sf, bw)) / 4 +
+         loraPayloadSymbols(payloadLen, sf, bw, cr) * loraSymbolUs(sf, bw);
+}
+
+constexpr uint32_t loraAirtimeUs(uint8_t payloadLen, const LoRaParams& p) {
+  return loraAirtimeUs(payloadLen, p.sf, p.bw, p.cr, p.preamble);
+}
+
+// Time on air in milliseconds (rounded up)
+constexpr uint32_t loraAirtimeMs(uint8_t payloadLen, const LoRaParams& p) {
+  return (loraAirtimeUs(payloadLen, p) + 999) / 1000;
+}
+
+// =============== LINK BUDGET ================================
+// Demodulation floor (dB SNR) per spreading factor
+constexpr float loraSnrFloor(uint8_t sf) {
+  return -7.5f - 2.5f * (sf - 7);
+}
+
+// 10·log10(bandwidth in Hz) per RYLR896 bandwidth code
+constexpr float loraBandwidthDb(uint8_t bw) {
+  return bw == 0 ? 38.9f :
+         bw == 1 ? 40.2f :
+         bw == 2 ? 41.9f :
+         bw == 3 ? 43.2f :
+         bw == 4 ? 44.9f :
+         bw == 5 ? 46.2f :
+         bw == 6 ? 48.0f :
+         bw == 7 ? 51.0f :
+         bw == 8 ? 54.0f : 57.0f;
+}
+
+// Receiver sensitivity (dBm), noise figure 6 dB
+constexpr float loraSensitivityDbm(const LoRaParams& p) {
+  return -174.0f + loraBandwidthDb(p.bw) + 6.0f + loraSnrFloor(p.sf);
+}
+
+// Link margin (dB) of a packet heard with rssi/snr
+inline float loraLinkMargin(int16_t rssi, int8_t snr, const LoRaParams& p) {
+  float snrMargin = snr - loraSnrFloor(p.sf);
+  float rssiMargin = rssi - loraSensitivityDbm(p);
+  return snrMargin < rssiMargin ? snrMargin : rssiMargin;
+}
+
+// =============== DUTY-CYCLE TOKEN BUCKET ================================
+struct DutyCycleBudget {
+  uint32_t tokensUs;         // Available airtime (µs)
+  uint32_t capacityUs;       // Bucket size (µs)
+  uint16_t permille;         // Allowed duty cycle (10 = 1%)
+  unsigned long lastRefill;  // millis() of last refill
+
+  // Statistics
+  unsigned long packetsAllowed;
+  unsigned long packetsDeferred;
+  unsigned long airtimeUsedMs;
+};
+
+inline void dutyCycleInit(DutyCycleBudget& b, uint16_t permille, uint32_t burstMs) {
+  b.capacityUs = burstMs * 1000;
+  b.tokensUs = b.capacityUs;  // Start full: first packets go out at once
+  b.permille = permille;
+  b.lastRefill = millis();
+  b.packetsAllowed = 0;
+  b.packetsDeferred = 0;
+  b.airtimeUsedMs = 0;
+}
+
+inline void dutyCycleRefill(DutyCycleBudget& b) {
+  unsigned long now = millis();
+  unsigned long elapsed = now - b.lastRefill;
+  if (elapsed == 0) return;
+  b.lastRefill = now;
+
+  // elapsed ms × permille = µs of airtime earned
+  uint64_t tokens = (uint64_t)b.tokensUs + (uint64_t)elapsed * b.permille;
+  b.tokensUs = tokens > b.capacityUs ? b.capacityUs : (uint32_t)tokens;
+}
+
+// Non-consuming check
+inline bool dutyCycleAllows(DutyCycleBudget& b, uint32_t airtimeUs) {
+  dutyCycleRefill(b);
+  return b.tokensUs >= airtimeUs;
+}
+
+// Spend airtime if available; counts deferrals otherwise
+inline bool dutyCycleTryConsume(DutyCycleBudget& b, uint32_t airtimeUs) {
+  if (!dutyCycleAllows(b, airtimeUs)) {
+    b.packetsDeferred++;
+    return false;
+  }
+  b.tokensUs -= airtimeUs;
+  b.packetsAllowed++;
+  b.airtimeUsedMs += (airtimeUs + 999) / 1000;
+  return true;
+}
+
+// Milliseconds until a packet of airtimeUs fits the budget
+inline unsigned long dutyCycleWaitMs(DutyCycleBudget& b, uint32_t airtimeUs) {
+  dutyCycleRefill(b);
+  if (b.tokensUs >= airtimeUs || b.permille == 0) return 0;
+  return (airtimeUs - b.tokensUs + b.permille - 1) / b.permille;
+}
+
+#endif // AIRTIME_H
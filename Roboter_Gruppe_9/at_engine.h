@@ -0,0 +1,366 @@
+/*=====================================================================
+  at_engine.h - Non-blocking RYLR896 AT Command Engine
+
+  Replaces the busy-wait AT exchange (send command, spin on
+  LoRaSerial.available() until "+OK" or timeout) with a queue of
+  outstanding commands and a byte-at-a-time response state machine.
+
+  How it works:
+  1. atEnqueue() copies the command into a small fixed queue
+  2. atPoll() is called every loop():
+     - Reads whatever bytes the UART has (never waits)
+     - Assembles lines, classifies them:
+         +RCV=...          → unsolicited handler (received packet,
+                             data read by length - see lora_rx.h)
+         +READY            → readySeen flag (after AT+RESET)
+         expected answer   → response to the command in flight
+         anything else     → stray (counted, dropped)
+     - Completes the in-flight command on response or timeout
+     - Writes the next queued command when the modem is idle
+  3. Completion callback receives result + response line
+
+  Only one command is on the wire at a time (the RYLR896 answers
+  strictly in order), so the queue gives ordering, not parallelism.
+
+  A timed-out command may still be answered later - a slow AT+SEND
+  says "+OK" when its TX ends. That answer must not complete the next
+  command, so:
+  - Every command only accepts its own answer: a query "AT+X?" wants
+    "+X=...", AT+RESET "+RESET", everything else "+OK", and
+    all of them "+ERR=n". A late "+OK" never answers AT+ADDRESS?.
+  - After a timeout the next command waits for a drain period
+    (AT_DRAIN_MS, ended early by the late answer) so a late "+OK" is
+    not taken as the answer of the next "+OK" command either.
+
+  RYLR896 answers:
+  - AT / AT+ADDRESS=x / AT+SEND=... → "+OK"   (SEND: after TX ends!)
+  - AT+ADDRESS? etc.                → "+ADDRESS=2"
+  - Error                           → "+ERR=n"
+  - AT+RESET                        → "+RESET" then "+READY"
+
+  The engine only depends on the Arduino Stream interface, so it can
+  be driven on a Linux host by any Stream that replays a script
+  (host/test_at_engine.cpp).
+
+  Memory: AT_QUEUE_SIZE × AT_CMD_MAX + AT_LINE_MAX (~1.4 KB), static.
+=======================================================================*/
+
+#ifndef AT_ENGINE_H
+#define AT_ENGINE_H
+
+#include <Arduino.h>
+#include "lora_rx.h"
+
+// Engine limits
+#define AT_QUEUE_SIZE 4          // Outstanding commands (incl. in flight)
+#define AT_CMD_MAX 264           // "AT+SEND=65535,240,<240 bytes>" + NUL
+#define AT_LINE_MAX 272          // Longest "+RCV=" line + NUL
+#define AT_POLL_BYTE_BUDGET 256  // Max bytes consumed per atPoll() call
+#define AT_EXPECT_MAX 16         // "+NETWORKID=" + NUL
+#define AT_DRAIN_MS 300          // Quiet period after a timeout
+
+// Command completion result
+enum ATResult {
+  AT_RESULT_OK = 0,       // "+OK" or query answer ("+ADDRESS=2")
+  AT_RESULT_ERROR = 1,    // "+ERR=n"
+  AT_RESULT_TIMEOUT = 2,  // No answer within timeout
+  AT_RESULT_DROPPED = 3   // Flushed from queue (atReset)
+};
+
+// Completion callback: response is the answer line (empty on timeout)
+typedef void (*ATCallback)(ATResult result, const char* response, void* ctx);
+
+// Unsolicited line handler (+RCV=...), len excludes NUL
+typedef void (*ATLineHandler)(const char* line, uint16_t len);
+
+// Queued command
+struct ATCommand {
+  char text[AT_CMD_MAX];
+  uint16_t length;
+  unsigned long timeout;
+  ATCallback callback;
+  void* ctx;
+};
+
+// Engine state
+struct ATEngine {
+  Stream* port;
+
+  // Command queue (ring)
+  ATCommand queue[AT_QUEUE_SIZE];
+  uint8_t head;                  // Oldest command (in flight if busy)
+  uint8_t count;
+
+  // In-flight command
+  bool busy;
+  unsigned long sentAt;
+  char expect[AT_EXPECT_MAX];    // Answer prefix ("+OK", "+ADDRESS=", ...)
+
+  // Drain after a timeout: late answer still possible
+  bool draining;
+  unsigned long drainStart;
+
+  // Response line assembly
+  char line[AT_LINE_MAX];
+  uint16_t lineLen;
+  bool lineOverflow;
+  uint8_t rcvDataRemaining;      // +RCV data bytes still to read raw
+
+  // Unsolicited lines
+  ATLineHandler onLine;
+  bool readySeen;
+
+  // Statistics
+  unsigned long commandsSent;
+  unsigned long commandsOk;
+  unsigned long commandsError;
+  unsigned long commandsTimeout;
+  unsigned long queueFull;
+  unsigned long linesOverflowed;
+  unsigned long strayLines;      // Answers nothing in flight was waiting for
+  unsigned long maxLatency;      // Longest command round-trip (ms)
+};
+
+// =============== INITIALIZE ================================
+inline void atBegin(ATEngine& at, Stream& port, ATLineHandler onLine = nullptr) {
+  at.port = &port;
+  at.head = 0;
+  at.count = 0;
+  at.busy = false;
+  at.sentAt = 0;
+  at.expect[0] = '\0';
+  at.draining = false;
+  at.drainStart = 0;
+  at.lineLen = 0;
+  at.lineOverflow = false;
+  at.rcvDataRemaining = 0;
+  at.onLine = onLine;
+  at.readySeen = false;
+
+  at.commandsSent = 0;
+  at.commandsOk = 0;
+  at.commandsError = 0;
+  at.commandsTimeout = 0;
+  at.queueFull = 0;
+  at.linesOverflowed = 0;
+  at.strayLines = 0;
+  at.maxLatency = 0;
+}
+
+// =============== QUEUE STATE ================================
+inline bool atIsIdle(const ATEngine& at) {
+  return at.count == 0;
+}
+
+inline uint8_t atPending(const ATEngine& at) {
+  return at.count;
+}
+
+// =============== ENQUEUE COMMAND ================================
+// Returns false if the queue is full or the command is too long.
+// The callback runs later from atPoll(), never from atEnqueue().
+inline bool atEnqueue(ATEngine& at, const char* text, uint16_t length,
+                      unsigned long timeout, ATCallback callback = nullptr,
+                      void* ctx = nullptr) {
+  if (at.count >= AT_QUEUE_SIZE || length >= AT_CMD_MAX) {
+    at.queueFull++;
+    return false;
+  }
+
+  ATCommand& cmd = at.queue[(at.head + at.count) % AT_QUEUE_SIZE];
+  memcpy(cmd.text, text, length);
+  cmd.text[length] = '\0';
+  cmd.length = length;
+  cmd.timeout = timeout;
+  cmd.callback = callback;
+  cmd.ctx = ctx;
+  at.count++;
+  return true;
+}
+
+inline bool atEnqueue(ATEngine& at, const char* text, unsigned long timeout,
+                      ATCallback callback = nullptr, void* ctx = nullptr) {
+  return atEnqueue(at, text, strlen(text), timeout, callback, ctx);
+}
+
+// =============== EXPECTED ANSWER ================================
+// "AT+ADDRESS?" → "+ADDRESS=", "AT+RESET" → "+RESET", else "+OK"
+inline void atExpectedAnswer(const ATCommand& cmd, char* expect) {
+  uint16_t n = cmd.length;
+  if (n > 3 && cmd.text[n - 1] == '?' && n - 2 < AT_EXPECT_MAX - 1) {
+    memcpy(expect, cmd.text + 2, n - 3);  // "+ADDRESS"
+    expect[n - 3] = '=';
+    expect[n - 2] = '\0';
+  } else if (strcmp(cmd.text, "AT+RESET") == 0) {
+    strcpy(expect, "+RESET");
+  } else {
+    strcpy(expect, "+OK");
+  }
+}
+
+inline bool atIsAnswer(const ATEngine& at, const char* line) {
+  if (strncmp(line, "+ERR", 4) == 0) return true;
+  return strncmp(line, at.expect, strlen(at.expect)) == 0;
+}
+
+// =============== COMPLETE IN-FLIGHT COMMAND ================================
+inline void atComplete(ATEngine& at, ATResult result, const char* response) {
+  ATCommand& cmd = at.queue[at.head];
+  ATCallback callback = cmd.callback;
+  void* ctx = cmd.ctx;
+
+  if (at.busy) {
+    unsigned long latency = millis() - at.sentAt;
+    if (latency > at.maxLatency) at.maxLatency = latency;
+  }
+
+  switch (result) {
+    case AT_RESULT_OK:      at.commandsOk++; break;
+    case AT_RESULT_ERROR:   at.commandsError++; break;
+    case AT_RESULT_TIMEOUT: at.commandsTimeout++; break;
+    default: break;
+  }
+
+  // Pop before the callback so it may enqueue follow-up commands
+  at.head = (at.head + 1) % AT_QUEUE_SIZE;
+  at.count--;
+  at.busy = false;
+
+  if (callback) callback(result, response, ctx);
+}
+
+// =============== HANDLE ONE COMPLETE LINE ================================
+inline void atHandleLine(ATEngine& at) {
+  at.line[at.lineLen] = '\0';
+
+  // Received packet: never an answer to our command
+  if (strncmp(at.line, "+RCV=", 5) == 0) {
+    if (at.onLine) at.onLine(at.line, at.lineLen);
+    return;
+  }
+
+  // Module (re)boot banner
+  if (strncmp(at.line, "+READY", 6) == 0) {
+    at.readySeen = true;
+    return;
+  }
+
+  // The answer the command in flight waits for
+  if (at.busy && atIsAnswer(at, at.line)) {
+    ATResult result = (strncmp(at.line, "+ERR", 4) == 0) ? AT_RESULT_ERROR : AT_RESULT_OK;
+    atComplete(at, result, at.line);
+    return;
+  }
+
+  // Late answer of a timed-out command (or noise): dropped. During the
+  // drain it was the answer we waited for - the module is in step again
+  at.strayLines++;
+  at.draining = false;
+}
+
+// =============== POLL (call every loop) ================================
+// Non-blocking: consumes at most AT_POLL_BYTE_BUDGET bytes and returns.
+inline void atPoll(ATEngine& at) {
+  if (!at.port) return;
+
+  // 1. Consume available bytes, one at a time
+  int budget = AT_POLL_BYTE_BUDGET;
+  while (budget-- > 0 && at.port->available() > 0) {
+    int c = at.port->read();
+    if (c < 0) break;
+
+    // +RCV data field: length-prefixed, may contain CR/LF
+    if (at.rcvDataRemaining > 0) {
+      at.rcvDataRemaining--;
+      if (at.lineLen < AT_LINE_MAX - 1) {
+        at.line[at.lineLen++] = (char)c;
+      } else {
+        at.lineOverflow = true;
+      }
+      continue;
+    }
+
+    if (c == '\r' || c == '\n') {
+      if (at.lineLen > 0) {
+        if (at.lineOverflow) {
+          at.linesOverflowed++;
+        } else {
+          atHandleLine(at);
+        }
+      }
+      at.lineLen = 0;
+      at.lineOverflow = false;
+      continue;
+    }
+
+    if (at.lineLen < AT_LINE_MAX - 1) {
+      at.line[at.lineLen++] = (char)c;
+    } else {
+      at.lineOverflow = true;  // Discard rest of line
+    }
+
+    // "+RCV=<addr>,<len>," complete → read <len> data bytes raw
+    if (c == ',' && at.line[0] == '+') {
+      int dataLength = rcvHeaderDataLength(at.line, at.lineLen);
+      if (dataLength > 0) at.rcvDataRemaining = dataLength;
+    }
+  }
+
+  // 2. Time out the command in flight
+  if (at.busy && millis() - at.sentAt >= at.queue[at.head].timeout) {
+    at.draining = true;
+    at.drainStart = millis();
+    atComplete(at, AT_RESULT_TIMEOUT, "");
+  }
+
+  // 3. Drain: a late answer of the timed-out command may still come
+  if (at.draining && millis() - at.drainStart >= AT_DRAIN_MS) {
+    at.draining = false;
+  }
+
+  // 4. Start the next command
+  if (!at.busy && !at.draining && at.count > 0) {
+    ATCommand& cmd = at.queue[at.head];
+    at.port->write((const uint8_t*)cmd.text, cmd.length);
+    at.port->write((const uint8_t*)"\r\n", 2);
+    atExpectedAnswer(cmd, at.expect);
+    at.busy = true;
+    at.sentAt = millis();
+    at.commandsSent++;
+  }
+}
+
+// =============== FLUSH QUEUE ================================
+// Drops every queued command (callbacks get AT_RESULT_DROPPED).
+inline void atReset(ATEngine& at) {
+  while (at.count > 0) {
+    atComplete(at, AT_RESULT_DROPPED, "");
+  }
+  at.lineLen = 0;
+  at.lineOverflow = false;
+  at.rcvDataRemaining = 0;
+  at.draining = false;
+}
+
+// =============== PRINT STATISTICS ================================
+inline void printATEngineStats(const ATEngine& at) {
+  Serial.println("\n╔════════ AT ENGINE ════════╗");
+  Serial.print("║ Sent:       ");
+  Serial.println(at.commandsSent);
+  Serial.print("║ OK:         ");
+  Serial.println(at.commandsOk);
+  Serial.print("║ Error:      ");
+  Serial.println(at.commandsError);
+  Serial.print("║ Timeout:    ");
+  Serial.println(at.commandsTimeout);
+  Serial.print("║ Queue full: ");
+  Serial.println(at.queueFull);
+  Serial.print("║ Stray:      ");
+  Serial.println(at.strayLines);
+  Serial.print("║ Max RTT:    ");
+  Serial.print(at.maxLatency);
+  Serial.println(" ms");
+  Serial.println("╚═══════════════════════════╝\n");
+}
+
+#endif // AT_ENGINE_H
@@ -297,13 +297,8 @@ void updateAudioDetection() {
           Serial.println(audio.peakCount);
           Serial.println("  Sending LoRa alert...");
 
-          // Send alert via LoRa
-          #if defined(LORA_SENDER_ADDRESS)
-            extern void sendLoRaMessage(String payload, int address);
-            String alert = "ALERT:FIRE_AUDIO,RMS:" + String(audio.currentRMS) +
-                          ",PEAKS:" + String(audio.peakCount);
-            sendLoRaMessage(alert, LORA_SENDER_ADDRESS);
-          #endif
+          // LoRa alert: fire_alarm_detector.h → onFireAlarmAlert() → priority
+          // queue (tx_queue.h) - never straight to the radio
 
           audio.alertCount++;
           audio.lastAlertTime = now;
@@ -331,12 +326,7 @@ void updateAudioDetection() {
 
       Serial.println("🚨 Alarm still active, sending reminder...");
 
-      #if defined(LORA_SENDER_ADDRESS)
-        extern void sendLoRaMessage(String payload, int address);
-        String alert = "ALERT:FIRE_AUDIO,RMS:" + String(audio.currentRMS) +
-                      ",DURATION:" + String((now - audio.alarmStartTime) / 1000);
-        sendLoRaMessage(alert, LORA_SENDER_ADDRESS);
-      #endif
+      // Repeats go out through fire_alarm_detector.h → onFireAlarmAlert()
 
       audio.lastAlertTime = now;
     }
@@ -8,6 +8,8 @@
   - MODE_GND_PIN (GPIO17) provides GND reference
   - When GPIO16 is connected to GPIO17: RECEIVER mode
   - When GPIO16 is floating (no connection): SENDER mode
+  - When GPIO16 is connected to 3V3: RELAY mode (ENABLE_RELAY only,
+    read with internal pull-down first)
   - Note: GPIO16 and GPIO17 are physically next to each other
 =======================================================================*/
 
@@ -30,6 +32,7 @@
 #define LORA_DISPLAY_ADDRESS 3    // Display station ID (ESP32-2432S022)
 #define LORA_NETWORK_ID 6         // Network ID (sama kaikilla!)
 #define LORA_BAUDRATE 115200      // RYLR896 baudrate
+#define LORA_SPREADING_FACTOR 12  // SF at boot (7-12, sama kaikilla!)
 
 // =============== COMMUNICATION ================================
 #define SERIAL2_BAUDRATE 115200   // Sama kuin LORA_BAUDRATE (yhteensopivuus)
@@ -52,10 +55,140 @@
 #define ENABLE_JSON_OUTPUT false     // Enable JSON data output (alternative format)
 #define DATA_OUTPUT_INTERVAL 2000    // Output interval in ms (2 seconds)
 
+// =============== PAYLOAD FORMAT ================================
+// Binary telemetry frame (telemetry_frame.h): 5 bytes instead of ~40 ASCII
+// Receiver always accepts both formats; set false if old receivers remain
+#define TELEMETRY_BINARY_FORMAT true
+
+// =============== BATCHED UPLINK ================================
+// Pack several snapshots into one packet (telemetry_batch.h): less
+// preamble/header overhead per sample, more data per duty-cycle second.
+// Receiver always unpacks batches; set the same value on both devices
+// (receiver watchdog timeouts follow BATCH_MAX_LATENCY)
+#define ENABLE_TELEMETRY_BATCH false
+#define BATCH_SAMPLES 8              // Send when this many samples are buffered
+#define BATCH_SAMPLE_INTERVAL 2000   // Snapshot interval (ms)
+#define BATCH_MAX_LATENCY 20000      // Send partial batch at this sample age (ms)
+
+// =============== AIRTIME & DUTY CYCLE ================================
+// Timeouts are derived from the real time-on-air (airtime.h):
+//   AT+SEND timeout = airtime + LORA_TIMEOUT_MARGIN
+//   ACK RX slot     = ACK_SLOT_OFFSET + ACK airtime ± ACK_SLOT_GUARD
+#define SEND_INTERVAL 2000           // Sender telemetry interval (ms, minimum)
+#define LORA_TIMEOUT_MARGIN 500      // UART + module processing on top of airtime (ms)
+
+// Send-on-change (uplink_policy.h): uplink at once when a watched field
+// changes (touch edge), otherwise a heartbeat every HEARTBEAT_INTERVAL.
+// Frames advertise the interval - the receiver's WEAK/LOST timeouts
+// stretch to match, so only the sender needs the setting.
+#define ENABLE_SEND_ON_CHANGE false
+#define HEARTBEAT_INTERVAL 60000     // Keepalive when nothing changes (ms)
+#define UPLINK_MIN_GAP SEND_INTERVAL // Min gap between event uplinks (ms)
+
+// Token bucket: defer sends that would exceed the duty cycle.
+// NOTE: SEND_INTERVAL 2000 at SF12 is ~35% duty cycle - enabling the
+// limit drops the rate to ~1 packet / 70 s at SF12 (~2 s at SF7)
+#define ENABLE_DUTY_CYCLE_LIMIT false
+#if LORA_BAND == 868
+  #define DUTY_CYCLE_PERMILLE 10     // 1% (EU 868 MHz g1 sub-band)
+#else
+  #define DUTY_CYCLE_PERMILLE 1000   // No duty-cycle limit
+#endif
+#define DUTY_CYCLE_BURST_MS 3000     // Airtime that may be spent in one burst
+
 // =============== BI-DIRECTIONAL COMMUNICATION ================================
 #define ENABLE_BIDIRECTIONAL true    // Enable two-way communication
-#define ACK_INTERVAL 5               // Send ACK every N messages (receiver)
-#define LISTEN_TIMEOUT 500           // Time sender listens for response (ms)
+#define ACK_INTERVAL 5               // Sender requests an ACK every N messages
+// Scheduled ACK slot (ack_slot.h): receiver sends the ACK ACK_SLOT_OFFSET
+// after the uplink and announces the offset in the ACK; the sender only
+// listens ±ACK_SLOT_GUARD around the expected ACK arrival
+#define ACK_SLOT_OFFSET 100          // Uplink end → ACK start (ms, announced)
+#define ACK_SLOT_GUARD 100           // UART/loop latency tolerance (ms)
+
+// =============== RELIABLE DELIVERY ================================
+// Selective-repeat ARQ for fire alarms and remote commands
+// (reliable_link.h): retransmit ring on the sender, 32-bit bitmap ACK
+// in the ACK slot. Telemetry stays fire-and-forget.
+#define ENABLE_RELIABLE_LINK false
+#define REL_WINDOW 8                 // Unconfirmed messages kept for resend (max 32)
+#define REL_MAX_TRIES 6              // Sends before a message is given up
+#define REL_RETRY_MS 10000           // Resend if no ACK answers at all (ms)
+
+// =============== PRIORITY TRANSMIT ================================
+// Sender picks the next frame by priority (tx_queue.h): fire alerts,
+// then remote commands, then telemetry. Without ENABLE_RELIABLE_LINK
+// alerts and "CMD:..." lines wait here (unconfirmed, sent once).
+#define TXQ_SIZE 4                   // Queued alerts + commands (full: alerts merge)
+
+// =============== FORWARD ERROR CORRECTION ================================
+// Parity frames across groups of uplink frames (fec.h): the receiver
+// rebuilds up to FEC_PARITY_COUNT lost frames per group without a
+// retransmission. Costs FEC_PARITY_COUNT / FEC_GROUP_SIZE extra packets.
+// Receiver always decodes FEC frames - enable on the sender.
+#define ENABLE_FEC false
+#define FEC_GROUP_SIZE 4             // Data frames per group (2-8)
+#define FEC_PARITY_COUNT 1           // 1 = XOR parity, 2 = XOR + Reed-Solomon Q
+
+// =============== GATEWAY MODE ================================
+// One receiver serves many senders on the same LORA_NETWORK_ID
+// (node_table.h): per-node state, health, CSV and report. Senders
+// need distinct addresses - LORA_SENDER_ADDRESS_AUTO derives one
+// from the chip MAC (4-253, keeps clear of receiver and display).
+#define ENABLE_GATEWAY_MODE false
+#define GATEWAY_MAX_NODES 32         // Node table capacity (max 255)
+#define LORA_SENDER_ADDRESS_AUTO false
+
+// =============== RELAY ================================
+// Store-and-forward repeater for senders out of the receiver's reach
+// (relay.h). Relay: GPIO16 jumpered to 3V3. Far sender sends to
+// LORA_UPLINK_VIA, the relay confirms every hop with a RELAY_ACK and
+// drops duplicates; the receiver unwraps the envelope (source, hop
+// RSSI). Enable on ALL devices of the path. All hops use one SF - with
+// a relay halfway, LORA_SPREADING_FACTOR 9 instead of 12.
+#define ENABLE_RELAY false
+#define LORA_RELAY_ADDRESS 254       // Relay's own address (outside AUTO range)
+#define RELAY_NEXT_HOP LORA_RECEIVER_ADDRESS  // Relay forwards to (another relay or receiver)
+#define LORA_UPLINK_VIA 0            // Sender: relay to send through (0 = direct)
+#define RELAY_TTL 3                  // Relays after the first before a frame is dropped (0-15)
+#define RELAY_QUEUE_SIZE 8           // Frames waiting for the next hop
+#define RELAY_MAX_TRIES 3            // Sends per hop without RELAY_ACK before giving up
+#define RELAY_CACHE_SIZE 32          // (source, seq) pairs kept for duplicate drop
+
+// =============== MEDIUM ACCESS (MULTI-SENDER) ================================
+// Uplink timing for several senders on one channel (mac_layer.h):
+// random start phase, ±MAC_JITTER_PCT per interval and exponential
+// backoff after missed ACK slots. TDMA: the receiver places every
+// sender into its own slot via a correction in the ACK (needs ACKs
+// and binary frames; a slot must hold uplink + ACK_SLOT_OFFSET + ACK).
+#define ENABLE_TX_MAC false
+#define MAC_JITTER_PCT 10            // Interval jitter (± %)
+#define MAC_BACKOFF_MAX_EXP 4        // Backoff up to 2^n-1 air times
+#define ENABLE_MAC_TDMA false
+#define TDMA_SLOT_COUNT 8            // Slots per frame (senders share slot % count)
+#define TDMA_SLOT_MS 2000            // SF12: 0.7 s uplink + 0.1 s + 0.8 s ACK
+
+// Time beacons (time_sync.h): receiver broadcasts its millis() and the
+// slot map, senders fit offset + crystal drift and place uplinks at
+// their slot start in receiver time (also between ACKs)
+#define ENABLE_TIME_SYNC false
+#define BEACON_INTERVAL 60000        // Receiver beacon period (ms)
+#define TIME_SYNC_LATENCY_MS 5       // AT+SEND → air + +RCV → loop (ms)
+
+// =============== TRANSMIT POWER CONTROL ================================
+// Sender steps AT+CRFOP down to the lowest level that keeps
+// TXP_MARGIN_DB of link margin (uplink RSSI/SNR reported in the ACK)
+// and back up on missed ACKs (tx_power.h). Logs TX energy per delivered
+// packet - measured with ENABLE_CURRENT_MONITOR, modelled otherwise.
+// Enable on BOTH devices (receiver adds the report to its ACKs).
+#define ENABLE_TX_POWER_CONTROL false
+#define TXP_MIN_DBM 0                // RYLR896 AT+CRFOP range 0-15
+#define TXP_MAX_DBM 15               // Start and fallback level
+#define TXP_MARGIN_DB 12             // Link margin to keep (dB)
+#define TXP_STEP_DB 2                // Step down (up: 2 steps per missed ACK)
+#define TXP_HYSTERESIS_DB 2          // Extra margin before stepping down
+#define TXP_HOLD_MS 30000            // Min time between steps down
+#define TXP_LOSS_MISSES 2            // Missed ACKs in a row → TXP_MAX_DBM
+#define TXP_SUPPLY_V 3.3             // Energy model without current monitor
 
 // =============== DISPLAY STATION ================================
 // Send real-time data to TFT display station (ESP32-2432S022)
@@ -67,6 +200,56 @@
 #define DISPLAY_UPDATE_INTERVAL 2000 // Send to display every 2 seconds
 #define DISPLAY_TX_PIN 23            // TX pin (connects to display RX)
 
+// =============== TASKS ================================
+// Radio, sensing and UI in separate FreeRTOS tasks (task_split.h):
+// loop() keeps the radio (LoRaSerial, protocol state) on its core,
+// sensors and LCD/display run beside it. Per-task CPU share, max run
+// time and jitter are printed with the status.
+#define ENABLE_TASK_SPLIT false
+#define TASK_RADIO_PERIOD_MS 5       // loop() period (was delay(10) after the work)
+#define TASK_SENSOR_PERIOD_MS 20     // Touch, battery, fire alarm detectors
+#define TASK_UI_PERIOD_MS 50         // LCD (redrawn every 100 ms), display station
+#define TASK_SENSOR_CORE 0           // loop() runs on core 1
+#define TASK_UI_CORE 0
+#define TASK_SENSOR_STACK 4096       // Bytes
+#define TASK_UI_STACK 4096
+#define TASK_SENSOR_QUEUE_SIZE 8     // Sensor → radio events (7 usable)
+#define TASK_STATS_WINDOW_MS 5000    // CPU / jitter window (= status interval)
+
+// =============== LOOP SCHEDULING ================================
+// Periodic jobs (spinner, touch, LCD, status, reports, data output,
+// display station, battery/current) are timers in one wheel
+// (timer_wheel.h). With ENABLE_IDLE_SLEEP loop() sleeps until the next
+// timer, uplink or LoRa UART byte instead of delay(10); wakeups and
+// sleep share are printed with the status either way.
+#define ENABLE_IDLE_SLEEP false
+#define IDLE_BUSY_POLL_MS 10         // Radio busy (AT, TX, ACK slot, queues): as before
+#define IDLE_MAX_SLEEP_MS 1000       // Cap on one sleep (protocol timeouts wake loop() on time)
+#define FIRE_ALARM_POLL_MS 20        // Audio / light detector sampling
+
+// =============== BOOT ================================
+// Fast boot (fast_boot.h): no splash screens or settle delays, RYLR896
+// settings read back instead of AT+RESET + reprogram, checked while
+// LCD/display/sensors start. ~12 s → well under 1 s to the first packet.
+// Boot phases are timestamped and printed in both modes.
+#define ENABLE_FAST_BOOT false
+
+// =============== SLEEPING SENDER ================================
+// Battery sender (sleep_cycle.h): wake every SLEEP_INTERVAL_MS, read the
+// sensors, send one uplink, wait for its ACK slot, put the RYLR896 to
+// sleep (AT+MODE=1) and sleep. Sequence number, SF, TX power, duty
+// cycle, AES counter and statistics survive deep sleep in RTC memory.
+// Average current per SF is printed every SLEEP_REPORT_CYCLES cycles.
+#define ENABLE_SLEEP_SENDER false
+#define SLEEP_LIGHT false            // true: light sleep (RAM kept, ~1 mA instead of µA)
+#define SLEEP_INTERVAL_MS 60000      // Wake to wake (replaces SEND_INTERVAL)
+#define SLEEP_ACK_WINDOW true        // ACK every ACK_INTERVAL uplinks (false: never listen)
+#define SLEEP_MAX_AWAKE_MS 5000      // Sleep anyway after this long awake
+#define SLEEP_AWAKE_MA 80            // Awake current without the INA219 (ENABLE_CURRENT_MONITOR)
+#define SLEEP_CURRENT_UA 150         // Sleep current: ESP32 + RYLR896 + board regulator
+#define SLEEP_BATTERY_MAH 2000       // Battery life estimate
+#define SLEEP_REPORT_CYCLES 10       // Energy report every N cycles
+
 // =============== FEATURE FLAGS ================================
 // 🚀 EXPERIMENTAL FEATURES - Easily enable/disable for testing
 // Each feature can be tested independently
@@ -120,12 +303,14 @@
 #define ENABLE_WATCHDOG false
 #define WATCHDOG_TIMEOUT_S 10            // Timeout in seconds
 
-// FEATURE 7: Data Encryption (Simple XOR)
-// Encrypt LoRa payload with XOR cipher (basic obfuscation)
-// Note: NOT cryptographically secure, use for basic privacy only
-// Testing: Enable on both devices with same key
+// FEATURE 7: Data Encryption (AES-128-CCM)
+// Every frame encrypted + 4-byte tag, replayed frames dropped
+// (encryption.h). ESP32 hardware AES via mbedTLS. Costs 6-10 bytes
+// per frame (SF12: ~+330 ms on a 5-byte telemetry frame).
+// Testing: Enable on ALL devices with the same key - CHANGE THE KEY!
 #define ENABLE_ENCRYPTION false
-#define ENCRYPTION_KEY 0xA5              // XOR encryption key (0x00-0xFF)
+#define ENCRYPTION_KEY {0x3c, 0x91, 0x5e, 0x07, 0xd2, 0x48, 0xa6, 0x1f, \
+                        0x7b, 0xe4, 0x20, 0x95, 0xc8, 0x6d, 0x33, 0xfa}  // 16 bytes
 
 // FEATURE 8: Extended Telemetry
 // Additional data in payload: uptime, free heap, temperature
@@ -134,12 +319,20 @@
 #define ENABLE_EXTENDED_TELEMETRY false
 
 // FEATURE 9: Adaptive Spreading Factor
-// Automatically adjust SF based on signal quality
-// Improves throughput at close range, maintains link at long range
-// Testing: Enable and monitor SF changes in serial output
+// Closed-loop ADR: receiver picks the fastest SF from uplink SNR margin
+// and loss, switches with a two-phase commit in the ACK slot (adaptive_sf.h)
+// Any timeout falls back to SF12 on both ends
+// Testing: Enable on BOTH devices and monitor "ADR:" lines in serial output
 #define ENABLE_ADAPTIVE_SF false
-#define ADAPTIVE_SF_RSSI_GOOD -80        // Decrease SF above this RSSI
-#define ADAPTIVE_SF_RSSI_WEAK -105       // Increase SF below this RSSI
+#define ADR_SF_MIN 7                     // Fastest SF allowed
+#define ADR_MARGIN_DB 10                 // Required SNR margin over demod floor (dB)
+#define ADR_HYSTERESIS_DB 3              // Extra margin to go faster (dB)
+#define ADR_LOSS_MAX_PCT 10              // Loss above this → slower SF
+#define ADR_COOLDOWN_MS 120000           // Min time between switches
+#define ADR_VERIFY_MS 60000              // Receiver: ACCEPT / first uplink timeout
+#define ADR_VERIFY_TRIES 3               // Sender: missed ACKs at new SF → SF12
+#define ADR_FALLBACK_MISSES 6            // Sender: missed ACKs in a row → SF12
+#define ADR_FALLBACK_MS 180000           // Receiver: silence at SF < 12 → SF12
 
 // FEATURE 10: Packet Statistics Logging
 // Detailed statistics: retries, duplicates, out-of-order packets
@@ -202,17 +395,175 @@
   #warning "════════════════════════════════════════════════════"
   #warning "⚠️  ADAPTIVE SF + RUNTIME CONFIG"
   #warning ""
-  #warning "Adaptive SF vaihtaa SF:ää automaattisesti RSSI:n mukaan."
+  #warning "Adaptive SF vaihtaa SF:ää automaattisesti SNR-marginaalin mukaan."
   #warning "Runtime CONFIG:SF:X komennot voivat olla ristiriidassa."
   #warning ""
   #warning "HUOM: Adaptive SF yliajaa manuaaliset asetukset."
   #warning "════════════════════════════════════════════════════"
 #endif
 
-// INFO: Salaus ja etäkomennot
-#if ENABLE_ENCRYPTION && ENABLE_ADVANCED_COMMANDS
-  #pragma message "ℹ️  Salaus käytössä etäkomentojen kanssa."
-  #pragma message "   Varmista että lähettäjä myös salaa komennot!"
+// VIRHE: Varmennettu kanava tarvitsee ACK-slotit
+#if ENABLE_RELIABLE_LINK && !ENABLE_BIDIRECTIONAL
+  #error "ENABLE_RELIABLE_LINK vaatii ENABLE_BIDIRECTIONAL true (bitmap-ACK kulkee ACK-slotissa)"
+#endif
+
+// VIRHE: Gateway-tilassa yksi FEC-dekooderi sekoittaisi lähettäjien ryhmät
+#if ENABLE_GATEWAY_MODE && ENABLE_FEC
+  #error "ENABLE_FEC ei toimi gateway-tilassa (yksi FEC-dekooderi kaikille lähettäjille)"
+#endif
+
+#if GATEWAY_MAX_NODES < 1 || GATEWAY_MAX_NODES > 255
+  #error "GATEWAY_MAX_NODES 1-255"
+#endif
+
+// VIRHE: TDMA-korjaus kulkee binäärisessä ACK-kehyksessä
+#if ENABLE_MAC_TDMA && (!ENABLE_TX_MAC || !ENABLE_BIDIRECTIONAL || !TELEMETRY_BINARY_FORMAT)
+  #error "ENABLE_MAC_TDMA vaatii ENABLE_TX_MAC, ENABLE_BIDIRECTIONAL ja TELEMETRY_BINARY_FORMAT true"
+#endif
+
+#if ENABLE_MAC_TDMA && ENABLE_TELEMETRY_BATCH
+  #error "ENABLE_MAC_TDMA ei toimi eräajon kanssa (erät lähtevät täyttymisen mukaan, ei slotissa)"
+#endif
+
+#if TDMA_SLOT_COUNT < 1 || TDMA_SLOT_COUNT > 255 || TDMA_SLOT_COUNT * TDMA_SLOT_MS > 65000
+  #error "TDMA_SLOT_COUNT 1-255 ja kehys (TDMA_SLOT_COUNT * TDMA_SLOT_MS) enintään 65000 ms"
+#endif
+
+// VIRHE: ADR-komento kulkee ACK-slotissa, yksi vastaanotin kuuntelee yhtä SF:ää
+#if ENABLE_ADAPTIVE_SF && !ENABLE_BIDIRECTIONAL
+  #error "ENABLE_ADAPTIVE_SF vaatii ENABLE_BIDIRECTIONAL true (ADR-komento kulkee ACK-slotissa)"
+#endif
+
+#if ENABLE_ADAPTIVE_SF && ENABLE_GATEWAY_MODE
+  #error "ENABLE_ADAPTIVE_SF ei toimi gateway-tilassa (vastaanotin kuuntelee vain yhtä SF:ää)"
+#endif
+
+// VIRHE: ADR palaa aina SF12:een - käynnistys samalla SF:llä
+#if ENABLE_ADAPTIVE_SF && LORA_SPREADING_FACTOR != 12
+  #error "ENABLE_ADAPTIVE_SF vaatii LORA_SPREADING_FACTOR 12"
+#endif
+
+#if LORA_SPREADING_FACTOR < 7 || LORA_SPREADING_FACTOR > 12
+  #error "LORA_SPREADING_FACTOR 7-12"
+#endif
+
+#if ADR_SF_MIN < 7 || ADR_SF_MIN > 12 || ADR_VERIFY_TRIES < 1 || ADR_FALLBACK_MISSES < ADR_VERIFY_TRIES
+  #error "ADR_SF_MIN 7-12, ADR_VERIFY_TRIES >= 1 ja ADR_FALLBACK_MISSES >= ADR_VERIFY_TRIES"
+#endif
+
+// VIRHE: Tehonsäätö saa linkkiraportin binäärisestä ACK-kehyksestä
+#if ENABLE_TX_POWER_CONTROL && (!ENABLE_BIDIRECTIONAL || !TELEMETRY_BINARY_FORMAT)
+  #error "ENABLE_TX_POWER_CONTROL vaatii ENABLE_BIDIRECTIONAL ja TELEMETRY_BINARY_FORMAT true"
+#endif
+
+#if TXP_MIN_DBM < 0 || TXP_MAX_DBM > 15 || TXP_MIN_DBM > TXP_MAX_DBM || TXP_STEP_DB < 1 || TXP_LOSS_MISSES < 1
+  #error "TXP_MIN_DBM <= TXP_MAX_DBM (0-15), TXP_STEP_DB >= 1 ja TXP_LOSS_MISSES >= 1"
+#endif
+
+// VIRHE: Tehonsäätö ja ADR samalla linkillä - teho ei saa pakottaa SF:ää hitaammaksi
+#if ENABLE_TX_POWER_CONTROL && ENABLE_ADAPTIVE_SF && TXP_MARGIN_DB <= ADR_MARGIN_DB
+  #error "TXP_MARGIN_DB pitää olla suurempi kuin ADR_MARGIN_DB (muuten ADR hidastaa SF:ää tehon laskiessa)"
+#endif
+
+#if ENABLE_TX_POWER_CONTROL && ENABLE_ADAPTIVE_SF && TXP_LOSS_MISSES >= ADR_VERIFY_TRIES
+  #error "TXP_LOSS_MISSES pitää olla pienempi kuin ADR_VERIFY_TRIES (täysi teho ennen SF12-paluuta)"
+#endif
+
+// VIRHE: Tapahtumapohjainen lähetys ei sovi kiinteisiin aikatauluihin
+#if ENABLE_SEND_ON_CHANGE && (ENABLE_MAC_TDMA || ENABLE_TELEMETRY_BATCH)
+  #error "ENABLE_SEND_ON_CHANGE ei toimi ENABLE_MAC_TDMA:n tai ENABLE_TELEMETRY_BATCH:n kanssa (kiinteä lähetysrytmi)"
+#endif
+
+#if HEARTBEAT_INTERVAL < SEND_INTERVAL || HEARTBEAT_INTERVAL > 3600000
+  #error "HEARTBEAT_INTERVAL SEND_INTERVAL - 3600000 ms"
+#endif
+
+// VIRHE: ADR palaa SF12:een, jos lähettäjä on hiljaa ADR_FALLBACK_MS
+#if ENABLE_SEND_ON_CHANGE && ENABLE_ADAPTIVE_SF && 2 * HEARTBEAT_INTERVAL >= ADR_FALLBACK_MS
+  #error "ADR_FALLBACK_MS pitää olla yli 2 * HEARTBEAT_INTERVAL"
+#endif
+
+// VIRHE: Majakat luetaan lähettäjän vastaanottopolussa (ACK-slotit)
+#if ENABLE_TIME_SYNC && !ENABLE_BIDIRECTIONAL
+  #error "ENABLE_TIME_SYNC vaatii ENABLE_BIDIRECTIONAL true"
+#endif
+
+#if MAC_JITTER_PCT < 0 || MAC_JITTER_PCT > 50 || MAC_BACKOFF_MAX_EXP > 10
+  #error "MAC_JITTER_PCT 0-50, MAC_BACKOFF_MAX_EXP 0-10"
+#endif
+
+// VIRHE: Releen kautta kulkee vain kehys kerrallaan (ei päästä päähän -kuittauksia)
+#if LORA_UPLINK_VIA && !ENABLE_RELAY
+  #error "LORA_UPLINK_VIA vaatii ENABLE_RELAY true"
+#endif
+
+#if ENABLE_RELAY && !ENABLE_BIDIRECTIONAL
+  #error "ENABLE_RELAY vaatii ENABLE_BIDIRECTIONAL true (RELAY_ACK kulkee ACK-slotissa)"
+#endif
+
+#if ENABLE_RELAY && (ENABLE_FEC || ENABLE_RELIABLE_LINK || ENABLE_ADAPTIVE_SF)
+  #error "ENABLE_RELAY ei toimi ENABLE_FEC:n, ENABLE_RELIABLE_LINK:n tai ENABLE_ADAPTIVE_SF:n kanssa (rele kuittaa hypyn, ei vastaanotin)"
+#endif
+
+#if ENABLE_RELAY && (ENABLE_MAC_TDMA || ENABLE_TIME_SYNC)
+  #error "ENABLE_RELAY ei toimi ENABLE_MAC_TDMA:n tai ENABLE_TIME_SYNC:n kanssa (majakat ja slotit eivät kulje releen läpi)"
+#endif
+
+#if RELAY_TTL > 15 || RELAY_QUEUE_SIZE < 1 || RELAY_QUEUE_SIZE > 255 || RELAY_CACHE_SIZE < 1 || RELAY_CACHE_SIZE > 255 || RELAY_MAX_TRIES < 1
+  #error "RELAY_TTL 0-15, RELAY_QUEUE_SIZE ja RELAY_CACHE_SIZE 1-255, RELAY_MAX_TRIES >= 1"
+#endif
+
+// VIRHE: Tehtäväjako
+#if TASK_SENSOR_CORE > 1 || TASK_UI_CORE > 1 || TASK_SENSOR_QUEUE_SIZE < 2 || TASK_SENSOR_QUEUE_SIZE > 255
+  #error "TASK_SENSOR_CORE ja TASK_UI_CORE 0-1, TASK_SENSOR_QUEUE_SIZE 2-255"
+#endif
+
+#if TASK_RADIO_PERIOD_MS < 1 || TASK_SENSOR_PERIOD_MS < 1 || TASK_UI_PERIOD_MS < 1
+  #error "TASK_*_PERIOD_MS vähintään 1 (FreeRTOS-tikki 1 ms)"
+#endif
+
+// VIRHE: Lepo odottaa seuraavaa ajastinta - tehtäväjaossa radio kulkee omalla jaksollaan
+#if ENABLE_IDLE_SLEEP && ENABLE_TASK_SPLIT
+  #error "ENABLE_IDLE_SLEEP ja ENABLE_TASK_SPLIT eivät toimi yhdessä"
+#endif
+
+#if IDLE_BUSY_POLL_MS < 1 || IDLE_MAX_SLEEP_MS < IDLE_BUSY_POLL_MS || FIRE_ALARM_POLL_MS < 1
+  #error "IDLE_BUSY_POLL_MS vähintään 1, IDLE_MAX_SLEEP_MS >= IDLE_BUSY_POLL_MS, FIRE_ALARM_POLL_MS vähintään 1"
+#endif
+
+// VIRHE: Nukkuva lähettäjä - setup() ajetaan joka herätyksellä, lähetysväli tulee unijaksosta
+#if ENABLE_SLEEP_SENDER && !ENABLE_FAST_BOOT
+  #error "ENABLE_SLEEP_SENDER vaatii ENABLE_FAST_BOOT true (setup() ajetaan joka herätyksellä)"
+#endif
+
+#if ENABLE_SLEEP_SENDER && (ENABLE_TX_MAC || ENABLE_SEND_ON_CHANGE || ENABLE_TELEMETRY_BATCH || ENABLE_TIME_SYNC)
+  #error "ENABLE_SLEEP_SENDER ei toimi ENABLE_TX_MAC:n, ENABLE_SEND_ON_CHANGE:n, ENABLE_TELEMETRY_BATCH:n tai ENABLE_TIME_SYNC:n kanssa (yksi lähetys per jakso)"
+#endif
+
+#if ENABLE_SLEEP_SENDER && (ENABLE_RELIABLE_LINK || ENABLE_FEC || ENABLE_TASK_SPLIT || ENABLE_IDLE_SLEEP)
+  #error "ENABLE_SLEEP_SENDER ei toimi ENABLE_RELIABLE_LINK:n, ENABLE_FEC:n, ENABLE_TASK_SPLIT:n tai ENABLE_IDLE_SLEEP:n kanssa"
+#endif
+
+#if ENABLE_SLEEP_SENDER && ENABLE_ADAPTIVE_SF && (!SLEEP_ACK_WINDOW || 2 * SLEEP_INTERVAL_MS >= ADR_FALLBACK_MS)
+  #error "ENABLE_ADAPTIVE_SF vaatii SLEEP_ACK_WINDOW true ja ADR_FALLBACK_MS yli 2 * SLEEP_INTERVAL_MS"
+#endif
+
+#if SLEEP_INTERVAL_MS < 1000 || SLEEP_MAX_AWAKE_MS < 1000 || SLEEP_MAX_AWAKE_MS >= SLEEP_INTERVAL_MS
+  #error "SLEEP_INTERVAL_MS vähintään 1000, SLEEP_MAX_AWAKE_MS 1000 - SLEEP_INTERVAL_MS"
+#endif
+
+#if SLEEP_REPORT_CYCLES < 1 || SLEEP_AWAKE_MA < 1 || SLEEP_BATTERY_MAH < 1
+  #error "SLEEP_REPORT_CYCLES, SLEEP_AWAKE_MA ja SLEEP_BATTERY_MAH vähintään 1"
+#endif
+
+// VIRHE: Prioriteettijonon koko
+#if TXQ_SIZE < 1 || TXQ_SIZE > 32
+  #error "TXQ_SIZE 1-32"
+#endif
+
+// VIRHE: FEC-ryhmän koko rajattu (3-bittinen indeksi, P + Q)
+#if FEC_GROUP_SIZE < 2 || FEC_GROUP_SIZE > 8 || FEC_PARITY_COUNT < 1 || FEC_PARITY_COUNT > 2
+  #error "FEC_GROUP_SIZE 2-8 ja FEC_PARITY_COUNT 1-2"
 #endif
 
 // MUISTIVAROITUS: Lasketaan arvioitu RAM-käyttö
@@ -225,7 +576,7 @@
   (ENABLE_AUDIO_DETECTION * 80) + \
   (ENABLE_LIGHT_DETECTION * 90) + \
   (ENABLE_ADAPTIVE_SF * 40) + \
-  (ENABLE_ENCRYPTION * 10) + \
+  (ENABLE_ENCRYPTION * 250) + \
   (ENABLE_ADVANCED_COMMANDS * 30)
 
 #if ESTIMATED_RAM_USAGE > 400
@@ -209,6 +209,17 @@ bool readCurrentSensor() {
   #endif
 }
 
+// Single raw reading (mA) without touching statistics or energy
+// integration - for short events like one LoRa transmission
+float sampleCurrent_mA() {
+  #if ENABLE_CURRENT_MONITOR
+    float mA = ina219.getCurrent_mA();
+    return mA > 0 ? mA : 0;
+  #else
+    return 0;
+  #endif
+}
+
 // Check current sensor and print status
 void checkCurrentMonitor() {
   #if ENABLE_CURRENT_MONITOR
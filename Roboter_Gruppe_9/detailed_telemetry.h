@@ -41,6 +41,7 @@
   - Lähetetyt paketit
   - ACK-vastaukset
   - ACK-aikakatkaisut
+  - FEC: korjatut / korjaamattomat kehykset (fec.h)
 
   ═══════════════════════════════════════════════════════════════════
 
@@ -161,6 +162,10 @@ struct PacketStatistics {
   unsigned long ackReceived;
   unsigned long ackTimeout;
 
+  // Forward error correction (fec.h)
+  unsigned long fecCorrected;      // Lost frames rebuilt from parity
+  unsigned long fecUncorrectable;  // Lost frames parity could not rebuild
+
   // Reporting
   unsigned long lastReport;
   int reportCount;
@@ -188,6 +193,7 @@ PacketStatistics pktStats = {
   0, 0, 0,                       // Loss streaks
   0, 0,                          // Duplicates, out-of-order
   0, 0, 0, 0,                    // Transmission
+  0, 0,                          // FEC
   0, 0                           // Reporting
 };
 
@@ -335,6 +341,20 @@ void recordAckTimeout() {
   #endif
 }
 
+// Record frames rebuilt by FEC
+void recordFecCorrected(unsigned long frames) {
+  #if ENABLE_PACKET_STATS
+    pktStats.fecCorrected += frames;
+  #endif
+}
+
+// Record frames FEC could not rebuild
+void recordFecUncorrectable(unsigned long frames) {
+  #if ENABLE_PACKET_STATS
+    pktStats.fecUncorrectable += frames;
+  #endif
+}
+
 // Calculate ACK success rate
 float calculateAckRate() {
   #if ENABLE_PACKET_STATS
@@ -528,6 +548,12 @@ void printDetailedReport(HealthMonitor& health) {
     Serial.println(pktStats.duplicates);
     Serial.print("║   Out-of-order:        ");
     Serial.println(pktStats.outOfOrder);
+    if (pktStats.fecCorrected + pktStats.fecUncorrectable > 0) {
+      Serial.print("║   FEC corrected:       ");
+      Serial.println(pktStats.fecCorrected);
+      Serial.print("║   FEC uncorrectable:   ");
+      Serial.println(pktStats.fecUncorrectable);
+    }
     #endif
 
     // ═══ TRANSMISSION STATS ═══
@@ -688,6 +714,8 @@ void resetDetailedStats() {
     pktStats.transmissionAttempts = 0;
     pktStats.ackReceived = 0;
     pktStats.ackTimeout = 0;
+    pktStats.fecCorrected = 0;
+    pktStats.fecUncorrectable = 0;
     pktStats.snrMin = 999;
     pktStats.snrMax = -999;
     pktStats.snrSum = 0;
@@ -35,11 +35,8 @@
 #include "config.h"
 #include "DisplayClient.h"
 
-// External declarations
-extern DeviceState local;
-extern DeviceState remote;
+// External declarations (device state comes in as a UiSnapshot)
 extern bool bRECEIVER;
-extern HealthMonitor health;
 
 #if ENABLE_BATTERY_MONITOR
   extern float readBatteryVoltage();
@@ -87,13 +84,17 @@ extern HealthMonitor health;
  */
 void initDisplaySender() {
   #if ENABLE_DISPLAY_OUTPUT
-    display.begin();
-    delay(100);
-
-    // Send welcome message
-    display.alert("Roboter 9 online");
-    delay(2000);
-    display.clearAlert();
+    #if ENABLE_FAST_BOOT
+      display.begin(0);  // First update comes from loop()
+    #else
+      display.begin();
+      delay(100);
+
+      // Send welcome message
+      display.alert("Roboter 9 online");
+      delay(2000);
+      display.clearAlert();
+    #endif
 
     Serial.println("\n📺 Display output enabled:");
     Serial.print("  TX pin: GPIO ");
@@ -110,10 +111,13 @@ void initDisplaySender() {
 
 /**
  * Send status update to display
- * Call this regularly from loop()
+ * Call this regularly from loop() (or the UI task, task_split.h)
  */
-void sendDisplayUpdate() {
+void sendDisplayUpdate(const UiSnapshot& ui) {
   #if ENABLE_DISPLAY_OUTPUT
+    const DeviceState& local = ui.local;
+    const DeviceState& remote = ui.remote;
+    const HealthMonitor& health = ui.health;
     unsigned long now = millis();
 
     // Check if it's time to update
@@ -141,6 +145,12 @@ void sendDisplayUpdate() {
       display.set("R_TOUCH", remote.touchState ? "YES" : "NO");
     }
 
+    #if ENABLE_GATEWAY_MODE
+      if (bRECEIVER) {
+        display.set("Nodes", String(ui.nodesOnline) + "/" + String(ui.nodeCount));
+      }
+    #endif
+
     // Connection state (always send, even if UNKNOWN)
     display.set("ConnState", getConnectionStateString(health.state));
 
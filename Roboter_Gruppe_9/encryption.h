@@ -1,303 +1,555 @@
 /*=====================================================================
-  encryption.h - Simple XOR Encryption
+  encryption.h - Authenticated Encryption (AES-128-CCM)
 
   FEATURE 7: Data Encryption
 
-  Encrypts LoRa payload using XOR cipher for basic privacy.
-
-  ⚠️  IMPORTANT SECURITY NOTICE:
-  - XOR encryption is NOT cryptographically secure!
-  - Suitable for basic obfuscation only
-  - Do NOT use for sensitive data (passwords, personal info)
-  - Can be broken easily with frequency analysis
-  - For real security, use AES (more complex, not implemented here)
-
-  How XOR Encryption Works:
-  - Each byte is XOR'd with encryption key
-  - Encryption: cipher = plaintext XOR key
-  - Decryption: plaintext = cipher XOR key (same operation!)
-  - Symmetric: Same key for encrypt and decrypt
-
-  Example:
-  - Plaintext: "LED:1" = 0x4C 0x45 0x44 0x3A 0x31
-  - Key: 0xA5
-  - Encrypted: 0xE9 0xE0 0xE1 0x9F 0x94
-  - Decrypt with 0xA5 → back to "LED:1"
-
-  Use Cases:
-  - Prevent casual eavesdropping (neighbors with LoRa receiver)
-  - Obfuscate commands (harder to reverse engineer)
-  - Privacy for non-critical data
-  - Quick and lightweight (no CPU overhead)
+  Every LoRa frame is encrypted and authenticated with AES-128-CCM
+  (NIST SP 800-38C, RFC 3610) before AT+SEND and checked before any
+  decoder sees it. The old XOR cipher (one key byte, a new String per
+  message, no integrity) is gone.
+
+  Frame (sealed in place around the plain frame):
+
+    | 0 type 0x8E | 1.. counter varint | ciphertext | 4 byte tag |
+
+  - Nonce (7 bytes): sender address (2) | network ID (1) | counter (4)
+  - AAD: type + counter bytes (the header cannot be swapped)
+  - Tag: 4 bytes (CCM M=4) - a forgery passes with p = 2^-32
+  - Overhead: 6-10 bytes (counter 1-5 bytes, 3 typical)
+
+  Replay protection:
+  - Each sender counts its frames; the counter never repeats under one
+    key (nonce reuse would break CCM). It is reserved in NVS in blocks
+    of ENC_COUNTER_BLOCK, so after a reboot it continues above the
+    last reservation - one flash write per block, not per frame.
+  - The receiver keeps, per sender address, the highest counter seen
+    plus a 32-frame bitmap below it (like IPsec ESP). Older frames and
+    frames already seen are dropped before decryption.
+  - The window is in RAM: right after a receiver reboot (or when the
+    peer table is full and a sender is evicted) the first valid frame
+    of a sender sets its window again.
+
+  Hardware:
+  - ESP32: AES blocks through mbedTLS (mbedtls_aes_crypt_ecb), which
+    ESP-IDF maps onto the AES accelerator
+  - Host builds (no ARDUINO_ARCH_ESP32): software AES-128 fallback,
+    same CCM code - encSelfTest() checks both against SP 800-38C;
+    host/test_encryption.cpp adds FIPS-197, seal/open, replay and
+    tampering
+
+  No heap anywhere: sendLoRaMessage() seals inside the AT+SEND buffer,
+  receiveLoRaPacket() opens inside the received line (lora_handler.h).
 
   Configuration:
-  - ENCRYPTION_KEY: 0x00-0xFF (0xA5 default)
-  - Both sender and receiver MUST use same key!
-  - Change key periodically for better security
-
-  Testing:
-  1. Set ENABLE_ENCRYPTION true in config.h
-  2. Set same ENCRYPTION_KEY on both devices
-  3. Upload to both
-  4. Messages still work (encrypted over-the-air)
-  5. Check serial: Should show encrypted payload in hex
-
-  Key Management:
-  - Store key in config.h (not ideal for production)
-  - For better security: Store in EEPROM/Flash
-  - For best security: Use AES-128 or AES-256
-
-  Performance:
-  - Very fast (<1ms for typical payload)
-  - No noticeable delay
-  - Works at any spreading factor
+  - ENABLE_ENCRYPTION on ALL devices, same 16-byte ENCRYPTION_KEY
+  - Plain frames are dropped while encryption is on
+
+  Statistics (EncryptionStats): sealed/opened frames, tag failures,
+  replays, plain frames dropped and µs per seal/open. At SF12 one
+  frame is ~0.7-1.8 s on air; CCM on a 5-40 byte frame takes tens of
+  µs, so the cost is the overhead bytes, not the CPU.
 =======================================================================*/
 
 #ifndef ENCRYPTION_H
 #define ENCRYPTION_H
 
 #include <Arduino.h>
+#include <Preferences.h>
 #include "config.h"
+#include "airtime.h"
+#include "telemetry_frame.h"  // putVarint() / getVarint()
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include "mbedtls/aes.h"
+  #define ENC_HW_AES 1
+#else
+  #define ENC_HW_AES 0
+#endif
+
+#define FRAME_TYPE_SECURE 0x8E
+
+#define ENC_KEY_LEN 16
+#define ENC_TAG_LEN 4                // CCM M=4
+#define ENC_NONCE_LEN 7              // CCM L=8
+#define ENC_OVERHEAD_MAX (1 + 5 + ENC_TAG_LEN)  // Type + counter varint + tag
+#define ENC_REPLAY_WINDOW 32         // Bitmap bits per sender
+#define ENC_COUNTER_BLOCK 1024       // Counters reserved per NVS write
+
+#if ENABLE_GATEWAY_MODE
+  #define ENC_PEERS GATEWAY_MAX_NODES
+#else
+  #define ENC_PEERS 4                // Sender, relay, display ... + spare
+#endif
+
+// =============== AES-128 BLOCK ================================
+struct EncAes {
+  #if ENC_HW_AES
+  mbedtls_aes_context hw;
+  #else
+  uint8_t roundKeys[176];
+  #endif
+};
 
-// Encryption statistics
-struct EncryptionStats {
-  unsigned long messagesEncrypted;
-  unsigned long messagesDecrypted;
-  unsigned long encryptionErrors;
-  uint8_t currentKey;
-  bool isEnabled;
+#if !ENC_HW_AES
+const uint8_t encSbox[256] = {
+  0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+  0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+  0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+  0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+  0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+  0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+  0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+  0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+  0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+  0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+  0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+  0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+  0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+  0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+  0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+  0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
 };
 
-EncryptionStats encStats = {0, 0, 0, 0, false};
-
-// Initialize encryption system
-void initEncryption() {
-  #if ENABLE_ENCRYPTION
-    encStats.isEnabled = true;
-    encStats.currentKey = ENCRYPTION_KEY;
-
-    Serial.println("🔒 Encryption enabled");
-    Serial.print("  Algorithm: XOR cipher");
-    Serial.println();
-    Serial.print("  Key: 0x");
-    Serial.println(ENCRYPTION_KEY, HEX);
-    Serial.println("  ⚠️  WARNING: XOR is NOT cryptographically secure!");
-    Serial.println("  Use for basic obfuscation only");
-    Serial.println("  Both devices MUST use same key!");
-  #else
-    encStats.isEnabled = false;
-  #endif
+inline uint8_t encXtime(uint8_t x) {
+  return (uint8_t)((x << 1) ^ ((x & 0x80) ? 0x1B : 0x00));
 }
+#endif
 
-// Encrypt string using XOR cipher
-String encryptXOR(String plaintext, uint8_t key) {
-  #if ENABLE_ENCRYPTION
-    String encrypted = "";
-    encrypted.reserve(plaintext.length());  // Pre-allocate memory
-
-    for (int i = 0; i < plaintext.length(); i++) {
-      // XOR each character with key
-      char encryptedChar = plaintext[i] ^ key;
-      encrypted += encryptedChar;
+inline void encAesInit(EncAes& aes, const uint8_t* key) {
+  #if ENC_HW_AES
+    mbedtls_aes_init(&aes.hw);
+    mbedtls_aes_setkey_enc(&aes.hw, key, 128);
+  #else
+    uint8_t* rk = aes.roundKeys;
+    uint8_t rcon = 0x01;
+    memcpy(rk, key, ENC_KEY_LEN);
+    for (uint8_t i = 16; i < 176; i += 4) {
+      uint8_t t[4] = {rk[i - 4], rk[i - 3], rk[i - 2], rk[i - 1]};
+      if (i % 16 == 0) {
+        uint8_t first = t[0];
+        t[0] = encSbox[t[1]] ^ rcon;
+        t[1] = encSbox[t[2]];
+        t[2] = encSbox[t[3]];
+        t[3] = encSbox[first];
+        rcon = encXtime(rcon);
+      }
+      for (uint8_t j = 0; j < 4; j++) rk[i + j] = rk[i + j - 16] ^ t[j];
     }
+  #endif
+}
 
-    encStats.messagesEncrypted++;
-    return encrypted;
+// One block, forward cipher only (CCM never decrypts a block); in == out allowed
+inline void encAesBlock(EncAes& aes, const uint8_t* in, uint8_t* out) {
+  #if ENC_HW_AES
+    mbedtls_aes_crypt_ecb(&aes.hw, MBEDTLS_AES_ENCRYPT, in, out);
   #else
-    // Encryption disabled, return plaintext
-    return plaintext;
+    uint8_t s[16];
+    for (uint8_t i = 0; i < 16; i++) s[i] = in[i] ^ aes.roundKeys[i];
+    for (uint8_t round = 1; round <= 10; round++) {
+      // SubBytes + ShiftRows (state is column-major: s[4 * col + row])
+      uint8_t t[16];
+      for (uint8_t c = 0; c < 4; c++) {
+        for (uint8_t r = 0; r < 4; r++) t[4 * c + r] = encSbox[s[4 * ((c + r) & 3) + r]];
+      }
+      // MixColumns (not in the last round)
+      for (uint8_t c = 0; c < 4; c++) {
+        uint8_t* col = t + 4 * c;
+        if (round < 10) {
+          uint8_t a0 = col[0], a1 = col[1], a2 = col[2], a3 = col[3];
+          uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+          col[0] = a0 ^ all ^ encXtime(a0 ^ a1);
+          col[1] = a1 ^ all ^ encXtime(a1 ^ a2);
+          col[2] = a2 ^ all ^ encXtime(a2 ^ a3);
+          col[3] = a3 ^ all ^ encXtime(a3 ^ a0);
+        }
+      }
+      const uint8_t* rk = aes.roundKeys + 16 * round;
+      for (uint8_t i = 0; i < 16; i++) s[i] = t[i] ^ rk[i];
+    }
+    memcpy(out, s, 16);
   #endif
 }
 
-// Decrypt string using XOR cipher (same as encrypt!)
-String decryptXOR(String ciphertext, uint8_t key) {
-  #if ENABLE_ENCRYPTION
-    // XOR decryption is identical to encryption
-    String decrypted = "";
-    decrypted.reserve(ciphertext.length());
+// =============== CCM ================================
+// CBC-MAC state: bytes are XORed in, a full block is encrypted
+struct EncCbcMac {
+  uint8_t mac[16];
+  uint8_t pos;
+};
 
-    for (int i = 0; i < ciphertext.length(); i++) {
-      char decryptedChar = ciphertext[i] ^ key;
-      decrypted += decryptedChar;
+inline void encMacAbsorb(EncAes& aes, EncCbcMac& cbc, const uint8_t* data, uint8_t len) {
+  for (uint8_t i = 0; i < len; i++) {
+    cbc.mac[cbc.pos++] ^= data[i];
+    if (cbc.pos == 16) {
+      encAesBlock(aes, cbc.mac, cbc.mac);
+      cbc.pos = 0;
     }
+  }
+}
 
-    encStats.messagesDecrypted++;
-    return decrypted;
-  #else
-    // Encryption disabled, return ciphertext as-is
-    return ciphertext;
-  #endif
+// Zero padding to the block boundary
+inline void encMacPad(EncAes& aes, EncCbcMac& cbc) {
+  if (cbc.pos) {
+    encAesBlock(aes, cbc.mac, cbc.mac);
+    cbc.pos = 0;
+  }
 }
 
-// Encrypt payload before sending
-String encryptPayload(String payload) {
-  #if ENABLE_ENCRYPTION
-    return encryptXOR(payload, ENCRYPTION_KEY);
-  #else
-    return payload;
-  #endif
+// T = CBC-MAC(B0 | len(a) | a | m), L = 15 - nonceLen
+inline void encCcmMac(EncAes& aes, const uint8_t* nonce, uint8_t nonceLen,
+                      const uint8_t* aad, uint8_t aadLen, const uint8_t* msg, uint8_t msgLen,
+                      uint8_t tagLen, uint8_t* mac) {
+  EncCbcMac cbc;
+  memset(&cbc, 0, sizeof(cbc));
+  cbc.mac[0] = (aadLen ? 0x40 : 0x00) | (((tagLen - 2) / 2) << 3) | (14 - nonceLen);
+  memcpy(cbc.mac + 1, nonce, nonceLen);
+  cbc.mac[15] = msgLen;  // Length field: L bytes big-endian, < 256 here
+  encAesBlock(aes, cbc.mac, cbc.mac);
+
+  if (aadLen) {
+    uint8_t aadHeader[2] = {0, aadLen};
+    encMacAbsorb(aes, cbc, aadHeader, 2);
+    encMacAbsorb(aes, cbc, aad, aadLen);
+    encMacPad(aes, cbc);
+  }
+  encMacAbsorb(aes, cbc, msg, msgLen);
+  encMacPad(aes, cbc);
+  memcpy(mac, cbc.mac, 16);
 }
 
-// Decrypt received payload
-String decryptPayload(String payload) {
-  #if ENABLE_ENCRYPTION
-    return decryptXOR(payload, ENCRYPTION_KEY);
-  #else
-    return payload;
-  #endif
+// CTR with A1, A2 ... over data (in place); S0 = E(A0) masks the tag
+inline void encCcmCtr(EncAes& aes, const uint8_t* nonce, uint8_t nonceLen,
+                      uint8_t* data, uint8_t len, uint8_t* s0) {
+  uint8_t counter[16];
+  uint8_t stream[16];
+  memset(counter, 0, sizeof(counter));
+  counter[0] = 14 - nonceLen;
+  memcpy(counter + 1, nonce, nonceLen);
+  encAesBlock(aes, counter, s0);
+
+  for (uint8_t offset = 0; offset < len; offset += 16) {
+    counter[15]++;  // At most 16 blocks (len < 256)
+    encAesBlock(aes, counter, stream);
+    uint8_t n = len - offset < 16 ? len - offset : 16;
+    for (uint8_t i = 0; i < n; i++) data[offset + i] ^= stream[i];
+  }
+}
+
+inline void encCcmSeal(EncAes& aes, const uint8_t* nonce, uint8_t nonceLen,
+                       const uint8_t* aad, uint8_t aadLen, uint8_t* data, uint8_t len,
+                       uint8_t* tag, uint8_t tagLen) {
+  uint8_t mac[16], s0[16];
+  encCcmMac(aes, nonce, nonceLen, aad, aadLen, data, len, tagLen, mac);
+  encCcmCtr(aes, nonce, nonceLen, data, len, s0);
+  for (uint8_t i = 0; i < tagLen; i++) tag[i] = mac[i] ^ s0[i];
 }
 
-// Convert string to hex for debugging
-String toHex(String str) {
-  String hex = "";
-  for (int i = 0; i < str.length(); i++) {
-    char buffer[4];
-    sprintf(buffer, "%02X ", (unsigned char)str[i]);
-    hex += buffer;
+// Wrong tag: data is wiped, never handed out unauthenticated
+inline bool encCcmOpen(EncAes& aes, const uint8_t* nonce, uint8_t nonceLen,
+                       const uint8_t* aad, uint8_t aadLen, uint8_t* data, uint8_t len,
+                       const uint8_t* tag, uint8_t tagLen) {
+  uint8_t mac[16], s0[16];
+  encCcmCtr(aes, nonce, nonceLen, data, len, s0);
+  encCcmMac(aes, nonce, nonceLen, aad, aadLen, data, len, tagLen, mac);
+  uint8_t diff = 0;
+  for (uint8_t i = 0; i < tagLen; i++) diff |= tag[i] ^ mac[i] ^ s0[i];
+  if (diff) {
+    memset(data, 0, len);
+    return false;
   }
-  return hex;
+  return true;
 }
 
-// Print encryption statistics
-void printEncryptionStats() {
-  #if ENABLE_ENCRYPTION
-    Serial.println("\n╔════════ ENCRYPTION STATISTICS ════════╗");
-    Serial.print("║ Status:          ");
-    Serial.println(encStats.isEnabled ? "ENABLED 🔒" : "DISABLED");
-
-    if (encStats.isEnabled) {
-      Serial.print("║ Algorithm:       XOR cipher");
-      Serial.println();
-      Serial.print("║ Key:             0x");
-      Serial.println(encStats.currentKey, HEX);
-      Serial.print("║ Encrypted:       ");
-      Serial.println(encStats.messagesEncrypted);
-      Serial.print("║ Decrypted:       ");
-      Serial.println(encStats.messagesDecrypted);
-      Serial.print("║ Errors:          ");
-      Serial.println(encStats.encryptionErrors);
-    }
+// =============== REPLAY WINDOW ================================
+struct EncReplay {
+  uint16_t sender;
+  bool used;
+  uint32_t top;                      // Highest counter accepted
+  uint32_t seen;                     // Bit n: top - n accepted
+  unsigned long lastAt;              // For eviction (least recent)
+};
 
-    Serial.println("╚═══════════════════════════════════════╝\n");
-  #endif
+inline bool encReplayFresh(const EncReplay& peer, uint32_t counter) {
+  if (!peer.used || counter > peer.top) return true;
+  uint32_t age = peer.top - counter;
+  return age < ENC_REPLAY_WINDOW && !((peer.seen >> age) & 1);
 }
 
-// Test encryption (verify it's working)
-void testEncryption() {
-  #if ENABLE_ENCRYPTION
-    Serial.println("\n🔒 Testing encryption...");
-
-    // Test string
-    String original = "LED:1,TEMP:25.5";
-    Serial.print("Original:  ");
-    Serial.println(original);
-    Serial.print("Hex:       ");
-    Serial.println(toHex(original));
-
-    // Encrypt
-    String encrypted = encryptPayload(original);
-    Serial.print("Encrypted: ");
-    Serial.println(encrypted);
-    Serial.print("Hex:       ");
-    Serial.println(toHex(encrypted));
-
-    // Decrypt
-    String decrypted = decryptPayload(encrypted);
-    Serial.print("Decrypted: ");
-    Serial.println(decrypted);
-
-    // Verify
-    if (original == decrypted) {
-      Serial.println("✓ Encryption test PASSED");
-    } else {
-      Serial.println("❌ Encryption test FAILED!");
-      Serial.print("Expected: ");
-      Serial.println(original);
-      Serial.print("Got:      ");
-      Serial.println(decrypted);
-    }
-  #else
-    Serial.println("⚠️  Encryption is disabled");
-  #endif
+// Only after the tag checked out
+inline void encReplayAccept(EncReplay& peer, uint32_t counter) {
+  if (!peer.used) {
+    peer.used = true;
+    peer.top = counter;
+    peer.seen = 1;
+  } else if (counter > peer.top) {
+    uint32_t shift = counter - peer.top;
+    peer.seen = shift >= ENC_REPLAY_WINDOW ? 1 : (peer.seen << shift) | 1;
+    peer.top = counter;
+  } else {
+    peer.seen |= 1UL << (peer.top - counter);
+  }
+}
+
+// =============== CONTEXT & STATISTICS ================================
+struct EncryptionStats {
+  unsigned long messagesEncrypted;
+  unsigned long messagesDecrypted;
+  unsigned long authFailures;        // Wrong tag (key, corruption, forgery)
+  unsigned long replays;             // Counter already seen or too old
+  unsigned long plainDropped;        // Frames without envelope
+  unsigned long peersEvicted;        // Replay windows reused for a new sender
+  unsigned long sealUsTotal;
+  unsigned long sealUsMax;
+  unsigned long openUsTotal;
+  unsigned long openUsMax;
+  unsigned long overheadBytes;       // Envelope bytes sent
+};
+
+struct EncContext {
+  EncAes aes;
+  bool ready;
+  uint16_t myAddress;
+  uint8_t networkId;
+  uint32_t txCounter;                // Next counter to send
+  uint32_t txReserved;               // Stored in NVS: counters below are used
+  EncReplay peers[ENC_PEERS];
+  EncryptionStats stats;
+};
+
+// Header counter: putVarint() / getVarint() (telemetry_frame.h)
+inline uint8_t encCounterLength(uint32_t value) {
+  uint8_t n = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    n++;
+  }
+  return n;
 }
 
-// Change encryption key at runtime (use carefully!)
-void setEncryptionKey(uint8_t newKey) {
-  #if ENABLE_ENCRYPTION
-    Serial.print("🔑 Changing encryption key: 0x");
-    Serial.print(encStats.currentKey, HEX);
-    Serial.print(" → 0x");
-    Serial.println(newKey, HEX);
+inline void encNonce(uint8_t* nonce, uint16_t sender, uint8_t networkId, uint32_t counter) {
+  nonce[0] = (uint8_t)sender;
+  nonce[1] = (uint8_t)(sender >> 8);
+  nonce[2] = networkId;
+  nonce[3] = (uint8_t)counter;
+  nonce[4] = (uint8_t)(counter >> 8);
+  nonce[5] = (uint8_t)(counter >> 16);
+  nonce[6] = (uint8_t)(counter >> 24);
+}
 
-    encStats.currentKey = newKey;
+// Envelope of the next frame: header before, tag after the plain bytes
+inline uint8_t encHeaderLength(const EncContext& enc) {
+  return 1 + encCounterLength(enc.txCounter);
+}
 
-    Serial.println("⚠️  WARNING: Both devices must use same key!");
-    Serial.println("⚠️  Old messages cannot be decrypted with new key!");
-  #endif
+inline uint8_t encOverhead(const EncContext& enc) {
+  return encHeaderLength(enc) + ENC_TAG_LEN;
 }
 
-// Get current encryption key
-uint8_t getEncryptionKey() {
-  #if ENABLE_ENCRYPTION
-    return encStats.currentKey;
-  #else
-    return 0;
-  #endif
+// Reserve the next counter block in NVS before using it
+inline bool encReserveCounters(EncContext& enc) {
+  Preferences nvs;
+  if (!nvs.begin("enc", false)) return false;
+  uint32_t next = enc.txCounter + ENC_COUNTER_BLOCK;
+  bool stored = nvs.putUInt("ctr", next) == sizeof(uint32_t);
+  nvs.end();
+  if (stored) enc.txReserved = next;
+  return stored;
 }
 
-// Check if encryption is enabled
-bool isEncryptionEnabled() {
-  return encStats.isEnabled;
+inline bool encInit(EncContext& enc, const uint8_t* key, uint16_t myAddress, uint8_t networkId) {
+  memset(&enc, 0, sizeof(enc));
+  encAesInit(enc.aes, key);
+  enc.myAddress = myAddress;
+  enc.networkId = networkId;
+
+  // Continue above the last reservation (counters may have been used)
+  Preferences nvs;
+  if (nvs.begin("enc", true)) {
+    enc.txCounter = nvs.getUInt("ctr", 0);
+    nvs.end();
+  }
+  enc.ready = encReserveCounters(enc);
+  return enc.ready;
 }
 
-// Encrypt with visual feedback (for debugging)
-String encryptWithDebug(String plaintext) {
-  #if ENABLE_ENCRYPTION
-    Serial.println("┌─ ENCRYPTION DEBUG ─");
-    Serial.print("│ Plaintext:  ");
-    Serial.println(plaintext);
-    Serial.print("│ Length:     ");
-    Serial.println(plaintext.length());
-    Serial.print("│ Key:        0x");
-    Serial.println(ENCRYPTION_KEY, HEX);
-
-    String encrypted = encryptPayload(plaintext);
-
-    Serial.print("│ Ciphertext: ");
-    Serial.println(encrypted);
-    Serial.print("│ Hex:        ");
-    Serial.println(toHex(encrypted));
-    Serial.println("└────────────────────");
-
-    return encrypted;
-  #else
-    return plaintext;
-  #endif
+// Deep-sleep wake (sleep_cycle.h): counter and reservation from RTC
+// memory - no NVS write per wake, no reserved block thrown away
+inline void encResume(EncContext& enc, const uint8_t* key, uint16_t myAddress, uint8_t networkId,
+                      uint32_t txCounter, uint32_t txReserved) {
+  memset(&enc, 0, sizeof(enc));
+  encAesInit(enc.aes, key);
+  enc.myAddress = myAddress;
+  enc.networkId = networkId;
+  enc.txCounter = txCounter;
+  enc.txReserved = txReserved;
+  enc.ready = true;
 }
 
-// Decrypt with visual feedback (for debugging)
-String decryptWithDebug(String ciphertext) {
-  #if ENABLE_ENCRYPTION
-    Serial.println("┌─ DECRYPTION DEBUG ─");
-    Serial.print("│ Ciphertext: ");
-    Serial.println(ciphertext);
-    Serial.print("│ Hex:        ");
-    Serial.println(toHex(ciphertext));
-    Serial.print("│ Key:        0x");
-    Serial.println(ENCRYPTION_KEY, HEX);
-
-    String decrypted = decryptPayload(ciphertext);
-
-    Serial.print("│ Plaintext:  ");
-    Serial.println(decrypted);
-    Serial.print("│ Length:     ");
-    Serial.println(decrypted.length());
-    Serial.println("└────────────────────");
-
-    return decrypted;
-  #else
-    return ciphertext;
+// frame = [encHeaderLength() free][len plain bytes][ENC_TAG_LEN free],
+// sealed in place. Returns the sealed length (0 = not sealed).
+inline uint8_t encSeal(EncContext& enc, uint8_t* frame, uint8_t len) {
+  if (!enc.ready || enc.txCounter == 0xFFFFFFFFUL) return 0;  // Out of nonces - change key
+  if (enc.txCounter >= enc.txReserved && !encReserveCounters(enc)) return 0;
+
+  unsigned long start = micros();
+  uint8_t headerLen = encHeaderLength(enc);
+  uint32_t counter = enc.txCounter++;
+  frame[0] = FRAME_TYPE_SECURE;
+  putVarint(frame + 1, counter);
+
+  uint8_t nonce[ENC_NONCE_LEN];
+  encNonce(nonce, enc.myAddress, enc.networkId, counter);
+  encCcmSeal(enc.aes, nonce, ENC_NONCE_LEN, frame, headerLen, frame + headerLen, len,
+             frame + headerLen + len, ENC_TAG_LEN);
+
+  unsigned long us = micros() - start;
+  enc.stats.messagesEncrypted++;
+  enc.stats.sealUsTotal += us;
+  if (us > enc.stats.sealUsMax) enc.stats.sealUsMax = us;
+  enc.stats.overheadBytes += headerLen + ENC_TAG_LEN;
+  return headerLen + len + ENC_TAG_LEN;
+}
+
+inline EncReplay* encFindPeer(EncContext& enc, uint16_t sender) {
+  for (uint8_t i = 0; i < ENC_PEERS; i++) {
+    if (enc.peers[i].used && enc.peers[i].sender == sender) return &enc.peers[i];
+  }
+  return nullptr;
+}
+
+// New sender: free window, else the least recently heard one
+inline EncReplay* encClaimPeer(EncContext& enc, uint16_t sender) {
+  EncReplay* slot = nullptr;
+  for (uint8_t i = 0; i < ENC_PEERS; i++) {
+    EncReplay& peer = enc.peers[i];
+    if (!peer.used) {
+      slot = &peer;
+      break;
+    }
+    if (!slot || (long)(peer.lastAt - slot->lastAt) < 0) slot = &peer;
+  }
+  if (slot->used) enc.stats.peersEvicted++;
+  memset(slot, 0, sizeof(*slot));
+  slot->sender = sender;
+  return slot;
+}
+
+// Opens a sealed frame in place; plain bytes start at frame + returned
+// offset (0 = rejected, frame wiped or left as is)
+inline uint8_t encOpen(EncContext& enc, uint8_t* frame, uint8_t len, uint16_t sender,
+                       unsigned long now, uint8_t& plainLen) {
+  if (len < 1 || frame[0] != FRAME_TYPE_SECURE) {
+    enc.stats.plainDropped++;
+    return 0;
+  }
+  uint32_t counter;
+  const uint8_t* p = frame + 1;
+  bool counterOk = getVarint(p, frame + len, counter);
+  uint8_t counterLen = p - (frame + 1);
+  if (!counterOk || len < 1 + counterLen + ENC_TAG_LEN) {
+    enc.stats.authFailures++;
+    return 0;
+  }
+
+  // Replays are dropped before any AES work
+  EncReplay* peer = encFindPeer(enc, sender);
+  if (peer && !encReplayFresh(*peer, counter)) {
+    enc.stats.replays++;
+    return 0;
+  }
+
+  unsigned long start = micros();
+  uint8_t headerLen = 1 + counterLen;
+  uint8_t bodyLen = len - headerLen - ENC_TAG_LEN;
+  uint8_t nonce[ENC_NONCE_LEN];
+  encNonce(nonce, sender, enc.networkId, counter);
+  bool authentic = encCcmOpen(enc.aes, nonce, ENC_NONCE_LEN, frame, headerLen,
+                              frame + headerLen, bodyLen,
+                              frame + headerLen + bodyLen, ENC_TAG_LEN);
+  unsigned long us = micros() - start;
+  enc.stats.openUsTotal += us;
+  if (us > enc.stats.openUsMax) enc.stats.openUsMax = us;
+  if (!authentic) {
+    enc.stats.authFailures++;
+    return 0;
+  }
+
+  // Window (and table slot) only move for authentic frames
+  if (!peer) peer = encClaimPeer(enc, sender);
+  encReplayAccept(*peer, counter);
+  peer->lastAt = now;
+  enc.stats.messagesDecrypted++;
+  plainLen = bodyLen;
+  return headerLen;
+}
+
+// =============== SELF-TEST ================================
+// NIST SP 800-38C example 1 (4-byte tag, 7-byte nonce - our parameters)
+inline bool encSelfTest() {
+  const uint8_t key[16] = {0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+                           0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f};
+  const uint8_t nonce[7] = {0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16};
+  const uint8_t aad[8] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+  const uint8_t expected[8] = {0x71, 0x62, 0x01, 0x5b, 0x4d, 0xac, 0x25, 0x5d};
+  uint8_t frame[8] = {0x20, 0x21, 0x22, 0x23};
+
+  EncAes aes;
+  encAesInit(aes, key);
+  encCcmSeal(aes, nonce, 7, aad, 8, frame, 4, frame + 4, ENC_TAG_LEN);
+  bool sealed = memcmp(frame, expected, 8) == 0;
+
+  bool opened = encCcmOpen(aes, nonce, 7, aad, 8, frame, 4, frame + 4, ENC_TAG_LEN) &&
+                frame[0] == 0x20 && frame[3] == 0x23;
+  frame[4] ^= 0x01;  // Any flipped tag bit must fail
+  bool rejected = !encCcmOpen(aes, nonce, 7, aad, 8, frame, 4, frame + 4, ENC_TAG_LEN);
+  #if ENC_HW_AES
+    mbedtls_aes_free(&aes.hw);
   #endif
+  return sealed && opened && rejected;
+}
+
+// =============== STATUS ================================
+// Air time of the envelope next to the frame it protects
+inline void printEncryptionStats(const EncContext& enc, const LoRaParams& params,
+                                 uint8_t frameLength) {
+  const EncryptionStats& s = enc.stats;
+  uint8_t overhead = encOverhead(enc);
+  Serial.print("🔒 AES-CCM: ");
+  Serial.print(s.messagesEncrypted);
+  Serial.print(" sealed (");
+  Serial.print(s.messagesEncrypted ? s.sealUsTotal / s.messagesEncrypted : 0);
+  Serial.print(" us avg, ");
+  Serial.print(s.sealUsMax);
+  Serial.print(" max), ");
+  Serial.print(s.messagesDecrypted);
+  Serial.print(" opened (");
+  Serial.print(s.messagesDecrypted ? s.openUsTotal / s.messagesDecrypted : 0);
+  Serial.print(" us avg, ");
+  Serial.print(s.openUsMax);
+  Serial.println(" max)");
+  Serial.print("   Rejected: ");
+  Serial.print(s.authFailures);
+  Serial.print(" tag, ");
+  Serial.print(s.replays);
+  Serial.print(" replay, ");
+  Serial.print(s.plainDropped);
+  Serial.print(" plain");
+  if (s.peersEvicted) {
+    Serial.print(", windows reused ");
+    Serial.print(s.peersEvicted);
+  }
+  Serial.println();
+  Serial.print("   Overhead: +");
+  Serial.print(overhead);
+  Serial.print(" B = +");
+  Serial.print((loraAirtimeUs(frameLength + overhead, params) -
+                loraAirtimeUs(frameLength, params)) / 1000);
+  Serial.print(" ms air on a ");
+  Serial.print(frameLength);
+  Serial.print(" B frame (");
+  Serial.print(loraAirtimeMs(frameLength, params));
+  Serial.print(" ms), counter ");
+  Serial.println(enc.txCounter);
 }
 
 #endif // ENCRYPTION_H
@@ -274,54 +274,55 @@ void printTelemetry() {
 }
 
 // Parse extended telemetry from received payload
-void parseTelemetry(String payload, ExtendedTelemetry* remoteTelem) {
+// "...,UP:x,HEAP:x,MHEAP:x,TEMP:x.x[,LOOP:x][,WIFI:x]" - single pass over
+// the fields (as decodeLegacyTelemetry()), no String. Unknown keys
+// (SEQ, LED, ...) are skipped, missing ones leave remoteTelem as it is.
+void parseTelemetry(const char* data, uint8_t len, ExtendedTelemetry* remoteTelem) {
   #if ENABLE_EXTENDED_TELEMETRY
-    // Parse UP:X
-    int upIdx = payload.indexOf("UP:");
-    if (upIdx >= 0) {
-      int comma = payload.indexOf(',', upIdx);
-      if (comma < 0) comma = payload.length();
-      remoteTelem->uptime = payload.substring(upIdx + 3, comma).toInt();
-    }
-
-    // Parse HEAP:X
-    int heapIdx = payload.indexOf("HEAP:");
-    if (heapIdx >= 0) {
-      int comma = payload.indexOf(',', heapIdx);
-      if (comma < 0) comma = payload.length();
-      remoteTelem->freeHeapKB = payload.substring(heapIdx + 5, comma).toInt();
-    }
-
-    // Parse MHEAP:X
-    int mheapIdx = payload.indexOf("MHEAP:");
-    if (mheapIdx >= 0) {
-      int comma = payload.indexOf(',', mheapIdx);
-      if (comma < 0) comma = payload.length();
-      remoteTelem->minFreeHeapKB = payload.substring(mheapIdx + 6, comma).toInt();
-    }
-
-    // Parse TEMP:X
-    int tempIdx = payload.indexOf("TEMP:");
-    if (tempIdx >= 0) {
-      int comma = payload.indexOf(',', tempIdx);
-      if (comma < 0) comma = payload.length();
-      remoteTelem->temperature = payload.substring(tempIdx + 5, comma).toFloat();
-    }
-
-    // Parse LOOP:X
-    int loopIdx = payload.indexOf("LOOP:");
-    if (loopIdx >= 0) {
-      int comma = payload.indexOf(',', loopIdx);
-      if (comma < 0) comma = payload.length();
-      remoteTelem->loopFrequency = payload.substring(loopIdx + 5, comma).toInt();
-    }
-
-    // Parse WIFI:X
-    int wifiIdx = payload.indexOf("WIFI:");
-    if (wifiIdx >= 0) {
-      int comma = payload.indexOf(',', wifiIdx);
-      if (comma < 0) comma = payload.length();
-      remoteTelem->wifiRSSI = payload.substring(wifiIdx + 5, comma).toInt();
+    const char* p = data;
+    const char* end = data + len;
+
+    while (p < end) {
+      // Key up to ':'
+      const char* key = p;
+      while (p < end && *p != ':' && *p != ',') p++;
+      uint8_t keyLen = p - key;
+      if (p >= end || *p != ':') {
+        if (p < end) p++;  // Skip token without value
+        continue;
+      }
+      p++;
+
+      // Signed value with optional one-place fraction (TEMP) up to ','
+      bool negative = p < end && *p == '-';
+      if (negative) p++;
+      long value = 0;
+      bool digits = false;
+      while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        digits = true;
+        p++;
+      }
+      int tenths = 0;
+      if (p + 1 < end && *p == '.' && p[1] >= '0' && p[1] <= '9') tenths = p[1] - '0';
+      while (p < end && *p != ',') p++;  // Ignore further decimals / junk
+      if (p < end) p++;
+      if (!digits) continue;
+      if (negative) value = -value;
+
+      if (keyLen == 2 && memcmp(key, "UP", 2) == 0) {
+        remoteTelem->uptime = value;
+      } else if (keyLen == 4 && memcmp(key, "HEAP", 4) == 0) {
+        remoteTelem->freeHeapKB = value;
+      } else if (keyLen == 5 && memcmp(key, "MHEAP", 5) == 0) {
+        remoteTelem->minFreeHeapKB = value;
+      } else if (keyLen == 4 && memcmp(key, "TEMP", 4) == 0) {
+        remoteTelem->temperature = value + (negative ? -tenths : tenths) / 10.0f;
+      } else if (keyLen == 4 && memcmp(key, "LOOP", 4) == 0) {
+        remoteTelem->loopFrequency = value;
+      } else if (keyLen == 4 && memcmp(key, "WIFI", 4) == 0) {
+        remoteTelem->wifiRSSI = value;
+      }
     }
   #endif
 }
@@ -0,0 +1,160 @@
+/*=====================================================================
+  fast_boot.h - Fast Boot Path and Boot Timeline
+
+  setup() used to sleep for over 12 s before the first packet:
+
+    Step                           | Sleep
+    -------------------------------|---------------------------------
+    Serial.begin()                 | delay(2000)
+    initLCD() splash               | delay(3000)
+    initLoRa()                     | delay(1000) + AT+RESET + up to
+                                   | 5 s waitForReady() + 6 commands
+    initDisplaySender() welcome    | delay(2000)
+    DisplayClient::begin()         | delay(500)
+
+  With ENABLE_FAST_BOOT:
+
+  1. No serial wait, no splash screens, pin settle time BOOT_SETTLE_MS
+  2. The radio is not reset and reprogrammed - the RYLR896 keeps its
+     settings in flash. bootRadioStart() opens the UART and queues the
+     link_recovery.h check ("AT", then AT+ADDRESS?, AT+NETWORKID?,
+     AT+PARAMETER? read back; a differing setting is written, a silent
+     module gets AT+RESET)
+  3. That check runs in the AT queue while LCD, display and sensors
+     start (bootRadioPoll() between the steps); bootRadioFinish() at
+     the end of setup() waits only for what is left of it
+
+  Either way every boot phase is timestamped (micros() since the app
+  started - ROM and bootloader time before that is not visible) and
+  printed at the end of setup(); the first packet sent or received
+  adds one more line.
+=======================================================================*/
+
+#ifndef FAST_BOOT_H
+#define FAST_BOOT_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "lora_handler.h"
+#include "link_recovery.h"
+
+// GPIO pull-up/-down settle time before a pin is read
+#if ENABLE_FAST_BOOT
+  #define BOOT_SETTLE_MS 1
+#else
+  #define BOOT_SETTLE_MS 100
+#endif
+
+enum BootPhase {
+  BOOT_SERIAL = 0,     // Serial Monitor up
+  BOOT_ROLE,           // Kill-switch and role pins read
+  BOOT_STATE,          // Structs and protocol modules initialized
+  BOOT_RADIO_PORT,     // LoRa UART and AT engine up
+  BOOT_PERIPHERALS,    // LCD, display station, sensors
+  BOOT_RADIO_READY,    // Module configuration verified (or failed)
+  BOOT_SETUP_DONE,
+  BOOT_FIRST_PACKET,   // First uplink sent (sender) / packet received
+  BOOT_PHASES
+};
+
+struct BootTimeline {
+  unsigned long atUs[BOOT_PHASES];   // micros(), 0 = not reached
+  bool radioOk;
+  LinkRecovery radio;                // Fast boot: configuration check
+};
+
+inline void bootInit(BootTimeline& boot) {
+  memset(&boot, 0, sizeof(boot));
+  linkRecoveryInit(boot.radio);
+}
+
+// Timestamp a phase (first time only)
+inline void bootMark(BootTimeline& boot, BootPhase phase) {
+  if (boot.atUs[phase] == 0) boot.atUs[phase] = micros();
+}
+
+// =============== RADIO ================================
+// Fast boot: UART up, configuration check queued - returns at once
+inline void bootRadioStart(BootTimeline& boot, uint8_t myAddress, uint8_t networkID) {
+  loraPortBegin(myAddress, networkID, 0);
+  linkRecoveryStart(boot.radio, myAddress, networkID);
+  bootMark(boot, BOOT_RADIO_PORT);
+}
+
+// Advance the check; true once it has finished
+inline bool bootRadioPoll(BootTimeline& boot) {
+  if (boot.atUs[BOOT_RADIO_READY]) return true;
+  loraPoll();
+  RecoveryResult result = linkRecoveryPoll(boot.radio);
+  if (result == RECOVERY_RUNNING) return false;
+  boot.radioOk = (result == RECOVERY_DONE);
+  bootMark(boot, BOOT_RADIO_READY);
+  return true;
+}
+
+// Wait for the rest of the check (bounded by the link_recovery.h timeouts)
+inline bool bootRadioFinish(BootTimeline& boot) {
+  while (!bootRadioPoll(boot)) {
+    yield();
+  }
+  return boot.radioOk;
+}
+
+// =============== REPORT ================================
+inline const char* bootPhaseName(uint8_t phase) {
+  static const char* const names[BOOT_PHASES] = {
+    "serial", "role", "state", "radio port", "peripherals",
+    "radio ready", "setup done", "first packet"
+  };
+  return phase < BOOT_PHASES ? names[phase] : "?";
+}
+
+inline void printBootPhase(const BootTimeline& boot, uint8_t phase) {
+  Serial.print("  ");
+  Serial.print(bootPhaseName(phase));
+  for (uint8_t i = strlen(bootPhaseName(phase)); i < 14; i++) Serial.print(" ");
+  Serial.print(boot.atUs[phase] / 1000.0f, 1);
+  Serial.println(" ms");
+}
+
+inline void printBootTimeline(const BootTimeline& boot) {
+  Serial.print("\n⏱️  Boot timeline (");
+  Serial.print(ENABLE_FAST_BOOT ? "fast boot" : "full init");
+  Serial.println("):");
+  // In time order (fast boot: the radio check ends after the peripherals)
+  uint16_t printed = 0;
+  for (uint8_t n = 0; n < BOOT_FIRST_PACKET; n++) {
+    uint8_t next = BOOT_PHASES;
+    for (uint8_t p = 0; p < BOOT_FIRST_PACKET; p++) {
+      if (!boot.atUs[p] || (printed & (1 << p))) continue;
+      if (next == BOOT_PHASES || boot.atUs[p] < boot.atUs[next]) next = p;
+    }
+    if (next == BOOT_PHASES) break;
+    printBootPhase(boot, next);
+    printed |= 1 << next;
+  }
+  #if ENABLE_FAST_BOOT
+    Serial.print("  radio check: ");
+    if (boot.radioOk) {
+      Serial.print(recoveryTierName(boot.radio.lastTier));
+    } else {
+      Serial.print("FAILED");
+    }
+    Serial.print(", ");
+    Serial.print(boot.radio.lastMs);
+    Serial.println(" ms");
+  #endif
+}
+
+// First packet after boot: timestamp and one line, later calls are free
+inline void bootFirstPacket(BootTimeline& boot, const char* what) {
+  if (boot.atUs[BOOT_FIRST_PACKET]) return;
+  bootMark(boot, BOOT_FIRST_PACKET);
+  Serial.print("⏱️  First packet ");
+  Serial.print(what);
+  Serial.print(" ");
+  Serial.print(boot.atUs[BOOT_FIRST_PACKET] / 1000);
+  Serial.println(" ms after start");
+}
+
+#endif // FAST_BOOT_H
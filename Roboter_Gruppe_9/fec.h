@@ -0,0 +1,332 @@
+/*=====================================================================
+  fec.h - Forward Error Correction Across Packets
+
+  At SF12 a lost packet costs ~0.7-2.7 s of airtime, and the RYLR896
+  only offers CR 4/5..4/8 inside the packet. The module also drops
+  every packet whose LoRa CRC fails - the application never sees a
+  damaged frame, only missing ones. So the useful code here is an
+  ERASURE code across packets, not an error code inside one.
+
+  Every FEC_GROUP_SIZE uplink frames the sender adds parity frames:
+
+    P = D0 ^ D1 ^ ... ^ Dk-1                  (XOR parity)
+    Q = D0 ^ g·D1 ^ g²·D2 ^ ... ^ g^(k-1)·Dk-1 (Reed-Solomon / RAID-6
+                                               syndrome over GF(2^8))
+
+  Di = [length][payload][zero padding] so frames of different length
+  can be rebuilt exactly.
+
+    FEC_PARITY_COUNT 1: P      → rebuilds any 1 lost frame per group
+    FEC_PARITY_COUNT 2: P + Q  → rebuilds any 2 lost frames per group
+
+  Cost: FEC_PARITY_COUNT / FEC_GROUP_SIZE extra packets (25% for 1/4)
+  plus 1 header byte per data frame. Recovered frames come out late
+  (after the parity), with no retransmission round-trip.
+
+  Frame schemas:
+
+  Data    | 0 tag 0xC0 | (group & 3) << 3 | index (0-7) | 1.. payload
+  Parity  | 0 type 0x87 | 1 group | 2 (k << 4) | j | 3.. P or Q block
+
+  CPU: P is 1 XOR per byte; Q adds one GF(2^8) multiply per byte
+  (shift-and-add, ≤ 8 iterations, no tables). Recovery of 2 frames is
+  one GF inverse (square-and-multiply) plus 3 multiplies per byte.
+  host/bench_fec.cpp measures each path per payload byte.
+
+  Pure C++ (no String, no heap) - host-testable.
+=======================================================================*/
+
+#ifndef FEC_H
+#define FEC_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define FRAME_FEC_DATA_TAG    0xC0  // 0xC0-0xDF: data frame, group/index in low bits
+#define FRAME_FEC_DATA_MASK   0xE0
+#define FRAME_TYPE_FEC_PARITY 0x87
+
+#define FEC_DATA_HEADER_LEN 1
+#define FEC_PARITY_HEADER_LEN 3
+#define FEC_DATA_MAX 200                  // Largest wrapped frame (batch frames)
+#define FEC_BLOCK_MAX (FEC_DATA_MAX + 1)  // [length][payload]
+#define FEC_MAX_GROUP 8                   // Index field is 3 bits
+#define FEC_MAX_PARITY 2                  // P and Q
+
+// =============== GF(2^8) ARITHMETIC ================================
+// Polynomial x^8 + x^4 + x^3 + x^2 + 1 (0x11D), generator g = 2
+inline uint8_t gfMul(uint8_t a, uint8_t b) {
+  uint8_t product = 0;
+  while (b) {
+    if (b & 1) product ^= a;
+    a = (uint8_t)(a << 1) ^ ((a & 0x80) ? 0x1D : 0);
+    b >>= 1;
+  }
+  return product;
+}
+
+inline uint8_t gfPow2(uint8_t n) {
+  uint8_t v = 1;
+  while (n--) v = gfMul(v, 2);
+  return v;
+}
+
+// a^254 = a^-1 (a != 0)
+inline uint8_t gfInv(uint8_t a) {
+  uint8_t result = 1;
+  uint8_t e = 254;
+  while (e) {
+    if (e & 1) result = gfMul(result, a);
+    a = gfMul(a, a);
+    e >>= 1;
+  }
+  return result;
+}
+
+// dst ^= c · src
+inline void gfMulAdd(uint8_t* dst, const uint8_t* src, uint8_t c, uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) dst[i] ^= gfMul(c, src[i]);
+}
+
+// =============== SENDER ================================
+struct FecEncoder {
+  uint8_t group;               // Group counter (low 2 bits on air)
+  uint8_t index;               // Data frames in the current group
+  uint8_t parityNext;          // Parity frames already sent
+  uint8_t blockLen;            // Longest block in the group
+  uint8_t parity[FEC_MAX_PARITY][FEC_BLOCK_MAX];
+
+  // Statistics
+  unsigned long dataFrames;
+  unsigned long parityFrames;
+  unsigned long paritySkipped; // Group closed before its parity went out
+};
+
+inline void fecNewGroup(FecEncoder& e) {
+  e.group++;
+  e.index = 0;
+  e.parityNext = 0;
+  e.blockLen = 0;
+  memset(e.parity, 0, sizeof(e.parity));
+}
+
+inline void fecEncoderInit(FecEncoder& e) {
+  memset(&e, 0, sizeof(e));
+}
+
+inline bool fecParityDue(const FecEncoder& e) {
+  return e.index >= FEC_GROUP_SIZE;
+}
+
+// Header + payload into out; returns frame length, 0 if too long
+inline uint8_t fecWrapData(FecEncoder& e, const uint8_t* data, uint8_t len, uint8_t* out) {
+  if (len > FEC_DATA_MAX) return 0;
+  if (fecParityDue(e)) {
+    e.paritySkipped++;  // Parity could not be sent in time - start over
+    fecNewGroup(e);
+  }
+  out[0] = FRAME_FEC_DATA_TAG | ((e.group & 0x03) << 3) | e.index;
+  memcpy(out + FEC_DATA_HEADER_LEN, data, len);
+  return FEC_DATA_HEADER_LEN + len;
+}
+
+// Frame is on its way: fold it into P and Q
+inline void fecAddData(FecEncoder& e, const uint8_t* data, uint8_t len) {
+  uint8_t coeff = gfPow2(e.index);
+  e.parity[0][0] ^= len;
+  e.parity[1][0] ^= gfMul(coeff, len);
+  for (uint8_t i = 0; i < len; i++) {
+    e.parity[0][1 + i] ^= data[i];
+  }
+  gfMulAdd(e.parity[1] + 1, data, coeff, len);
+
+  if (len + 1 > e.blockLen) e.blockLen = len + 1;
+  e.index++;
+  e.dataFrames++;
+}
+
+// Next parity frame of a full group; call fecParitySent() once queued
+inline uint8_t fecBuildParity(const FecEncoder& e, uint8_t* out) {
+  out[0] = FRAME_TYPE_FEC_PARITY;
+  out[1] = e.group & 0x03;
+  out[2] = (e.index << 4) | e.parityNext;
+  memcpy(out + FEC_PARITY_HEADER_LEN, e.parity[e.parityNext], e.blockLen);
+  return FEC_PARITY_HEADER_LEN + e.blockLen;
+}
+
+inline void fecParitySent(FecEncoder& e) {
+  e.parityFrames++;
+  if (++e.parityNext >= FEC_PARITY_COUNT) fecNewGroup(e);
+}
+
+// =============== RECEIVER ================================
+struct FecDecoder {
+  bool active;
+  bool complete;               // Every data frame present or rebuilt
+  uint8_t group;
+  uint8_t have;                // Bitmask of data indexes
+  uint8_t highest;             // Highest data index seen + 1
+  uint8_t k;                   // Group size (known once parity arrives)
+  uint8_t lastK;               // Group size of earlier groups
+  uint8_t blocks[FEC_MAX_GROUP][FEC_BLOCK_MAX];
+  uint8_t parity[FEC_MAX_PARITY][FEC_BLOCK_MAX];
+  uint8_t parityHave;          // Bitmask of P/Q
+  uint8_t parityLen;
+
+  // Rebuilt frames waiting to be read (fecTakeRecovered)
+  uint8_t pending[FEC_MAX_PARITY];
+  uint8_t pendingCount;
+
+  // Statistics
+  unsigned long recovered;     // Frames rebuilt from parity
+  unsigned long unrecoverable; // Frames lost for good
+};
+
+inline uint8_t fecPopCount(uint8_t v) {
+  uint8_t n = 0;
+  for (; v; v &= v - 1) n++;
+  return n;
+}
+
+inline void fecDecoderInit(FecDecoder& d) {
+  memset(&d, 0, sizeof(d));
+}
+
+// Close the current group (counting what stayed lost) and open another
+inline void fecStartGroup(FecDecoder& d, uint8_t group) {
+  if (d.k) d.lastK = d.k;
+  if (d.active && !d.complete) {
+    uint8_t k = d.lastK > d.highest ? d.lastK : d.highest;
+    uint8_t expected = k >= 8 ? 0xFF : (1 << k) - 1;
+    d.unrecoverable += fecPopCount(expected & ~d.have);
+  }
+  // Whole groups that never showed up (group id skipped)
+  uint8_t skipped = (group - d.group - 1) & 0x03;
+  if (d.active && skipped > 0) d.unrecoverable += skipped * d.lastK;
+
+  d.active = true;
+  d.complete = false;
+  d.group = group;
+  d.have = 0;
+  d.highest = 0;
+  d.k = 0;
+  d.parityHave = 0;
+  d.parityLen = 0;
+  d.pendingCount = 0;
+}
+
+// Data frame: remembers the block, returns the inner payload
+inline bool fecAcceptData(FecDecoder& d, const uint8_t* frame, uint8_t len,
+                          const uint8_t*& payload, uint8_t& payloadLen) {
+  if (len < FEC_DATA_HEADER_LEN || (frame[0] & FRAME_FEC_DATA_MASK) != FRAME_FEC_DATA_TAG) return false;
+  uint8_t group = (frame[0] >> 3) & 0x03;
+  uint8_t index = frame[0] & 0x07;
+  payload = frame + FEC_DATA_HEADER_LEN;
+  payloadLen = len - FEC_DATA_HEADER_LEN;
+
+  if (!d.active || group != d.group) fecStartGroup(d, group);
+  if (!(d.have & (1 << index))) {
+    memset(d.blocks[index], 0, FEC_BLOCK_MAX);
+    d.blocks[index][0] = payloadLen;
+    memcpy(d.blocks[index] + 1, payload, payloadLen);
+    d.have |= 1 << index;
+    if (index + 1 > d.highest) d.highest = index + 1;
+  }
+  return true;
+}
+
+// Rebuild missing[] from P/Q and the frames that did arrive
+inline bool fecRecover(FecDecoder& d, const uint8_t* missing, uint8_t count) {
+  uint8_t L = d.parityLen;
+  uint8_t sp[FEC_BLOCK_MAX], sq[FEC_BLOCK_MAX];  // Syndromes of the missing frames
+  memcpy(sp, d.parity[0], L);
+  memcpy(sq, d.parity[1], L);
+  for (uint8_t i = 0; i < d.k; i++) {
+    if (!(d.have & (1 << i))) continue;
+    for (uint8_t b = 0; b < L; b++) sp[b] ^= d.blocks[i][b];
+    gfMulAdd(sq, d.blocks[i], gfPow2(i), L);
+  }
+
+  uint8_t x = missing[0];
+  if (count == 1 && (d.parityHave & 0x01)) {
+    memcpy(d.blocks[x], sp, L);                      // Dx = P'
+  } else if (count == 1) {
+    uint8_t inv = gfInv(gfPow2(x));                  // Dx = Q' / g^x
+    for (uint8_t b = 0; b < L; b++) d.blocks[x][b] = gfMul(sq[b], inv);
+  } else {
+    uint8_t y = missing[1];
+    uint8_t gy = gfPow2(y);
+    uint8_t inv = gfInv(gfPow2(x) ^ gy);             // Dx = (Q' ^ g^y·P') / (g^x ^ g^y)
+    for (uint8_t b = 0; b < L; b++) {
+      d.blocks[x][b] = gfMul(sq[b] ^ gfMul(gy, sp[b]), inv);
+      d.blocks[y][b] = sp[b] ^ d.blocks[x][b];       // Dy = P' ^ Dx
+    }
+  }
+
+  // Length byte must fit the block - otherwise parity and data disagree
+  for (uint8_t m = 0; m < count; m++) {
+    if (d.blocks[missing[m]][0] + 1 > L) return false;
+  }
+  for (uint8_t m = 0; m < count; m++) {
+    d.have |= 1 << missing[m];
+    d.pending[d.pendingCount++] = missing[m];
+  }
+  d.recovered += count;
+  return true;
+}
+
+// Parity frame: rebuilds lost frames when enough parity is present.
+// Returns number of frames rebuilt (read them with fecTakeRecovered).
+inline uint8_t fecAcceptParity(FecDecoder& d, const uint8_t* frame, uint8_t len) {
+  if (len <= FEC_PARITY_HEADER_LEN || frame[0] != FRAME_TYPE_FEC_PARITY) return 0;
+  uint8_t group = frame[1] & 0x03;
+  uint8_t k = frame[2] >> 4;
+  uint8_t j = frame[2] & 0x0F;
+  uint8_t blockLen = len - FEC_PARITY_HEADER_LEN;
+  if (k == 0 || k > FEC_MAX_GROUP || j >= FEC_MAX_PARITY || blockLen > FEC_BLOCK_MAX) return 0;
+
+  if (!d.active || group != d.group) fecStartGroup(d, group);  // Whole group lost so far
+  if (d.complete) return 0;
+  if (d.parityLen && d.parityLen != blockLen) return 0;         // Inconsistent group
+  d.k = k;
+  d.parityLen = blockLen;
+  memcpy(d.parity[j], frame + FEC_PARITY_HEADER_LEN, blockLen);
+  d.parityHave |= 1 << j;
+
+  uint8_t missing[FEC_MAX_GROUP];
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < k; i++) {
+    if (!(d.have & (1 << i))) missing[count++] = i;
+  }
+  if (count == 0) {
+    d.complete = true;
+    return 0;
+  }
+  if (count > fecPopCount(d.parityHave)) return 0;  // Wait for more parity
+  if (count == 2 && d.parityHave != 0x03) return 0;
+
+  if (!fecRecover(d, missing, count)) return 0;
+  d.complete = true;
+  return count;
+}
+
+// Next rebuilt frame (valid until the decoder sees another frame)
+inline bool fecTakeRecovered(FecDecoder& d, const uint8_t*& payload, uint8_t& len) {
+  if (d.pendingCount == 0) return false;
+  uint8_t index = d.pending[0];
+  d.pending[0] = d.pending[1];
+  d.pendingCount--;
+  len = d.blocks[index][0];
+  payload = d.blocks[index] + 1;
+  return true;
+}
+
+inline bool isFecData(const char* data, uint8_t len) {
+  return len > 0 && ((uint8_t)data[0] & FRAME_FEC_DATA_MASK) == FRAME_FEC_DATA_TAG;
+}
+
+inline bool isFecParity(const char* data, uint8_t len) {
+  return len > 0 && (uint8_t)data[0] == FRAME_TYPE_FEC_PARITY;
+}
+
+#endif // FEC_H
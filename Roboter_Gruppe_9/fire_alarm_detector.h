@@ -115,6 +115,10 @@ struct FireAlarmState {
 
 static FireAlarmState fireAlarmState = {false, false, 0, 0, 0, 0, 0};
 
+// Hälytyksen välitys LoRalla - toteutetaan pääohjelmassa
+// (varmennettu kanava, reliable_link.h)
+void onFireAlarmAlert(bool audio, bool light, unsigned long alertCount);
+
 /**
  * Alustaa palovaroittimen havaitsemisen.
  * Kutsuu käytössä olevien detektorien init-funktioita.
@@ -207,8 +211,8 @@ void checkFireAlarm() {
 
       Serial.println();
 
-      // Tässä voidaan lähettää LoRa-hälytys
-      // Esim: sendLoRaMessage("ALERT:FIRE_ALARM");
+      // Lähetä LoRa-hälytys
+      onFireAlarmAlert(audioTriggered, lightTriggered, fireAlarmState.alertCount);
     }
   }
 }
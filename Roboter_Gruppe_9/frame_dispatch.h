@@ -0,0 +1,210 @@
+/*=====================================================================
+  frame_dispatch.h - Frame Classification and Handler Tables
+
+  Every received payload used to walk a chain of predicates in loop():
+  isTelemetryBatch(), isReliableFrame(), isAlertFrame(), adrDecode(),
+  decodeTelemetry() ... each one looking at the frame again until one
+  matched, and remote commands went through String::indexOf() once per
+  known command. Cost grew with every frame type added.
+
+  Now each frame is classified once (frameKind(), first byte - plus
+  the "ACK," prefix for legacy ASCII) and the role's handler is picked
+  from a dense table indexed by FrameKind:
+
+    receiveLoRaPacket()  → loraRxKind (after relay/FEC unwrapping)
+    loop()               → frameDispatch(receiverRoutes, loraRxKind, rx)
+
+  Handler tables are built at compile time from a route list, so a
+  role only names the frames it handles and unknown kinds stay nullptr:
+
+    constexpr FrameRoute<Ctx> routes[] = {
+      {FRAME_KIND_TELEMETRY, onTelemetry},
+      {FRAME_KIND_BATCH, onBatch},
+    };
+    constexpr FrameHandler<Ctx> table[FRAME_KIND_COUNT] = FRAME_ROUTE_TABLE(routes);
+
+  Binary frame types 0x81-0x8E map 1:1 onto FrameKind (type - 0x80),
+  FEC data frames (0xC0-0xDF) get their own kind. Length checks stay
+  in each decoder - the kind only selects it.
+
+  Remote commands ("CMD:VERB[:arg][,...]") are classified the same
+  way: one pass over the prefix and verb (remoteCommand(), argument
+  with remoteCommandArg()) - the kill switch in the sketch and
+  processAdvancedCommand() (advanced_commands.h) share the verb table.
+
+  Pure C++ (no String, no heap) - host-testable. host/bench_dispatch.cpp
+  measures the old predicate chain (and String::indexOf() command and
+  field scans) against this table.
+=======================================================================*/
+
+#ifndef FRAME_DISPATCH_H
+#define FRAME_DISPATCH_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "fec.h"
+
+// =============== FRAME KINDS ================================
+// Order = binary type - 0x80 (telemetry_frame.h ... tx_queue.h)
+enum FrameKind : uint8_t {
+  FRAME_KIND_UNKNOWN = 0,
+  FRAME_KIND_TELEMETRY,      // 0x81 or legacy "SEQ:..."
+  FRAME_KIND_ACK,            // 0x82 or legacy "ACK,..."
+  FRAME_KIND_BATCH,          // 0x83
+  FRAME_KIND_RELIABLE,       // 0x84
+  FRAME_KIND_REL_ACK,        // 0x85
+  FRAME_KIND_BEACON,         // 0x86
+  FRAME_KIND_FEC_PARITY,     // 0x87
+  FRAME_KIND_ADR_CMD,        // 0x88
+  FRAME_KIND_ADR_ACCEPT,     // 0x89
+  FRAME_KIND_RELAY,          // 0x8A
+  FRAME_KIND_RELAY_ACK,      // 0x8B
+  FRAME_KIND_ALERT,          // 0x8C
+  FRAME_KIND_COMMAND,        // 0x8D
+  FRAME_KIND_SECURE,         // 0x8E (opened in receiveLoRaPacket())
+  FRAME_KIND_FEC_DATA,       // 0xC0-0xDF
+  FRAME_KIND_COUNT
+};
+
+#define FRAME_KIND_BINARY_LAST FRAME_KIND_SECURE
+
+inline FrameKind frameKind(const char* data, uint8_t len) {
+  if (len == 0) return FRAME_KIND_UNKNOWN;
+  uint8_t type = (uint8_t)data[0];
+  if (!(type & 0x80)) {
+    // Legacy ASCII telemetry
+    return (len >= 4 && memcmp(data, "ACK,", 4) == 0) ? FRAME_KIND_ACK : FRAME_KIND_TELEMETRY;
+  }
+  if (type > 0x80 && type <= 0x80 + FRAME_KIND_BINARY_LAST) return (FrameKind)(type - 0x80);
+  if ((type & FRAME_FEC_DATA_MASK) == FRAME_FEC_DATA_TAG) return FRAME_KIND_FEC_DATA;
+  return FRAME_KIND_UNKNOWN;
+}
+
+// =============== HANDLER TABLES ================================
+template <typename Ctx>
+using FrameHandler = void (*)(Ctx&);
+
+template <typename Ctx>
+struct FrameRoute {
+  uint8_t kind;
+  FrameHandler<Ctx> handler;
+};
+
+// Handler of kind in a route list (first match), nullptr if none
+template <typename Ctx, size_t N>
+constexpr FrameHandler<Ctx> frameRouteLookup(const FrameRoute<Ctx> (&routes)[N],
+                                             uint8_t kind, size_t i = 0) {
+  return i >= N ? nullptr
+       : routes[i].kind == kind ? routes[i].handler
+       : frameRouteLookup(routes, kind, i + 1);
+}
+
+// Dense table, one entry per FrameKind in enum order
+#define FRAME_ROUTE_TABLE(routes) { \
+  frameRouteLookup(routes, FRAME_KIND_UNKNOWN), \
+  frameRouteLookup(routes, FRAME_KIND_TELEMETRY), \
+  frameRouteLookup(routes, FRAME_KIND_ACK), \
+  frameRouteLookup(routes, FRAME_KIND_BATCH), \
+  frameRouteLookup(routes, FRAME_KIND_RELIABLE), \
+  frameRouteLookup(routes, FRAME_KIND_REL_ACK), \
+  frameRouteLookup(routes, FRAME_KIND_BEACON), \
+  frameRouteLookup(routes, FRAME_KIND_FEC_PARITY), \
+  frameRouteLookup(routes, FRAME_KIND_ADR_CMD), \
+  frameRouteLookup(routes, FRAME_KIND_ADR_ACCEPT), \
+  frameRouteLookup(routes, FRAME_KIND_RELAY), \
+  frameRouteLookup(routes, FRAME_KIND_RELAY_ACK), \
+  frameRouteLookup(routes, FRAME_KIND_ALERT), \
+  frameRouteLookup(routes, FRAME_KIND_COMMAND), \
+  frameRouteLookup(routes, FRAME_KIND_SECURE), \
+  frameRouteLookup(routes, FRAME_KIND_FEC_DATA) }
+static_assert(FRAME_KIND_COUNT == 16, "FRAME_ROUTE_TABLE lists every FrameKind");
+
+// Run the handler for kind; false if the role has none
+template <typename Ctx>
+inline bool frameDispatch(const FrameHandler<Ctx> (&table)[FRAME_KIND_COUNT],
+                          FrameKind kind, Ctx& ctx) {
+  FrameHandler<Ctx> handler = table[kind < FRAME_KIND_COUNT ? kind : FRAME_KIND_UNKNOWN];
+  if (!handler) return false;
+  handler(ctx);
+  return true;
+}
+
+// =============== REMOTE COMMANDS ================================
+// Kill switch (processRemoteKillSwitch()) and advanced_commands.h
+enum RemoteCommand : uint8_t {
+  REMOTE_CMD_UNKNOWN = 0,
+  REMOTE_CMD_RESTART,
+  REMOTE_CMD_STOP,
+  REMOTE_CMD_STATUS,
+  REMOTE_CMD_RESET_STATS,
+  REMOTE_CMD_PING,
+  REMOTE_CMD_SET_POWER,      // :dBm
+  REMOTE_CMD_SET_SF,         // :SF
+  REMOTE_CMD_SET_INTERVAL,   // :ms
+  REMOTE_CMD_LED_ON,
+  REMOTE_CMD_LED_OFF,
+  REMOTE_CMD_LED_BLINK,      // :times
+  REMOTE_CMD_GET_RSSI,
+  REMOTE_CMD_GET_BATTERY
+};
+
+struct RemoteCommandName {
+  const char* verb;
+  uint8_t verbLen;
+  RemoteCommand command;
+};
+
+const RemoteCommandName remoteCommandNames[] = {
+  {"RESTART", 7, REMOTE_CMD_RESTART},
+  {"STOP", 4, REMOTE_CMD_STOP},
+  {"STATUS", 6, REMOTE_CMD_STATUS},
+  {"RESET_STATS", 11, REMOTE_CMD_RESET_STATS},
+  {"PING", 4, REMOTE_CMD_PING},
+  {"SET_POWER", 9, REMOTE_CMD_SET_POWER},
+  {"SET_SF", 6, REMOTE_CMD_SET_SF},
+  {"SET_INTERVAL", 12, REMOTE_CMD_SET_INTERVAL},
+  {"LED_ON", 6, REMOTE_CMD_LED_ON},
+  {"LED_OFF", 7, REMOTE_CMD_LED_OFF},
+  {"LED_BLINK", 9, REMOTE_CMD_LED_BLINK},
+  {"GET_RSSI", 8, REMOTE_CMD_GET_RSSI},
+  {"GET_BATTERY", 11, REMOTE_CMD_GET_BATTERY},
+};
+
+// Length of VERB in "CMD:VERB[:arg][,...]"
+inline uint8_t remoteCommandVerbLength(const char* text, uint8_t len) {
+  uint8_t verbLen = 0;
+  while (4 + verbLen < len && text[4 + verbLen] != ',' && text[4 + verbLen] != ':') verbLen++;
+  return verbLen;
+}
+
+// "CMD:VERB[:arg][,...]" → command
+inline RemoteCommand remoteCommand(const char* text, uint8_t len) {
+  if (len < 5 || memcmp(text, "CMD:", 4) != 0) return REMOTE_CMD_UNKNOWN;
+  const char* verb = text + 4;
+  uint8_t verbLen = remoteCommandVerbLength(text, len);
+  for (const RemoteCommandName& name : remoteCommandNames) {
+    if (name.verbLen == verbLen && memcmp(name.verb, verb, verbLen) == 0) return name.command;
+  }
+  return REMOTE_CMD_UNKNOWN;
+}
+
+// Decimal argument after "CMD:VERB:" - false if missing or not a number
+inline bool remoteCommandArg(const char* text, uint8_t len, long& value) {
+  if (len < 5 || memcmp(text, "CMD:", 4) != 0) return false;
+  uint8_t p = 4 + remoteCommandVerbLength(text, len);
+  if (p >= len || text[p] != ':') return false;
+  p++;
+  bool negative = p < len && text[p] == '-';
+  if (negative) p++;
+  if (p >= len || text[p] < '0' || text[p] > '9') return false;
+  long v = 0;
+  uint8_t digits = 0;
+  while (p < len && text[p] >= '0' && text[p] <= '9') {
+    v = v * 10 + (text[p++] - '0');
+    if (++digits > 6) return false;  // Far beyond any valid argument
+  }
+  value = negative ? -v : v;
+  return true;
+}
+
+#endif // FRAME_DISPATCH_H
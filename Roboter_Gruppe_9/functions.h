@@ -19,12 +19,14 @@ inline void initLCD() {
   lcd.init();
   lcd.clear();    
   lcd.backlight();
-  lcd.setCursor(0, 0);
-  lcd.print("ZignalMeister");
-  lcd.setCursor(2, 1);
-  lcd.print("2000");
-  delay(3000);
-  lcd.clear();
+  #if !ENABLE_FAST_BOOT
+    lcd.setCursor(0, 0);
+    lcd.print("ZignalMeister");
+    lcd.setCursor(2, 1);
+    lcd.print("2000");
+    delay(3000);
+    lcd.clear();
+  #endif
 }
 
 #endif // FUNCTIONS_H
\ No newline at end of file
@@ -5,12 +5,13 @@
   - Connection state machine (UNKNOWN -> CONNECTED -> WEAK -> LOST)
   - RSSI statistics tracking (min, max, average)
   - Packet loss detection with sequence numbers
-  - Automatic recovery attempts
+  - Automatic recovery attempts (tiered, non-blocking - link_recovery.h)
   - Health status reporting
 
   Usage:
   1. Call initHealthMonitor() in setup()
-  2. Call updateConnectionState() in loop() (receiver)
+  2. Call updateConnectionState() in loop() (receiver), then
+     attemptRecovery() and pollRecovery()
   3. Call trackPacket() when packet received
   4. Call getConnectionStateString() for display
 
@@ -21,6 +22,7 @@
 
 #include "config.h"
 #include "structs.h"
+#include "link_recovery.h"
 
 // =============== GLOBAL WATCHDOG CONFIG ================================
 // Default thresholds - can be adjusted
@@ -34,7 +36,7 @@ WatchdogConfig watchdogCfg = {
 };
 
 // =============== INITIALIZE HEALTH MONITOR ================================
-inline void initHealthMonitor(HealthMonitor& health) {
+inline void initHealthMonitor(HealthMonitor& health, bool announce = true) {
   health.state = CONN_UNKNOWN;
   health.stateChangeTime = millis();
   health.connectedSince = 0;
@@ -55,7 +57,7 @@ inline void initHealthMonitor(HealthMonitor& health) {
 
   health.startTime = millis();
 
-  Serial.println("✓ Health Monitor initialized");
+  if (announce) Serial.println("✓ Health Monitor initialized");
 }
 
 // =============== UPDATE RSSI STATISTICS ================================
@@ -112,6 +114,16 @@ inline void trackPacket(HealthMonitor& health, int receivedSeq) {
   health.expectedSeq = receivedSeq + 1;
 }
 
+// Frame rebuilt by FEC after the loss was already counted
+inline void trackRecoveredPacket(HealthMonitor& health, int receivedSeq) {
+  if (receivedSeq < health.expectedSeq && health.packetsLost > 0) {
+    health.packetsLost--;
+    health.packetsReceived++;
+  } else {
+    trackPacket(health, receivedSeq);
+  }
+}
+
 // =============== GET PACKET LOSS PERCENTAGE ================================
 inline float getPacketLoss(HealthMonitor& health) {
   int totalExpected = health.packetsReceived + health.packetsLost;
@@ -143,33 +155,53 @@ inline char getConnectionIcon(ConnectionState state) {
   }
 }
 
+// =============== PEER TIMEOUTS ================================
+// Senders with a heartbeat (uplink_policy.h) advertise its interval:
+// WEAK after one missed heartbeat, LOST after two (plus the defaults
+// as jitter/air time margin)
+inline unsigned long watchdogWeakTimeout(const DeviceState& remote) {
+  return watchdogCfg.weakTimeout + remote.keepaliveMs;
+}
+
+inline unsigned long watchdogLostTimeout(const DeviceState& remote) {
+  return watchdogCfg.lostTimeout + 2 * remote.keepaliveMs;
+}
+
+// =============== NEXT CONNECTION STATE ================================
+// State rules only (no side effects) - shared with the gateway node table
+inline ConnectionState nextConnectionState(const HealthMonitor& health,
+                                           const DeviceState& remote, unsigned long now) {
+  unsigned long timeSinceLastMsg = now - remote.lastMessageTime;
+  unsigned long weakTimeout = watchdogWeakTimeout(remote);
+
+  if (timeSinceLastMsg > watchdogLostTimeout(remote)) {
+    // No messages for > 8 seconds (two heartbeats + 8 s)
+    return CONN_LOST;
+  }
+  if (timeSinceLastMsg > weakTimeout ||
+      remote.rssi < watchdogCfg.weakRssiThreshold) {
+    // No messages for 3-8 seconds (one heartbeat + 3 s) OR weak signal
+    return CONN_WEAK;
+  }
+  if (timeSinceLastMsg < weakTimeout &&
+      remote.rssi >= watchdogCfg.weakRssiThreshold) {
+    // Messages recent and signal good
+    return CONN_CONNECTED;
+  }
+  return health.state;
+}
+
 // =============== UPDATE CONNECTION STATE ================================
 // Call this regularly in receiver loop
 inline void updateConnectionState(HealthMonitor& health, DeviceState& remote) {
   unsigned long now = millis();
   unsigned long timeSinceLastMsg = now - remote.lastMessageTime;
   ConnectionState oldState = health.state;
-  ConnectionState newState = health.state;
+  ConnectionState newState = nextConnectionState(health, remote, now);
 
-  // Determine new state based on time and RSSI
-  if (timeSinceLastMsg > watchdogCfg.lostTimeout) {
-    // No messages for > 8 seconds
-    newState = CONN_LOST;
-  }
-  else if (timeSinceLastMsg > watchdogCfg.weakTimeout ||
-           remote.rssi < watchdogCfg.weakRssiThreshold) {
-    // No messages for 3-8 seconds OR weak signal
-    newState = CONN_WEAK;
-  }
-  else if (timeSinceLastMsg < watchdogCfg.weakTimeout &&
-           remote.rssi >= watchdogCfg.weakRssiThreshold) {
-    // Messages recent and signal good
-    newState = CONN_CONNECTED;
-
-    // Track connected time
-    if (oldState != CONN_CONNECTED) {
-      health.connectedSince = now;
-    }
+  // Track connected time
+  if (newState == CONN_CONNECTED && oldState != CONN_CONNECTED) {
+    health.connectedSince = now;
   }
 
   // State changed?
@@ -195,13 +227,15 @@ inline void updateConnectionState(HealthMonitor& health, DeviceState& remote) {
 }
 
 // =============== ATTEMPT RECOVERY ================================
-// Try to recover lost connection by re-initializing LoRa
-inline bool attemptRecovery(HealthMonitor& health, uint8_t myAddress, uint8_t networkID) {
+// Start a tiered module check (link_recovery.h) when the link is LOST;
+// pollRecovery() follows it. Returns true if an attempt was started.
+inline bool attemptRecovery(HealthMonitor& health, LinkRecovery& recovery,
+                            uint8_t myAddress, uint8_t networkID) {
   unsigned long now = millis();
 
   // Check if we should attempt recovery
-  if (health.state != CONN_LOST) {
-    return false;  // Only recover from LOST state
+  if (health.state != CONN_LOST || linkRecoveryActive(recovery)) {
+    return false;  // Only recover from LOST state, one attempt at a time
   }
 
   // Check recovery cooldown
@@ -237,22 +271,34 @@ inline bool attemptRecovery(HealthMonitor& health, uint8_t myAddress, uint8_t ne
     Serial.println("\n╔════════════════════════════════════╗");
     Serial.print("║ LoRa RECOVERY ATTEMPT #");
     Serial.println(health.recoveryAttempts);
-    Serial.println("║ Re-initializing LoRa module...");
+    Serial.println("║ Checking LoRa module (AT probe)...");
     Serial.println("╚════════════════════════════════════╝");
   }
 
-  // Re-initialize LoRa (from lora_handler.h)
-  bool success = initLoRa(myAddress, networkID);
+  linkRecoveryStart(recovery, myAddress, networkID);
+  return true;
+}
 
-  if (success) {
-    Serial.println("✓ Recovery successful!");
+// Call every loop(): advances the running attempt and books its outcome
+inline void pollRecovery(HealthMonitor& health, LinkRecovery& recovery) {
+  RecoveryResult result = linkRecoveryPoll(recovery);
+  if (result == RECOVERY_RUNNING) return;
+
+  if (result == RECOVERY_DONE) {
+    Serial.print("✓ Recovery successful: ");
+    Serial.print(recovery.lastTier == RECOVERY_PROBE ? "module OK" :
+                 recovery.lastTier == RECOVERY_REAPPLY ? "settings re-applied" :
+                 "module reset");
+    Serial.print(" (");
+    Serial.print(recovery.lastMs);
+    Serial.println(" ms)");
     health.state = CONN_CONNECTING;
-    health.stateChangeTime = now;
+    health.stateChangeTime = millis();
     health.recoveryAttempts = 0;  // Reset counter on success
-    return true;
   } else {
-    Serial.println("❌ Recovery failed");
-    return false;
+    Serial.print("❌ Recovery failed after ");
+    Serial.print(recovery.lastMs);
+    Serial.println(" ms (module reset did not complete)");
   }
 }
 
@@ -0,0 +1,264 @@
+/*=====================================================================
+  bench_dispatch.cpp - Receive Dispatch: Predicate Chain vs frameKind()
+
+  Cost per received frame of the two ways the sketch has classified
+  payloads (frame_dispatch.h), same handler work in both:
+
+  - chain: what loop() did before - isFecParity() ... decodeTelemetry()
+           one after another; a command copied into a String and
+           scanned with indexOf() for the kill switch, then the verb
+           and argument cut out with substring() (processAdvancedCommand());
+           extended telemetry fields found with six indexOf() (parseTelemetry())
+  - table: frameKind() once, the handler from a FRAME_ROUTE_TABLE,
+           remoteCommand() + remoteCommandArg(), single-pass parseTelemetry()
+
+  Corpus: binary telemetry, legacy telemetry with the extended fields,
+  two commands, an alert. Both paths must agree on every result
+  (error exit otherwise). Built from a variant with
+  ENABLE_EXTENDED_TELEMETRY (host/CMakeLists.txt).
+
+  Usage: bench_dispatch [rounds]   (default 200000 per payload)
+=======================================================================*/
+
+#include <Arduino.h>
+#include <chrono>
+#include "telemetry_frame.h"
+#include "telemetry_batch.h"
+#include "reliable_link.h"
+#include "tx_queue.h"
+#include "fec.h"
+#include "frame_dispatch.h"
+#include "extended_telemetry.h"
+#include "host_test.h"
+
+#define BENCH_PAYLOAD_MAX 120  // Longest corpus payload
+
+extern "C" uint8_t temprature_sens_read() { return 128; }
+
+// What a dispatch found out about one frame
+struct Outcome {
+  FrameKind kind;
+  uint32_t seq;
+  uint32_t alertCount;
+  RemoteCommand command;
+  long arg;
+  ExtendedTelemetry telem;
+
+  bool operator==(const Outcome& o) const {
+    return kind == o.kind && seq == o.seq && alertCount == o.alertCount && command == o.command &&
+           arg == o.arg && telem.uptime == o.telem.uptime &&
+           telem.freeHeapKB == o.telem.freeHeapKB && telem.minFreeHeapKB == o.telem.minFreeHeapKB &&
+           (int)(telem.temperature * 10) == (int)(o.telem.temperature * 10) &&
+           telem.loopFrequency == o.telem.loopFrequency && telem.wifiRSSI == o.telem.wifiRSSI;
+  }
+};
+
+// =============== BEFORE (String scans) ================================
+// processRemoteKillSwitch(String) + the command parse of processAdvancedCommand(String)
+static void commandByIndexOf(const String& payload, Outcome& o) {
+  if (payload.indexOf("CMD:RESTART") >= 0) {
+    o.command = REMOTE_CMD_RESTART;
+    return;
+  }
+  if (payload.indexOf("CMD:STOP") >= 0) {
+    o.command = REMOTE_CMD_STOP;
+    return;
+  }
+  if (payload.indexOf("CMD:") < 0) return;
+  int cmdStart = payload.indexOf("CMD:");
+  String command = payload.substring(cmdStart + 4);
+  int commaPos = command.indexOf(',');
+  if (commaPos >= 0) command = command.substring(0, commaPos);
+  command.trim();
+
+  if (command == "STATUS") o.command = REMOTE_CMD_STATUS;
+  else if (command == "RESET_STATS") o.command = REMOTE_CMD_RESET_STATS;
+  else if (command == "PING") o.command = REMOTE_CMD_PING;
+  else if (command.startsWith("SET_POWER:")) {
+    o.command = REMOTE_CMD_SET_POWER;
+    o.arg = command.substring(10).toInt();
+  } else if (command.startsWith("SET_SF:")) {
+    o.command = REMOTE_CMD_SET_SF;
+    o.arg = command.substring(7).toInt();
+  } else if (command.startsWith("SET_INTERVAL:")) {
+    o.command = REMOTE_CMD_SET_INTERVAL;
+    o.arg = command.substring(13).toInt();
+  } else if (command == "LED_ON") o.command = REMOTE_CMD_LED_ON;
+  else if (command == "LED_OFF") o.command = REMOTE_CMD_LED_OFF;
+  else if (command.startsWith("LED_BLINK:")) {
+    o.command = REMOTE_CMD_LED_BLINK;
+    o.arg = command.substring(10).toInt();
+  } else if (command == "GET_RSSI") o.command = REMOTE_CMD_GET_RSSI;
+  else if (command == "GET_BATTERY") o.command = REMOTE_CMD_GET_BATTERY;
+}
+
+// parseTelemetry(String, ExtendedTelemetry*) as it was
+static void telemetryByIndexOf(String payload, ExtendedTelemetry* remoteTelem) {
+  const struct {
+    const char* key;
+    uint8_t keyLen;
+  } keys[] = {{"UP:", 3}, {"HEAP:", 5}, {"MHEAP:", 6}, {"TEMP:", 5}, {"LOOP:", 5}, {"WIFI:", 5}};
+  for (uint8_t k = 0; k < 6; k++) {
+    int idx = payload.indexOf(keys[k].key);
+    if (idx < 0) continue;
+    int comma = payload.indexOf(',', idx);
+    if (comma < 0) comma = payload.length();
+    String value = payload.substring(idx + keys[k].keyLen, comma);
+    switch (k) {
+      case 0: remoteTelem->uptime = value.toInt(); break;
+      case 1: remoteTelem->freeHeapKB = value.toInt(); break;
+      case 2: remoteTelem->minFreeHeapKB = value.toInt(); break;
+      case 3: remoteTelem->temperature = value.toFloat(); break;
+      case 4: remoteTelem->loopFrequency = value.toInt(); break;
+      case 5: remoteTelem->wifiRSSI = value.toInt(); break;
+    }
+  }
+}
+
+static Outcome dispatchChain(const char* data, uint8_t len) {
+  Outcome o = {};
+  TelemetryFrame frame = {};
+  if (isFecParity(data, len) || isFecData(data, len)) {
+    o.kind = FRAME_KIND_FEC_DATA;
+  } else if (isTelemetryBatch(data, len)) {
+    o.kind = FRAME_KIND_BATCH;
+  } else if (isReliableFrame(data, len)) {
+    o.kind = FRAME_KIND_RELIABLE;
+  } else if (isAlertFrame(data, len)) {
+    uint8_t method;
+    uint32_t ageMs;
+    o.kind = FRAME_KIND_ALERT;
+    txqDecodeAlert(data, len, method, o.alertCount, ageMs);
+  } else if (isCommandFrame(data, len)) {
+    char text[TXQ_FRAME_MAX];
+    memcpy(text, data + 1, len - 1);
+    text[len - 1] = '\0';
+    o.kind = FRAME_KIND_COMMAND;
+    commandByIndexOf(String(text), o);
+  } else if (len == 3 && (uint8_t)data[0] == 0x89) {
+    o.kind = FRAME_KIND_ADR_ACCEPT;
+  } else if (decodeTelemetry(data, len, frame)) {
+    o.kind = frame.type == FRAME_TYPE_ACK ? FRAME_KIND_ACK : FRAME_KIND_TELEMETRY;
+    o.seq = frame.seq;
+    if (frame.legacy) {
+      char text[BENCH_PAYLOAD_MAX + 1];
+      memcpy(text, data, len);
+      text[len] = '\0';
+      telemetryByIndexOf(String(text), &o.telem);
+    }
+  }
+  return o;
+}
+
+// =============== AFTER (frame_dispatch.h) ================================
+struct BenchRx {
+  const char* data;
+  uint8_t len;
+  Outcome* out;
+};
+
+static void onTelemetry(BenchRx& rx) {
+  TelemetryFrame frame = {};
+  if (!decodeTelemetry(rx.data, rx.len, frame)) return;
+  rx.out->seq = frame.seq;
+  if (frame.legacy) parseTelemetry(rx.data, rx.len, &rx.out->telem);
+}
+
+static void onAlert(BenchRx& rx) {
+  uint8_t method;
+  uint32_t ageMs;
+  txqDecodeAlert(rx.data, rx.len, method, rx.out->alertCount, ageMs);
+}
+
+static void onCommand(BenchRx& rx) {
+  rx.out->command = remoteCommand(rx.data + 1, rx.len - 1);
+  remoteCommandArg(rx.data + 1, rx.len - 1, rx.out->arg);
+}
+
+constexpr FrameRoute<BenchRx> benchRouteList[] = {
+  {FRAME_KIND_TELEMETRY, onTelemetry},
+  {FRAME_KIND_ACK, onTelemetry},
+  {FRAME_KIND_ALERT, onAlert},
+  {FRAME_KIND_COMMAND, onCommand},
+};
+constexpr FrameHandler<BenchRx> benchRoutes[FRAME_KIND_COUNT] = FRAME_ROUTE_TABLE(benchRouteList);
+
+static Outcome dispatchTable(const char* data, uint8_t len) {
+  Outcome o = {};
+  BenchRx rx = {data, len, &o};
+  o.kind = frameKind(data, len);
+  frameDispatch(benchRoutes, o.kind, rx);
+  return o;
+}
+
+// =============== CORPUS ================================
+struct Payload {
+  const char* name;
+  uint8_t data[BENCH_PAYLOAD_MAX];
+  uint8_t len;
+};
+
+static Payload corpus[5];
+
+static void setText(Payload& p, const char* name, uint8_t type, const char* text) {
+  p.name = name;
+  p.len = 0;
+  if (type) p.data[p.len++] = type;
+  memcpy(p.data + p.len, text, strlen(text));
+  p.len += strlen(text);
+}
+
+static void buildCorpus() {
+  corpus[0].name = "telemetry binary";
+  corpus[0].len = encodeTelemetryFrame(corpus[0].data, FRAME_TYPE_TELEMETRY, 1532, true, false, 2, 1533);
+  setText(corpus[1], "telemetry legacy+ext", 0,
+          "SEQ:1532,LED:1,TOUCH:0,SPIN:2,COUNT:1533,UP:3600,HEAP:245,MHEAP:231,TEMP:42.5,LOOP:450");
+  setText(corpus[2], "command SET_POWER", FRAME_TYPE_COMMAND, "CMD:SET_POWER:14");
+  setText(corpus[3], "command STOP", FRAME_TYPE_COMMAND, "CMD:STOP");
+  corpus[4].name = "alert";
+  uint8_t alertLength = txqEncodeAlert(corpus[4].data, REL_ALERT_AUDIO, 3);
+  corpus[4].len = txqStampAlert(corpus[4].data, alertLength, 420);
+}
+
+// =============== BENCH ================================
+static uint32_t rounds = 200000;
+static volatile uint32_t sink = 0;  // Keeps results alive
+
+template <typename F>
+static double nsPerOp(F dispatch, const Payload& p) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t r = 0; r < rounds; r++) {
+    Outcome o = dispatch((const char*)p.data, p.len);
+    sink += o.seq + o.command + o.alertCount;
+  }
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / rounds;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) rounds = strtoul(argv[1], nullptr, 10);
+  buildCorpus();
+
+  for (const Payload& p : corpus) {
+    Outcome chain = dispatchChain((const char*)p.data, p.len);
+    Outcome table = dispatchTable((const char*)p.data, p.len);
+    if (!(chain == table)) fprintf(stderr, "%s: chain and table disagree\n", p.name);
+    CHECK(chain == table);
+    CHECK(table.kind != FRAME_KIND_UNKNOWN);
+  }
+  CHECK_EQ(dispatchTable((const char*)corpus[1].data, corpus[1].len).telem.minFreeHeapKB, 231);
+  CHECK_EQ(dispatchTable((const char*)corpus[2].data, corpus[2].len).arg, 14);
+
+  printf("%u rounds per payload\n", rounds);
+  printf("  %-22s %12s %12s %8s\n", "payload", "chain ns/op", "table ns/op", "ratio");
+  double chainSum = 0, tableSum = 0;
+  for (const Payload& p : corpus) {
+    double chain = nsPerOp(dispatchChain, p);
+    double table = nsPerOp(dispatchTable, p);
+    chainSum += chain;
+    tableSum += table;
+    printf("  %-22s %12.1f %12.1f %7.1fx\n", p.name, chain, table, chain / table);
+  }
+  size_t n = sizeof(corpus) / sizeof(corpus[0]);
+  printf("  %-22s %12.1f %12.1f %7.1fx\n", "mean", chainSum / n, tableSum / n, chainSum / tableSum);
+  return hostTestExit();
+}
@@ -0,0 +1,168 @@
+/*=====================================================================
+  bench_fec.cpp - FEC Encode/Decode Cost per Byte
+
+  Cycles and ns per payload byte of fec.h for the frame sizes the
+  sketch sends (5 B telemetry, 21 B ACK-sized, 64 B, 200 B batch):
+
+  - encode:    fecWrapData() + fecAddData() for a group, then the P
+               and Q parity frames (fecAddData() always folds in Q)
+  - decode:    every data frame plus P arrives, nothing to rebuild
+  - recover 1: one frame lost, rebuilt from P (XOR)
+  - recover 2: two frames lost, rebuilt from P and Q (GF(2^8))
+
+  Every rebuilt frame is compared with the original; a mismatch is an
+  error exit. Cycles are the x86 TSC (host cycles, not Xtensa ones -
+  use them to compare the paths with each other).
+
+  Usage: bench_fec [groups]   (default 20000 per size and path)
+=======================================================================*/
+
+#include <Arduino.h>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "fec.h"
+#include "host_test.h"
+
+static inline uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static uint32_t rngState = 1;
+static uint8_t rnd() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return (uint8_t)rngState;
+}
+
+// =============== GROUP ================================
+struct Group {
+  uint8_t data[FEC_MAX_GROUP][FEC_DATA_MAX];
+  uint8_t len[FEC_MAX_GROUP];
+  uint8_t frames[FEC_MAX_GROUP][FEC_DATA_HEADER_LEN + FEC_DATA_MAX];
+  uint8_t frameLen[FEC_MAX_GROUP];
+  uint8_t parity[FEC_MAX_PARITY][FEC_PARITY_HEADER_LEN + FEC_BLOCK_MAX];
+  uint8_t parityLen[FEC_MAX_PARITY];
+};
+
+static void fill(Group& g, uint8_t payload) {
+  for (uint8_t i = 0; i < FEC_GROUP_SIZE; i++) {
+    g.len[i] = payload - (rnd() % 2);  // Lengths differ inside a group
+    for (uint8_t b = 0; b < g.len[i]; b++) g.data[i][b] = rnd();
+  }
+}
+
+static void encodeGroup(FecEncoder& e, Group& g) {
+  for (uint8_t i = 0; i < FEC_GROUP_SIZE; i++) {
+    g.frameLen[i] = fecWrapData(e, g.data[i], g.len[i], g.frames[i]);
+    fecAddData(e, g.data[i], g.len[i]);
+  }
+  for (uint8_t j = 0; j < FEC_MAX_PARITY; j++) {
+    e.parityNext = j;
+    g.parityLen[j] = fecBuildParity(e, g.parity[j]);
+  }
+  fecNewGroup(e);
+}
+
+// Feeds the group with `lost` frames missing; returns false if the
+// rebuilt frames differ from the originals
+static bool decodeGroup(FecDecoder& d, const Group& g, uint8_t lostMask, uint8_t parities) {
+  const uint8_t* payload;
+  uint8_t payloadLen;
+  for (uint8_t i = 0; i < FEC_GROUP_SIZE; i++) {
+    if (lostMask & (1 << i)) continue;
+    fecAcceptData(d, g.frames[i], g.frameLen[i], payload, payloadLen);
+  }
+  for (uint8_t j = 0; j < parities; j++) fecAcceptParity(d, g.parity[j], g.parityLen[j]);
+
+  bool ok = true;
+  for (uint8_t i = 0; i < FEC_GROUP_SIZE; i++) {
+    if (!(lostMask & (1 << i))) continue;
+    if (!fecTakeRecovered(d, payload, payloadLen) || payloadLen != g.len[i] ||
+        memcmp(payload, g.data[i], payloadLen) != 0) {
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+// =============== BENCH ================================
+static uint32_t groupCount = 20000;
+
+struct Timing {
+  uint64_t cycles;
+  double ns;
+};
+
+template <typename F>
+static Timing timed(F body) {
+  auto t0 = std::chrono::steady_clock::now();
+  uint64_t c0 = cycles();
+  body();
+  uint64_t c1 = cycles();
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+  return {c1 - c0, ns};
+}
+
+static void printRow(const char* path, uint8_t payload, uint64_t bytes, Timing t) {
+  printf("  %-10s %3u B  %7.1f cycles/B  %6.2f ns/B\n", path, payload,
+         (double)t.cycles / bytes, t.ns / bytes);
+}
+
+static void benchSize(uint8_t payload) {
+  static Group groups[256];
+  FecEncoder e;
+  fecEncoderInit(e);
+  uint64_t bytes = 0;
+  for (Group& g : groups) fill(g, payload);
+  for (Group& g : groups) {
+    for (uint8_t i = 0; i < FEC_GROUP_SIZE; i++) bytes += g.len[i];
+  }
+  uint32_t rounds = (groupCount + 255) / 256;
+  bytes *= rounds;
+
+  Timing t = timed([&] {
+    for (uint32_t r = 0; r < rounds; r++) {
+      for (Group& g : groups) encodeGroup(e, g);
+    }
+  });
+  printRow("encode", payload, bytes, t);
+
+  // Decoder sees the groups in order, as after encodeGroup()
+  const struct {
+    const char* name;
+    uint8_t lostMask;
+    uint8_t parities;
+  } paths[] = {
+    {"decode", 0x00, 1},
+    {"recover 1", 0x02, 1},
+    {"recover 2", 0x05, 2},
+  };
+  for (const auto& path : paths) {
+    FecDecoder d;
+    fecDecoderInit(d);
+    bool ok = true;
+    t = timed([&] {
+      for (uint32_t r = 0; r < rounds; r++) {
+        for (Group& g : groups) ok &= decodeGroup(d, g, path.lostMask, path.parities);
+      }
+    });
+    CHECK(ok);
+    CHECK_EQ(d.unrecoverable, 0);
+    printRow(path.name, payload, bytes, t);
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) groupCount = strtoul(argv[1], nullptr, 10);
+  printf("FEC_GROUP_SIZE %d, %u groups per row\n", FEC_GROUP_SIZE, groupCount);
+  const uint8_t sizes[] = {5, 21, 64, FEC_DATA_MAX};
+  for (uint8_t payload : sizes) benchSize(payload);
+  return hostTestExit();
+}
@@ -0,0 +1,308 @@
+/*=====================================================================
+  bench_hotpath.cpp - Encode/Parse Hot Paths with Regression Baselines
+
+  Runs every payload encode/parse path over a small corpus of realistic
+  payloads and prints one line per path:
+
+    decodeTelemetry bin          10.0 ns/op  0.0 alloc/op     0 B/op  ok
+
+  Paths:
+  - encodeTelemetryFrame / decodeTelemetry (binary + legacy ASCII),
+    the successors of parsePayload()
+  - parseRcvLine: the +RCV tokenizer receiveLoRaPacket() runs on every
+    line (receiveLoRaMessage() and its String copy are gone)
+  - decodeTelemetryBatch (batched uplink)
+  - DisplayClient set() + send(): the field set of sendDisplayUpdate()
+  - parseTelemetry() (extended_telemetry.h)
+  - parseMessage() of the display station (Roboter_Display_TFT/
+    message_parser.h) on what DisplayClient sent, an alert and a
+    short SEQ line
+
+  Allocations: operator new is counted while a path runs. The shim's
+  String is std::string, so every String growth counts - but strings
+  up to 15 characters stay inline (the ESP32 String allocates sooner).
+  Counts and bytes do not depend on the machine.
+
+  Regression check (--check): a path FAILS if it allocates more blocks
+  or bytes per op than hotPathBaseline[], or is more than --tolerance
+  percent (default 20) slower. ns baselines are from the machine that
+  recorded them - on another one pass a wider tolerance or record new
+  ones. After an intended change paste the printed "Baseline:" lines
+  into hotPathBaseline[]. --allocs-only compares allocations and prints
+  ns/op without judging them: wall clock depends on what else the
+  machine runs (ctest -j), allocation counts do not (ctest uses it).
+
+  Usage: bench_hotpath [--runs N] [--check] [--tolerance PCT] [--allocs-only]
+=======================================================================*/
+
+#include <Arduino.h>
+#include <chrono>
+#include <new>
+#include "lora_rx.h"
+#include "telemetry_frame.h"
+#include "telemetry_batch.h"
+#include "DisplayClient.h"
+#include "extended_telemetry.h"
+#include "message_parser.h"
+
+extern "C" uint8_t temprature_sens_read() { return 128; }
+
+// =============== ALLOCATION COUNTER ================================
+static bool allocCounting = false;
+static uint64_t allocCount = 0;
+static uint64_t allocBytes = 0;
+
+void* operator new(size_t size) {
+  if (allocCounting) {
+    allocCount++;
+    allocBytes += size;
+  }
+  void* p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+// =============== CORPUS ================================
+#define HOT_CORPUS_SIZE 3
+
+const char* const hotLegacyCorpus[HOT_CORPUS_SIZE] = {
+  "SEQ:1532,LED:1,TOUCH:0,SPIN:2,COUNT:1533",
+  "ACK,SEQ:77,LED:0,TOUCH:0,SPIN:0,COUNT:77,SLOT:100",
+  "SEQ:9,LED:0,TOUCH:1,SPIN:3,COUNT:9,REQ:1",
+};
+const char* const hotRcvCorpus[HOT_CORPUS_SIZE] = {
+  "+RCV=2,40,SEQ:1532,LED:1,TOUCH:0,SPIN:2,COUNT:1533,-87,9",
+  "+RCV=1,5,\x81\x05\xFC\x0B\x02,-112,-7",
+  "+RCV=2,12,\x83\x03\x07\x10\x20\x30\x40\x50\x60\x70\x11\x22,-64,12",
+};
+const char* const hotExtendedCorpus[HOT_CORPUS_SIZE] = {
+  "SEQ:1532,LED:1,TOUCH:0,SPIN:2,COUNT:1533,UP:3600,HEAP:245,MHEAP:231,TEMP:42.5,LOOP:450",
+  "UP:59,HEAP:251,MHEAP:250,TEMP:38.0",
+  "SEQ:9,UP:86400,HEAP:198,MHEAP:120,TEMP:-3.5,LOOP:12,WIFI:-71",
+};
+
+uint8_t hotBinaryCorpus[HOT_CORPUS_SIZE][TELEMETRY_FRAME_MAX];
+uint8_t hotBinaryLength[HOT_CORPUS_SIZE];
+uint8_t hotBatchCorpus[BATCH_FRAME_MAX];
+uint8_t hotBatchLength = 0;
+String hotDisplayCorpus[HOT_CORPUS_SIZE];  // Lines the display station reads
+
+volatile uint32_t hotSink = 0;  // Keeps results alive (no dead-code elimination)
+
+// =============== BENCHMARKED PATHS ================================
+void hotEncodeFrame(uint8_t i) {
+  uint8_t out[TELEMETRY_FRAME_MAX];
+  hotSink += encodeTelemetryFrame(out, FRAME_TYPE_TELEMETRY, 1532 + i, i & 1, 0, i & 3, 1533 + i);
+}
+
+void hotDecodeBinary(uint8_t i) {
+  TelemetryFrame frame;
+  hotSink += decodeTelemetry((const char*)hotBinaryCorpus[i], hotBinaryLength[i], frame) ? frame.seq : 0;
+}
+
+void hotDecodeLegacy(uint8_t i) {
+  TelemetryFrame frame;
+  const char* p = hotLegacyCorpus[i];
+  hotSink += decodeTelemetry(p, strlen(p), frame) ? frame.seq : 0;
+}
+
+void hotParseRcv(uint8_t i) {
+  RcvView packet;
+  const char* line = hotRcvCorpus[i];
+  hotSink += parseRcvLine(line, strlen(line), packet) ? packet.len : 0;
+}
+
+void hotDecodeBatch(uint8_t i) {
+  BatchSample samples[BATCH_MAX_SAMPLES];
+  hotSink += decodeTelemetryBatch(hotBatchCorpus, hotBatchLength, samples,
+                                  BATCH_MAX_SAMPLES, millis()) + i;
+}
+
+// Field set of sendDisplayUpdate() (receiver), UART write included
+DisplayClient hotDisplay(DISPLAY_TX_PIN);
+void hotDisplaySend(uint8_t i) {
+  hotDisplay.clear();
+  hotDisplay.set("Mode", "RECEIVER");
+  hotDisplay.set("SEQ", 1532 + i);
+  hotDisplay.set("LED", "ON");
+  hotDisplay.set("TOUCH", "NO");
+  hotDisplay.set("Count", 1533 + i);
+  hotDisplay.set("ConnState", "OK");
+  hotDisplay.set("RSSI", String(-87) + "dBm");
+  hotDisplay.set("SNR", String(9) + "dB");
+  hotDisplay.set("Uptime", String(millis() / 1000) + "s");
+  hotDisplay.send();
+  hotSink += i;
+}
+
+void hotParseTelemetry(uint8_t i) {
+  ExtendedTelemetry remoteTelem = {};
+  const char* p = hotExtendedCorpus[i];
+  parseTelemetry(p, strlen(p), &remoteTelem);
+  hotSink += remoteTelem.freeHeapKB;
+}
+
+void hotParseMessage(uint8_t i) {
+  parseMessage(hotDisplayCorpus[i]);
+  hotSink += fieldCount;
+}
+
+// =============== BASELINE ================================
+struct HotPathCase {
+  const char* name;
+  void (*run)(uint8_t);
+  float baselineNs;        // 0 = not recorded
+  int16_t baselineAllocs;  // Blocks per op, -1 = not recorded
+  int32_t baselineBytes;   // Bytes per op, -1 = not recorded
+};
+
+// x86-64, GCC -O2 (Release). Allocations are machine independent.
+HotPathCase hotPathBaseline[] = {
+  {"encodeTelemetryFrame",   hotEncodeFrame,     3.2, 0, 0},
+  {"decodeTelemetry bin",    hotDecodeBinary,   10.0, 0, 0},
+  {"decodeTelemetry legacy", hotDecodeLegacy,   78.9, 0, 0},
+  {"parseRcvLine",           hotParseRcv,       20.8, 0, 0},
+  {"decodeTelemetryBatch",   hotDecodeBatch,    68.8, 0, 0},
+  {"DisplayClient send",     hotDisplaySend,  1214.9, 0, 0},
+  {"parseTelemetry",         hotParseTelemetry, 154.5, 0, 0},
+  {"TFT parseMessage",       hotParseMessage,  953.8, 2, 60},
+};
+#define HOT_PATH_COUNT (sizeof(hotPathBaseline) / sizeof(hotPathBaseline[0]))
+
+// =============== RUN ================================
+struct HotDisplayTap : HostUartPeer {
+  String line;
+  void uartReceive(HardwareSerial& from, const uint8_t* data, size_t n) override {
+    line.concat((const char*)data, n);
+  }
+};
+
+void buildHotCorpus() {
+  for (uint8_t i = 0; i < HOT_CORPUS_SIZE; i++) {
+    hotBinaryLength[i] = encodeTelemetryFrame(hotBinaryCorpus[i],
+                                              i == 1 ? FRAME_TYPE_ACK : FRAME_TYPE_TELEMETRY,
+                                              1532 + 1000 * i, i & 1, i == 2, i, 1533 + 1000 * i,
+                                              i == 2, i == 1 ? 100 : 0);
+  }
+
+  // 8 samples with battery + current, 2 s apart
+  static TelemetryBatch batch;
+  batchInit(batch, BATCH_FIELD_BATTERY | BATCH_FIELD_CURRENT);
+  for (uint8_t i = 0; i < 8; i++) {
+    BatchSample sample = {millis() + i * 2000UL, 1000U + i, (bool)(i & 1), false,
+                          (uint8_t)(i & 3), (uint16_t)(3900 - i), 1250 + 3 * i, 0, 0};
+    batchAdd(batch, sample);
+  }
+  hotBatchLength = encodeTelemetryBatch(batch, hotBatchCorpus, sizeof(hotBatchCorpus));
+  batchAbort(batch);
+
+  // The station reads what hotDisplaySend() writes to Serial2
+  HotDisplayTap tap;
+  Serial2.peer = &tap;
+  hotDisplaySend(0);
+  Serial2.peer = nullptr;
+  tap.line.trim();
+  hotDisplayCorpus[0] = tap.line;
+  hotDisplayCorpus[1] = "ALERT:FIRE audio+light";
+  hotDisplayCorpus[2] = "SEQ:1533,LED:OFF,RSSI:-91dBm";
+}
+
+struct HotResult {
+  double ns;
+  double allocs;
+  double bytes;
+};
+
+// Best of 5 repetitions (least disturbed by the rest of the machine)
+HotResult measure(const HotPathCase& path, uint32_t runs) {
+  uint32_t ops = runs * HOT_CORPUS_SIZE;
+  for (uint8_t i = 0; i < HOT_CORPUS_SIZE; i++) path.run(i);  // Warm-up (String growth)
+
+  HotResult best = {1e30, 0, 0};
+  for (int rep = 0; rep < 5; rep++) {
+    allocCount = 0;
+    allocBytes = 0;
+    allocCounting = true;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < runs; r++) {
+      for (uint8_t i = 0; i < HOT_CORPUS_SIZE; i++) path.run(i);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    allocCounting = false;
+    if (ns / ops < best.ns) best.ns = ns / ops;
+    best.allocs = (double)allocCount / ops;
+    best.bytes = (double)allocBytes / ops;
+  }
+  return best;
+}
+
+int main(int argc, char** argv) {
+  uint32_t runs = 20000;
+  bool check = false;
+  int tolerancePct = 20;
+  bool allocsOnly = false;
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    const char* v = i + 1 < argc ? argv[i + 1] : "";
+    if (!strcmp(a, "--runs")) { runs = strtoul(v, nullptr, 10); i++; }
+    else if (!strcmp(a, "--check")) { check = true; }
+    else if (!strcmp(a, "--tolerance")) { tolerancePct = atoi(v); i++; }
+    else if (!strcmp(a, "--allocs-only")) { allocsOnly = true; }
+    else {
+      fprintf(stderr, "usage: %s [--runs N] [--check] [--tolerance PCT] [--allocs-only]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  buildHotCorpus();
+
+  if (allocsOnly) {
+    printf("%u runs x %d payloads, allocations only (ns/op not compared)\n", runs, HOT_CORPUS_SIZE);
+  } else {
+    printf("%u runs x %d payloads, tolerance %d%%\n", runs, HOT_CORPUS_SIZE, tolerancePct);
+  }
+  int regressions = 0;
+  HotResult results[HOT_PATH_COUNT];
+  for (size_t c = 0; c < HOT_PATH_COUNT; c++) {
+    const HotPathCase& path = hotPathBaseline[c];
+    HotResult r = measure(path, runs);
+    results[c] = r;
+
+    bool slower = !allocsOnly && path.baselineNs > 0 &&
+                  r.ns > path.baselineNs * (100 + tolerancePct) / 100;
+    int allocs = (int)(r.allocs + 0.5);
+    int bytes = (int)(r.bytes + 0.5);
+    bool moreAllocs = (path.baselineAllocs >= 0 && allocs > path.baselineAllocs) ||
+                      (path.baselineBytes >= 0 && bytes > path.baselineBytes);
+    printf("  %-24s %8.1f ns/op %4.1f alloc/op %5.0f B/op", path.name, r.ns, r.allocs, r.bytes);
+    if (slower || moreAllocs) {
+      regressions++;
+      printf("  FAIL");
+      if (slower) printf(" +%.0f%%", (r.ns - path.baselineNs) * 100 / path.baselineNs);
+      if (moreAllocs) printf(" allocs");
+      printf("\n");
+    } else {
+      printf("  %s\n", path.baselineNs > 0 ? "ok" : "(no baseline)");
+    }
+  }
+
+  printf("Baseline:\n");
+  for (size_t c = 0; c < HOT_PATH_COUNT; c++) {
+    char name[32];
+    snprintf(name, sizeof(name), "\"%s\",", hotPathBaseline[c].name);
+    printf("  {%-25s ..., %.1f, %d, %d},\n", name, results[c].ns,
+           (int)(results[c].allocs + 0.5), (int)(results[c].bytes + 0.5));
+  }
+
+  if (regressions == 0) {
+    printf("HOTPATH_BENCH: PASS\n");
+  } else {
+    printf("HOTPATH_BENCH: FAIL (%d regressions)\n", regressions);
+  }
+  return check && regressions ? 1 : 0;
+}
@@ -0,0 +1,109 @@
+/*=====================================================================
+  fake_uart.h - Scripted Fake UART for the AT Engine Tests
+
+  A Stream that plays the RYLR896 from a script: every command the
+  engine writes must match the next expected one, the scripted reply
+  lines come back after their delay on the virtual clock. Lines can
+  also be injected at any time (late answers, +RCV, +READY).
+
+    ScriptedUart uart;
+    uart.expect("AT+ADDRESS?", "+ADDRESS=2", 20);  // answer after 20 ms
+    uart.inject(150, "+RCV=2,5,HELLO,-40,9");       // at t = 150 ms
+=======================================================================*/
+
+#ifndef FAKE_UART_H
+#define FAKE_UART_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+class ScriptedUart : public Stream {
+public:
+  struct Step {
+    std::string command;        // Expected line from the engine
+    std::string reply;          // "" = stay silent
+    unsigned long delayMs;
+  };
+
+  void expect(const char* command, const char* reply, unsigned long delayMs = 5) {
+    script.push_back({command, reply, delayMs});
+  }
+
+  // Bytes (CR/LF added) readable from t = atMs on
+  void inject(unsigned long atMs, const std::string& line) {
+    pending.push_back({atMs, line + "\r\n"});
+  }
+
+  int available() override {
+    release();
+    return (int)rx.size();
+  }
+  int read() override {
+    release();
+    if (rx.empty()) return -1;
+    int c = (uint8_t)rx.front();
+    rx.erase(rx.begin());
+    return c;
+  }
+  int peek() override {
+    release();
+    return rx.empty() ? -1 : (uint8_t)rx.front();
+  }
+
+  size_t write(uint8_t c) override {
+    if (c == '\n') {
+      onCommand();
+    } else if (c != '\r') {
+      partial += (char)c;
+    }
+    return 1;
+  }
+  using Print::write;
+
+  bool scriptDone() const { return next == script.size(); }
+
+  std::vector<std::string> written;    // Every command line, in order
+  unsigned long unexpected = 0;        // Commands that did not match the script
+
+private:
+  struct Pending {
+    unsigned long atMs;
+    std::string bytes;
+  };
+
+  std::vector<Step> script;
+  size_t next = 0;
+  std::vector<Pending> pending;
+  std::string rx;
+  std::string partial;
+
+  void onCommand() {
+    written.push_back(partial);
+    if (next < script.size() && script[next].command == partial) {
+      const Step& step = script[next++];
+      if (!step.reply.empty()) inject(millis() + step.delayMs, step.reply);
+    } else {
+      fprintf(stderr, "ScriptedUart: unexpected command \"%s\"\n", partial.c_str());
+      unexpected++;
+    }
+    partial.clear();
+  }
+
+  // Move due lines into the readable bytes, in time order
+  void release() {
+    for (;;) {
+      size_t best = pending.size();
+      for (size_t i = 0; i < pending.size(); i++) {
+        if (pending[i].atMs <= millis() && (best == pending.size() || pending[i].atMs < pending[best].atMs)) {
+          best = i;
+        }
+      }
+      if (best == pending.size()) return;
+      rx += pending[best].bytes;
+      pending.erase(pending.begin() + best);
+    }
+  }
+};
+
+#endif // FAKE_UART_H
@@ -0,0 +1,319 @@
+/*=====================================================================
+  fuzz_rcv.cpp - +RCV Receive Path Fuzz and Benchmark
+
+  Feeds synthetic "+RCV=" lines through the same path as the firmware:
+  UART chunks → LoRaRxRing → LoRaRxStream → atPoll() (length-prefixed
+  data) → onLine → parseRcvLine().
+
+  - Valid lines carry binary data with commas, CR, LF and NUL bytes;
+    every one must come out of parseRcvLine() byte-exact, in order
+  - A share of the lines is mutated (bit flips, truncation, wrong
+    length, dropped fields). They may be lost or misread, but must not
+    crash the parser, and every valid line that starts more than one
+    maximum line after a mutated one must still be delivered (the
+    stream resynchronises)
+  - Random garbage goes straight into parseRcvLine() and
+    rcvHeaderDataLength(): a view it accepts must point inside the line
+
+  Usage: fuzz_rcv [lines] [seed]   (default 1000000 lines, seed 1)
+  Prints ns per line and MB/s of the receive path (generation of the
+  lines is not timed).
+=======================================================================*/
+
+#include <Arduino.h>
+#include <chrono>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include "at_engine.h"
+#include "lora_rx.h"
+#include "host_test.h"
+
+// =============== GENERATOR ================================
+static uint64_t rngState;
+
+static uint32_t rnd() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 7;
+  rngState ^= rngState << 17;
+  return (uint32_t)rngState;
+}
+
+static uint32_t rnd(uint32_t n) { return rnd() % n; }
+
+struct Expected {
+  uint64_t id;
+  uint64_t startByte;         // Offset in the byte stream
+  uint64_t prevMutatedEnd;    // End of the last mutated line before it
+  bool mutated;
+  uint16_t sender;
+  std::string data;
+  int rssi;
+  int snr;
+};
+
+// Data field: the id first (so a line can be recognised), then binary
+static std::string makeData(uint64_t id) {
+  char head[24];
+  int n = snprintf(head, sizeof(head), "#%llu;", (unsigned long long)id);
+  std::string data(head, n);
+  uint32_t len = data.size() + rnd(240 - data.size() + 1);
+  static const char special[] = {',', '\r', '\n', '\0', '+', '='};
+  while (data.size() < len) {
+    data += (rnd(4) == 0) ? special[rnd(sizeof(special))] : (char)rnd(256);
+  }
+  return data;
+}
+
+static std::string formatLine(const Expected& e) {
+  char head[32];
+  snprintf(head, sizeof(head), "+RCV=%u,%u,", e.sender, (unsigned)e.data.size());
+  char tail[24];
+  snprintf(tail, sizeof(tail), ",%d,%d\r\n", e.rssi, e.snr);
+  return std::string(head) + e.data + tail;
+}
+
+static std::string mutate(std::string line) {
+  switch (rnd(6)) {
+    case 0:  // Bit flips anywhere
+      for (int i = 0, n = 1 + rnd(4); i < n; i++) line[rnd(line.size())] ^= (char)(1 << rnd(8));
+      break;
+    case 1:  // Truncated (the CR/LF stays)
+      line = line.substr(0, rnd(line.size() - 2)) + "\r\n";
+      break;
+    case 2: {  // Length field too large
+      size_t comma = line.find(',', 5);
+      size_t end = line.find(',', comma + 1);
+      line.replace(comma + 1, end - comma - 1, std::to_string(rnd(300)));
+      break;
+    }
+    case 3:  // SNR missing
+      line = line.substr(0, line.rfind(',')) + "\r\n";
+      break;
+    case 4:  // Address out of range
+      line.replace(5, line.find(',') - 5, std::to_string(65536 + rnd(100000)));
+      break;
+    default:  // Random bytes inserted
+      for (int i = 0, n = 1 + rnd(8); i < n; i++) line.insert(rnd(line.size()), 1, (char)rnd(256));
+      break;
+  }
+  return line;
+}
+
+// =============== RECEIVER ================================
+static std::unordered_map<uint64_t, Expected> inFlight;  // Valid lines not yet seen
+static uint64_t delivered;
+static uint64_t outOfOrder;
+static uint64_t outsideLine;
+static uint64_t lastDeliveredId;
+
+static void onLine(const char* line, uint16_t len) {
+  RcvView view;
+  if (!parseRcvLine(line, len, view)) return;
+
+  // The view must stay inside the line
+  if (view.data < line || view.data + view.len > line + len) {
+    fprintf(stderr, "parseRcvLine: data outside the line\n");
+    outsideLine++;
+    return;
+  }
+  if (view.len < 2 || view.data[0] != '#') return;
+  uint64_t id = strtoull(std::string(view.data + 1, std::min<int>(view.len - 1, 20)).c_str(), nullptr, 10);
+
+  // Only the exact line counts (a mutated one may carry any id)
+  auto it = inFlight.find(id);
+  if (it == inFlight.end()) return;
+  const Expected& e = it->second;
+  bool same = view.sender == e.sender && view.len == e.data.size() &&
+              memcmp(view.data, e.data.data(), view.len) == 0 &&
+              view.rssi == e.rssi && view.snr == e.snr;
+  if (!same) return;
+
+  if (delivered && id <= lastDeliveredId) outOfOrder++;
+  lastDeliveredId = id;
+  delivered++;
+  inFlight.erase(it);
+}
+
+// Valid lines never delivered that no mutated line could have hit
+static uint64_t protectedLost() {
+  uint64_t lost = 0;
+  for (const auto& entry : inFlight) {
+    const Expected& e = entry.second;
+    if (e.startByte > e.prevMutatedEnd + AT_LINE_MAX) {
+      fprintf(stderr, "line %llu lost\n", (unsigned long long)e.id);
+      lost++;
+    }
+  }
+  return lost;
+}
+
+// =============== RUN ================================
+struct RunResult {
+  uint64_t lines;
+  uint64_t bytes;
+  uint64_t valid;
+  double seconds;
+};
+
+static RunResult runStream(uint64_t lines, uint32_t mutatePermille) {
+  static LoRaRxRing ring;
+  static LoRaRxStream stream(ring, Serial2);
+  static ATEngine at;
+  ring.head = ring.tail = 0;
+  ring.overflows = 0;
+  atBegin(at, stream, onLine);
+  inFlight.clear();
+  delivered = outOfOrder = outsideLine = 0;
+  uint64_t lastMutatedEnd = 0;
+
+  RunResult r = {lines, 0, 0, 0};
+  const uint64_t batchLines = 10000;
+  std::string batch;
+  std::vector<uint16_t> chunks;
+
+  for (uint64_t id = 0; id < lines;) {
+    // Generate a batch and its UART chunking (not timed)
+    batch.clear();
+    chunks.clear();
+    for (uint64_t end = std::min(lines, id + batchLines); id < end; id++) {
+      Expected e;
+      e.id = id;
+      e.startByte = r.bytes + batch.size();
+      e.prevMutatedEnd = lastMutatedEnd;
+      e.sender = (uint16_t)rnd(65536);
+      e.data = makeData(e.id);
+      e.rssi = -(int)rnd(200);
+      e.snr = (int)rnd(60) - 30;
+      e.mutated = rnd(1000) < mutatePermille;
+      std::string line = formatLine(e);
+      if (e.mutated) {
+        line = mutate(line);
+        lastMutatedEnd = e.startByte + line.size();
+      } else {
+        r.valid++;
+        inFlight.emplace(e.id, e);
+      }
+      batch += line;
+    }
+    for (size_t left = batch.size(); left > 0;) {
+      uint16_t chunk = (uint16_t)std::min<size_t>(left, 1 + rnd(120));
+      chunks.push_back(chunk);
+      left -= chunk;
+    }
+
+    // One UART event per chunk, then one poll - as on the ESP32
+    auto t0 = std::chrono::steady_clock::now();
+    const uint8_t* p = (const uint8_t*)batch.data();
+    for (uint16_t chunk : chunks) {
+      while (LORA_RX_RING_SIZE - 1 - rxRingAvailable(ring) < chunk) atPoll(at);
+      for (uint16_t i = 0; i < chunk; i++) rxRingPush(ring, *p++);
+      atPoll(at);
+    }
+    while (rxRingAvailable(ring) > 0) atPoll(at);
+    r.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    r.bytes += batch.size();
+  }
+
+  CHECK_EQ(ring.overflows, 0);
+  return r;
+}
+
+// =============== TESTS ================================
+static uint64_t lineCount = 1000000;
+
+static void testValidLines() {
+  RunResult r = runStream(lineCount / 4, 0);
+  CHECK_EQ(delivered, r.valid);
+  CHECK_EQ(outOfOrder, 0);
+  printf("  valid:   %llu lines, %.1f MB, %.0f ns/line, %.1f MB/s\n",
+         (unsigned long long)r.lines, r.bytes / 1e6, r.seconds * 1e9 / r.lines,
+         r.bytes / 1e6 / r.seconds);
+}
+
+static void testMutatedLines() {
+  RunResult r = runStream(lineCount, 20);  // 2% mutated
+  CHECK_EQ(protectedLost(), 0);
+  CHECK_EQ(outOfOrder, 0);
+  CHECK_EQ(outsideLine, 0);
+  CHECK(delivered > r.valid * 9 / 10);
+  printf("  mutated: %llu lines (%llu valid, %llu delivered), %.0f ns/line\n",
+         (unsigned long long)r.lines, (unsigned long long)r.valid,
+         (unsigned long long)delivered, r.seconds * 1e9 / r.lines);
+}
+
+// Bytes lost in a full ring: lines after it still come through
+static void testRingOverflow() {
+  static LoRaRxRing ring;
+  static LoRaRxStream stream(ring, Serial2);
+  static ATEngine at;
+  ring.head = ring.tail = 0;
+  ring.overflows = 0;
+  atBegin(at, stream, onLine);
+  inFlight.clear();
+  delivered = 0;
+
+  Expected e = {0, 0, 0, false, 7, "#0;hello", -50, 5};
+  std::string burst;
+  while (burst.size() < 3 * LORA_RX_RING_SIZE) burst += formatLine(e);
+  for (char c : burst) rxRingPush(ring, (uint8_t)c);  // Nobody polls
+  CHECK(ring.overflows > 0);
+  while (rxRingAvailable(ring) > 0) atPoll(at);
+
+  inFlight.clear();
+  for (uint64_t i = 1; i <= 20; i++) {
+    Expected next = {i, 0, 0, false, 7, makeData(i), -60, 3};
+    inFlight.emplace(i, next);
+    for (char c : formatLine(next)) rxRingPush(ring, (uint8_t)c);
+    while (rxRingAvailable(ring) > 0) atPoll(at);
+  }
+  CHECK(delivered >= 19);  // At most the first one is eaten by the resync
+}
+
+// Garbage straight into the tokenizer
+static void testParserGarbage() {
+  char buf[AT_LINE_MAX];
+  uint64_t accepted = 0;
+  for (uint64_t i = 0; i < lineCount; i++) {
+    // Near-valid lines with a few wrong bytes, or tokenizer characters
+    uint16_t n;
+    if (rnd(2)) {
+      Expected e = {0, 0, 0, false, (uint16_t)rnd(65536), std::string(rnd(241), 'x'),
+                    -(int)rnd(200), (int)rnd(60) - 30};
+      std::string line = formatLine(e);
+      n = (uint16_t)std::min<size_t>(line.size() - 2, sizeof(buf));
+      memcpy(buf, line.data(), n);
+      for (uint32_t k = 0, flips = rnd(3); k < flips; k++) buf[rnd(n)] = (char)rnd(256);
+    } else {
+      static const char alphabet[] = "0123456789,,,--+RCV=";
+      n = rnd(AT_LINE_MAX);
+      for (uint16_t k = 0; k < n; k++) {
+        buf[k] = rnd(5) ? alphabet[rnd(sizeof(alphabet) - 1)] : (char)rnd(256);
+      }
+      if (n >= 5 && rnd(2)) memcpy(buf, "+RCV=", 5);
+    }
+
+    RcvView view;
+    if (parseRcvLine(buf, n, view)) {
+      accepted++;
+      CHECK(view.data >= buf && view.data + view.len <= buf + n);
+    }
+    int dataLength = rcvHeaderDataLength(buf, n);
+    CHECK(dataLength >= -1 && dataLength <= 240);
+  }
+  CHECK(accepted > 0);
+  printf("  garbage: %llu lines, %llu accepted\n", (unsigned long long)lineCount,
+         (unsigned long long)accepted);
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) lineCount = strtoull(argv[1], nullptr, 10);
+  rngState = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1;
+  if (rngState == 0) rngState = 1;
+
+  RUN(testValidLines);
+  RUN(testMutatedLines);
+  RUN(testRingOverflow);
+  RUN(testParserGarbage);
+  return hostTestExit();
+}
@@ -0,0 +1,47 @@
+/*=====================================================================
+  host_test.h - Minimal Test Macros for the Host Targets
+
+  No framework: CHECK() counts failures, RUN() prints one line per
+  test, hostTestExit() is the exit code ctest looks at.
+=======================================================================*/
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int hostTestFailures = 0;
+
+#define CHECK(cond)                                                        \
+  do {                                                                     \
+    if (!(cond)) {                                                         \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,     \
+              #cond);                                                      \
+      hostTestFailures++;                                                  \
+    }                                                                      \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                     \
+  do {                                                                     \
+    long long va_ = (long long)(a), vb_ = (long long)(b);                  \
+    if (va_ != vb_) {                                                      \
+      fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n",    \
+              __FILE__, __LINE__, #a, #b, va_, vb_);                       \
+      hostTestFailures++;                                                  \
+    }                                                                      \
+  } while (0)
+
+#define RUN(test)                                                          \
+  do {                                                                     \
+    int before_ = hostTestFailures;                                        \
+    test();                                                                \
+    printf("%s %s\n", hostTestFailures == before_ ? "PASS" : "FAIL", #test); \
+  } while (0)
+
+inline int hostTestExit() {
+  if (hostTestFailures) printf("%d check(s) failed\n", hostTestFailures);
+  return hostTestFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif // HOST_TEST_H
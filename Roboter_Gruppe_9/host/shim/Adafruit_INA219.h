@@ -0,0 +1,21 @@
+// Host shim: INA219 that reads the current of the HostBoard
+#ifndef HOST_ADAFRUIT_INA219_H
+#define HOST_ADAFRUIT_INA219_H
+
+#include "Arduino.h"
+
+class Adafruit_INA219 {
+public:
+  explicit Adafruit_INA219(uint8_t address = 0x40) { (void)address; }
+  bool begin() { return true; }
+  void setCalibration_32V_2A() {}
+  void setCalibration_32V_1A() {}
+  void setCalibration_16V_400mA() {}
+  void powerSave(bool on) { (void)on; }
+  float getBusVoltage_V() { return hostBoard->busVoltage_V; }
+  float getShuntVoltage_mV() { return hostBoard->current_mA * 0.1f; }
+  float getCurrent_mA() { return hostBoard->current_mA; }
+  float getPower_mW() { return hostBoard->current_mA * hostBoard->busVoltage_V; }
+};
+
+#endif // HOST_ADAFRUIT_INA219_H
@@ -0,0 +1,428 @@
+/*=====================================================================
+  Arduino.h - Host Shim of the ESP32 Arduino API
+
+  Just enough of the Arduino core for the sketch and its headers to
+  compile and run on a Linux host (host/CMakeLists.txt):
+
+  - String, Print, Stream, HardwareSerial (Serial = stdout)
+  - Virtual clock: millis()/micros() only move when the code waits
+    (delay(), yield(), vTaskDelayUntil(), ...) - a test decides what
+    time it is, runs are repeatable
+  - HostBoard: the pins, efuse MAC, NVS, random state and clock (boot
+    time, crystal ppm) of one ESP32. The multi-node simulator
+    (host/sim/) gives every node its own board and switches hostBoard
+    when it switches nodes
+  - HostScheduler: where the waiting goes. The default one just
+    advances the clock; the simulator replaces it with its own
+
+  Not the real core: no interrupts, no WiFi, no I2C devices (Wire
+  answers NACK), INA219 readings come from the board.
+=======================================================================*/
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+#define T0 4
+#define SERIAL_8N1 0x800001c
+
+#define F(x) (x)
+#define PROGMEM
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define ARDUINO_RUNNING_CORE 1
+
+#define HOST_PIN_COUNT 40
+#define HOST_BUILD 1
+
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+using std::min;
+using std::max;
+
+// =============== VIRTUAL CLOCK ================================
+extern uint64_t hostClockUs;
+inline uint64_t hostLocalUs();  // Board clock, see HostBoard
+
+inline unsigned long millis() { return (unsigned long)(uint32_t)(hostLocalUs() / 1000); }
+inline unsigned long micros() { return (unsigned long)(uint32_t)hostLocalUs(); }
+
+// =============== SCHEDULER ================================
+// Everything that waits ends up here
+struct HostScheduler {
+  virtual ~HostScheduler() {}
+  virtual void sleepUs(uint64_t us) { hostClockUs += us; }
+  // FreeRTOS task notification (idleWait(), task_split.h)
+  virtual uint32_t notifyTake(bool clear, uint32_t ms) { sleepUs((uint64_t)ms * 1000); return 0; }
+  virtual void notifyGive(void* task) { (void)task; }
+  virtual void* currentTask() { return (void*)1; }
+  virtual bool createTask(void (*body)(void*), void* arg, const char* name) {
+    (void)body; (void)arg; (void)name;
+    return false;
+  }
+  virtual void deepSleep(uint64_t us);
+  virtual void restart();
+};
+
+extern HostScheduler* hostScheduler;
+
+inline void delay(unsigned long ms) { hostScheduler->sleepUs((uint64_t)ms * 1000); }
+inline void delayMicroseconds(unsigned int us) { hostScheduler->sleepUs(us); }
+inline void yield() { hostScheduler->sleepUs(100); }  // Busy-wait loops must see time pass
+
+// =============== BOARD ================================
+// One ESP32: pins, identity, NVS, random state, console
+struct HostBoard {
+  const char* name;
+  uint64_t efuseMac;
+  int8_t pinDrive[HOST_PIN_COUNT];   // -1 floating, else tied LOW/HIGH
+  uint8_t pinModes[HOST_PIN_COUNT];
+  uint8_t pinOut[HOST_PIN_COUNT];    // digitalWrite() level
+  uint16_t touchValue;               // touchRead() (<= 500: touched)
+  float current_mA;                  // INA219 reading
+  float busVoltage_V;
+  uint32_t randomState;
+  int wakeCause;                     // esp_sleep_get_wakeup_cause()
+  std::map<std::string, uint32_t> nvs;
+  bool echo;                         // Console to stdout
+  std::string consoleLine;
+  void (*onConsoleLine)(HostBoard& board, const std::string& line);
+  uint64_t bootUs;                   // hostClockUs at power-on (millis() 0)
+  int32_t clockPpm;                  // Crystal error: + runs fast
+};
+
+extern HostBoard* hostBoard;
+
+// Time since boot on this board's crystal
+inline uint64_t hostLocalUs() {
+  const HostBoard& b = *hostBoard;
+  uint64_t us = hostClockUs - b.bootUs;
+  if (b.clockPpm) us += (int64_t)us * b.clockPpm / 1000000;
+  return us;
+}
+void hostBoardInit(HostBoard& board, const char* name, uint64_t efuseMac);
+void hostConsoleWrite(const uint8_t* data, size_t n);
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < HOST_PIN_COUNT) hostBoard->pinModes[pin] = mode;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin < HOST_PIN_COUNT) hostBoard->pinOut[pin] = level ? HIGH : LOW;
+}
+
+inline int digitalRead(uint8_t pin) {
+  if (pin >= HOST_PIN_COUNT) return LOW;
+  HostBoard& b = *hostBoard;
+  if (b.pinModes[pin] == OUTPUT) return b.pinOut[pin];
+  if (b.pinDrive[pin] >= 0) return b.pinDrive[pin];
+  return b.pinModes[pin] == INPUT_PULLUP ? HIGH : LOW;
+}
+
+inline uint16_t analogRead(uint8_t pin) { (void)pin; return 0; }
+inline uint16_t touchRead(uint8_t pin) { (void)pin; return hostBoard->touchValue; }
+
+// xorshift32 per board: every node has its own repeatable sequence
+inline uint32_t hostRandom() {
+  uint32_t& x = hostBoard->randomState;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return x;
+}
+
+inline void randomSeed(unsigned long seed) { hostBoard->randomState = (uint32_t)seed | 1; }
+inline long random(long howBig) { return howBig > 0 ? (long)(hostRandom() % (uint32_t)howBig) : 0; }
+inline long random(long howSmall, long howBig) {
+  return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// =============== STRING ================================
+class String {
+public:
+  String() {}
+  String(const char* c) : s(c ? c : "") {}
+  String(const std::string& x) : s(x) {}
+  explicit String(char c) : s(1, c) {}
+  explicit String(unsigned char v, unsigned char base = DEC) { fromUnsigned(v, base); }
+  explicit String(int v, unsigned char base = DEC) { fromSigned(v, base); }
+  explicit String(unsigned int v, unsigned char base = DEC) { fromUnsigned(v, base); }
+  explicit String(long v, unsigned char base = DEC) { fromSigned(v, base); }
+  explicit String(unsigned long v, unsigned char base = DEC) { fromUnsigned(v, base); }
+  explicit String(long long v, unsigned char base = DEC) { fromSigned(v, base); }
+  explicit String(unsigned long long v, unsigned char base = DEC) { fromUnsigned(v, base); }
+  explicit String(float v, unsigned int decimals = 2) { fromDouble(v, decimals); }
+  explicit String(double v, unsigned int decimals = 2) { fromDouble(v, decimals); }
+
+  unsigned int length() const { return s.size(); }
+  const char* c_str() const { return s.c_str(); }
+  char charAt(unsigned int i) const { return i < s.size() ? s[i] : 0; }
+  char operator[](unsigned int i) const { return charAt(i); }
+  char& operator[](unsigned int i) { return s[i]; }
+  bool reserve(unsigned int n) { s.reserve(n); return true; }
+
+  bool concat(const String& o) { s += o.s; return true; }
+  bool concat(const char* o) { if (o) s += o; return true; }
+  bool concat(const char* o, unsigned int n) { s.append(o, n); return true; }
+  bool concat(char c) { s += c; return true; }
+  template <typename T> bool concat(T v) { s += String(v).s; return true; }
+  template <typename T> String& operator+=(const T& v) { concat(v); return *this; }
+
+  friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+  friend String operator+(const String& a, const char* b) { return String(a.s + (b ? b : "")); }
+  friend String operator+(const char* a, const String& b) { return String((a ? a : "") + b.s); }
+  friend String operator+(const String& a, char b) { return String(a.s + b); }
+  template <typename T> friend String operator+(const String& a, T v) { return a + String(v); }
+
+  bool operator==(const String& o) const { return s == o.s; }
+  bool operator==(const char* o) const { return s == (o ? o : ""); }
+  bool operator!=(const String& o) const { return s != o.s; }
+  bool operator!=(const char* o) const { return !(*this == o); }
+  bool equals(const String& o) const { return s == o.s; }
+  bool equalsIgnoreCase(const String& o) const { return strcasecmp(s.c_str(), o.s.c_str()) == 0; }
+  bool startsWith(const String& p) const { return s.compare(0, p.s.size(), p.s) == 0; }
+  bool endsWith(const String& p) const {
+    return s.size() >= p.s.size() && s.compare(s.size() - p.s.size(), p.s.size(), p.s) == 0;
+  }
+
+  int indexOf(char c, unsigned int from = 0) const { return found(s.find(c, from)); }
+  int indexOf(const String& x, unsigned int from = 0) const { return found(s.find(x.s, from)); }
+  int lastIndexOf(char c) const { return found(s.rfind(c)); }
+  int lastIndexOf(const String& x) const { return found(s.rfind(x.s)); }
+  String substring(unsigned int from) const { return from >= s.size() ? String() : String(s.substr(from)); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= s.size()) return String();
+    return String(s.substr(from, to - from));
+  }
+
+  long toInt() const { return atol(s.c_str()); }
+  float toFloat() const { return (float)atof(s.c_str()); }
+  void trim() {
+    size_t a = s.find_first_not_of(" \t\r\n");
+    if (a == std::string::npos) { s.clear(); return; }
+    s = s.substr(a, s.find_last_not_of(" \t\r\n") - a + 1);
+  }
+  void toUpperCase() { for (auto& c : s) c = (char)toupper((unsigned char)c); }
+  void toLowerCase() { for (auto& c : s) c = (char)tolower((unsigned char)c); }
+  void remove(unsigned int i) { if (i < s.size()) s.erase(i); }
+  void remove(unsigned int i, unsigned int n) { if (i < s.size()) s.erase(i, n); }
+  void replace(const String& from, const String& to) {
+    if (from.s.empty()) return;
+    for (size_t p = 0; (p = s.find(from.s, p)) != std::string::npos; p += to.s.size()) {
+      s.replace(p, from.s.size(), to.s);
+    }
+  }
+  void toCharArray(char* buf, unsigned int n) const {
+    if (!n) return;
+    strncpy(buf, s.c_str(), n - 1);
+    buf[n - 1] = '\0';
+  }
+  void getBytes(unsigned char* buf, unsigned int n) const { toCharArray((char*)buf, n); }
+
+private:
+  std::string s;
+
+  static int found(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+  void fromSigned(long long v, unsigned char base) {
+    if (base != DEC) return fromUnsigned((unsigned long long)v, base);
+    char b[24];
+    snprintf(b, sizeof(b), "%lld", v);
+    s = b;
+  }
+  void fromUnsigned(unsigned long long v, unsigned char base) {
+    char b[66];
+    int i = sizeof(b) - 1;
+    b[i] = '\0';
+    if (base < 2) base = DEC;
+    do {
+      int d = (int)(v % base);
+      b[--i] = (char)(d < 10 ? '0' + d : 'A' + d - 10);
+      v /= base;
+    } while (v);
+    s = b + i;
+  }
+  void fromDouble(double v, unsigned int decimals) {
+    char b[64];
+    snprintf(b, sizeof(b), "%.*f", (int)decimals, v);
+    s = b;
+  }
+};
+
+// =============== PRINT / STREAM ================================
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+  size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+  size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+  virtual void flush() {}
+
+  size_t print(const String& v) { return write(v.c_str(), v.length()); }
+  size_t print(const char* v) { return write(v); }
+  size_t print(char c) { return write((uint8_t)c); }
+  template <typename T> size_t print(T v) { return print(String(v)); }
+  template <typename T> size_t print(T v, int format) { return print(String(v, format)); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+  template <typename T> size_t println(const T& v, int format) { size_t n = print(v, format); return n + println(); }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long ms) { timeoutMs = ms; }
+  String readStringUntil(char terminator);
+  size_t readBytes(char* buffer, size_t length);
+
+protected:
+  unsigned long timeoutMs = 1000;
+  int timedRead();
+};
+
+// =============== HARDWARE SERIAL ================================
+class HardwareSerial;
+
+// Whatever sits on the other end of a UART (fake RYLR896, test script)
+struct HostUartPeer {
+  virtual ~HostUartPeer() {}
+  virtual void uartReceive(HardwareSerial& from, const uint8_t* data, size_t n) = 0;
+};
+
+class HardwareSerial : public Stream {
+public:
+  explicit HardwareSerial(int uartNr) : uart(uartNr) {}
+
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1) {
+    (void)config; (void)rxPin; (void)txPin;
+    baudRate = baud;
+  }
+  void end() {}
+  void onReceive(std::function<void()> callback) { rxEvent = callback; }
+  size_t availableForWrite() { return 128; }
+  operator bool() const { return true; }
+
+  int available() override { return (int)rx.size(); }
+  int read() override {
+    if (rx.empty()) return -1;
+    int c = rx.front();
+    rx.pop_front();
+    return c;
+  }
+  int peek() override { return rx.empty() ? -1 : rx.front(); }
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+
+  // Host side: bytes from the peer, as the UART event task would see them
+  void hostFeed(const uint8_t* data, size_t n) {
+    rx.insert(rx.end(), data, data + n);
+    if (rxEvent) rxEvent();
+  }
+  void hostFeed(const char* text) { hostFeed((const uint8_t*)text, strlen(text)); }
+
+  int uart;
+  unsigned long baudRate = 0;
+  HostUartPeer* peer = nullptr;
+  std::deque<uint8_t> rx;
+  std::function<void()> rxEvent;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial2;
+
+// =============== ESP ================================
+struct EspClass {
+  uint32_t getFreeHeap() { return 200000; }
+  uint32_t getMinFreeHeap() { return 180000; }
+  uint32_t getHeapSize() { return 320000; }
+  uint32_t getCpuFreqMHz() { return 240; }
+  uint32_t getCycleCount() { return (uint32_t)(hostLocalUs() * 240); }
+  uint64_t getEfuseMac() { return hostBoard->efuseMac; }
+  void restart() { hostScheduler->restart(); }
+};
+
+extern EspClass ESP;
+
+// =============== FREERTOS ================================
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+inline TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+inline void vTaskDelay(TickType_t ticks) { delay(ticks); }
+inline void vTaskDelayUntil(TickType_t* previousWake, TickType_t period) {
+  *previousWake += period;
+  TickType_t now = xTaskGetTickCount();
+  if ((int32_t)(*previousWake - now) > 0) delay(*previousWake - now);
+}
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t body, const char* name, uint32_t stackBytes,
+                                          void* arg, UBaseType_t priority, TaskHandle_t* handle,
+                                          BaseType_t core) {
+  (void)stackBytes; (void)priority; (void)core;
+  if (handle) *handle = nullptr;
+  return hostScheduler->createTask(body, arg, name) ? pdPASS : pdFAIL;
+}
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return hostScheduler->currentTask(); }
+inline void xTaskNotifyGive(TaskHandle_t task) { hostScheduler->notifyGive(task); }
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+  return hostScheduler->notifyTake(clear == pdTRUE, ticks);
+}
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) { (void)task; return 2048; }
+inline BaseType_t xPortGetCoreID() { return ARDUINO_RUNNING_CORE; }
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,22 @@
+// Host shim: 16x2 I2C LCD that shows nothing
+#ifndef HOST_LIQUIDCRYSTAL_I2C_H
+#define HOST_LIQUIDCRYSTAL_I2C_H
+
+#include "Arduino.h"
+
+class LiquidCrystal_I2C : public Print {
+public:
+  LiquidCrystal_I2C(uint8_t address, uint8_t cols, uint8_t rows) {
+    (void)address; (void)cols; (void)rows;
+  }
+  void init() {}
+  void begin() {}
+  void clear() {}
+  void backlight() {}
+  void noBacklight() {}
+  void setCursor(uint8_t col, uint8_t row) { (void)col; (void)row; }
+  size_t write(uint8_t c) override { (void)c; return 1; }
+  using Print::write;
+};
+
+#endif // HOST_LIQUIDCRYSTAL_I2C_H
@@ -0,0 +1,41 @@
+/*=====================================================================
+  Preferences.h - Host Shim of the ESP32 NVS Preferences
+
+  Key/value store of the current HostBoard: survives a simulated
+  reboot of that board, nothing else. Only what the sketch uses.
+=======================================================================*/
+
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include "Arduino.h"
+
+class Preferences {
+public:
+  bool begin(const char* name, bool readOnly = false) {
+    ns = name;
+    ns += '/';
+    this->readOnly = readOnly;
+    return true;
+  }
+  void end() {}
+
+  uint32_t getUInt(const char* key, uint32_t defaultValue = 0) {
+    auto it = hostBoard->nvs.find(ns + key);
+    return it == hostBoard->nvs.end() ? defaultValue : it->second;
+  }
+  size_t putUInt(const char* key, uint32_t value) {
+    if (readOnly) return 0;
+    hostBoard->nvs[ns + key] = value;
+    writes++;
+    return sizeof(value);
+  }
+
+  static unsigned long writes;   // All boards: flash wear in tests
+
+private:
+  std::string ns;
+  bool readOnly = false;
+};
+
+#endif // HOST_PREFERENCES_H
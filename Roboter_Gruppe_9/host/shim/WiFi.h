@@ -0,0 +1,18 @@
+// Host shim: WiFi never connects
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "Arduino.h"
+
+#define WL_CONNECTED 3
+#define WL_DISCONNECTED 6
+
+class WiFiClass {
+public:
+  int status() { return WL_DISCONNECTED; }
+  int8_t RSSI() { return 0; }
+};
+
+extern WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
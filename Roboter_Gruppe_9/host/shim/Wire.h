@@ -0,0 +1,17 @@
+// Host shim: I2C bus without devices (every address answers NACK)
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+
+class TwoWire {
+public:
+  bool begin() { return true; }
+  bool begin(int sda, int scl) { (void)sda; (void)scl; return true; }
+  void beginTransmission(uint8_t address) { (void)address; }
+  uint8_t endTransmission(bool stop = true) { (void)stop; return 2; }
+};
+
+extern TwoWire Wire;
+
+#endif // HOST_WIRE_H
@@ -0,0 +1,25 @@
+// Host shim: sleep goes through the HostScheduler
+#ifndef HOST_ESP_SLEEP_H
+#define HOST_ESP_SLEEP_H
+
+#include "Arduino.h"
+
+typedef enum {
+  ESP_SLEEP_WAKEUP_UNDEFINED = 0,
+  ESP_SLEEP_WAKEUP_TIMER = 4
+} esp_sleep_wakeup_cause_t;
+
+extern uint64_t hostSleepTimerUs;
+
+inline esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+  return (esp_sleep_wakeup_cause_t)hostBoard->wakeCause;
+}
+inline int esp_sleep_enable_timer_wakeup(uint64_t us) { hostSleepTimerUs = us; return 0; }
+inline int esp_light_sleep_start() {
+  hostScheduler->sleepUs(hostSleepTimerUs);
+  hostBoard->wakeCause = ESP_SLEEP_WAKEUP_TIMER;
+  return 0;
+}
+inline void esp_deep_sleep_start() { hostScheduler->deepSleep(hostSleepTimerUs); }
+
+#endif // HOST_ESP_SLEEP_H
@@ -0,0 +1,10 @@
+// Host shim: esp_restart() and the hardware RNG
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#include "Arduino.h"
+
+inline void esp_restart() { hostScheduler->restart(); }
+inline uint32_t esp_random() { return hostRandom(); }
+
+#endif // HOST_ESP_SYSTEM_H
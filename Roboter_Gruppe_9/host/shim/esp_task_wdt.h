@@ -0,0 +1,17 @@
+// Host shim: task watchdog that never bites
+#ifndef HOST_ESP_TASK_WDT_H
+#define HOST_ESP_TASK_WDT_H
+
+#include "Arduino.h"
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+inline esp_err_t esp_task_wdt_init(uint32_t timeoutS, bool panic) { (void)timeoutS; (void)panic; return ESP_OK; }
+inline esp_err_t esp_task_wdt_add(void* task) { (void)task; return ESP_OK; }
+inline esp_err_t esp_task_wdt_delete(void* task) { (void)task; return ESP_OK; }
+inline esp_err_t esp_task_wdt_reset() { return ESP_OK; }
+inline const char* esp_err_to_name(esp_err_t err) { return err == ESP_OK ? "ESP_OK" : "ESP_FAIL"; }
+
+#endif // HOST_ESP_TASK_WDT_H
@@ -0,0 +1,130 @@
+/*=====================================================================
+  shim.cpp - Host Shim Globals
+
+  Serial, the virtual clock, the default board and scheduler. Linked
+  into every host target (library "arduino_shim").
+=======================================================================*/
+
+#include <stdarg.h>
+#include "Arduino.h"
+#include "Preferences.h"
+#include "Wire.h"
+#include "WiFi.h"
+#include "esp_sleep.h"
+
+uint64_t hostClockUs = 0;
+uint64_t hostSleepTimerUs = 0;
+
+HardwareSerial Serial(0);
+HardwareSerial Serial2(2);
+EspClass ESP;
+TwoWire Wire;
+WiFiClass WiFi;
+unsigned long Preferences::writes = 0;
+
+// =============== DEFAULT BOARD ================================
+void hostBoardInit(HostBoard& board, const char* name, uint64_t efuseMac) {
+  board.name = name;
+  board.efuseMac = efuseMac;
+  for (int i = 0; i < HOST_PIN_COUNT; i++) {
+    board.pinDrive[i] = -1;
+    board.pinModes[i] = INPUT;
+    board.pinOut[i] = LOW;
+  }
+  board.touchValue = 700;
+  board.current_mA = 0;
+  board.busVoltage_V = 3.3f;
+  board.randomState = (uint32_t)(efuseMac ^ (efuseMac >> 32)) | 1;
+  board.wakeCause = 0;
+  board.nvs.clear();
+  board.echo = getenv("HOST_SERIAL") != nullptr;
+  board.consoleLine.clear();
+  board.onConsoleLine = nullptr;
+  board.bootUs = 0;
+  board.clockPpm = 0;
+}
+
+static HostBoard makeDefaultBoard() {
+  HostBoard board;
+  hostBoardInit(board, "host", 0x0000A1B2C3D4E5F6ULL);
+  return board;
+}
+
+static HostBoard defaultBoard = makeDefaultBoard();
+HostBoard* hostBoard = &defaultBoard;
+
+// =============== DEFAULT SCHEDULER ================================
+void HostScheduler::deepSleep(uint64_t us) {
+  fprintf(stderr, "[%s] esp_deep_sleep_start(%llu us): not supported by this host target\n",
+          hostBoard->name, (unsigned long long)us);
+  exit(3);
+}
+
+void HostScheduler::restart() {
+  fprintf(stderr, "[%s] ESP.restart(): not supported by this host target\n", hostBoard->name);
+  exit(3);
+}
+
+static HostScheduler defaultScheduler;
+HostScheduler* hostScheduler = &defaultScheduler;
+
+// =============== CONSOLE ================================
+// Serial output of the current board, one line at a time
+void hostConsoleWrite(const uint8_t* data, size_t n) {
+  HostBoard& b = *hostBoard;
+  for (size_t i = 0; i < n; i++) {
+    char c = (char)data[i];
+    if (c == '\r') continue;
+    if (c != '\n') {
+      b.consoleLine += c;
+      continue;
+    }
+    if (b.onConsoleLine) b.onConsoleLine(b, b.consoleLine);
+    if (b.echo) printf("%10.3f %-8s| %s\n", hostClockUs / 1e6, b.name, b.consoleLine.c_str());
+    b.consoleLine.clear();
+  }
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  if (peer) {
+    peer->uartReceive(*this, buffer, size);
+  } else if (uart == 0) {
+    hostConsoleWrite(buffer, size);
+  }
+  return size;
+}
+
+// =============== PRINT / STREAM ================================
+size_t Print::printf(const char* format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (n < 0) return 0;
+  return write((const uint8_t*)buf, std::min((size_t)n, sizeof(buf) - 1));
+}
+
+int Stream::timedRead() {
+  unsigned long start = millis();
+  do {
+    int c = read();
+    if (c >= 0) return c;
+    yield();
+  } while (millis() - start < timeoutMs);
+  return -1;
+}
+
+String Stream::readStringUntil(char terminator) {
+  String out;
+  int c;
+  while ((c = timedRead()) >= 0 && c != terminator) out += (char)c;
+  return out;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+  size_t n = 0;
+  int c;
+  while (n < length && (c = timedRead()) >= 0) buffer[n++] = (char)c;
+  return n;
+}
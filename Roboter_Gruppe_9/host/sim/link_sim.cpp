@@ -0,0 +1,276 @@
+/*=====================================================================
+  link_sim.cpp - Link Simulator: One Receiver, N Senders, Real Firmware
+
+  Boots a receiver and --senders senders from the sketch (sim.h) and
+  lets them run for --hours of virtual time. Every node configures its
+  RYLR896 over AT, sends telemetry, requests and answers ACKs exactly
+  as the firmware built from config.h does - the channel options below
+  are the only thing the simulator decides.
+
+  Options:
+    --hours H        Virtual duration (default 1)
+    --seed N         Channel, MACs, power-on times, crystals (default 1)
+    --senders N      Senders next to the receiver (default 1)
+    --distance M     Every link (default 500 m)
+    --shadowing DB   Log-normal sigma (default 4 dB)
+    --burst P        Gilbert-Elliott P(good → bad) per packet (default 0)
+    --boot-spread MS Sender power-on spread (default SEND_INTERVAL;
+                     50 = switched on together)
+    --drift PPM      Crystal error, uniform ± per node (default 50)
+    --sweep N        Run 1..N senders, print delivered/s per run
+    --csv FILE       Every frame the receiver gets (time, sender, rssi, snr)
+    --serial         Echo every node's Serial (same as HOST_SERIAL=1)
+    --check          Exit 1 unless all nodes came up and every sender got
+                     ≥ 90 % of its frames and ACKs through (ctest)
+
+  Senders share one address unless LORA_SENDER_ADDRESS_AUTO: several of
+  them need a gateway variant (host/CMakeLists.txt, sim_target()).
+=======================================================================*/
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include "sim.h"
+#include "config.h"
+
+struct Options {
+  double hours = 1;
+  uint64_t seed = 1;
+  int senders = 1;
+  double bootSpreadMs = SEND_INTERVAL;
+  int driftPpm = 50;
+  int sweep = 0;
+  const char* csv = nullptr;
+  bool check = false;
+  SimChannelConfig channel;
+};
+
+// Radio-level counts per sender (frames to/from the receiver address)
+struct SenderStats {
+  uint16_t address;
+  unsigned long sent;
+  unsigned long delivered;
+  unsigned long acksSent;            // Receiver → this sender
+  unsigned long acksReceived;
+  uint64_t airtimeUs;
+};
+
+struct RunResult {
+  int senders;
+  int booted;                        // Radio got its address over AT
+  int halted;
+  unsigned long sent;
+  unsigned long delivered;
+  unsigned long collided;
+  SimRadioStats receiver;
+  SenderStats sender[SIM_MAX_NODES];
+};
+
+// =============== ONE RUN ================================
+static RunResult simulate(const Options& opt, FILE* csv) {
+  SimWorld world(opt.seed, opt.channel);
+  std::uniform_int_distribution<uint64_t> mac(0, 0xFFFFFF);
+  std::uniform_int_distribution<int> ppm(-opt.driftPpm, opt.driftPpm);
+  std::uniform_real_distribution<double> boot(0, opt.bootSpreadMs * 1000);
+
+  world.addNode("receiver", SIM_RECEIVER, 0x24A1600000000ULL | mac(world.rng), 0, ppm(world.rng));
+  bool used[256] = {};
+  for (int i = 0; i < opt.senders; i++) {
+    uint64_t efuse;
+    do {
+      efuse = 0x24A1600000000ULL | mac(world.rng);
+    } while (used[simAutoSenderAddress(efuse)]);
+    used[simAutoSenderAddress(efuse)] = true;
+    world.addNode("sender" + std::to_string(i + 1), SIM_SENDER, efuse,
+                  (uint64_t)boot(world.rng), ppm(world.rng));
+  }
+
+  RunResult r = {};
+  r.senders = opt.senders;
+  SimRadio& receiver = *world.nodes[0]->radio;
+  auto senderIndex = [&](uint16_t address) {
+    for (int i = 1; i <= opt.senders; i++) {
+      if (world.nodes[i]->radio->address == address) return i - 1;
+    }
+    return -1;
+  };
+
+  world.onTransmit = [&](SimRadio& from, uint16_t dest, const std::string& data) {
+    (void)data;
+    if (&from == &receiver) {
+      int i = senderIndex(dest);
+      if (i >= 0) r.sender[i].acksSent++;
+    } else if (dest == receiver.address) {
+      int i = senderIndex(from.address);
+      if (i >= 0) r.sender[i].sent++;
+    }
+  };
+  world.onReceive = [&](SimRadio& to, uint16_t from, const std::string& data, int rssi, int snr) {
+    if (&to == &receiver) {
+      int i = senderIndex(from);
+      if (i >= 0) r.sender[i].delivered++;
+      if (csv) {
+        fprintf(csv, "%llu,%u,%zu,%d,%d\n", (unsigned long long)(world.now() / 1000), from,
+                data.size(), rssi, snr);
+      }
+    } else if (from == receiver.address) {
+      int i = senderIndex(to.address);
+      if (i >= 0) r.sender[i].acksReceived++;
+    }
+  };
+
+  world.runUntil((uint64_t)(opt.hours * 3600e6));
+
+  for (auto& node : world.nodes) {
+    if (node->radio->address != 0) r.booted++;
+    if (node->halted) r.halted++;
+  }
+  for (int i = 0; i < opt.senders; i++) {
+    SimRadio& radio = *world.nodes[i + 1]->radio;
+    r.sender[i].address = radio.address;
+    r.sender[i].airtimeUs = radio.airtimeUs;
+    r.sent += r.sender[i].sent;
+    r.delivered += r.sender[i].delivered;
+  }
+  r.receiver = receiver.stats;
+  r.collided = receiver.stats.lostCollision;
+  return r;
+}
+
+// Each run in its own process: the sketch globals of every slot start
+// from their initial values again
+static RunResult simulateIsolated(const Options& opt) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    exit(2);
+  }
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    RunResult r = simulate(opt, nullptr);
+    ssize_t n = write(fds[1], &r, sizeof(r));
+    _exit(n == (ssize_t)sizeof(r) ? 0 : 1);
+  }
+  close(fds[1]);
+  RunResult r = {};
+  ssize_t n = read(fds[0], &r, sizeof(r));
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (n != (ssize_t)sizeof(r) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    fprintf(stderr, "link_sim: run with %d senders failed\n", opt.senders);
+    exit(2);
+  }
+  return r;
+}
+
+// =============== REPORT ================================
+static void line(char c) {
+  for (int i = 0; i < 60; i++) putchar(c);
+  putchar('\n');
+}
+
+static void report(const Options& opt, const RunResult& r) {
+  line('=');
+  printf("  LINK SIMULATION  (%.2f h virtual, seed %llu)\n", opt.hours, (unsigned long long)opt.seed);
+  line('=');
+  printf("SF%d, send interval %d ms, ACK every %d, %.0f m, shadowing %.1f dB, burst %.3f\n",
+         LORA_SPREADING_FACTOR, SEND_INTERVAL, ACK_INTERVAL, opt.channel.distanceM, opt.channel.shadowingDb,
+         opt.channel.burstP);
+  printf("Nodes up %d/%d, halted %d\n", r.booted, r.senders + 1, r.halted);
+  line('-');
+  for (int i = 0; i < r.senders; i++) {
+    const SenderStats& s = r.sender[i];
+    printf("Sender %u: sent %lu, delivered %lu (%.1f%%), duty %.2f%%, ACK %lu/%lu\n", s.address,
+           s.sent, s.delivered, s.sent ? 100.0 * s.delivered / s.sent : 0.0,
+           100.0 * s.airtimeUs / (opt.hours * 3600e6), s.acksReceived, s.acksSent);
+  }
+  line('-');
+  printf("Receiver: heard %lu, received %lu, AT errors %lu\n", r.receiver.heard, r.receiver.rx,
+         r.receiver.errors);
+  printf("  lost: sensitivity %lu, collision %lu, burst %lu, half-duplex %lu\n",
+         r.receiver.lostSensitivity, r.receiver.lostCollision, r.receiver.lostBurst,
+         r.receiver.lostHalfDuplex);
+  line('=');
+}
+
+static void sweep(Options opt) {
+  double seconds = opt.hours * 3600;
+  line('=');
+  printf("  SENDER SWEEP  SF%d, %.2f h virtual per run, seed %llu\n", LORA_SPREADING_FACTOR,
+         opt.hours, (unsigned long long)opt.seed);
+  line('=');
+  printf("%7s %10s %12s %9s %10s\n", "senders", "offered/s", "delivered/s", "delivery", "collided");
+  for (int n = 1; n <= opt.sweep; n++) {
+    opt.senders = n;
+    RunResult r = simulateIsolated(opt);
+    printf("%7d %10.3f %12.3f %8.1f%% %10lu\n", n, r.sent / seconds, r.delivered / seconds,
+           r.sent ? 100.0 * r.delivered / r.sent : 0.0, r.collided);
+  }
+  line('=');
+}
+
+// All nodes up, none halted, every sender's frames and ACKs get through
+static bool checkRun(const RunResult& r) {
+  bool ok = r.booted == r.senders + 1 && r.halted == 0;
+  for (int i = 0; i < r.senders; i++) {
+    const SenderStats& s = r.sender[i];
+    ok = ok && s.sent > 0 && s.delivered >= s.sent * 9 / 10;
+    #if ENABLE_BIDIRECTIONAL
+      ok = ok && s.acksSent > 0 && s.acksReceived >= s.acksSent * 9 / 10;
+    #endif
+  }
+  printf("check: %s\n", ok ? "PASS" : "FAIL");
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  Options opt;
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    const char* v = i + 1 < argc ? argv[i + 1] : "";
+    if (!strcmp(a, "--hours")) { opt.hours = atof(v); i++; }
+    else if (!strcmp(a, "--seed")) { opt.seed = strtoull(v, nullptr, 10); i++; }
+    else if (!strcmp(a, "--senders")) { opt.senders = atoi(v); i++; }
+    else if (!strcmp(a, "--distance")) { opt.channel.distanceM = atof(v); i++; }
+    else if (!strcmp(a, "--shadowing")) { opt.channel.shadowingDb = atof(v); i++; }
+    else if (!strcmp(a, "--burst")) { opt.channel.burstP = atof(v); i++; }
+    else if (!strcmp(a, "--boot-spread")) { opt.bootSpreadMs = atof(v); i++; }
+    else if (!strcmp(a, "--drift")) { opt.driftPpm = atoi(v); i++; }
+    else if (!strcmp(a, "--sweep")) { opt.sweep = atoi(v); i++; }
+    else if (!strcmp(a, "--csv")) { opt.csv = v; i++; }
+    else if (!strcmp(a, "--serial")) { setenv("HOST_SERIAL", "1", 1); }
+    else if (!strcmp(a, "--check")) { opt.check = true; }
+    else {
+      fprintf(stderr, "usage: %s [--hours H] [--seed N] [--senders N] [--distance M] [--shadowing DB]\n"
+                      "       [--burst P] [--boot-spread MS] [--drift PPM] [--sweep N] [--csv FILE]\n"
+                      "       [--serial] [--check]\n", argv[0]);
+      return 2;
+    }
+  }
+  int most = opt.sweep ? opt.sweep : opt.senders;
+  if (most < 1 || most + 1 > SIM_MAX_NODES) {
+    fprintf(stderr, "link_sim: 1-%d senders (SIM_MAX_NODES %d)\n", SIM_MAX_NODES - 1, SIM_MAX_NODES);
+    return 2;
+  }
+
+  if (opt.sweep) {
+    sweep(opt);
+    return 0;
+  }
+
+  FILE* csv = nullptr;
+  if (opt.csv) {
+    csv = fopen(opt.csv, "w");
+    if (!csv) {
+      perror(opt.csv);
+      return 2;
+    }
+    fprintf(csv, "time_ms,sender,length,rssi,snr\n");
+  }
+  RunResult r = simulate(opt, csv);
+  if (csv) fclose(csv);
+  report(opt, r);
+  return opt.check && !checkRun(r) ? 1 : 0;
+}
@@ -0,0 +1,36 @@
+/*=====================================================================
+  node_image.cpp - One Copy of the Sketch for the Simulator
+
+  Compiled once per node slot (host/CMakeLists.txt, sim_target()) with
+  SIM_NODE = node<N> and SIM_NODE_INDEX = N: the whole sketch goes into
+  namespace node<N>, so every node has its own globals (LoRaSerial,
+  device state, queues, ...) in one process. The libraries (Arduino.h
+  and friends) stay outside and are shared - they keep their per-node
+  state in the HostBoard the simulator selects.
+=======================================================================*/
+
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include <Wire.h>
+#include <WiFi.h>
+#include <Preferences.h>
+#include <LiquidCrystal_I2C.h>
+#include <Adafruit_INA219.h>
+#include <esp_system.h>
+#include <esp_sleep.h>
+#include <esp_task_wdt.h>
+#include "sim.h"
+
+namespace SIM_NODE {
+#include "structs.h"
+// Prototypes the Arduino IDE generates for the .ino
+void executeRestart(const char* reason);
+void updateLCD_Version1_WideBar(const UiSnapshot& ui);
+void updateLCD_Version2_Compact(const UiSnapshot& ui);
+void updateLCD_Version3_Detailed(const UiSnapshot& ui);
+void updateLCD_Version4_Original(const UiSnapshot& ui);
+#include "Roboter_Gruppe_9.ino"
+}
+
+static bool registered = simRegisterImage(SIM_NODE_INDEX, {SIM_NODE::setup, SIM_NODE::loop,
+                                                           &SIM_NODE::LoRaSerial});
@@ -0,0 +1,444 @@
+/*=====================================================================
+  sim.cpp - Multi-Node Simulator: Fibers, Channel and RYLR896
+
+  See sim.h. Everything runs on the main thread: the event loop pops
+  the next event, sets the virtual clock and either resumes a node's
+  fiber (until it waits again) or runs a radio/channel action.
+=======================================================================*/
+
+#include "sim.h"
+
+SketchImage simImages[SIM_MAX_NODES];
+
+bool simRegisterImage(int slot, const SketchImage& image) {
+  if (slot < 0 || slot >= SIM_MAX_NODES) return false;
+  simImages[slot] = image;
+  return true;
+}
+
+uint8_t simAutoSenderAddress(uint64_t efuseMac) {
+  uint8_t hash = 0;
+  for (uint8_t i = 0; i < 6; i++) hash = hash * 31 + (uint8_t)(efuseMac >> (8 * i));
+  return 4 + hash % 250;
+}
+
+static SimWorld* activeWorld = nullptr;
+
+// Console lines of a node go to SimWorld::onConsole
+static void consoleLine(HostBoard& board, const std::string& line) {
+  if (!activeWorld || !activeWorld->onConsole) return;
+  for (auto& node : activeWorld->nodes) {
+    if (&node->board == &board) activeWorld->onConsole(*node, line);
+  }
+}
+
+// =============== WORLD ================================
+SimWorld::SimWorld(uint64_t seed, const SimChannelConfig& channel)
+  : channel(channel), rng(seed), previousScheduler(hostScheduler), previousBoard(hostBoard) {
+  hostClockUs = 0;
+  hostScheduler = this;
+  activeWorld = this;
+}
+
+SimWorld::~SimWorld() {
+  // Halted and waiting fibers are simply dropped with their stacks
+  hostScheduler = previousScheduler;
+  hostBoard = previousBoard;
+  activeWorld = nullptr;
+}
+
+SimNode& SimWorld::addNode(const std::string& name, SimRole role, uint64_t efuseMac,
+                           uint64_t bootUs, int32_t clockPpm) {
+  int slot = (int)nodes.size();
+  if (slot >= SIM_MAX_NODES || !simImages[slot].setup) {
+    fprintf(stderr, "sim: no sketch image for node %d (SIM_MAX_NODES %d)\n", slot, SIM_MAX_NODES);
+    exit(2);
+  }
+  nodes.emplace_back(new SimNode());
+  SimNode& node = *nodes.back();
+  node.index = slot;
+  node.name = name;
+  node.role = role;
+  node.image = &simImages[slot];
+
+  hostBoardInit(node.board, node.name.c_str(), efuseMac);
+  node.board.bootUs = bootUs;
+  node.board.clockPpm = clockPpm;
+  node.board.onConsoleLine = consoleLine;
+  node.board.pinDrive[16] = role == SIM_RECEIVER ? LOW : role == SIM_RELAY ? HIGH : -1;
+
+  node.radio.reset(new SimRadio(*this, node));
+  node.image->loraSerial->peer = node.radio.get();
+
+  SimNode* n = &node;
+  at(bootUs, [this, n] {
+    n->booted = true;
+    resume(spawn(*n, nodeMain, n, "loopTask"));
+  });
+  return node;
+}
+
+void SimWorld::at(uint64_t timeUs, std::function<void()> action) {
+  events.push({timeUs, eventOrder++, std::move(action)});
+}
+
+void SimWorld::runUntil(uint64_t endUs) {
+  while (!events.empty() && events.top().timeUs <= endUs) {
+    SimEvent e = events.top();
+    events.pop();
+    hostClockUs = e.timeUs;
+    e.action();
+  }
+  hostClockUs = endUs;
+}
+
+void SimWorld::onBoard(SimNode& node, const std::function<void()>& fn) {
+  HostBoard* saved = hostBoard;
+  hostBoard = &node.board;
+  fn();
+  hostBoard = saved;
+}
+
+// =============== FIBERS ================================
+void SimWorld::nodeMain(void* arg) {
+  SimNode* node = (SimNode*)arg;
+  node->image->setup();
+  for (;;) node->image->loop();
+}
+
+void SimWorld::fiberEntry() {
+  SimFiber* fiber = activeWorld->current;
+  fiber->body(fiber->arg);
+  // FreeRTOS tasks must not return - treat it like one that blocks forever
+  activeWorld->suspend();
+}
+
+SimFiber* SimWorld::spawn(SimNode& node, void (*body)(void*), void* arg, const char* name) {
+  fibers.emplace_back(new SimFiber());
+  SimFiber* fiber = fibers.back().get();
+  fiber->node = &node;
+  fiber->body = body;
+  fiber->arg = arg;
+  fiber->name = name;
+  fiber->stack.resize(SIM_STACK_BYTES);
+  getcontext(&fiber->ctx);
+  fiber->ctx.uc_stack.ss_sp = fiber->stack.data();
+  fiber->ctx.uc_stack.ss_size = fiber->stack.size();
+  fiber->ctx.uc_link = nullptr;
+  makecontext(&fiber->ctx, fiberEntry, 0);
+  return fiber;
+}
+
+void SimWorld::resume(SimFiber* fiber) {
+  if (fiber->node->halted) return;
+  HostBoard* saved = hostBoard;
+  current = fiber;
+  hostBoard = &fiber->node->board;
+  swapcontext(&mainCtx, &fiber->ctx);
+  current = nullptr;
+  hostBoard = saved;
+}
+
+void SimWorld::suspend() {
+  swapcontext(&current->ctx, &mainCtx);
+}
+
+void SimWorld::wakeAt(SimFiber* fiber, uint64_t timeUs) {
+  uint32_t token = ++fiber->wakeToken;
+  at(timeUs, [this, fiber, token] {
+    if (fiber->wakeToken == token) resume(fiber);
+  });
+}
+
+// Local (crystal) microseconds → virtual clock
+uint64_t SimWorld::localToGlobalUs(const SimNode& node, uint64_t us) const {
+  int32_t ppm = node.board.clockPpm;
+  if (!ppm) return us;
+  return (uint64_t)((long double)us * 1000000 / (1000000 + ppm) + 0.5L);
+}
+
+void SimWorld::sleepUs(uint64_t us) {
+  if (!current) return;  // UART callback on the main context: nothing to wait for
+  wakeAt(current, hostClockUs + localToGlobalUs(*current->node, us));
+  suspend();
+}
+
+uint32_t SimWorld::notifyTake(bool clear, uint32_t ms) {
+  SimFiber* fiber = current;
+  if (!fiber) return 0;
+  if (fiber->notifyCount == 0 && ms > 0) {
+    fiber->waitingNotify = true;
+    if (ms == portMAX_DELAY) {
+      ++fiber->wakeToken;  // Only xTaskNotifyGive() wakes it
+    } else {
+      wakeAt(fiber, hostClockUs + localToGlobalUs(*fiber->node, (uint64_t)ms * 1000));
+    }
+    suspend();
+    fiber->waitingNotify = false;
+  }
+  uint32_t count = fiber->notifyCount;
+  if (clear) {
+    fiber->notifyCount = 0;
+  } else if (count) {
+    fiber->notifyCount--;
+  }
+  return count;
+}
+
+void SimWorld::notifyGive(void* task) {
+  SimFiber* fiber = (SimFiber*)task;
+  if (!fiber) return;
+  fiber->notifyCount++;
+  if (fiber->waitingNotify) wakeAt(fiber, hostClockUs);
+}
+
+void* SimWorld::currentTask() {
+  return current;
+}
+
+bool SimWorld::createTask(void (*body)(void*), void* arg, const char* name) {
+  if (!current) return false;
+  SimFiber* fiber = spawn(*current->node, body, arg, name);
+  at(hostClockUs, [this, fiber] { resume(fiber); });
+  return true;
+}
+
+void SimWorld::halt(const std::string& reason) {
+  SimNode& node = *current->node;
+  node.halted = true;
+  node.haltReason = reason;
+  node.radio->sleeping = true;
+  fprintf(stderr, "%10.3f %-8s| sim: %s - node halted\n", hostClockUs / 1e6, node.name.c_str(),
+          reason.c_str());
+  for (;;) suspend();  // Never resumed again
+}
+
+void SimWorld::deepSleep(uint64_t us) {
+  halt("deep sleep (" + std::to_string(us / 1000) + " ms)");
+}
+
+void SimWorld::restart() {
+  halt("ESP.restart()");
+}
+
+// =============== CHANNEL ================================
+float SimWorld::pathRssi(SimRadio& from, SimRadio& to) {
+  // 868 MHz free space at 1 m ≈ 31.2 dB
+  float d = std::max(channel.distanceM, 1.0f);
+  float pathLoss = 31.2f + 10 * channel.pathLossExp * log10f(d);
+  std::normal_distribution<float> shadowing(0, channel.shadowingDb);
+  (void)to;
+  return from.txPowerDbm - pathLoss + (channel.shadowingDb > 0 ? shadowing(rng) : 0);
+}
+
+bool SimWorld::burstDrop(SimRadio& a, SimRadio& b) {
+  SimLink& link = links[{std::min(a.node.index, b.node.index), std::max(a.node.index, b.node.index)}];
+  std::uniform_real_distribution<float> u(0, 1);
+  if (link.bad) {
+    if (u(rng) < channel.burstR) link.bad = false;
+  } else if (channel.burstP > 0 && u(rng) < channel.burstP) {
+    link.bad = true;
+  }
+  return link.bad && u(rng) < channel.burstLoss;
+}
+
+void SimWorld::transmit(SimRadio& radio, uint16_t dest, const std::string& payload) {
+  auto tx = std::make_shared<Transmission>();
+  tx->start = hostClockUs;
+  tx->end = hostClockUs + loraAirtimeUs((uint8_t)payload.size(), radio.params);
+  tx->sender = &radio;
+  tx->dest = dest;
+  tx->payload = payload;
+  for (auto& node : nodes) {
+    if (node->radio.get() != &radio) tx->rssi.push_back({node->radio.get(), pathRssi(radio, *node->radio)});
+  }
+  onAir.push_back(tx);
+  if (onTransmit) onTransmit(radio, dest, payload);
+  radio.airtimeUs += tx->end - tx->start;
+  radio.txLog.push_back({tx->start, tx->end});
+  if (radio.txLog.size() > 4) radio.txLog.pop_front();
+  at(tx->end, [this, tx] { deliver(tx); });
+}
+
+bool SimWorld::collided(const Transmission& tx, SimRadio& radio, float rssi) const {
+  for (const auto& other : onAir) {
+    if (other.get() == &tx || other->sender == &radio) continue;
+    if (other->end <= tx.start || other->start >= tx.end) continue;
+    if (other->sender->params.sf != tx.sender->params.sf) continue;  // Orthogonal
+    float otherRssi = -200;
+    for (const auto& r : other->rssi) {
+      if (r.first == &radio) otherRssi = r.second;
+    }
+    if (rssi - otherRssi < channel.captureDb) return true;
+  }
+  return false;
+}
+
+void SimWorld::deliver(const std::shared_ptr<Transmission>& tx) {
+  SimRadio& sender = *tx->sender;
+  for (const auto& r : tx->rssi) {
+    SimRadio& radio = *r.first;
+    float rssi = r.second;
+    if (!radio.node.booted || radio.sleeping) continue;
+    if (radio.networkId != sender.networkId) continue;
+    if (tx->dest != 0 && tx->dest != radio.address) continue;
+    if (radio.params.sf != sender.params.sf || radio.params.bw != sender.params.bw) continue;
+    radio.stats.heard++;
+    float snr = rssi - (-174 + loraBandwidthDb(radio.params.bw) + channel.noiseFigureDb);
+
+    if (radio.wasTransmitting(tx->start, tx->end)) {
+      radio.stats.lostHalfDuplex++;
+    } else if (snr < loraSnrFloor(radio.params.sf)) {
+      radio.stats.lostSensitivity++;
+    } else if (collided(*tx, radio, rssi)) {
+      radio.stats.lostCollision++;
+    } else if (burstDrop(sender, radio)) {
+      radio.stats.lostBurst++;
+    } else {
+      radio.receive(sender.address, tx->payload, (int)lroundf(rssi),
+                    (int)lroundf(std::max(std::min(snr, 12.0f), -20.0f)));
+    }
+  }
+
+  // Keep transmissions that may still overlap a pending packet
+  uint64_t horizon = hostClockUs > 10000000 ? hostClockUs - 10000000 : 0;
+  onAir.erase(std::remove_if(onAir.begin(), onAir.end(),
+                             [horizon](const std::shared_ptr<Transmission>& t) { return t->end < horizon; }),
+              onAir.end());
+}
+
+// =============== SIMULATED RYLR896 ================================
+SimRadio::SimRadio(SimWorld& world, SimNode& node) : world(world), node(node) {}
+
+bool SimRadio::wasTransmitting(uint64_t start, uint64_t end) const {
+  for (const auto& t : txLog) {
+    if (t.first < end && t.second > start) return true;
+  }
+  return false;
+}
+
+// Bytes from the firmware: command lines, AT+SEND data is binary
+// (<len> raw bytes after "AT+SEND=<addr>,<len>,")
+void SimRadio::uartReceive(HardwareSerial& from, const uint8_t* data, size_t n) {
+  (void)from;
+  for (size_t i = 0; i < n; i++) {
+    char c = (char)data[i];
+    line += c;
+    if (dataLeft) {
+      dataLeft--;
+      continue;
+    }
+    if (c == ',' && line.compare(0, 8, "AT+SEND=") == 0 &&
+        std::count(line.begin(), line.end(), ',') == 2) {
+      long len = atol(line.c_str() + line.find(',') + 1);
+      dataLeft = len > 0 && len <= 255 ? (size_t)len : 0;
+      continue;
+    }
+    if (line.size() >= 2 && line.compare(line.size() - 2, 2, "\r\n") == 0) {
+      std::string cmd = line.substr(0, line.size() - 2);
+      line.clear();
+      command(cmd);
+    } else if (line.size() > 512) {
+      line.clear();  // Garbage without a line end
+    }
+  }
+}
+
+void SimRadio::reply(const std::string& text, uint64_t delayUs) {
+  SimNode* n = &node;
+  std::string bytes = text + "\r\n";
+  world.at(world.now() + delayUs, [this, n, bytes] {
+    if (n->halted) return;
+    world.onBoard(*n, [&] {
+      node.image->loraSerial->hostFeed((const uint8_t*)bytes.data(), bytes.size());
+    });
+  });
+}
+
+void SimRadio::error(int code) {
+  stats.errors++;
+  reply("+ERR=" + std::to_string(code));
+}
+
+void SimRadio::command(const std::string& cmd) {
+  sleeping = false;  // Any command wakes the module from AT+MODE=1
+  if (cmd.compare(0, 2, "AT") != 0) return error(2);
+  if (cmd == "AT") return reply("+OK");
+
+  size_t eq = cmd.find('=');
+  std::string name = cmd.substr(3, eq == std::string::npos ? std::string::npos : eq - 3);
+  std::string arg = eq == std::string::npos ? "" : cmd.substr(eq + 1);
+  if (name == "SEND") return send(arg);
+
+  char value[40];
+  if (name.size() > 1 && name.back() == '?') {
+    name.pop_back();
+    if (name == "ADDRESS") {
+      snprintf(value, sizeof(value), "%u", address);
+    } else if (name == "NETWORKID") {
+      snprintf(value, sizeof(value), "%u", networkId);
+    } else if (name == "CRFOP") {
+      snprintf(value, sizeof(value), "%d", txPowerDbm);
+    } else if (name == "PARAMETER") {
+      snprintf(value, sizeof(value), "%u,%u,%u,%u", params.sf, params.bw, params.cr, params.preamble);
+    } else if (name == "VER") {
+      snprintf(value, sizeof(value), "RYLR89C_V1.2.7");
+    } else {
+      return error(4);
+    }
+    return reply("+" + name + "=" + value);
+  }
+
+  if (name == "ADDRESS") {
+    address = (uint16_t)atoi(arg.c_str());
+  } else if (name == "NETWORKID") {
+    networkId = (uint8_t)atoi(arg.c_str());
+  } else if (name == "CRFOP") {
+    txPowerDbm = std::max(0, std::min(15, atoi(arg.c_str())));
+  } else if (name == "PARAMETER") {
+    unsigned sf, bw, cr, pre;
+    if (sscanf(arg.c_str(), "%u,%u,%u,%u", &sf, &bw, &cr, &pre) != 4 || sf < 7 || sf > 12 || bw > 9 ||
+        cr < 1 || cr > 4) {
+      return error(4);
+    }
+    params = {(uint8_t)sf, (uint8_t)bw, (uint8_t)cr, (uint8_t)pre};
+  } else if (name == "RESET") {
+    busyUntil = 0;
+    reply("+RESET");
+    reply("+READY", 50000);
+    return;
+  } else if (name == "MODE") {
+    sleeping = atoi(arg.c_str()) == 1;
+  } else if (name != "BAND" && name != "IPR") {
+    return error(4);
+  }
+  reply("+OK");
+}
+
+void SimRadio::send(const std::string& arg) {
+  size_t c1 = arg.find(',');
+  size_t c2 = c1 == std::string::npos ? c1 : arg.find(',', c1 + 1);
+  if (c2 == std::string::npos) return error(4);
+  uint16_t dest = (uint16_t)atoi(arg.c_str());
+  long length = atol(arg.c_str() + c1 + 1);
+  std::string data = arg.substr(c2 + 1);
+  if (length > SIM_MAX_PAYLOAD) return error(13);
+  if (length != (long)data.size()) return error(5);
+  if (world.now() < busyUntil) return error(15);
+
+  stats.tx++;
+  uint64_t airtime = loraAirtimeUs((uint8_t)data.size(), params);
+  busyUntil = world.now() + SIM_UART_LATENCY_US + airtime;
+  world.at(world.now() + SIM_UART_LATENCY_US, [this, dest, data, airtime] {
+    if (node.halted) return;
+    world.transmit(*this, dest, data);
+    reply("+OK", airtime + SIM_UART_LATENCY_US);
+  });
+}
+
+void SimRadio::receive(uint16_t from, const std::string& data, int rssi, int snr) {
+  stats.rx++;
+  if (world.onReceive) world.onReceive(*this, from, data, rssi, snr);
+  reply("+RCV=" + std::to_string(from) + "," + std::to_string(data.size()) + "," + data + "," +
+        std::to_string(rssi) + "," + std::to_string(snr));
+}
@@ -0,0 +1,234 @@
+/*=====================================================================
+  sim.h - Multi-Node Simulator of the Sketch
+
+  Runs several copies of the real firmware (Roboter_Gruppe_9.ino with
+  all its headers, compiled once per node slot by node_image.cpp)
+  against simulated RYLR896 modules on one virtual clock:
+
+  - SimWorld: event queue (µs) and one fiber per FreeRTOS task of every
+    node (setup() + loop() is the first). delay(), yield(),
+    ulTaskNotifyTake() ... switch to the next event: an hour of
+    firmware runs in seconds, the same seed gives the same run
+  - SimRadio: the UART side of one RYLR896 on the node's LoRaSerial
+    (AT, ADDRESS, NETWORKID, PARAMETER, CRFOP, SEND, RESET, VER, MODE,
+    BAND, IPR), +RCV for received packets, +ERR for bad commands
+  - Channel: time on air from airtime.h, log-distance path loss with
+    shadowing, SNR floor per SF, Gilbert-Elliott burst loss,
+    collisions with capture, half duplex
+
+  Roles come from the pins as on hardware: GPIO16 tied LOW = receiver,
+  tied HIGH = relay, floating = sender. Every board has its own efuse
+  MAC (LORA_SENDER_ADDRESS_AUTO), power-on time and crystal error.
+
+  Not simulated: ESP.restart() and deep sleep halt the node (the sketch
+  globals of a slot cannot be reset), the display station on Serial2.
+=======================================================================*/
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <Arduino.h>
+#include <ucontext.h>
+#include <memory>
+#include <queue>
+#include <random>
+#include <vector>
+#include "airtime.h"
+
+#ifndef SIM_MAX_NODES
+#define SIM_MAX_NODES 4
+#endif
+
+#define SIM_STACK_BYTES (256 * 1024)
+#define SIM_UART_LATENCY_US 2000     // AT command → radio, +RCV → firmware
+#define SIM_MAX_PAYLOAD 240          // RYLR896 AT+SEND limit
+
+// =============== SKETCH IMAGES ================================
+// One compiled copy of the sketch per node slot (node_image.cpp)
+struct SketchImage {
+  void (*setup)();
+  void (*loop)();
+  HardwareSerial* loraSerial;
+};
+
+extern SketchImage simImages[SIM_MAX_NODES];
+bool simRegisterImage(int slot, const SketchImage& image);
+
+// =============== CHANNEL MODEL ================================
+struct SimChannelConfig {
+  float distanceM = 500;
+  float pathLossExp = 2.7f;
+  float shadowingDb = 4;             // Log-normal sigma per packet
+  float burstP = 0;                  // P(good → bad) per packet
+  float burstR = 0.3f;               // P(bad → good) per packet
+  float burstLoss = 0.8f;            // Loss probability in the bad state
+  float captureDb = 6;               // Stronger packet survives a collision
+  float noiseFigureDb = 6;
+};
+
+// Path loss, shadowing and burst state of one pair of radios
+struct SimLink {
+  bool bad = false;
+};
+
+// =============== SIMULATED RYLR896 ================================
+struct SimRadioStats {
+  unsigned long tx = 0;
+  unsigned long rx = 0;
+  unsigned long heard = 0;           // Addressed to us, same SF/BW
+  unsigned long errors = 0;          // +ERR answers
+  unsigned long lostSensitivity = 0;
+  unsigned long lostCollision = 0;
+  unsigned long lostBurst = 0;
+  unsigned long lostHalfDuplex = 0;
+};
+
+class SimWorld;
+struct SimNode;
+
+class SimRadio : public HostUartPeer {
+public:
+  SimRadio(SimWorld& world, SimNode& node);
+
+  void uartReceive(HardwareSerial& from, const uint8_t* data, size_t n) override;
+  void receive(uint16_t from, const std::string& data, int rssi, int snr);
+  bool wasTransmitting(uint64_t start, uint64_t end) const;
+
+  SimWorld& world;
+  SimNode& node;
+  uint16_t address = 0;
+  uint8_t networkId = 0;
+  LoRaParams params = {12, 7, 1, 4};
+  int txPowerDbm = 15;
+  bool sleeping = false;             // AT+MODE=1
+  uint64_t busyUntil = 0;
+  uint64_t airtimeUs = 0;
+  std::deque<std::pair<uint64_t, uint64_t>> txLog;  // Last transmissions (start, end)
+  SimRadioStats stats;
+
+private:
+  std::string line;                  // Command being received
+  size_t dataLeft = 0;               // Binary AT+SEND bytes still to come
+
+  void command(const std::string& cmd);
+  void send(const std::string& arg);
+  void reply(const std::string& text, uint64_t delayUs = SIM_UART_LATENCY_US);
+  void error(int code);
+};
+
+// =============== NODES ================================
+enum SimRole {
+  SIM_SENDER,    // GPIO16 floating
+  SIM_RECEIVER,  // GPIO16 tied LOW
+  SIM_RELAY      // GPIO16 tied HIGH (ENABLE_RELAY)
+};
+
+struct SimFiber {
+  SimNode* node;
+  void (*body)(void*);
+  void* arg;
+  const char* name;
+  ucontext_t ctx;
+  std::vector<char> stack;
+  uint32_t wakeToken = 0;            // Stale wake-ups are ignored
+  uint32_t notifyCount = 0;
+  bool waitingNotify = false;
+};
+
+struct SimNode {
+  int index;
+  std::string name;
+  SimRole role;
+  HostBoard board;
+  const SketchImage* image;
+  std::unique_ptr<SimRadio> radio;
+  bool booted = false;
+  bool halted = false;               // ESP.restart() / deep sleep
+  std::string haltReason;
+};
+
+// =============== WORLD ================================
+struct SimEvent {
+  uint64_t timeUs;
+  uint64_t order;
+  std::function<void()> action;
+  bool operator>(const SimEvent& o) const {
+    return timeUs != o.timeUs ? timeUs > o.timeUs : order > o.order;
+  }
+};
+
+class SimWorld : public HostScheduler {
+public:
+  SimWorld(uint64_t seed, const SimChannelConfig& channel);
+  ~SimWorld() override;
+
+  // Next free image slot; powered on at bootUs with the given crystal error
+  SimNode& addNode(const std::string& name, SimRole role, uint64_t efuseMac,
+                   uint64_t bootUs, int32_t clockPpm);
+  void at(uint64_t timeUs, std::function<void()> action);
+  void runUntil(uint64_t endUs);
+  uint64_t now() const { return hostClockUs; }
+
+  // Channel (SimRadio)
+  void transmit(SimRadio& radio, uint16_t dest, const std::string& payload);
+  // Runs fn with the node's board selected (UART callbacks, millis())
+  void onBoard(SimNode& node, const std::function<void()>& fn);
+
+  // HostScheduler
+  void sleepUs(uint64_t us) override;
+  uint32_t notifyTake(bool clear, uint32_t ms) override;
+  void notifyGive(void* task) override;
+  void* currentTask() override;
+  bool createTask(void (*body)(void*), void* arg, const char* name) override;
+  void deepSleep(uint64_t us) override;
+  void restart() override;
+
+  std::vector<std::unique_ptr<SimNode>> nodes;
+  SimChannelConfig channel;
+  std::mt19937_64 rng;
+  // Every Serial line of every node
+  std::function<void(SimNode& node, const std::string& line)> onConsole;
+  // Every packet a radio puts on the air / hands to its firmware
+  std::function<void(SimRadio& from, uint16_t dest, const std::string& data)> onTransmit;
+  std::function<void(SimRadio& to, uint16_t from, const std::string& data, int rssi, int snr)> onReceive;
+
+private:
+  struct Transmission {
+    uint64_t start;
+    uint64_t end;
+    SimRadio* sender;
+    uint16_t dest;
+    std::string payload;
+    std::vector<std::pair<SimRadio*, float>> rssi;  // At every other radio
+  };
+
+  std::priority_queue<SimEvent, std::vector<SimEvent>, std::greater<SimEvent>> events;
+  uint64_t eventOrder = 0;
+  std::vector<std::unique_ptr<SimFiber>> fibers;
+  SimFiber* current = nullptr;
+  ucontext_t mainCtx;
+  std::vector<std::shared_ptr<Transmission>> onAir;
+  std::map<std::pair<int, int>, SimLink> links;
+  HostScheduler* previousScheduler;
+  HostBoard* previousBoard;
+
+  SimFiber* spawn(SimNode& node, void (*body)(void*), void* arg, const char* name);
+  void resume(SimFiber* fiber);
+  void suspend();
+  void wakeAt(SimFiber* fiber, uint64_t timeUs);
+  uint64_t localToGlobalUs(const SimNode& node, uint64_t us) const;
+  void halt(const std::string& reason);
+  static void fiberEntry();
+  static void nodeMain(void* arg);
+
+  float pathRssi(SimRadio& from, SimRadio& to);
+  bool burstDrop(SimRadio& a, SimRadio& b);
+  bool collided(const Transmission& tx, SimRadio& radio, float rssi) const;
+  void deliver(const std::shared_ptr<Transmission>& tx);
+};
+
+// Address a sender with LORA_SENDER_ADDRESS_AUTO takes (senderAddress()
+// in the sketch) - pick efuse MACs that give distinct ones
+uint8_t simAutoSenderAddress(uint64_t efuseMac);
+
+#endif // SIM_H
@@ -0,0 +1,290 @@
+/*=====================================================================
+  test_at_engine.cpp - AT Engine Against a Scripted Fake UART
+
+  Drives at_engine.h with ScriptedUart (fake_uart.h) on the virtual
+  clock: answers, errors, timeouts, unsolicited +RCV/+READY lines in
+  the middle of an exchange, and late answers of timed-out commands.
+=======================================================================*/
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "at_engine.h"
+#include "fake_uart.h"
+#include "host_test.h"
+
+// =============== HELPERS ================================
+struct Done {
+  ATResult result;
+  std::string response;
+};
+
+static std::vector<Done> done;
+static std::vector<std::string> rcvLines;
+
+static void onDone(ATResult result, const char* response, void* ctx) {
+  (void)ctx;
+  done.push_back({result, response});
+}
+
+static void onRcv(const char* line, uint16_t len) {
+  rcvLines.push_back(std::string(line, len));
+}
+
+static void start(ATEngine& at, ScriptedUart& uart) {
+  hostClockUs = 0;
+  done.clear();
+  rcvLines.clear();
+  atBegin(at, uart, onRcv);
+}
+
+// atPoll() once per virtual millisecond
+static void runFor(ATEngine& at, unsigned long ms) {
+  for (unsigned long i = 0; i < ms; i++) {
+    atPoll(at);
+    hostClockUs += 1000;
+  }
+  atPoll(at);
+}
+
+// =============== TESTS ================================
+static void testAnswers() {
+  ATEngine at;
+  ScriptedUart uart;
+  start(at, uart);
+  uart.expect("AT", "+OK");
+  uart.expect("AT+ADDRESS?", "+ADDRESS=2");
+  uart.expect("AT+NETWORKID=99", "+ERR=4");
+
+  CHECK(atEnqueue(at, "AT", 100, onDone));
+  CHECK(atEnqueue(at, "AT+ADDRESS?", 100, onDone));
+  CHECK(atEnqueue(at, "AT+NETWORKID=99", 100, onDone));
+  runFor(at, 50);
+
+  CHECK(uart.scriptDone());
+  CHECK_EQ(done.size(), 3);
+  CHECK_EQ(done[0].result, AT_RESULT_OK);
+  CHECK_EQ(done[1].result, AT_RESULT_OK);
+  CHECK(done[1].response == "+ADDRESS=2");
+  CHECK_EQ(done[2].result, AT_RESULT_ERROR);
+  CHECK(atIsIdle(at));
+  CHECK_EQ(at.commandsOk, 2);
+  CHECK_EQ(at.commandsError, 1);
+}
+
+static void testOneCommandOnTheWire() {
+  ATEngine at;
+  ScriptedUart uart;
+  start(at, uart);
+  uart.expect("AT", "+OK", 30);
+  uart.expect("AT+PARAMETER?", "+PARAMETER=12,7,1,4", 30);
+
+  atEnqueue(at, "AT", 100, onDone);
+  atEnqueue(at, "AT+PARAMETER?", 100, onDone);
+  runFor(at, 10);
+  CHECK_EQ(uart.written.size(), 1);  // Second waits for the first answer
+  runFor(at, 60);
+  CHECK_EQ(uart.written.size(), 2);
+  CHECK_EQ(done.size(), 2);
+}
+
+static void testRcvDuringCommand() {
+  ATEngine at;
+  ScriptedUart uart;
+  start(at, uart);
+  uart.expect("AT+SEND=1,3,abc", "+OK", 40);
+  uart.inject(10, "+RCV=2,5,HELLO,-40,9");
+  uart.inject(20, "+READY");
+
+  atEnqueue(at, "AT+SEND=1,3,abc", 200, onDone);
+  runFor(at, 30);
+  CHECK_EQ(done.size(), 0);          // Neither line answers AT+SEND
+  CHECK_EQ(rcvLines.size(), 1);
+  CHECK(at.readySeen);
+  runFor(at, 30);
+  CHECK_EQ(done.size(), 1);
+  CHECK_EQ(done[0].result, AT_RESULT_OK);
+}
+
+static void testRcvDataWithLineBreaks() {
+  ATEngine at;
+  ScriptedUart uart;
+  start(at, uart);
+  // 7 data bytes: "a,\r\nb,c" - commas and CR/LF inside the field
+  uart.inject(0, std::string("+RCV=3,7,a,\r\nb,c,-71,-2"));
+  runFor(at, 5);
+
+  CHECK_EQ(rcvLines.size(), 1);
+  RcvView view;
+  CHECK(!rcvLines.empty() && parseRcvLine(rcvLines[0].c_str(), rcvLines[0].size(), view));
+  CHECK_EQ(view.sender, 3);
+  CHECK_EQ(view.len, 7);
+  CHECK(memcmp(view.data, "a,\r\nb,c", 7) == 0);
+  CHECK_EQ(view.rssi, -71);
+  CHECK_EQ(view.snr, -2);
+}
+
+static void testTimeout() {
+  ATEngine at;
+  ScriptedUart uart;
+  start(at, uart);
+  uart.expect("AT", "");
+
+  atEnqueue(at, "AT", 100, onDone);
+  runFor(at, 99);
+  CHECK_EQ(done.size(), 0);
+  runFor(at, 2);
+  CHECK_EQ(done.size(), 1);
+  CHECK_EQ(done[0].result, AT_RESULT_TIMEOUT);
+  CHECK(done[0].response.empty());
+  CHECK_EQ(at.commandsTimeout, 1);
+}
+
+// A late "+OK" of a timed-out AT+SEND must not answer AT+ADDRESS?
+// (link_recovery.h would read it as an address mismatch, and every
+// later answer would be off by one)
+static void testLateOkDoesNotAnswerQuery() {
+  ATEngine at;
+  ScriptedUart uart;
+  start(at, uart);
+  uart.expect("AT+SEND=1,3,abc", "+OK", 110);   // Answered 10 ms too late
+  uart.expect("AT+ADDRESS?", "+ADDRESS=2", 20);
+  uart.expect("AT+NETWORKID?", "+NETWORKID=18", 20);
+
+  atEnqueue(at, "AT+SEND=1,3,abc", 100, onDone);
+  atEnqueue(at, "AT+ADDRESS?", 100, onDone);
+  atEnqueue(at, "AT+NETWORKID?", 100, onDone);
+  runFor(at, 1000);
+
+  CHECK(uart.scriptDone());
+  CHECK_EQ(done.size(), 3);
+  CHECK_EQ(done[0].result, AT_RESULT_TIMEOUT);
+  CHECK(done[1].response == "+ADDRESS=2");
+  CHECK(done[2].response == "+NETWORKID=18");
+  CHECK_EQ(at.strayLines, 1);
+}
+
+// Same with a next command that also answers "+OK": the drain period
+// keeps it off the wire until the late answer is in
+static void testDrainAfterTimeout() {
+  ATEngine at;
+  ScriptedUart uart;
+  start(at, uart);
+  uart.expect("AT+SEND=1,3,abc", "+OK", 150);
+  uart.expect("AT+SEND=1,3,def", "", 0);         // Its own answer comes below
+
+  atEnqueue(at, "AT+SEND=1,3,abc", 100, onDone);
+  atEnqueue(at, "AT+SEND=1,3,def", 500, onDone);
+  runFor(at, 120);
+  CHECK_EQ(done.size(), 1);
+  CHECK_EQ(uart.written.size(), 1);              // Draining, not sent yet
+
+  runFor(at, 40);                                // Late +OK at 150 ms
+  CHECK_EQ(at.strayLines, 1);
+  CHECK_EQ(uart.written.size(), 2);              // Drain ended by the late answer
+  CHECK_EQ(done.size(), 1);
+
+  uart.inject(millis() + 80, "+OK");
+  runFor(at, 100);
+  CHECK_EQ(done.size(), 2);
+  CHECK_EQ(done[1].result, AT_RESULT_OK);
+}
+
+// No late answer at all: the drain ends after AT_DRAIN_MS
+static void testDrainExpires() {
+  ATEngine at;
+  ScriptedUart uart;
+  start(at, uart);
+  uart.expect("AT", "");
+  uart.expect("AT+VER?", "+VER=RYLR89C_V1.2.7");
+
+  atEnqueue(at, "AT", 100, onDone);
+  atEnqueue(at, "AT+VER?", 100, onDone);
+  runFor(at, 100 + AT_DRAIN_MS - 5);
+  CHECK_EQ(uart.written.size(), 1);
+  runFor(at, 40);
+  CHECK(uart.scriptDone());
+  CHECK_EQ(done.size(), 2);
+  CHECK_EQ(done[1].result, AT_RESULT_OK);
+}
+
+static void testResetAndReady() {
+  ATEngine at;
+  ScriptedUart uart;
+  start(at, uart);
+  uart.expect("AT+RESET", "+RESET", 10);
+  uart.inject(60, "+READY");
+
+  atEnqueue(at, "AT+RESET", 100, onDone);
+  runFor(at, 20);
+  CHECK_EQ(done.size(), 1);
+  CHECK_EQ(done[0].result, AT_RESULT_OK);
+  CHECK(!at.readySeen);
+  runFor(at, 50);
+  CHECK(at.readySeen);
+}
+
+static void testQueueFull() {
+  ATEngine at;
+  ScriptedUart uart;
+  start(at, uart);
+  for (int i = 0; i < AT_QUEUE_SIZE; i++) CHECK(atEnqueue(at, "AT", 100, onDone));
+  CHECK(!atEnqueue(at, "AT", 100, onDone));
+  CHECK_EQ(at.queueFull, 1);
+
+  atReset(at);
+  CHECK_EQ(done.size(), AT_QUEUE_SIZE);
+  CHECK_EQ(done[0].result, AT_RESULT_DROPPED);
+  CHECK(atIsIdle(at));
+}
+
+static ATEngine* followUpEngine;
+static void onFirstDone(ATResult result, const char* response, void* ctx) {
+  onDone(result, response, ctx);
+  CHECK(atEnqueue(*followUpEngine, "AT+CRFOP?", 100, onDone));
+}
+
+static void testEnqueueFromCallback() {
+  ATEngine at;
+  ScriptedUart uart;
+  start(at, uart);
+  followUpEngine = &at;
+  uart.expect("AT", "+OK");
+  uart.expect("AT+CRFOP?", "+CRFOP=15");
+
+  atEnqueue(at, "AT", 100, onFirstDone);
+  runFor(at, 30);
+  CHECK(uart.scriptDone());
+  CHECK_EQ(done.size(), 2);
+  CHECK(done.size() == 2 && done[1].response == "+CRFOP=15");
+}
+
+static void testOverlongLineDropped() {
+  ATEngine at;
+  ScriptedUart uart;
+  start(at, uart);
+  uart.expect("AT", "+OK", 20);
+  uart.inject(5, std::string(AT_LINE_MAX + 10, 'x'));
+
+  atEnqueue(at, "AT", 100, onDone);
+  runFor(at, 30);
+  CHECK_EQ(at.linesOverflowed, 1);
+  CHECK_EQ(done.size(), 1);
+  CHECK_EQ(done[0].result, AT_RESULT_OK);
+}
+
+int main() {
+  RUN(testAnswers);
+  RUN(testOneCommandOnTheWire);
+  RUN(testRcvDuringCommand);
+  RUN(testRcvDataWithLineBreaks);
+  RUN(testTimeout);
+  RUN(testLateOkDoesNotAnswerQuery);
+  RUN(testDrainAfterTimeout);
+  RUN(testDrainExpires);
+  RUN(testResetAndReady);
+  RUN(testQueueFull);
+  RUN(testEnqueueFromCallback);
+  RUN(testOverlongLineDropped);
+  return hostTestExit();
+}
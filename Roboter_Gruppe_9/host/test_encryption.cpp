@@ -0,0 +1,257 @@
+/*=====================================================================
+  test_encryption.cpp - AES-128-CCM Envelope (encryption.h)
+
+  The host build has no ARDUINO_ARCH_ESP32, so this runs the software
+  AES-128 fallback through the same CCM code the firmware uses:
+
+  - AES-128 against FIPS-197, CCM against NIST SP 800-38C examples 1-3
+    (encSelfTest() is example 1)
+  - encSeal() → encOpen() for every frame length up to 200 bytes
+  - Replays, frames older than the window, out-of-order frames inside it
+  - Every flipped bit (header, ciphertext, tag), wrong sender, wrong
+    key, plain frames: rejected, nothing handed out
+  - Counter blocks in NVS: one write per ENC_COUNTER_BLOCK frames, a
+    reboot continues above the last reservation
+=======================================================================*/
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "encryption.h"
+#include "host_test.h"
+
+static const uint8_t testKey[ENC_KEY_LEN] = ENCRYPTION_KEY;
+
+static HostBoard senderBoard;
+static HostBoard receiverBoard;
+
+static uint32_t rngState = 4711;
+static uint8_t rnd() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return (uint8_t)rngState;
+}
+
+static void fromHex(const char* hex, uint8_t* out) {
+  for (size_t i = 0; hex[2 * i]; i++) {
+    unsigned v;
+    sscanf(hex + 2 * i, "%2x", &v);
+    out[i] = (uint8_t)v;
+  }
+}
+
+// Sender (address 2) and receiver (address 1), each with its own NVS
+static void initPair(EncContext& tx, EncContext& rx) {
+  hostBoard = &senderBoard;
+  CHECK(encInit(tx, testKey, 2, LORA_NETWORK_ID));
+  hostBoard = &receiverBoard;
+  CHECK(encInit(rx, testKey, 1, LORA_NETWORK_ID));
+}
+
+// Frame buffer: [header][plain][tag]
+struct Sealed {
+  uint8_t frame[256];
+  uint8_t len;
+};
+
+static Sealed seal(EncContext& tx, const uint8_t* plain, uint8_t len) {
+  Sealed s;
+  uint8_t header = encHeaderLength(tx);
+  memcpy(s.frame + header, plain, len);
+  s.len = encSeal(tx, s.frame, len);
+  return s;
+}
+
+static bool open(EncContext& rx, Sealed s, uint16_t sender, const uint8_t* plain, uint8_t len) {
+  uint8_t plainLen = 0;
+  uint8_t offset = encOpen(rx, s.frame, s.len, sender, millis(), plainLen);
+  if (!offset) return false;
+  CHECK_EQ(plainLen, len);
+  CHECK(memcmp(s.frame + offset, plain, len) == 0);
+  return true;
+}
+
+// =============== KNOWN ANSWERS ================================
+static void testAesFips197() {
+  uint8_t key[16], in[16], expected[16], out[16];
+  fromHex("000102030405060708090a0b0c0d0e0f", key);
+  fromHex("00112233445566778899aabbccddeeff", in);
+  fromHex("69c4e0d86a7b0430d8cdb78070b4c55a", expected);
+  EncAes aes;
+  encAesInit(aes, key);
+  encAesBlock(aes, in, out);
+  CHECK(memcmp(out, expected, 16) == 0);
+  encAesBlock(aes, in, in);  // In place
+  CHECK(memcmp(in, expected, 16) == 0);
+}
+
+static void testSelfTest() {
+  CHECK(encSelfTest());
+}
+
+// SP 800-38C C.2 / C.3: other nonce, AAD and tag lengths than ours
+static void testCcmExamples() {
+  const struct {
+    uint8_t nonceLen, aadLen, msgLen, tagLen;
+    const char* expected;
+  } examples[] = {
+    {8, 16, 16, 6, "d2a1f0e051ea5f62081a7792073d593d1fc64fbfaccd"},
+    {12, 20, 24, 8, "e3b201a9f5b71a7a9b1ceaeccd97e70b6176aad9a4428aa5484392fbc1b09951"},
+  };
+  uint8_t key[16];
+  fromHex("404142434445464748494a4b4c4d4e4f", key);
+  EncAes aes;
+  encAesInit(aes, key);
+  for (const auto& ex : examples) {
+    uint8_t nonce[16], aad[32], data[64], expected[64];
+    for (uint8_t i = 0; i < ex.nonceLen; i++) nonce[i] = 0x10 + i;
+    for (uint8_t i = 0; i < ex.aadLen; i++) aad[i] = i;
+    for (uint8_t i = 0; i < ex.msgLen; i++) data[i] = 0x20 + i;
+    fromHex(ex.expected, expected);
+
+    encCcmSeal(aes, nonce, ex.nonceLen, aad, ex.aadLen, data, ex.msgLen,
+               data + ex.msgLen, ex.tagLen);
+    CHECK(memcmp(data, expected, ex.msgLen + ex.tagLen) == 0);
+    CHECK(encCcmOpen(aes, nonce, ex.nonceLen, aad, ex.aadLen, data, ex.msgLen, data + ex.msgLen,
+                     ex.tagLen));
+    CHECK_EQ(data[0], 0x20);
+    CHECK_EQ(data[ex.msgLen - 1], 0x20 + ex.msgLen - 1);
+  }
+}
+
+// =============== ENVELOPE ================================
+static void testRoundTripAllLengths() {
+  EncContext tx, rx;
+  initPair(tx, rx);
+  for (uint16_t len = 0; len <= 200; len++) {
+    uint8_t plain[200];
+    for (uint16_t i = 0; i < len; i++) plain[i] = rnd();
+    uint8_t header = encHeaderLength(tx);
+    Sealed s = seal(tx, plain, (uint8_t)len);
+    CHECK_EQ(s.len, header + len + ENC_TAG_LEN);
+    CHECK_EQ(s.frame[0], FRAME_TYPE_SECURE);
+    if (len >= 8) CHECK(memcmp(s.frame + header, plain, len) != 0);  // Encrypted
+    CHECK(open(rx, s, 2, plain, (uint8_t)len));
+  }
+  CHECK_EQ(tx.stats.messagesEncrypted, 201);
+  CHECK_EQ(rx.stats.messagesDecrypted, 201);
+  CHECK_EQ(rx.stats.authFailures, 0);
+}
+
+static void testReplay() {
+  EncContext tx, rx;
+  initPair(tx, rx);
+  const uint8_t plain[5] = {0x81, 0x05, 0x01, 0x02, 0x03};
+  Sealed frames[40];
+  for (Sealed& f : frames) f = seal(tx, plain, sizeof(plain));
+
+  CHECK(open(rx, frames[0], 2, plain, sizeof(plain)));
+  CHECK(!open(rx, frames[0], 2, plain, sizeof(plain)));        // Same frame again
+  CHECK_EQ(rx.stats.replays, 1);
+
+  CHECK(open(rx, frames[35], 2, plain, sizeof(plain)));        // Jump ahead
+  CHECK(open(rx, frames[10], 2, plain, sizeof(plain)));        // 25 behind: inside the window
+  CHECK(!open(rx, frames[10], 2, plain, sizeof(plain)));
+  CHECK(!open(rx, frames[3], 2, plain, sizeof(plain)));        // 32 behind: too old
+  CHECK(!open(rx, frames[0], 2, plain, sizeof(plain)));
+  CHECK_EQ(rx.stats.replays, 4);
+  CHECK(open(rx, frames[36], 2, plain, sizeof(plain)));
+
+  // Another sender has its own window (and its own nonces)
+  EncContext other;
+  hostBoard = &senderBoard;
+  encInit(other, testKey, 7, LORA_NETWORK_ID);
+  Sealed o = seal(other, plain, sizeof(plain));
+  CHECK(open(rx, o, 7, plain, sizeof(plain)));
+  CHECK_EQ(rx.stats.authFailures, 0);
+
+  // Receiver reboot: window gone, the next authentic frame sets it again
+  hostBoard = &receiverBoard;
+  encInit(rx, testKey, 1, LORA_NETWORK_ID);
+  CHECK(open(rx, frames[37], 2, plain, sizeof(plain)));
+  CHECK(!open(rx, frames[37], 2, plain, sizeof(plain)));
+}
+
+static void testTampering() {
+  EncContext tx, rx;
+  initPair(tx, rx);
+  const uint8_t plain[12] = {0x81, 0x0B, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  Sealed good = seal(tx, plain, sizeof(plain));
+
+  unsigned long flips = 0;
+  for (uint8_t i = 0; i < good.len; i++) {
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      Sealed bad = good;
+      bad.frame[i] ^= (uint8_t)(1 << bit);
+      uint8_t plainLen = 0;
+      CHECK_EQ(encOpen(rx, bad.frame, bad.len, 2, millis(), plainLen), 0);
+      flips++;
+    }
+  }
+  // Type byte flips are "plain", everything else fails the tag or the varint
+  CHECK_EQ(rx.stats.plainDropped + rx.stats.authFailures, flips);
+  CHECK_EQ(rx.stats.messagesDecrypted, 0);
+
+  // Truncated frames
+  for (uint8_t len = 0; len < good.len; len++) {
+    Sealed cut = good;
+    uint8_t plainLen = 0;
+    CHECK_EQ(encOpen(rx, cut.frame, len, 2, millis(), plainLen), 0);
+  }
+
+  // Wrong sender address (nonce) and wrong key
+  CHECK(!open(rx, good, 3, plain, sizeof(plain)));
+  EncContext wrongKey;
+  uint8_t otherKey[ENC_KEY_LEN];
+  memcpy(otherKey, testKey, ENC_KEY_LEN);
+  otherKey[15] ^= 0x80;
+  encInit(wrongKey, otherKey, 1, LORA_NETWORK_ID);
+  CHECK(!open(wrongKey, good, 2, plain, sizeof(plain)));
+  CHECK_EQ(wrongKey.stats.authFailures, 1);
+
+  // A rejected frame does not poison the window: the genuine one still opens
+  CHECK(open(rx, good, 2, plain, sizeof(plain)));
+}
+
+static void testPlainDropped() {
+  EncContext tx, rx;
+  initPair(tx, rx);
+  uint8_t plain[5] = {0x81, 0x05, 0x01, 0x02, 0x03};
+  uint8_t plainLen = 0;
+  CHECK_EQ(encOpen(rx, plain, sizeof(plain), 2, millis(), plainLen), 0);
+  CHECK_EQ(rx.stats.plainDropped, 1);
+}
+
+// =============== COUNTER RESERVATION ================================
+static void testCounterBlocks() {
+  senderBoard.nvs.clear();
+  hostBoard = &senderBoard;
+  unsigned long writesBefore = Preferences::writes;
+  EncContext tx;
+  CHECK(encInit(tx, testKey, 2, LORA_NETWORK_ID));
+  CHECK_EQ(tx.txReserved, ENC_COUNTER_BLOCK);
+  const uint8_t plain[3] = {1, 2, 3};
+  for (uint32_t i = 0; i < ENC_COUNTER_BLOCK + 10; i++) seal(tx, plain, sizeof(plain));
+  CHECK_EQ(Preferences::writes - writesBefore, 2);  // Boot + one block
+  CHECK_EQ(tx.txCounter, ENC_COUNTER_BLOCK + 10);
+
+  // Reboot: continues above the reservation, never reuses a nonce
+  EncContext again;
+  CHECK(encInit(again, testKey, 2, LORA_NETWORK_ID));
+  CHECK_EQ(again.txCounter, 2 * ENC_COUNTER_BLOCK);
+  CHECK(again.txCounter > tx.txCounter);
+}
+
+int main() {
+  hostBoardInit(senderBoard, "sender", 0x0000A1B2C3D4E502ULL);
+  hostBoardInit(receiverBoard, "receiver", 0x0000A1B2C3D4E501ULL);
+  RUN(testAesFips197);
+  RUN(testSelfTest);
+  RUN(testCcmExamples);
+  RUN(testRoundTripAllLengths);
+  RUN(testReplay);
+  RUN(testTampering);
+  RUN(testPlainDropped);
+  RUN(testCounterBlocks);
+  return hostTestExit();
+}
@@ -0,0 +1,327 @@
+/*=====================================================================
+  test_reliable_link.cpp - Reliable Link Over a Lossy Channel
+
+  ReliableSender and ReliableReceiver (reliable_link.h) connected by a
+  channel that drops data frames and bitmap ACKs independently, with
+  a uniform or bursty (Gilbert-Elliott) loss model. Frames go through
+  relEncode()/relEncodeAck()/decodeRelAck() as on the radio.
+
+  Checked on every run:
+  - The receiver acts on each message at most once (no duplicates
+    reach the application, also across the 8 bit seq wrap)
+  - Every message the sender counts as delivered really arrived
+  - Messages that are not given up arrive; the given-up share stays
+    within what REL_MAX_TRIES allows at that loss
+  - relOnAck() turns bitmap holes into gaps, which are resent first
+
+  Usage: test_reliable_link [messages] [seed]   (default 20000, 1)
+=======================================================================*/
+
+#include <Arduino.h>
+#include <vector>
+#include "reliable_link.h"
+#include "host_test.h"
+
+// =============== CHANNEL ================================
+static uint64_t rngState;
+
+static uint32_t rnd() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 7;
+  rngState ^= rngState << 17;
+  return (uint32_t)rngState;
+}
+
+static bool chance(float p) { return rnd() % 1000000 < (uint32_t)(p * 1000000); }
+
+// Gilbert-Elliott: loss rate in the good and bad state, mean burst
+// length in frames (burst 1 = independent losses)
+struct LossModel {
+  float loss;
+  float burst;
+  bool bad;
+};
+
+static bool lost(LossModel& m) {
+  if (m.burst <= 1) return chance(m.loss);
+  // Stay bad for `burst` frames on average, enter it often enough that
+  // the long-run loss rate is `loss`
+  float leave = 1.0f / m.burst;
+  float enter = m.loss * leave / (1.0f - m.loss);
+  if (m.bad ? chance(leave) : chance(enter)) m.bad = !m.bad;
+  return m.bad;
+}
+
+// =============== SIMULATION ================================
+#define STEP_MS 2000UL             // One uplink opportunity
+
+struct RunResult {
+  uint32_t queued;
+  uint32_t arrived;                // Distinct messages acted on
+  uint32_t duplicateDeliveries;    // Acted on twice - must stay 0
+  uint32_t falseConfirms;          // Sender "delivered", receiver never saw it
+  uint32_t failed;
+  uint32_t failedArrived;          // Given up, but arrived (all ACKs lost)
+  uint32_t frames;
+};
+
+static uint32_t messageCount = 20000;
+
+static RunResult runLink(float loss, float burst) {
+  ReliableSender tx;
+  ReliableReceiver rx;
+  relSenderInit(tx, 0x5A);
+  relReceiverInit(rx);
+  LossModel up = {loss, burst, false};
+  LossModel down = {loss, burst, false};
+  hostClockUs = 0;
+
+  std::vector<uint8_t> seen(messageCount, 0);       // Deliveries per message id
+  std::vector<uint8_t> confirmed(messageCount, 0);
+  RunResult r = {};
+  uint32_t nextId = 0;
+  unsigned long delivered = 0;
+
+  while (nextId < messageCount || !relIdle(tx)) {
+    // Alerts and commands arrive faster than one per opportunity
+    while (nextId < messageCount && (rnd() % 3) != 0) {
+      uint8_t payload[5] = {(uint8_t)nextId, (uint8_t)(nextId >> 8),
+                            (uint8_t)(nextId >> 16), (uint8_t)(nextId >> 24), 0};
+      uint8_t kind = (rnd() & 1) ? REL_KIND_ALERT : REL_KIND_COMMAND;
+      if (!relQueue(tx, kind, payload, sizeof(payload))) break;  // Ring full
+      nextId++;
+      r.queued++;
+    }
+
+    RelEntry* e = relNextToSend(tx, REL_RETRY_MS);
+    if (e) {
+      uint8_t frame[REL_FRAME_MAX];
+      uint8_t length = relEncode(tx, *e, frame);
+      relMarkSent(tx, *e);
+      uint32_t id = e->data[0] | (e->data[1] << 8) | (e->data[2] << 16) | ((uint32_t)e->data[3] << 24);
+      r.frames++;
+
+      if (!lost(up)) {
+        CHECK(isReliableFrame((const char*)frame, length));
+        if (relAccept(rx, frame[1], frame[2])) {
+          const uint8_t* p = frame + REL_HEADER_LEN;
+          uint32_t got = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+          CHECK_EQ(got, id);
+          if (seen[got]++) r.duplicateDeliveries++;
+        }
+
+        // Bitmap ACK in the ACK slot (also for duplicates: re-ACK)
+        uint8_t ack[REL_ACK_LEN];
+        uint8_t ackLength = relEncodeAck(rx, ack);
+        if (!lost(down)) {
+          uint8_t session, top;
+          uint32_t bitmap;
+          CHECK(decodeRelAck((const char*)ack, ackLength, session, top, bitmap));
+          if (session == tx.session) {
+            // Remember which ids this ACK confirms
+            for (uint8_t i = 0; i < tx.count; i++) {
+              RelEntry& c = relEntry(tx, i);
+              uint8_t age = top - c.seq;
+              if (!c.done && c.tries > 0 && age < REL_HISTORY && (bitmap & ((uint32_t)1 << age))) {
+                confirmed[c.data[0] | (c.data[1] << 8) | (c.data[2] << 16) | ((uint32_t)c.data[3] << 24)] = 1;
+              }
+            }
+            relOnAck(tx, top, bitmap);
+          }
+        }
+      }
+    }
+    hostClockUs += STEP_MS * 1000;
+  }
+
+  for (uint32_t id = 0; id < messageCount; id++) {
+    if (seen[id]) r.arrived++;
+    if (confirmed[id] && !seen[id]) r.falseConfirms++;
+    delivered += confirmed[id];
+  }
+  r.failed = tx.failed;
+  for (uint32_t id = 0; id < messageCount; id++) {
+    if (seen[id] && !confirmed[id]) r.failedArrived++;
+  }
+  CHECK_EQ(tx.delivered, delivered);
+  CHECK_EQ(tx.delivered + tx.failed, tx.queued);
+  CHECK_EQ(tx.rejected > 0, true);  // The ring did fill up (flow control exercised)
+  return r;
+}
+
+static void report(const char* name, float loss, const RunResult& r) {
+  printf("  %-8s loss %2.0f%%: %u msgs, %.2f frames/msg, %u failed (%u of them arrived)\n",
+         name, loss * 100, r.queued, (double)r.frames / r.queued, r.failed, r.failedArrived);
+}
+
+// Invariants at any loss; `maxFailed` is the given-up share allowed
+static void checkRun(const char* name, float loss, float burst, float maxFailed) {
+  RunResult r = runLink(loss, burst);
+  report(name, loss, r);
+  CHECK_EQ(r.queued, messageCount);
+  CHECK_EQ(r.duplicateDeliveries, 0);
+  CHECK_EQ(r.falseConfirms, 0);
+  CHECK_EQ(r.arrived + (r.failed - r.failedArrived), r.queued);  // Lost only if given up
+  CHECK(r.failed <= (uint32_t)(maxFailed * r.queued) + 1);
+}
+
+// =============== LOSSY LINK ================================
+static void testLossless() {
+  RunResult r = runLink(0, 1);
+  CHECK_EQ(r.arrived, messageCount);
+  CHECK_EQ(r.failed, 0);
+  CHECK_EQ(r.frames, messageCount);  // Not a single resend
+}
+
+// A message is given up when all REL_MAX_TRIES sends or their ACKs
+// are lost: (1 - (1-p)^2)^6 per message, with a factor 3 of slack
+static void testUniformLoss() {
+  checkRun("uniform", 0.10f, 1, 3 * 4.7e-5f);
+  checkRun("uniform", 0.30f, 1, 3 * 0.0176f);
+  checkRun("uniform", 0.50f, 1, 3 * 0.178f);
+}
+
+// Bursts wipe out several tries in a row; only the invariants and a
+// loose bound hold
+static void testBurstLoss() {
+  checkRun("burst", 0.20f, 8, 0.05f);
+  checkRun("burst", 0.40f, 20, 0.40f);
+}
+
+// =============== relOnAck GAP HANDLING ================================
+static void sendAll(ReliableSender& tx, uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    RelEntry* e = relNextToSend(tx, REL_RETRY_MS);
+    CHECK(e != nullptr);
+    if (e) relMarkSent(tx, *e);
+  }
+}
+
+// 0, 1, 2 sent, 1 lost: the ACK confirms 0 and 2, 1 is resent at once
+// (before the retry timeout and before newer messages)
+static void testGapResentFirst() {
+  ReliableSender tx;
+  relSenderInit(tx, 1);
+  hostClockUs = 0;
+  uint8_t payload[1] = {0};
+  for (int i = 0; i < 4; i++) relQueue(tx, REL_KIND_COMMAND, payload, 1);
+  sendAll(tx, 3);
+
+  relOnAck(tx, 2, 0b101);
+  CHECK_EQ(tx.delivered, 2);
+  CHECK_EQ(tx.count, 3);        // 0 compacted away, 1 and 3 pending, 2 done
+  RelEntry* e = relNextToSend(tx, REL_RETRY_MS);
+  CHECK(e && e->seq == 1 && e->gap);
+  relMarkSent(tx, *e);
+  CHECK_EQ(tx.retransmits, 1);
+
+  e = relNextToSend(tx, REL_RETRY_MS);
+  CHECK(e && e->seq == 3);      // Then the new one
+}
+
+// An alert gap goes before a command gap
+static void testAlertGapBeforeCommandGap() {
+  ReliableSender tx;
+  relSenderInit(tx, 1);
+  hostClockUs = 0;
+  uint8_t payload[1] = {0};
+  relQueue(tx, REL_KIND_COMMAND, payload, 1);  // seq 0
+  relQueue(tx, REL_KIND_ALERT, payload, 1);    // seq 1 - sent first
+  relQueue(tx, REL_KIND_COMMAND, payload, 1);  // seq 2
+  sendAll(tx, 3);
+
+  relOnAck(tx, 2, 0b100);       // Only 2 arrived
+  RelEntry* e = relNextToSend(tx, REL_RETRY_MS);
+  CHECK(e && e->seq == 1);
+}
+
+// The ACK of frame 0 is lost, a later bitmap confirms it: no resend
+static void testLostAckConfirmedLater() {
+  ReliableSender tx;
+  ReliableReceiver rx;
+  relSenderInit(tx, 7);
+  relReceiverInit(rx);
+  hostClockUs = 0;
+  uint8_t payload[1] = {0};
+  relQueue(tx, REL_KIND_ALERT, payload, 1);
+  relQueue(tx, REL_KIND_ALERT, payload, 1);
+
+  sendAll(tx, 1);
+  CHECK(relAccept(rx, 7, 0));   // Its ACK never reaches the sender
+  hostClockUs += 1000000;
+  sendAll(tx, 1);
+  CHECK(relAccept(rx, 7, 1));
+  uint8_t ack[REL_ACK_LEN];
+  uint8_t session, top;
+  uint32_t bitmap;
+  CHECK(decodeRelAck((const char*)ack, relEncodeAck(rx, ack), session, top, bitmap));
+  relOnAck(tx, top, bitmap);
+
+  CHECK_EQ(tx.delivered, 2);
+  CHECK_EQ(tx.retransmits, 0);
+  CHECK(relIdle(tx));
+}
+
+// An ACK whose top is older than a sent frame says nothing about it
+static void testAckOlderThanFrame() {
+  ReliableSender tx;
+  relSenderInit(tx, 1);
+  hostClockUs = 0;
+  uint8_t payload[1] = {0};
+  relQueue(tx, REL_KIND_COMMAND, payload, 1);
+  relQueue(tx, REL_KIND_COMMAND, payload, 1);
+  sendAll(tx, 2);
+
+  relOnAck(tx, 0, 0b1);
+  CHECK_EQ(tx.delivered, 1);
+  RelEntry* e = relFind(tx, 1);
+  CHECK(e && !e->gap);          // Not a gap - still in flight
+  CHECK(relNextToSend(tx, REL_RETRY_MS) == nullptr);
+}
+
+// Without any answer a message is given up after REL_MAX_TRIES
+static void testGivenUpAfterMaxTries() {
+  ReliableSender tx;
+  relSenderInit(tx, 1);
+  hostClockUs = 0;
+  uint8_t payload[1] = {0};
+  relQueue(tx, REL_KIND_ALERT, payload, 1);
+  for (int i = 0; i < REL_MAX_TRIES; i++) {
+    RelEntry* e = relNextToSend(tx, REL_RETRY_MS);
+    CHECK(e != nullptr);
+    if (e) relMarkSent(tx, *e);
+    CHECK(relNextToSend(tx, REL_RETRY_MS) == nullptr);  // Waits for the retry
+    hostClockUs += REL_RETRY_MS * 1000ULL;
+  }
+  CHECK(relNextToSend(tx, REL_RETRY_MS) == nullptr);
+  CHECK_EQ(tx.failed, 1);
+  CHECK(relIdle(tx));
+}
+
+// A rebooted sender (new session, seq 0 again) is not a duplicate
+static void testSessionRestart() {
+  ReliableReceiver rx;
+  relReceiverInit(rx);
+  for (uint8_t seq = 0; seq < 5; seq++) CHECK(relAccept(rx, 1, seq));
+  CHECK(!relAccept(rx, 1, 0));
+  CHECK(relAccept(rx, 2, 0));
+  CHECK(!relAccept(rx, 2, 0));
+  CHECK_EQ(rx.duplicates, 2);
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) messageCount = strtoul(argv[1], nullptr, 10);
+  rngState = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1;
+  if (rngState == 0) rngState = 1;
+
+  RUN(testLossless);
+  RUN(testUniformLoss);
+  RUN(testBurstLoss);
+  RUN(testGapResentFirst);
+  RUN(testAlertGapBeforeCommandGap);
+  RUN(testLostAckConfirmedLater);
+  RUN(testAckOlderThanFrame);
+  RUN(testGivenUpAfterMaxTries);
+  RUN(testSessionRestart);
+  return hostTestExit();
+}
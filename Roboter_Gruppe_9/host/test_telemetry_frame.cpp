@@ -0,0 +1,230 @@
+/*=====================================================================
+  test_telemetry_frame.cpp - Telemetry Frame Round Trips
+
+  encodeTelemetryFrame() → decodeTelemetry() for the binary frame with
+  every combination of the optional fields (link report, keepalive,
+  slot, TDMA), random values at the field limits, truncated frames, and
+  the legacy ASCII payloads of older firmware.
+=======================================================================*/
+
+#include <Arduino.h>
+#include "telemetry_frame.h"
+#include "host_test.h"
+
+static uint32_t rngState = 12345;
+static uint32_t rnd() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+struct Sample {
+  uint8_t type;
+  uint32_t seq;
+  bool led;
+  bool touch;
+  uint8_t spinner;
+  uint32_t count;
+  bool ackRequest;
+  uint16_t slotOffset;
+  bool tdma;
+  int16_t tdmaShift;
+  bool link;
+  int16_t linkRssi;
+  int8_t linkSnr;
+  uint16_t keepaliveS;
+};
+
+static uint8_t encode(const Sample& s, uint8_t* out) {
+  return encodeTelemetryFrame(out, s.type, s.seq, s.led, s.touch, s.spinner, s.count,
+                              s.ackRequest, s.slotOffset, s.tdma, s.tdmaShift,
+                              s.link, s.linkRssi, s.linkSnr, s.keepaliveS);
+}
+
+// Decoded frame must carry exactly what the encoder was allowed to write
+static void checkRoundTrip(const Sample& s) {
+  uint8_t buf[TELEMETRY_FRAME_MAX + 8];
+  memset(buf, 0xEE, sizeof(buf));
+  uint8_t n = encode(s, buf);
+  CHECK(n <= TELEMETRY_FRAME_MAX);
+  CHECK_EQ(buf[n], 0xEE);                       // Nothing written past n
+
+  TelemetryFrame f = {};
+  bool ok = decodeTelemetry((const char*)buf, n, f);
+  CHECK(ok);
+  if (!ok) return;
+
+  bool ack = s.type == FRAME_TYPE_ACK;
+  bool link = ack && s.link;
+  bool slot = ack && (s.slotOffset > 0 || s.tdma);
+  CHECK_EQ(f.type, s.type);
+  CHECK(!f.legacy);
+  CHECK_EQ(f.seq, s.seq);
+  CHECK_EQ(f.count, s.count);
+  CHECK_EQ(f.led, s.led);
+  CHECK_EQ(f.touch, s.touch);
+  CHECK_EQ(f.spinner, s.spinner & 3);
+  CHECK_EQ(f.ackRequest, s.ackRequest);
+  CHECK_EQ(f.fields & FIELD_ALL, FIELD_ALL);
+  CHECK_EQ((f.fields & FIELD_LINK) != 0, link);
+  CHECK_EQ((f.fields & FIELD_SLOT) != 0, slot);
+  CHECK_EQ((f.fields & FIELD_TDMA) != 0, ack && s.tdma);
+  CHECK_EQ(f.linkRssi, link ? s.linkRssi : 0);
+  CHECK_EQ(f.linkSnr, link ? s.linkSnr : 0);
+  CHECK_EQ(f.slotOffset, slot ? s.slotOffset : 0);
+  CHECK_EQ(f.tdmaShift, ack && s.tdma ? s.tdmaShift : 0);
+  CHECK_EQ(f.keepaliveS, ack ? 0 : s.keepaliveS);
+
+  // Every shorter prefix is rejected or, for an ACK, read without the
+  // optional tail (slot/TDMA are recognised by length)
+  for (uint8_t k = 0; k < n; k++) {
+    TelemetryFrame t = {};
+    if (decodeTelemetryFrame(buf, k, t)) {
+      CHECK(ack);
+      CHECK(slot);
+      CHECK_EQ(t.seq, s.seq);
+    }
+  }
+}
+
+// =============== BINARY ================================
+static void testTypicalSizes() {
+  uint8_t buf[TELEMETRY_FRAME_MAX];
+  CHECK_EQ(encodeTelemetryFrame(buf, FRAME_TYPE_TELEMETRY, 100, true, false, 2, 100), 4);
+  CHECK_EQ(encodeTelemetryFrame(buf, FRAME_TYPE_TELEMETRY, 1000, true, false, 2, 1000), 5);
+  CHECK_EQ(buf[0], FRAME_TYPE_TELEMETRY);
+  CHECK_EQ(buf[1], FRAME_FLAG_LED | (2 << FRAME_SPIN_SHIFT));
+
+  // Largest ACK: 32 bit seq and count, link, slot and TDMA
+  uint8_t n = encodeTelemetryFrame(buf, FRAME_TYPE_ACK, 0xFFFFFFFF, true, true, 3, 0x7FFFFFFF,
+                                   true, 0xFFFF, true, -32768, true, -255, -128, 0);
+  CHECK(n <= TELEMETRY_FRAME_MAX);
+}
+
+static void testOptionalFieldCombinations() {
+  const uint8_t types[] = {FRAME_TYPE_TELEMETRY, FRAME_TYPE_ACK};
+  for (uint8_t type : types) {
+    for (uint8_t mask = 0; mask < 16; mask++) {
+      Sample s = {type, 4711, true, false, 1, 4712, (mask & 1) != 0,
+                  (uint16_t)((mask & 2) ? 850 : 0), (mask & 4) != 0, -37,
+                  (mask & 8) != 0, -112, -9, (uint16_t)((mask & 1) ? 60 : 0)};
+      checkRoundTrip(s);
+    }
+  }
+}
+
+static void testRandomRoundTrips() {
+  for (int i = 0; i < 200000; i++) {
+    Sample s;
+    s.type = (rnd() & 1) ? FRAME_TYPE_ACK : FRAME_TYPE_TELEMETRY;
+    s.seq = rnd() >> (rnd() % 32);
+    s.led = rnd() & 1;
+    s.touch = rnd() & 1;
+    s.spinner = rnd() & 3;
+    // count - seq must fit int32 (zigzag delta)
+    int32_t delta = (int32_t)(rnd() >> (1 + rnd() % 31)) * ((rnd() & 1) ? 1 : -1);
+    s.count = s.seq + delta;
+    s.ackRequest = rnd() & 1;
+    s.slotOffset = (rnd() & 1) ? (uint16_t)rnd() : 0;
+    s.tdma = rnd() & 1;
+    s.tdmaShift = (int16_t)rnd();
+    s.link = rnd() & 1;
+    s.linkRssi = -(int16_t)(rnd() % 256);
+    s.linkSnr = (int8_t)rnd();
+    s.keepaliveS = (rnd() & 1) ? (uint16_t)rnd() : 0;
+    checkRoundTrip(s);
+  }
+}
+
+static void testMalformedBinary() {
+  TelemetryFrame f = {};
+  const uint8_t wrongType[] = {0x83, 0x00, 0x01, 0x00};
+  CHECK(!decodeTelemetryFrame(wrongType, sizeof(wrongType), f));
+
+  const uint8_t endlessVarint[] = {FRAME_TYPE_TELEMETRY, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x7F, 0x00};
+  CHECK(!decodeTelemetryFrame(endlessVarint, sizeof(endlessVarint), f));
+
+  uint8_t buf[TELEMETRY_FRAME_MAX + 1];
+  uint8_t n = encodeTelemetryFrame(buf, FRAME_TYPE_TELEMETRY, 5, false, false, 0, 5);
+  buf[n] = 0x00;  // Telemetry has no optional tail without a flag
+  CHECK(!decodeTelemetryFrame(buf, n + 1, f));
+
+  // Keepalive flag set, value missing
+  const uint8_t noKeepalive[] = {FRAME_TYPE_TELEMETRY, FRAME_FLAG_KEEPALIVE, 0x05, 0x00};
+  CHECK(!decodeTelemetryFrame(noKeepalive, sizeof(noKeepalive), f));
+}
+
+// =============== LEGACY ASCII ================================
+// What the sketch writes with TELEMETRY_BINARY_FORMAT false
+static void testLegacyRoundTrip() {
+  for (int i = 0; i < 20000; i++) {
+    bool ack = rnd() & 1;
+    uint32_t seq = rnd() % 100000;
+    uint32_t count = rnd() % 100000;
+    bool led = rnd() & 1, touch = rnd() & 1, req = rnd() & 1;
+    uint8_t spin = rnd() & 3;
+    // As in the sketch: SLOT only on ACKs, KA only on telemetry
+    uint16_t slot = (ack && (rnd() & 1)) ? (uint16_t)(rnd() % 5000 + 1) : 0;
+    uint16_t ka = (!ack && (rnd() & 1)) ? (uint16_t)(rnd() % 3600 + 1) : 0;
+
+    char text[64];  // LEGACY_PAYLOAD_MAX
+    int n = snprintf(text, sizeof(text), "%sSEQ:%u,LED:%d,TOUCH:%d,SPIN:%d,COUNT:%u",
+                     ack ? "ACK," : "", seq, led, touch, spin, count);
+    if (req) n += snprintf(text + n, sizeof(text) - n, ",REQ:1");
+    if (slot) n += snprintf(text + n, sizeof(text) - n, ",SLOT:%u", slot);
+    if (ka) n += snprintf(text + n, sizeof(text) - n, ",KA:%u", ka);
+
+    TelemetryFrame f = {};
+    CHECK(decodeTelemetry(text, n, f));
+    CHECK(f.legacy);
+    CHECK_EQ(f.type, ack ? FRAME_TYPE_ACK : FRAME_TYPE_TELEMETRY);
+    CHECK_EQ(f.fields & FIELD_ALL, FIELD_ALL);
+    CHECK_EQ(f.seq, seq);
+    CHECK_EQ(f.count, count);
+    CHECK_EQ(f.led, led);
+    CHECK_EQ(f.touch, touch);
+    CHECK_EQ(f.spinner, spin);
+    CHECK_EQ(f.ackRequest, req);
+    CHECK_EQ((f.fields & FIELD_SLOT) != 0, slot != 0);
+    CHECK_EQ(f.slotOffset, slot);
+    CHECK_EQ(f.keepaliveS, ka);
+  }
+}
+
+// Payloads of firmware before the binary frame
+static void testLegacyOldFirmware() {
+  TelemetryFrame f = {};
+  const char* old = "SEQ:123,LED:1,TOUCH:0,SPIN:2,COUNT:123";
+  CHECK(decodeTelemetry(old, strlen(old), f));
+  CHECK_EQ(f.seq, 123);
+  CHECK_EQ(f.led, true);
+  CHECK_EQ(f.touch, false);
+  CHECK_EQ(f.spinner, 2);
+  CHECK_EQ(f.count, 123);
+
+  const char* partial = "SEQ:9,TOUCH:1";
+  CHECK(decodeTelemetry(partial, strlen(partial), f));
+  CHECK_EQ(f.fields, FIELD_SEQ | FIELD_TOUCH);
+
+  const char* badSpin = "SEQ:1,SPIN:9";
+  CHECK(decodeTelemetry(badSpin, strlen(badSpin), f));
+  CHECK_EQ(f.spinner, 0);
+
+  const char* ackOnly = "ACK,";
+  CHECK(decodeTelemetry(ackOnly, strlen(ackOnly), f));
+  CHECK_EQ(f.type, FRAME_TYPE_ACK);
+
+  const char* junk = "HELLO WORLD";
+  CHECK(!decodeTelemetry(junk, strlen(junk), f));
+}
+
+int main() {
+  RUN(testTypicalSizes);
+  RUN(testOptionalFieldCombinations);
+  RUN(testRandomRoundTrips);
+  RUN(testMalformedBinary);
+  RUN(testLegacyRoundTrip);
+  RUN(testLegacyOldFirmware);
+  return hostTestExit();
+}
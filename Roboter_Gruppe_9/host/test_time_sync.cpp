@@ -0,0 +1,203 @@
+/*=====================================================================
+  test_time_sync.cpp - Beacon Clock Estimate Against Drifting Crystals
+
+  A receiver and a sender clock, each off by up to ±50 ppm, with a
+  random offset between them. The receiver "sends" a beacon every
+  BEACON_INTERVAL; the sender reads it with up to ±8 ms of UART/loop
+  jitter and feeds timeSyncOnBeacon() exactly as the sketch does.
+
+  Checked over many seeds (default 200):
+  - After one hour of beacons and one more hour without any, the
+    estimate of receiver time is within 50 ms (holdover target)
+  - While beacons arrive, the estimate stays within the jitter
+  - A receiver reboot (epoch jump) restarts the fit
+  - Beacon frame round trip, slot map lookup, timeSyncNextSlot()
+    returns slot starts in receiver time
+
+  Usage: test_time_sync [seeds]   (default 200)
+=======================================================================*/
+
+#include <Arduino.h>
+#include <math.h>
+#include "time_sync.h"
+#include "host_test.h"
+
+#define AIRTIME_MS 60                // Beacon time on air (both sides know it)
+#define JITTER_MS 8                  // ± on the local +RCV timestamp
+#define HOLDOVER_LIMIT_MS 50
+
+static uint64_t rngState;
+
+static uint32_t rnd() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 7;
+  rngState ^= rngState << 17;
+  return (uint32_t)rngState;
+}
+
+static double uniform(double lo, double hi) { return lo + (hi - lo) * (rnd() / 4294967296.0); }
+
+// =============== CLOCKS ================================
+// Real time t (ms, double) → millis() of each board
+struct Clocks {
+  double receiverPpm;
+  double senderPpm;
+  double receiverStart;            // millis() at t = 0
+  double senderStart;
+
+  unsigned long receiver(double t) const {
+    return (unsigned long)floor(receiverStart + t * (1 + receiverPpm * 1e-6));
+  }
+  unsigned long sender(double t) const {
+    return (unsigned long)floor(senderStart + t * (1 + senderPpm * 1e-6));
+  }
+};
+
+static Clocks randomClocks() {
+  Clocks c;
+  c.receiverPpm = uniform(-50, 50);
+  c.senderPpm = uniform(-50, 50);
+  c.receiverStart = uniform(0, 3600e3);
+  c.senderStart = uniform(0, 3600e3);
+  return c;
+}
+
+// Beacon sent at real time t, heard by the sender
+static void beacon(TimeSync& ts, const Clocks& c, double t) {
+  uint8_t frame[BEACON_FRAME_MAX];
+  uint8_t len = encodeBeacon(frame, c.receiver(t), 1, 2000, nullptr, 0);
+  double rx = t + AIRTIME_MS + TIME_SYNC_LATENCY_MS + uniform(-JITTER_MS, JITTER_MS);
+  CHECK(timeSyncOnBeacon(ts, c.sender(rx), (const char*)frame, len, 2, AIRTIME_MS));
+}
+
+static int32_t estimateError(const TimeSync& ts, const Clocks& c, double t) {
+  return (int32_t)(timeSyncGateway(ts, c.sender(t)) - c.receiver(t));
+}
+
+// =============== HOLDOVER ================================
+static uint32_t seeds = 200;
+
+static void testHoldover() {
+  int32_t worstHoldover = 0, worstTracking = 0;
+  for (uint32_t seed = 1; seed <= seeds; seed++) {
+    rngState = 0x9E3779B97F4A7C15ULL * seed;
+    Clocks c = randomClocks();
+    TimeSync ts;
+    timeSyncInit(ts);
+
+    double t = 0;
+    for (; t < 3600e3; t += BEACON_INTERVAL) {
+      beacon(ts, c, t);
+      if (ts.count >= TIME_SYNC_HISTORY / 2) {
+        // Half a beacon interval later, still tracking
+        int32_t e = abs(estimateError(ts, c, t + BEACON_INTERVAL / 2));
+        if (e > worstTracking) worstTracking = e;
+      }
+    }
+    int32_t e = abs(estimateError(ts, c, t + 3600e3));
+    if (e > worstHoldover) worstHoldover = e;
+    if (e > HOLDOVER_LIMIT_MS) {
+      fprintf(stderr, "seed %u: %d ms after 1 h holdover (ppm %.1f / %.1f)\n", seed, e,
+              c.receiverPpm, c.senderPpm);
+    }
+  }
+  printf("  %u seeds: worst %d ms after 1 h without beacons, %d ms while tracking\n", seeds,
+         worstHoldover, worstTracking);
+  CHECK(worstHoldover <= HOLDOVER_LIMIT_MS);
+  CHECK(worstTracking <= JITTER_MS + 2);
+}
+
+// Without the fit (single newest sample) the same hour drifts by up to
+// 100 ppm × 3600 s = 360 ms: the test would notice a broken fit
+static void testDriftIsCorrected() {
+  rngState = 42;
+  Clocks c = randomClocks();
+  c.receiverPpm = 50;
+  c.senderPpm = -50;
+  TimeSync ts;
+  timeSyncInit(ts);
+  double t = 0;
+  for (; t < 3600e3; t += BEACON_INTERVAL) beacon(ts, c, t);
+  CHECK(fabs(ts.drift - 100e-6) < 5e-6);
+  CHECK(abs(estimateError(ts, c, t + 3600e3)) <= HOLDOVER_LIMIT_MS);
+}
+
+// =============== RESET / FRAME / SLOTS ================================
+static void testReceiverReboot() {
+  rngState = 7;
+  Clocks c = randomClocks();
+  TimeSync ts;
+  timeSyncInit(ts);
+  double t = 0;
+  for (int i = 0; i < 10; i++, t += BEACON_INTERVAL) beacon(ts, c, t);
+  CHECK_EQ(ts.count, 10);
+  CHECK_EQ(ts.resets, 0);
+
+  c.receiverStart -= c.receiver(t);  // Receiver restarted: millis() from 0
+  beacon(ts, c, t);
+  CHECK_EQ(ts.resets, 1);
+  CHECK_EQ(ts.count, 1);
+  CHECK(abs(estimateError(ts, c, t + 1000)) <= JITTER_MS + 2);
+}
+
+static void testBeaconFrame() {
+  const uint8_t map[4] = {5, 9, 2, 7};
+  uint8_t frame[BEACON_FRAME_MAX];
+  uint8_t len = encodeBeacon(frame, 0xA1B2C3D4, 4, 2000, map, sizeof(map));
+  CHECK_EQ(len, BEACON_HEADER_LEN + 4);
+  CHECK(isBeaconFrame((const char*)frame, len));
+  CHECK(!isBeaconFrame((const char*)frame, BEACON_HEADER_LEN - 1));
+
+  TimeSync ts;
+  timeSyncInit(ts);
+  CHECK(timeSyncOnBeacon(ts, 1000, (const char*)frame, len, 2, AIRTIME_MS));
+  CHECK_EQ(ts.slotCount, 4);
+  CHECK_EQ(ts.slotMs, 2000);
+  CHECK_EQ(ts.mySlot, 2);
+  CHECK_EQ((uint32_t)timeSyncGateway(ts, 1000), 0xA1B2C3D4U + AIRTIME_MS + TIME_SYNC_LATENCY_MS);
+
+  CHECK(timeSyncOnBeacon(ts, 2000, (const char*)frame, len, 3, AIRTIME_MS));
+  CHECK_EQ(ts.mySlot, -1);  // Not in the map
+  CHECK(!timeSyncSlotKnown(ts));
+
+  len = encodeBeacon(frame, 5000, 1, 2000, nullptr, 0);
+  CHECK(timeSyncOnBeacon(ts, 2000, (const char*)frame, len, 3, AIRTIME_MS));
+  CHECK_EQ(ts.mySlot, 0);  // Empty map: single sender in slot 0
+}
+
+static void testNextSlot() {
+  rngState = 11;
+  Clocks c = randomClocks();
+  TimeSync ts;
+  timeSyncInit(ts);
+  const uint8_t map[4] = {5, 9, 2, 7};
+  double t = 0;
+  for (; t < 1800e3; t += BEACON_INTERVAL) {
+    uint8_t frame[BEACON_FRAME_MAX];
+    uint8_t len = encodeBeacon(frame, c.receiver(t), 4, 2000, map, sizeof(map));
+    double rx = t + AIRTIME_MS + TIME_SYNC_LATENCY_MS + uniform(-JITTER_MS, JITTER_MS);
+    timeSyncOnBeacon(ts, c.sender(rx), (const char*)frame, len, 2, AIRTIME_MS);
+  }
+  CHECK(timeSyncSlotKnown(ts));
+
+  unsigned long local = c.sender(t);
+  for (int i = 0; i < 20; i++) {
+    unsigned long slot = timeSyncNextSlot(ts, local);
+    CHECK(slot >= local);
+    CHECK(slot - local <= 8000);                                // Within one frame
+    unsigned long gateway = timeSyncGateway(ts, slot);
+    long phase = (long)(gateway % 8000) - 2 * 2000;             // Slot 2 starts at 4000
+    CHECK(phase >= -1 && phase <= 1);
+    local = slot + 1;
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) seeds = strtoul(argv[1], nullptr, 10);
+  RUN(testHoldover);
+  RUN(testDriftIsCorrected);
+  RUN(testReceiverReboot);
+  RUN(testBeaconFrame);
+  RUN(testNextSlot);
+  return hostTestExit();
+}
@@ -266,13 +266,8 @@ void detectFlash() {
           Serial.println(light.flashCount);
           Serial.println("  Sending LoRa alert...");
 
-          // Send alert via LoRa
-          #if defined(LORA_SENDER_ADDRESS)
-            extern void sendLoRaMessage(String payload, int address);
-            String alert = "ALERT:FIRE_LIGHT,RED:" + String(light.red) +
-                          ",FLASHES:" + String(light.flashCount);
-            sendLoRaMessage(alert, LORA_SENDER_ADDRESS);
-          #endif
+          // LoRa alert: fire_alarm_detector.h → onFireAlarmAlert() → priority
+          // queue (tx_queue.h) - never straight to the radio
 
           light.alertCount++;
           light.lastAlertTime = now;
@@ -310,12 +305,7 @@ void detectFlash() {
 
       Serial.println("🚨 Red light alarm still active...");
 
-      #if defined(LORA_SENDER_ADDRESS)
-        extern void sendLoRaMessage(String payload, int address);
-        String alert = "ALERT:FIRE_LIGHT,RED:" + String(light.red) +
-                      ",DURATION:" + String((now - light.alarmStartTime) / 1000);
-        sendLoRaMessage(alert, LORA_SENDER_ADDRESS);
-      #endif
+      // Repeats go out through fire_alarm_detector.h → onFireAlarmAlert()
 
       light.lastAlertTime = now;
     }
@@ -0,0 +1,295 @@
+/*=====================================================================
+  link_recovery.h - Tiered, Non-blocking Radio Recovery
+
+  A LOST link used to mean a full initLoRa(): LoRaSerial.begin(),
+  delay(1000), AT+RESET, up to 5 s waitForReady() and five blocking
+  AT commands - ~8 s deaf every recoveryInterval, while most of the
+  time the module was fine and the sender simply out of range.
+
+  Now recovery escalates only as far as needed, one AT command at a
+  time through the AT engine (loop() keeps running, +RCV lines keep
+  arriving between the steps):
+
+    Tier    | Steps                                     | Typical
+    --------|-------------------------------------------|---------
+    PROBE   | "AT" answers, then AT+ADDRESS?,            | ~50 ms
+            | AT+NETWORKID?, AT+PARAMETER? all match     |
+    REAPPLY | a query differs → only that setting is     | ~100 ms
+            | written again (AT+ADDRESS=... etc.)        |
+    RESET   | probe/query/write failed → AT+RESET, wait  | ~1-2 s
+            | for +READY (RECOVERY_READY_MS), write all   |
+            | three settings                             |
+
+  The expected settings are what the node runs now (loraParams - an
+  ADR switch is not undone). A RESET that fails (no +READY, a setting
+  refused) ends the attempt; the next one starts at PROBE again.
+
+  Time to recover (attempt start → module verified) is recorded per
+  tier that ended the attempt (printLinkRecoveryStats()).
+=======================================================================*/
+
+#ifndef LINK_RECOVERY_H
+#define LINK_RECOVERY_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "lora_handler.h"  // atEnqueue(loraAT), loraParams
+
+#define RECOVERY_PROBE_MS 500        // "AT" answer timeout
+#define RECOVERY_COMMAND_MS 1000     // Query / write answer timeout
+#define RECOVERY_RESET_MS 2000       // AT+RESET answer timeout
+#define RECOVERY_READY_MS 5000       // +READY after AT+RESET
+#define RECOVERY_SETTINGS 3          // ADDRESS, NETWORKID, PARAMETER
+
+enum RecoveryTier {
+  RECOVERY_PROBE = 0,
+  RECOVERY_REAPPLY = 1,
+  RECOVERY_RESET = 2,
+  RECOVERY_TIERS = 3
+};
+
+enum RecoveryStep {
+  REC_IDLE,
+  REC_PROBE,       // "AT"
+  REC_QUERY,       // AT+<setting>? of item
+  REC_APPLY,       // AT+<setting>=... of item (query differed)
+  REC_RESET,       // AT+RESET
+  REC_READY,       // Waiting for +READY
+  REC_CONFIGURE    // AT+<setting>=... of item after the reset
+};
+
+enum RecoveryResult {
+  RECOVERY_RUNNING,
+  RECOVERY_DONE,
+  RECOVERY_FAILED
+};
+
+struct RecoveryTierStats {
+  unsigned long runs;                // Attempts that ended in this tier
+  unsigned long totalMs;
+  unsigned long maxMs;
+};
+
+struct LinkRecovery {
+  RecoveryStep step;
+  uint8_t item;                      // Setting being queried / written
+  uint8_t address;
+  uint8_t networkId;
+  uint8_t reapplied;                 // Bit per setting written in this attempt
+  bool reprobed;                     // Probe repeated after a +READY
+  unsigned long startedAt;
+  unsigned long readyDeadline;
+
+  // AT command of the current step
+  bool issued;
+  bool answered;
+  ATResult result;
+  char response[32];
+
+  // Statistics
+  RecoveryTierStats tiers[RECOVERY_TIERS];
+  unsigned long failed;
+  unsigned long lastMs;
+  uint8_t lastTier;
+};
+
+inline void linkRecoveryInit(LinkRecovery& r) {
+  memset(&r, 0, sizeof(r));
+  r.step = REC_IDLE;
+}
+
+inline bool linkRecoveryActive(const LinkRecovery& r) {
+  return r.step != REC_IDLE;
+}
+
+// =============== AT COMMANDS ================================
+inline void onRecoveryAnswer(ATResult result, const char* response, void* ctx) {
+  LinkRecovery* r = (LinkRecovery*)ctx;
+  r->result = result;
+  strncpy(r->response, response, sizeof(r->response) - 1);
+  r->response[sizeof(r->response) - 1] = '\0';
+  r->answered = true;
+}
+
+// "AT+ADDRESS" / "AT+NETWORKID" / "AT+PARAMETER" + suffix
+inline int recoverySetting(const LinkRecovery& r, uint8_t item, char* out, size_t size,
+                           const char* prefix) {
+  switch (item) {
+    case 0:  return snprintf(out, size, "%sADDRESS=%u", prefix, r.address);
+    case 1:  return snprintf(out, size, "%sNETWORKID=%u", prefix, r.networkId);
+    default: return snprintf(out, size, "%sPARAMETER=%u,%u,%u,%u", prefix,
+                             loraParams.sf, loraParams.bw, loraParams.cr, loraParams.preamble);
+  }
+}
+
+// Command of the current step; false if the AT queue is full (retried)
+inline bool recoveryIssue(LinkRecovery& r) {
+  static const char* const queries[RECOVERY_SETTINGS] = {
+    "AT+ADDRESS?", "AT+NETWORKID?", "AT+PARAMETER?"
+  };
+  char cmd[40];
+  unsigned long timeout = RECOVERY_COMMAND_MS;
+  switch (r.step) {
+    case REC_PROBE:
+      strcpy(cmd, "AT");
+      timeout = RECOVERY_PROBE_MS;
+      break;
+    case REC_QUERY:
+      strcpy(cmd, queries[r.item]);
+      break;
+    case REC_RESET:
+      strcpy(cmd, "AT+RESET");
+      timeout = RECOVERY_RESET_MS;
+      loraAT.readySeen = false;
+      break;
+    default:  // REC_APPLY, REC_CONFIGURE
+      recoverySetting(r, r.item, cmd, sizeof(cmd), "AT+");
+      break;
+  }
+  r.answered = false;
+  return atEnqueue(loraAT, cmd, timeout, onRecoveryAnswer, &r);
+}
+
+// Query answer ("+ADDRESS=2") matches the running setting?
+inline bool recoveryMatches(const LinkRecovery& r) {
+  char expected[40];
+  recoverySetting(r, r.item, expected, sizeof(expected), "+");
+  return r.result == AT_RESULT_OK && strcmp(r.response, expected) == 0;
+}
+
+// =============== STATE MACHINE ================================
+inline void recoveryGoto(LinkRecovery& r, RecoveryStep step, uint8_t item = 0) {
+  r.step = step;
+  r.item = item;
+  r.issued = false;
+}
+
+inline RecoveryResult recoveryFinish(LinkRecovery& r, uint8_t tier, bool ok) {
+  r.lastMs = millis() - r.startedAt;
+  r.lastTier = tier;
+  r.step = REC_IDLE;
+  if (!ok) {
+    r.failed++;
+    return RECOVERY_FAILED;
+  }
+  RecoveryTierStats& s = r.tiers[tier];
+  s.runs++;
+  s.totalMs += r.lastMs;
+  if (r.lastMs > s.maxMs) s.maxMs = r.lastMs;
+  return RECOVERY_DONE;
+}
+
+inline void linkRecoveryStart(LinkRecovery& r, uint8_t address, uint8_t networkId) {
+  r.address = address;
+  r.networkId = networkId;
+  r.reapplied = 0;
+  r.startedAt = millis();
+  r.reprobed = false;
+  loraAT.readySeen = false;  // +READY from now on = the module just rebooted
+  recoveryGoto(r, REC_PROBE);
+}
+
+// Call every loop(); DONE / FAILED are returned once per attempt
+inline RecoveryResult linkRecoveryPoll(LinkRecovery& r) {
+  if (r.step == REC_IDLE) return RECOVERY_RUNNING;
+
+  if (r.step == REC_READY) {
+    if (loraAT.readySeen) {
+      recoveryGoto(r, REC_CONFIGURE);
+    } else if ((long)(millis() - r.readyDeadline) >= 0) {
+      return recoveryFinish(r, RECOVERY_RESET, false);
+    }
+    return RECOVERY_RUNNING;
+  }
+
+  if (!r.issued) {
+    r.issued = recoveryIssue(r);
+    return RECOVERY_RUNNING;
+  }
+  if (!r.answered) return RECOVERY_RUNNING;
+
+  bool ok = r.result == AT_RESULT_OK;
+  switch (r.step) {
+    case REC_PROBE:
+      if (ok) {
+        recoveryGoto(r, REC_QUERY);
+      } else if (loraAT.readySeen && !r.reprobed) {
+        r.reprobed = true;  // Still booting (power-on, brown-out) - ask again
+        recoveryGoto(r, REC_PROBE);
+      } else {
+        recoveryGoto(r, REC_RESET);
+      }
+      break;
+
+    case REC_QUERY:
+      if (r.result != AT_RESULT_OK && r.result != AT_RESULT_ERROR) {
+        recoveryGoto(r, REC_RESET);  // Silent module
+      } else if (!recoveryMatches(r)) {
+        // Written once and still different → the module is not sane
+        if (r.reapplied & (1 << r.item)) recoveryGoto(r, REC_RESET);
+        else recoveryGoto(r, REC_APPLY, r.item);
+      } else if (r.item + 1 < RECOVERY_SETTINGS) {
+        recoveryGoto(r, REC_QUERY, r.item + 1);
+      } else {
+        return recoveryFinish(r, r.reapplied ? RECOVERY_REAPPLY : RECOVERY_PROBE, true);
+      }
+      break;
+
+    case REC_APPLY:
+      if (!ok) {
+        recoveryGoto(r, REC_RESET);
+      } else {
+        r.reapplied |= 1 << r.item;
+        recoveryGoto(r, REC_QUERY, r.item);  // Read back
+      }
+      break;
+
+    case REC_RESET:
+      // "+RESET" or nothing - +READY decides
+      recoveryGoto(r, REC_READY);
+      r.readyDeadline = millis() + RECOVERY_READY_MS;
+      break;
+
+    case REC_CONFIGURE:
+      if (!ok) return recoveryFinish(r, RECOVERY_RESET, false);
+      if (r.item + 1 < RECOVERY_SETTINGS) {
+        recoveryGoto(r, REC_CONFIGURE, r.item + 1);
+      } else {
+        return recoveryFinish(r, RECOVERY_RESET, true);
+      }
+      break;
+
+    default:
+      break;
+  }
+  return RECOVERY_RUNNING;
+}
+
+// =============== STATUS ================================
+inline const char* recoveryTierName(uint8_t tier) {
+  static const char* const names[RECOVERY_TIERS] = {"probe", "reapply", "reset"};
+  return tier < RECOVERY_TIERS ? names[tier] : "?";
+}
+
+inline void printLinkRecoveryStats(const LinkRecovery& r) {
+  Serial.print("Recovery:");
+  for (uint8_t t = 0; t < RECOVERY_TIERS; t++) {
+    const RecoveryTierStats& s = r.tiers[t];
+    Serial.print(" ");
+    Serial.print(recoveryTierName(t));
+    Serial.print(" ");
+    Serial.print(s.runs);
+    if (s.runs) {
+      Serial.print(" (");
+      Serial.print(s.totalMs / s.runs);
+      Serial.print("/");
+      Serial.print(s.maxMs);
+      Serial.print(" ms)");
+    }
+    Serial.print(",");
+  }
+  Serial.print(" failed ");
+  Serial.println(r.failed);
+}
+
+#endif // LINK_RECOVERY_H
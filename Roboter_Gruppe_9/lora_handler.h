@@ -5,7 +5,9 @@
   Based on proven working implementation.
 
   Features:
-  - Reliable AT command interface
+  - Non-blocking AT command engine (at_engine.h) - call loraPoll()
+    every loop(); AT+SEND never stalls loop() during air time
+  - Zero-allocation receive: UART → ring buffer → RcvView (lora_rx.h)
   - Automatic initialization with optimal settings
   - Message send/receive with error handling
   - RSSI and SNR monitoring
@@ -16,18 +18,42 @@
   - Baudrate: 115200
 
   LoRa Parameters:
-  - Spreading Factor: 12 (maximum range)
+  - Spreading Factor: LORA_SPREADING_FACTOR, default 12 (maximum range)
   - Bandwidth: 125kHz (BW7)
   - Coding Rate: 4/5 (CR1)
   - Preamble: 4
 
-  SF12 Air Time (BW 125kHz):
-  - 10 bytes: ~1.3 seconds
-  - 20 bytes: ~2.0 seconds
-  - 34 bytes: ~2.6 seconds
-  - 36 bytes: ~2.8 seconds
+  SF12 Air Time (BW 125kHz, Semtech formula - see airtime.h):
+  -  5 bytes: ~0.70 seconds (binary telemetry frame)
+  - 10 bytes: ~0.86 seconds
+  - 20 bytes: ~1.19 seconds
+  - 40 bytes: ~1.84 seconds
   - RYLR896 responds with +OK AFTER transmission completes!
-  - AT+SEND timeout must be > air time (4000ms for safety)
+  - AT+SEND timeout = air time + LORA_TIMEOUT_MARGIN (current params)
+  - Every AT+SEND is charged to the duty-cycle budget (loraDutyCycle)
+
+  Forward error correction (fec.h):
+  - Sender: sendLoRaUplink() wraps frames into FEC groups when
+    ENABLE_FEC is set; parity goes out with sendLoRaParity()
+  - Receiver: receiveLoRaPacket() always unwraps FEC frames and hands
+    out frames rebuilt from parity (loraRxRecovered = true, sender =
+    the parity frame's sender)
+
+  Frame kind (frame_dispatch.h):
+  - receiveLoRaPacket() classifies each layer once and leaves the kind
+    of the frame it hands out in loraRxKind - callers dispatch on it
+
+  Encryption (encryption.h, ENABLE_ENCRYPTION):
+  - sendLoRaMessage() seals every frame with AES-128-CCM inside the
+    AT+SEND buffer; airtime/duty-cycle helpers count the envelope
+  - receiveLoRaPacket() opens it in loraRxLine first - frames with a
+    wrong tag, a replayed counter or no envelope never reach a decoder
+    and do not count as link activity
+
+  Relay envelopes (relay.h, ENABLE_RELAY):
+  - receiveLoRaPacket() unwraps them before FEC: packet.sender is the
+    far sender, loraRelayPath keeps the hop RSSI, loraRelayAckDue asks
+    the caller for a RELAY_ACK to loraRelayVia
 =======================================================================*/
 
 #ifndef LORA_HANDLER_H
@@ -36,75 +62,219 @@
 #include <HardwareSerial.h>
 #include "config.h"
 #include "structs.h"
+#include "at_engine.h"
+#include "lora_rx.h"
+#include "airtime.h"
+#include "fec.h"
+#include "frame_dispatch.h"
+#if ENABLE_RELAY
+  #include "relay.h"
+#endif
+#if ENABLE_ENCRYPTION
+  #include "encryption.h"
+#endif
+#if ENABLE_IDLE_SLEEP
+  #include "timer_wheel.h"  // idleWake()
+#endif
+
+// ESP32 Arduino core 2.x can push UART bytes from its event task;
+// older cores fall back to draining the UART in loraPoll()
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 2
+  #define LORA_RX_UART_EVENT 1
+#else
+  #define LORA_RX_UART_EVENT 0
+#endif
 
 // Use Serial1 explicitly for better reliability
 HardwareSerial LoRaSerial(1);
 
-// =============== AT COMMAND FUNCTION ================================
-inline String sendLoRaCommand(String command, int timeout = 500) {
-  // Clear any pending data before sending command
-  while (LoRaSerial.available()) {
-    LoRaSerial.read();
+// UART bytes land in a fixed ring; the AT engine reads the ring
+LoRaRxRing loraRxRing;
+LoRaRxStream loraStream(loraRxRing, LoRaSerial);
+
+// Non-blocking AT engine owns LoRaSerial (see at_engine.h)
+ATEngine loraAT;
+
+// Radio parameters in use (AT+PARAMETER) - drives the airtime model
+LoRaParams loraParams = {LORA_SPREADING_FACTOR, 7, 1, 4};  // SF12 default, BW125kHz, CR4/5, preamble 4
+
+// Duty-cycle token bucket + total airtime spent (both always tracked,
+// enforced only with ENABLE_DUTY_CYCLE_LIMIT)
+DutyCycleBudget loraDutyCycle;
+unsigned long loraAirtimeTotalMs = 0;
+
+// Last "+RCV=" line handed over by the AT engine (RcvView points here)
+char loraRxLine[AT_LINE_MAX];
+uint16_t loraRxLength = 0;
+bool loraRxPending = false;
+unsigned long loraRxTime = 0;         // millis() when the line arrived (ACK slot timing)
+unsigned long loraRxOverwritten = 0;  // Lines replaced before being read
+unsigned long loraRxMalformed = 0;    // "+RCV=" lines that failed to parse
+
+// FEC: receiver always decodes, sender encodes with ENABLE_FEC
+FecDecoder loraFecRx;
+bool loraRxRecovered = false;         // Last packet was rebuilt from parity
+uint16_t loraFecSender = 0;           // Sender of the parity (= of its group)
+FrameKind loraRxKind = FRAME_KIND_UNKNOWN;  // Kind of the packet handed out (frame_dispatch.h)
+unsigned long loraFecLostReported = 0;
+#if ENABLE_FEC
+FecEncoder loraFecTx;
+#endif
+
+#if ENABLE_ENCRYPTION
+// AES-CCM key, TX counter and per-sender replay windows (encryption.h)
+const uint8_t loraEncKey[ENC_KEY_LEN] = ENCRYPTION_KEY;
+EncContext loraEnc;
+#endif
+
+#if ENABLE_RELAY
+// Relay envelopes (relay.h): unwrapped here, the path stays readable
+RelayCache loraRelayCache;            // (source, seq) seen lately
+RelayHeader loraRelayPath;            // Envelope of the last relayed packet
+uint16_t loraRelayVia = 0;            // Relay that delivered it
+bool loraRxRelayed = false;           // Last packet came through a relay
+bool loraRelayAckDue = false;         // Envelope (new or resent) wants a RELAY_ACK
+#endif
+
+// =============== UART → RING ================================
+inline void drainLoRaUart() {
+  while (LoRaSerial.available() > 0) {
+    rxRingPush(loraRxRing, (uint8_t)LoRaSerial.read());
   }
+}
 
-  LoRaSerial.println(command);
+#if LORA_RX_UART_EVENT
+// UART event task: bytes in, loop() woken if it sleeps in idleWait()
+inline void onLoRaUartReceive() {
+  drainLoRaUart();
+  #if ENABLE_IDLE_SLEEP
+    idleWake();
+  #endif
+}
+#endif
+
+// =============== RX LINE HANDLER ================================
+inline void onLoRaLine(const char* line, uint16_t len) {
+  if (loraRxPending) loraRxOverwritten++;
+  memcpy(loraRxLine, line, len + 1);
+  loraRxLength = len;
+  loraRxPending = true;
+  loraRxTime = millis();
+}
 
-  unsigned long start = millis();
-  String response = "";
+// =============== POLL (call every loop) ================================
+inline void loraPoll() {
+  #if !LORA_RX_UART_EVENT
+    drainLoRaUart();
+  #endif
+  atPoll(loraAT);
+}
 
-  while (millis() - start < timeout) {
-    if (LoRaSerial.available()) {
-      char c = LoRaSerial.read();
-      response += c;
-      if (c == '\n' && response.length() > 2) break;
-    }
+// =============== AT COMMAND FUNCTION (blocking) ================================
+// Blocking wrapper around the AT engine. Only for setup/recovery and
+// manual debugging - loop() code must use atEnqueue()/sendLoRaMessage().
+struct LoRaBlockingResult {
+  bool done;
+  char response[AT_LINE_MAX];
+};
+
+inline void onLoRaBlockingDone(ATResult result, const char* response, void* ctx) {
+  LoRaBlockingResult* r = (LoRaBlockingResult*)ctx;
+  strncpy(r->response, response, AT_LINE_MAX - 1);
+  r->response[AT_LINE_MAX - 1] = '\0';
+  r->done = true;
+}
+
+inline String sendLoRaCommand(String command, int timeout = 500) {
+  static LoRaBlockingResult result;
+  if (!loraAT.port) return "";  // initLoRa() not called yet
+  result.done = false;
+  result.response[0] = '\0';
+
+  if (!atEnqueue(loraAT, command.c_str(), command.length(), timeout,
+                 onLoRaBlockingDone, &result)) {
+    return "";
   }
 
+  // Queued commands ahead of us also run here
+  while (!result.done) {
+    loraPoll();
+    yield();
+  }
+
+  String response = result.response;
   response.trim();
   return response;
 }
 
-// Helper: Clear serial buffer and wait for READY signal
-inline void waitForReady(int timeout = 5000) {
+// Helper: Wait for +READY signal (set by the AT engine)
+inline void waitForReady(unsigned long timeout = 5000) {
   Serial.println("Waiting for +READY signal...");
   unsigned long start = millis();
-  String buffer = "";
 
   while (millis() - start < timeout) {
-    if (LoRaSerial.available()) {
-      char c = LoRaSerial.read();
-      buffer += c;
-
-      // Check if we got READY signal
-      if (buffer.indexOf("READY") >= 0) {
-        Serial.println("✓ Module ready!");
-        delay(100);
-        // Clear any remaining data
-        while (LoRaSerial.available()) LoRaSerial.read();
-        return;
-      }
-
-      // Keep buffer size manageable
-      if (buffer.length() > 50) {
-        buffer = buffer.substring(buffer.length() - 30);
-      }
+    loraPoll();
+    if (loraAT.readySeen) {
+      Serial.println("✓ Module ready!");
+      return;
     }
+    yield();
   }
   Serial.println("⚠ READY signal timeout (continuing anyway)");
 }
 
 // =============== INITIALIZE LoRa ================================
-inline bool initLoRa(uint8_t myAddress, uint8_t networkID) {
-  Serial.println("\n============================");
-  Serial.println("=== LoRa Init ===");
-  Serial.println("============================");
-
+// UART, RX ring and AT engine - the module itself is not touched
+// (initLoRa() resets and programs it, fast_boot.h only reads it back)
+inline void loraPortBegin(uint8_t myAddress, uint8_t networkID, unsigned long settleMs) {
   // Start serial connection
   LoRaSerial.begin(LORA_BAUDRATE, SERIAL_8N1, RXD2, TXD2);
-  delay(1000);
+  if (settleMs) delay(settleMs);
 
   // Clear serial buffer
   while (LoRaSerial.available()) LoRaSerial.read();
+  loraRxRing.tail = loraRxRing.head;
+
+  // Feed the RX ring from the UART event task
+  #if LORA_RX_UART_EVENT
+    LoRaSerial.onReceive(onLoRaUartReceive);
+  #endif
+
+  // (Re)start AT engine - drops anything queued before a recovery
+  atReset(loraAT);
+  atBegin(loraAT, loraStream, onLoRaLine);
+  loraRxPending = false;
+
+  // Duty-cycle budget starts full once; a recovery re-init keeps it
+  if (loraDutyCycle.capacityUs == 0) {
+    dutyCycleInit(loraDutyCycle, DUTY_CYCLE_PERMILLE, DUTY_CYCLE_BURST_MS);
+  }
+
+  // Same for the TX counter and the replay windows
+  #if ENABLE_ENCRYPTION
+  if (!loraEnc.ready) {
+    bool selfTest = encSelfTest();
+    encInit(loraEnc, loraEncKey, myAddress, networkID);
+    Serial.print("🔒 AES-128-CCM (");
+    Serial.print(ENC_HW_AES ? "hardware AES" : "software AES");
+    Serial.print("), self-test ");
+    Serial.print(selfTest ? "PASS" : "FAIL");
+    Serial.print(", TX counter ");
+    Serial.println(loraEnc.txCounter);
+    if (!selfTest || !loraEnc.ready) {
+      loraEnc.ready = false;  // Nothing goes out unprotected
+      Serial.println("❌ Encryption unavailable - TX disabled");
+    }
+  }
+  #endif
+}
+
+inline bool initLoRa(uint8_t myAddress, uint8_t networkID) {
+  Serial.println("\n============================");
+  Serial.println("=== LoRa Init ===");
+  Serial.println("============================");
+
+  loraPortBegin(myAddress, networkID, 1000);
 
   // Reset module
   Serial.println("Resetting module...");
@@ -147,11 +317,18 @@ inline bool initLoRa(uint8_t myAddress, uint8_t networkID) {
 
   // Set parameters (SF12 = max range, works reliably)
   Serial.println("Setting parameters...");
-  response = sendLoRaCommand("AT+PARAMETER=12,7,1,4", 1000);
+  char parameterCmd[32];
+  snprintf(parameterCmd, sizeof(parameterCmd), "AT+PARAMETER=%u,%u,%u,%u",
+           loraParams.sf, loraParams.bw, loraParams.cr, loraParams.preamble);
+  response = sendLoRaCommand(parameterCmd, 1000);
   if (response.indexOf("OK") >= 0) {
-    Serial.println("✓ Parameters: SF12, BW125kHz");
+    Serial.print("✓ Parameters: SF");
+    Serial.print(loraParams.sf);
+    Serial.print(", BW");
+    Serial.print(loraBandwidthHz(loraParams.bw) / 1000);
+    Serial.println("kHz");
   }
-  
+
   Serial.println("============================");
   Serial.println("✓ RYLR896 Ready!");
   Serial.println("============================\n");
@@ -159,89 +336,304 @@ inline bool initLoRa(uint8_t myAddress, uint8_t networkID) {
   return true;
 }
 
-// =============== SEND MESSAGE ================================
-inline bool sendLoRaMessage(String message, uint8_t targetAddress) {
-  String command = "AT+SEND=" + String(targetAddress) + "," +
-                   String(message.length()) + "," + message;
+// =============== AIRTIME HELPERS ================================
+// Bytes on air for a payload (AES-CCM envelope included)
+inline uint8_t loraOnAirLength(uint8_t length) {
+  #if ENABLE_ENCRYPTION
+    return length + encOverhead(loraEnc);
+  #else
+    return length;
+  #endif
+}
 
-  // SF12 is VERY slow! Air time for 36 bytes: ~2.8 seconds
-  // Must wait for +OK response AFTER message is transmitted
-  // Increased timeout: 2000ms → 4000ms for SF12 reliability
-  String response = sendLoRaCommand(command, 4000);
+// Time on air of a payload with the current radio parameters
+inline uint32_t loraAirtimeMs(uint8_t length) {
+  return loraAirtimeMs(loraOnAirLength(length), loraParams);
+}
 
-  if (response.indexOf("OK") >= 0) {
+// AT+SEND answer (+OK) arrives once the packet has left the antenna
+inline unsigned long loraSendTimeout(uint8_t length) {
+  return loraAirtimeMs(length) + LORA_TIMEOUT_MARGIN;
+}
+
+// Would a packet of this length fit the duty-cycle budget now?
+inline bool loraCanSend(uint8_t length) {
+  #if ENABLE_DUTY_CYCLE_LIMIT
+    return dutyCycleAllows(loraDutyCycle, loraAirtimeUs(loraOnAirLength(length), loraParams));
+  #else
     return true;
-  } else {
+  #endif
+}
+
+// Milliseconds until a packet of this length fits the budget
+inline unsigned long loraSendWait(uint8_t length) {
+  #if ENABLE_DUTY_CYCLE_LIMIT
+    return dutyCycleWaitMs(loraDutyCycle, loraAirtimeUs(loraOnAirLength(length), loraParams));
+  #else
+    return 0;
+  #endif
+}
+
+// Share of airtime used since boot (percent)
+inline float loraDutyCyclePercent() {
+  unsigned long uptime = millis();
+  return uptime > 0 ? 100.0f * loraAirtimeTotalMs / uptime : 0;
+}
+
+// =============== SEND MESSAGE (non-blocking) ================================
+// Default completion: report failures only
+inline void onLoRaSendDone(ATResult result, const char* response, void* ctx) {
+  if (result != AT_RESULT_OK) {
     Serial.print("❌ LoRa send failed: ");
-    Serial.println(message);
+    Serial.println(result == AT_RESULT_TIMEOUT ? "timeout" : response);
+  }
+}
+
+// Queues AT+SEND and returns immediately. Returns false if the command
+// could not be queued or the duty-cycle budget is exhausted (caller
+// retries later with fresh data); the outcome arrives in callback.
+// Data is sent verbatim (binary frames allowed), sealed with
+// ENABLE_ENCRYPTION.
+inline bool sendLoRaMessage(const uint8_t* data, uint8_t length, uint8_t targetAddress,
+                            ATCallback callback = onLoRaSendDone, void* ctx = nullptr) {
+  char command[AT_CMD_MAX];
+  if (length > 240 - loraOnAirLength(0)) {  // RYLR896 payload limit
+    Serial.println("❌ LoRa message too long");
+    return false;
+  }
+  uint8_t onAir = loraOnAirLength(length);
+  int header = snprintf(command, sizeof(command), "AT+SEND=%u,%u,",
+                        targetAddress, onAir);
+  if (header < 0 || header + onAir >= (int)sizeof(command)) {
+    Serial.println("❌ LoRa message too long");
+    return false;
+  }
+
+  uint32_t airtimeUs = loraAirtimeUs(onAir, loraParams);
+  #if ENABLE_DUTY_CYCLE_LIMIT
+    if (!dutyCycleAllows(loraDutyCycle, airtimeUs)) {
+      loraDutyCycle.packetsDeferred++;
+      Serial.print("⏳ Duty cycle: TX deferred ");
+      Serial.print(dutyCycleWaitMs(loraDutyCycle, airtimeUs));
+      Serial.println(" ms");
+      return false;
+    }
+  #endif
+
+  // Plain bytes go straight behind the envelope header and are
+  // sealed where they lie - no second buffer
+  #if ENABLE_ENCRYPTION
+    memcpy(command + header + encHeaderLength(loraEnc), data, length);
+    if (encSeal(loraEnc, (uint8_t*)command + header, length) != onAir) {
+      Serial.println("❌ LoRa message not sealed");
+      return false;
+    }
+  #else
+    memcpy(command + header, data, length);
+  #endif
+
+  // RYLR896 answers +OK AFTER the message is transmitted,
+  // so the timeout follows the real air time at the current SF
+  if (!atEnqueue(loraAT, command, header + onAir, loraSendTimeout(length),
+                 callback, ctx)) {
+    Serial.println("❌ LoRa queue full");
     return false;
   }
+
+  // Charge the budget once the packet is certain to go out
+  #if ENABLE_DUTY_CYCLE_LIMIT
+    dutyCycleTryConsume(loraDutyCycle, airtimeUs);
+  #endif
+  loraAirtimeTotalMs += (airtimeUs + 999) / 1000;
+  return true;
 }
 
-// =============== RECEIVE MESSAGE ================================
-inline bool receiveLoRaMessage(DeviceState& remote, String& payload) {
-  if (!LoRaSerial.available()) {
+inline bool sendLoRaMessage(String message, uint8_t targetAddress,
+                            ATCallback callback = onLoRaSendDone, void* ctx = nullptr) {
+  return sendLoRaMessage((const uint8_t*)message.c_str(), message.length(),
+                         targetAddress, callback, ctx);
+}
+
+// =============== FEC UPLINK ================================
+// Telemetry/batch frames: FEC-wrapped with ENABLE_FEC, raw otherwise
+inline bool sendLoRaUplink(const uint8_t* data, uint8_t length, uint8_t targetAddress,
+                           ATCallback callback = onLoRaSendDone, void* ctx = nullptr) {
+  #if ENABLE_FEC
+    uint8_t frame[FEC_DATA_HEADER_LEN + FEC_DATA_MAX];
+    uint8_t frameLength = fecWrapData(loraFecTx, data, length, frame);
+    if (frameLength == 0 ||
+        !sendLoRaMessage(frame, frameLength, targetAddress, callback, ctx)) {
+      return false;
+    }
+    fecAddData(loraFecTx, data, length);  // Parity covers what was queued
+    return true;
+  #else
+    return sendLoRaMessage(data, length, targetAddress, callback, ctx);
+  #endif
+}
+
+// Uplink bytes on air for a payload (FEC header included)
+inline uint8_t loraUplinkLength(uint8_t length) {
+  return ENABLE_FEC ? length + FEC_DATA_HEADER_LEN : length;
+}
+
+#if ENABLE_FEC
+// A full group is waiting for its parity frames
+inline bool loraFecParityDue() {
+  return fecParityDue(loraFecTx);
+}
+
+inline bool sendLoRaParity(uint8_t targetAddress, ATCallback callback = onLoRaSendDone,
+                           void* ctx = nullptr) {
+  uint8_t frame[FEC_PARITY_HEADER_LEN + FEC_BLOCK_MAX];
+  uint8_t length = fecBuildParity(loraFecTx, frame);
+  if (!loraCanSend(length) ||
+      !sendLoRaMessage(frame, length, targetAddress, callback, ctx)) {
     return false;
   }
+  fecParitySent(loraFecTx);
+  return true;
+}
+#endif
 
-  // Read with timeout to avoid blocking (readStringUntil has 1s default timeout)
-  // Manual read is faster and more responsive
-  String response = "";
-  unsigned long start = millis();
-  while (millis() - start < 100) {  // 100ms timeout
-    if (LoRaSerial.available()) {
-      char c = LoRaSerial.read();
-      if (c == '\n' || c == '\r') {
-        if (response.length() > 0) break;  // Got complete line
-      } else {
-        response += c;
-      }
+// Frames lost for good since the last call (for packet statistics)
+inline unsigned long loraFecTakeLost() {
+  unsigned long lost = loraFecRx.unrecoverable - loraFecLostReported;
+  loraFecLostReported = loraFecRx.unrecoverable;
+  return lost;
+}
+
+// =============== PRINT PAYLOAD (debug) ================================
+// ASCII payloads as text, binary frames as hex
+inline void printLoRaPayload(const char* data, uint8_t len) {
+  if (len > 0 && ((uint8_t)data[0] & 0x80)) {
+    for (uint8_t i = 0; i < len; i++) {
+      uint8_t b = (uint8_t)data[i];
+      if (b < 0x10) Serial.print('0');
+      Serial.print(b, HEX);
     }
+  } else {
+    Serial.write((const uint8_t*)data, len);
   }
-  response.trim();
-  
-  // Check if it's a received message
-  if (response.startsWith("+RCV=")) {
-    // Parse: +RCV=sender,length,data,RSSI,SNR
-    // NOTE: Data field may contain commas! Use length to parse correctly.
-    int start = 5;  // Skip "+RCV="
-    int comma1 = response.indexOf(',', start);
-    int comma2 = response.indexOf(',', comma1 + 1);
-
-    if (comma1 > 0 && comma2 > 0) {
-      String sender = response.substring(start, comma1);
-      String lengthStr = response.substring(comma1 + 1, comma2);
-      int dataLength = lengthStr.toInt();
-
-      // Extract exact data length (data may contain commas!)
-      int dataStart = comma2 + 1;
-      payload = response.substring(dataStart, dataStart + dataLength);
-
-      // RSSI and SNR are after the data
-      int rssiStart = dataStart + dataLength + 1;  // +1 for comma
-      int comma3 = response.indexOf(',', rssiStart);
-
-      if (comma3 > 0) {
-        String rssiStr = response.substring(rssiStart, comma3);
-        String snrStr = response.substring(comma3 + 1);
-
-        remote.rssi = rssiStr.toInt();
-        remote.snr = snrStr.toInt();
-        remote.lastMessageTime = millis();  // Update last message timestamp!
-
-        Serial.print("📥 RX [");
-        Serial.print(payload);
-        Serial.print("] RSSI:");
-        Serial.print(remote.rssi);
-        Serial.print(" SNR:");
-        Serial.println(remote.snr);
-
-        return true;
-      }
+}
+
+// =============== RECEIVE PACKET (zero-copy) ================================
+// Returns a view into loraRxLine - valid until the next loraPoll().
+// No heap allocation anywhere on this path.
+inline bool receiveLoRaPacket(DeviceState& remote, RcvView& packet) {
+  // Frames rebuilt from FEC parity come out first (RSSI of the parity)
+  loraRxRecovered = false;
+  #if ENABLE_RELAY
+  loraRxRelayed = false;
+  #endif
+  const uint8_t* recovered;
+  if (fecTakeRecovered(loraFecRx, recovered, packet.len)) {
+    packet.data = (const char*)recovered;
+    packet.sender = loraFecSender;
+    packet.rssi = remote.rssi;
+    packet.snr = remote.snr;
+    loraRxRecovered = true;
+    loraRxKind = frameKind(packet.data, packet.len);
+    Serial.print("🛠️  FEC recovered [");
+    printLoRaPayload(packet.data, packet.len);
+    Serial.println("]");
+    return true;
+  }
+
+  // Lines are collected by the AT engine in loraPoll()
+  if (!loraRxPending) {
+    return false;
+  }
+  loraRxPending = false;
+
+  if (!parseRcvLine(loraRxLine, loraRxLength, packet)) {
+    loraRxMalformed++;
+    return false;
+  }
+
+  #if ENABLE_ENCRYPTION
+  // Opened in place (packet.data points into loraRxLine); rejected
+  // frames leave the link state alone
+  uint8_t* sealed = (uint8_t*)loraRxLine + (packet.data - loraRxLine);
+  uint8_t plainLength;
+  uint8_t plainOffset = encOpen(loraEnc, sealed, packet.len, packet.sender, millis(),
+                                plainLength);
+  if (!plainOffset) {
+    Serial.print("🔒 RX rejected from ");
+    Serial.println(packet.sender);
+    return false;
+  }
+  packet.data = (const char*)sealed + plainOffset;
+  packet.len = plainLength;
+  #endif
+
+  remote.rssi = packet.rssi;
+  remote.snr = packet.snr;
+  remote.lastMessageTime = millis();  // Update last message timestamp!
+
+  Serial.print("📥 RX [");
+  printLoRaPayload(packet.data, packet.len);
+  Serial.print("] RSSI:");
+  Serial.print(remote.rssi);
+  Serial.print(" SNR:");
+  Serial.println(remote.snr);
+
+  // One classification per layer; the caller dispatches on loraRxKind
+  loraRxKind = frameKind(packet.data, packet.len);
+
+  #if ENABLE_RELAY
+  // Relay envelope: the far sender becomes packet.sender. A resend is
+  // confirmed again (RELAY_ACK lost) but not delivered twice.
+  if (loraRxKind == FRAME_KIND_RELAY) {
+    if (!relayDecode((const uint8_t*)packet.data, packet.len, loraRelayPath)) {
+      loraRxMalformed++;
+      return false;
+    }
+    loraRelayVia = packet.sender;
+    loraRelayAckDue = loraRelayPath.ackRequest;
+    if (relayCacheSeen(loraRelayCache, loraRelayPath.source, loraRelayPath.seq)) {
+      return false;
     }
+    packet.sender = loraRelayPath.source;
+    packet.data = (const char*)loraRelayPath.inner;
+    packet.len = loraRelayPath.innerLen;
+    loraRxRelayed = true;
+    loraRxKind = frameKind(packet.data, packet.len);
   }
-  
-  return false;
+  #endif
+
+  // FEC: parity is consumed here, data frames are unwrapped
+  if (loraRxKind == FRAME_KIND_FEC_PARITY) {
+    if (fecAcceptParity(loraFecRx, (const uint8_t*)packet.data, packet.len)) {
+      loraFecSender = packet.sender;
+    }
+    return false;  // Rebuilt frames follow on the next calls
+  }
+  if (loraRxKind == FRAME_KIND_FEC_DATA) {
+    const uint8_t* payload;
+    if (!fecAcceptData(loraFecRx, (const uint8_t*)packet.data, packet.len,
+                       payload, packet.len)) {
+      return false;
+    }
+    packet.data = (const char*)payload;
+    loraRxKind = frameKind(packet.data, packet.len);
+  }
+
+  return true;
+}
+
+// =============== RECEIVE MESSAGE ================================
+// String wrapper for code that still parses payloads as String
+inline bool receiveLoRaMessage(DeviceState& remote, String& payload) {
+  RcvView packet;
+  if (!receiveLoRaPacket(remote, packet)) {
+    return false;
+  }
+
+  payload = "";
+  payload.reserve(packet.len);
+  payload.concat(packet.data, packet.len);
+  return true;
 }
 
 #endif // LORA_HANDLER_H
\ No newline at end of file
@@ -0,0 +1,177 @@
+/*=====================================================================
+  lora_rx.h - Zero-allocation LoRa Receive Path
+
+  Replaces the String-based "+RCV=" handling (String += per byte,
+  five substring() calls, toInt() per field) with:
+
+  1. RX ring buffer
+     - Fixed LORA_RX_RING_SIZE byte ring, single producer/consumer
+     - Producer: UART receive event (ESP32 core 2.x onReceive)
+       or loraPoll() when the event API is not available
+     - Consumer: AT engine, through LoRaRxStream
+     - Overflow is counted, never blocks
+
+  2. Zero-copy "+RCV=" tokenizer
+     - parseRcvLine() walks the line once, no heap, no copies
+     - Returns RcvView {sender, len, data, rssi, snr}
+     - data points INTO the line buffer (valid until next packet)
+     - Data may contain commas: the length prefix is used to find
+       the end of data, exactly like the old substring() code
+
+  Line format (RYLR896):
+    +RCV=<sender>,<length>,<data>,<RSSI>,<SNR>
+    +RCV=2,5,HELLO,-45,11
+
+  Both parts depend only on <Arduino.h> (Stream) so they compile on a
+  Linux host for fuzzing and benchmarking (host/fuzz_rcv.cpp).
+=======================================================================*/
+
+#ifndef LORA_RX_H
+#define LORA_RX_H
+
+#include <Arduino.h>
+
+// Ring size must be a power of two (index masking)
+#define LORA_RX_RING_SIZE 1024
+
+// =============== RX RING BUFFER ================================
+struct LoRaRxRing {
+  uint8_t data[LORA_RX_RING_SIZE];
+  volatile uint16_t head;       // Written by producer only
+  volatile uint16_t tail;       // Written by consumer only
+  volatile unsigned long overflows;
+  uint16_t highWater;           // Max fill level seen (consumer side)
+};
+
+inline uint16_t rxRingAvailable(const LoRaRxRing& ring) {
+  return (uint16_t)(ring.head - ring.tail) & (LORA_RX_RING_SIZE - 1);
+}
+
+// Producer side (UART event / polled drain)
+inline bool rxRingPush(LoRaRxRing& ring, uint8_t c) {
+  uint16_t next = (ring.head + 1) & (LORA_RX_RING_SIZE - 1);
+  if (next == ring.tail) {
+    ring.overflows++;
+    return false;  // Full - drop byte
+  }
+  ring.data[ring.head] = c;
+  ring.head = next;
+  return true;
+}
+
+// Consumer side (AT engine)
+inline int rxRingPop(LoRaRxRing& ring) {
+  if (ring.tail == ring.head) return -1;
+  uint8_t c = ring.data[ring.tail];
+  ring.tail = (ring.tail + 1) & (LORA_RX_RING_SIZE - 1);
+  return c;
+}
+
+// =============== RING AS STREAM (for the AT engine) ================================
+// Reads come from the ring, writes go straight to the UART.
+class LoRaRxStream : public Stream {
+private:
+  LoRaRxRing* ring;
+  Stream* uart;
+
+public:
+  LoRaRxStream(LoRaRxRing& rxRing, Stream& txUart) : ring(&rxRing), uart(&txUart) {}
+
+  int available() override {
+    uint16_t n = rxRingAvailable(*ring);
+    if (n > ring->highWater) ring->highWater = n;
+    return n;
+  }
+  int read() override { return rxRingPop(*ring); }
+  int peek() override {
+    return (ring->tail == ring->head) ? -1 : ring->data[ring->tail];
+  }
+  size_t write(uint8_t c) override { return uart->write(c); }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    return uart->write(buffer, size);
+  }
+  void flush() override { uart->flush(); }
+};
+
+// =============== ZERO-COPY +RCV TOKENIZER ================================
+struct RcvView {
+  uint16_t sender;     // LoRa address of sender
+  uint8_t len;         // Payload length (bytes)
+  const char* data;    // Points into the line - NOT NUL-terminated!
+  int16_t rssi;        // dBm
+  int8_t snr;          // dB
+};
+
+// Parse unsigned/signed decimal at p (stops at end or non-digit)
+inline bool rcvParseInt(const char*& p, const char* end, long& value) {
+  bool negative = false;
+  if (p < end && *p == '-') {
+    negative = true;
+    p++;
+  }
+  if (p >= end || *p < '0' || *p > '9') return false;
+
+  long v = 0;
+  int digits = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    v = v * 10 + (*p - '0');
+    p++;
+    if (++digits > 6) return false;  // Far beyond any valid field
+  }
+  value = negative ? -v : v;
+  return true;
+}
+
+// Parse "+RCV=sender,len,data,rssi,snr". Returns false on malformed
+// input; out is only valid when true is returned.
+inline bool parseRcvLine(const char* line, uint16_t n, RcvView& out) {
+  const char* p = line;
+  const char* end = line + n;
+  long value;
+
+  if (n < 5 || memcmp(p, "+RCV=", 5) != 0) return false;
+  p += 5;
+
+  // Sender address
+  if (!rcvParseInt(p, end, value) || value < 0 || value > 65535) return false;
+  out.sender = (uint16_t)value;
+  if (p >= end || *p++ != ',') return false;
+
+  // Payload length (RYLR896 max 240)
+  if (!rcvParseInt(p, end, value) || value < 0 || value > 240) return false;
+  out.len = (uint8_t)value;
+  if (p >= end || *p++ != ',') return false;
+
+  // Data: exactly len bytes, may contain commas
+  if (end - p < out.len + 1) return false;
+  out.data = p;
+  p += out.len;
+  if (*p++ != ',') return false;
+
+  // RSSI
+  if (!rcvParseInt(p, end, value) || value < -200 || value > 0) return false;
+  out.rssi = (int16_t)value;
+  if (p >= end || *p++ != ',') return false;
+
+  // SNR (rest of line)
+  if (!rcvParseInt(p, end, value) || value < -128 || value > 127) return false;
+  out.snr = (int8_t)value;
+
+  return p == end;
+}
+
+// Length of the data field of a partial "+RCV=" line once both header
+// commas have arrived, -1 before that. Used by the AT engine to read
+// binary payloads that contain '\r' or '\n'.
+inline int rcvHeaderDataLength(const char* line, uint16_t n) {
+  if (n < 5 || memcmp(line, "+RCV=", 5) != 0) return -1;
+
+  const char* p = line + 5;
+  const char* end = line + n;
+  long value;
+  if (!rcvParseInt(p, end, value) || p >= end || *p++ != ',') return -1;
+  if (!rcvParseInt(p, end, value) || p >= end || *p != ',' || p + 1 != end) return -1;
+  return (value >= 0 && value <= 240) ? (int)value : -1;
+}
+
+#endif // LORA_RX_H
@@ -0,0 +1,130 @@
+/*=====================================================================
+  mac_layer.h - Uplink Medium Access (jitter, backoff, TDMA)
+
+  A fixed `millis() - lastSend >= SEND_INTERVAL` cadence keeps senders
+  that were powered on together phase-locked: at SF12 every packet of
+  every sender collides, forever (crystal drift of ±50 ppm needs hours
+  to separate them). This layer decides WHEN the next uplink may go:
+
+  1. Random start phase - first uplink somewhere in [0, interval)
+  2. Jitter - each interval is interval ± MAC_JITTER_PCT (mean stays
+     the same, so throughput and duty cycle do not change)
+  3. Exponential backoff - a missed ACK slot means collision or fade:
+     the next uplink waits an extra random 0..2^n-1 packet air times
+     (n = missed slots in a row, max MAC_BACKOFF_MAX_EXP), an ACK
+     resets n
+  4. TDMA (ENABLE_MAC_TDMA) - the receiver owns the schedule:
+
+       frame = TDMA_SLOT_COUNT × TDMA_SLOT_MS (receiver's millis())
+       |slot 0 |slot 1 |slot 2 | ... |  node table slot % count
+
+     The receiver measures where an uplink started in its frame and
+     puts the signed correction (ms) into the ACK. The sender shifts
+     its next uplink by that amount and then sends once per frame.
+     No shared clock needed - every ACK re-aligns the sender, so
+     crystal drift never accumulates past ACK_INTERVAL frames. Backoff
+     in TDMA skips whole frames and keeps the slot. With time beacons
+     (time_sync.h) the slot start comes straight from the receiver
+     clock estimate (macOnSlot()) and ACK corrections are not needed.
+
+  The receiver side is the pure macTdmaShift() - a slot must hold the
+  uplink, ACK_SLOT_OFFSET and the ACK (checked in setup()).
+
+  Pure C++ (no String, no heap) - host-testable.
+  Multi-sender behaviour: host/sim/ (link_sim_mac_* --sweep N)
+=======================================================================*/
+
+#ifndef MAC_LAYER_H
+#define MAC_LAYER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define TDMA_FRAME_MS ((unsigned long)TDMA_SLOT_COUNT * TDMA_SLOT_MS)
+
+struct TxMac {
+  unsigned long nextSend;          // Earliest next uplink (millis)
+  unsigned long lastSend;
+  unsigned long interval;          // Mean interval (TDMA: frame length)
+  uint16_t airtimeMs;              // Last uplink air time = backoff unit
+  uint8_t backoffExp;              // Missed ACK slots in a row (capped)
+  bool tdmaSynced;                 // Receiver has placed us in a slot
+
+  // Statistics
+  unsigned long backoffs;
+  unsigned long backoffMs;         // Total extra wait
+  unsigned long tdmaCorrections;
+  int16_t tdmaLastShift;
+};
+
+// Random in [0, n) - hardware RNG, never the same sequence on two nodes
+inline unsigned long macRandom(unsigned long n) {
+  return n ? esp_random() % n : 0;
+}
+
+inline void macInit(TxMac& mac, unsigned long interval, unsigned long now) {
+  memset(&mac, 0, sizeof(mac));
+  mac.interval = interval;
+  mac.lastSend = now;
+  mac.nextSend = now + macRandom(interval);  // Random start phase
+}
+
+inline bool macDue(const TxMac& mac, unsigned long now) {
+  return (long)(now - mac.nextSend) >= 0;
+}
+
+// Uplink queued: next one interval later (jittered unless in a TDMA slot)
+inline void macOnSend(TxMac& mac, unsigned long now, uint16_t airtimeMs) {
+  mac.lastSend = now;
+  mac.airtimeMs = airtimeMs;
+
+  unsigned long next = mac.interval;
+  if (!mac.tdmaSynced) {
+    unsigned long jitter = mac.interval * MAC_JITTER_PCT / 100;
+    next = next - jitter + macRandom(2 * jitter + 1);
+  }
+  mac.nextSend = now + next;
+}
+
+inline void macOnAck(TxMac& mac) {
+  mac.backoffExp = 0;
+}
+
+// ACK slot closed empty: wait 0..2^n-1 extra air times before the next
+// uplink (whole frames in TDMA - the slot position is kept)
+inline void macOnAckMissed(TxMac& mac) {
+  if (mac.backoffExp < MAC_BACKOFF_MAX_EXP) mac.backoffExp++;
+  unsigned long unit = mac.tdmaSynced ? mac.interval : mac.airtimeMs;
+  unsigned long extra = macRandom(1UL << mac.backoffExp) * unit;
+  mac.nextSend += extra;
+  mac.backoffs++;
+  mac.backoffMs += extra;
+}
+
+// Next uplink at a known slot start (time_sync.h: receiver clock)
+inline void macOnSlot(TxMac& mac, unsigned long slotStart) {
+  mac.nextSend = slotStart;
+  mac.tdmaSynced = true;
+}
+
+// ACK carried a TDMA correction for the uplink sent at lastSend
+inline void macOnTdma(TxMac& mac, int16_t shiftMs) {
+  mac.nextSend = mac.lastSend + mac.interval + shiftMs;
+  mac.tdmaSynced = true;
+  mac.tdmaCorrections++;
+  mac.tdmaLastShift = shiftMs;
+}
+
+// =============== RECEIVER: TDMA SCHEDULE ================================
+// Signed move (ms) that puts an uplink which started at txStart
+// (receiver's millis()) at the start of its slot, in (-frame/2, frame/2]
+inline int16_t macTdmaShift(uint8_t slot, unsigned long txStart) {
+  long frame = TDMA_FRAME_MS;
+  long target = (long)(slot % TDMA_SLOT_COUNT) * TDMA_SLOT_MS;
+  long shift = target - (long)(txStart % frame);
+  if (shift > frame / 2) shift -= frame;
+  if (shift <= -frame / 2) shift += frame;
+  return (int16_t)shift;
+}
+
+#endif // MAC_LAYER_H
@@ -0,0 +1,191 @@
+/*=====================================================================
+  node_table.h - Gateway Node Table (one receiver, many senders)
+
+  Normal mode pairs one receiver with one sender (LORA_SENDER_ADDRESS,
+  a single `remote` and `health`). In gateway mode (ENABLE_GATEWAY_MODE)
+  the receiver serves a fleet on the same LORA_NETWORK_ID and keeps the
+  per-sender state here:
+
+    nodeIndex[address] ──► nodes[slot] { DeviceState, HealthMonitor,
+                                         reliable window, counters }
+
+  - Fixed capacity (GATEWAY_MAX_NODES), no heap, entries contiguous
+  - Lookup per +RCV is O(1): 256-byte index by LoRa address (0 = free)
+  - A full table rejects new addresses (counted) - known nodes keep
+    their slot for the whole uptime
+
+  Global `remote`/`health` stay as the CHANNEL view (any packet → RSSI,
+  last message time, LCD, recovery when the whole fleet went silent).
+  Sequence tracking, loss and connection state are per node only -
+  interleaved sequence numbers of different senders would look like
+  loss on a single monitor.
+
+  Output (per node):
+  - DATA_NODE,TIMESTAMP,ADDR,RSSI,SNR,SEQ,MSG_COUNT,CONN_STATE,PACKET_LOSS,LED,TOUCH
+  - Node table report (replaces the single health report)
+  - One line per state change: "📡 Node 7: OK -> WEAK"
+
+  Senders need distinct addresses: LORA_SENDER_ADDRESS_AUTO derives one
+  from the chip MAC so the fleet can still run identical code.
+=======================================================================*/
+
+#ifndef NODE_TABLE_H
+#define NODE_TABLE_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "structs.h"
+#include "health_monitor.h"
+#if ENABLE_RELIABLE_LINK
+  #include "reliable_link.h"
+#endif
+
+#define NODE_ADDRESS_SPACE 256     // RcvView sender addresses mapped 0-255
+
+struct NodeEntry {
+  uint8_t address;
+  DeviceState state;               // Latest telemetry, RSSI/SNR, last seen
+  HealthMonitor health;            // Sequence tracking, loss, connection state
+  #if ENABLE_RELIABLE_LINK
+  ReliableReceiver rel;            // Each sender has its own session/window
+  #endif
+};
+
+struct NodeTable {
+  NodeEntry nodes[GATEWAY_MAX_NODES];
+  uint8_t index[NODE_ADDRESS_SPACE];  // Address → slot + 1 (0 = unknown)
+  uint8_t count;
+
+  // Statistics
+  unsigned long rejected;          // Packets from nodes that did not fit
+};
+
+inline void nodeTableInit(NodeTable& table) {
+  memset(&table, 0, sizeof(table));
+}
+
+// Known node or nullptr
+inline NodeEntry* nodeLookup(NodeTable& table, uint16_t address) {
+  if (address >= NODE_ADDRESS_SPACE) return nullptr;
+  uint8_t slot = table.index[address];
+  return slot ? &table.nodes[slot - 1] : nullptr;
+}
+
+// Known node, or a new slot for it; nullptr if the table is full
+inline NodeEntry* nodeFindOrAdd(NodeTable& table, uint16_t address) {
+  NodeEntry* node = nodeLookup(table, address);
+  if (node) return node;
+
+  if (address >= NODE_ADDRESS_SPACE || table.count >= GATEWAY_MAX_NODES) {
+    table.rejected++;
+    return nullptr;
+  }
+
+  node = &table.nodes[table.count++];
+  table.index[address] = table.count;
+  memset(node, 0, sizeof(*node));
+  node->address = address;
+  node->state.lastMessageTime = millis();
+  initHealthMonitor(node->health, false);
+  #if ENABLE_RELIABLE_LINK
+  relReceiverInit(node->rel);
+  #endif
+
+  Serial.print("📡 New node ");
+  Serial.print(address);
+  Serial.print(" (");
+  Serial.print(table.count);
+  Serial.print("/");
+  Serial.print(GATEWAY_MAX_NODES);
+  Serial.println(")");
+  return node;
+}
+
+// Connection state of every node (call every loop - cheap, no output
+// unless a state changes)
+inline void nodeTableUpdate(NodeTable& table) {
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < table.count; i++) {
+    NodeEntry& node = table.nodes[i];
+    ConnectionState oldState = node.health.state;
+    ConnectionState newState = nextConnectionState(node.health, node.state, now);
+    if (newState == oldState) continue;
+
+    node.health.state = newState;
+    node.health.stateChangeTime = now;
+    if (newState == CONN_CONNECTED) node.health.connectedSince = now;
+
+    Serial.print("📡 Node ");
+    Serial.print(node.address);
+    Serial.print(": ");
+    Serial.print(getConnectionStateString(oldState));
+    Serial.print(" -> ");
+    Serial.println(getConnectionStateString(newState));
+  }
+}
+
+inline uint8_t nodeTableOnline(const NodeTable& table) {
+  uint8_t online = 0;
+  for (uint8_t i = 0; i < table.count; i++) {
+    ConnectionState s = table.nodes[i].health.state;
+    if (s == CONN_CONNECTED || s == CONN_WEAK) online++;
+  }
+  return online;
+}
+
+// =============== OUTPUT ================================
+// Format: DATA_NODE,TIMESTAMP,ADDR,RSSI,SNR,SEQ,MSG_COUNT,CONN_STATE,PACKET_LOSS,LED,TOUCH
+inline void printNodeTableCSV(NodeTable& table) {
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < table.count; i++) {
+    NodeEntry& node = table.nodes[i];
+    Serial.print("DATA_NODE,");
+    Serial.print(now);
+    Serial.print(",");
+    Serial.print(node.address);
+    Serial.print(",");
+    Serial.print(node.state.rssi);
+    Serial.print(",");
+    Serial.print(node.state.snr);
+    Serial.print(",");
+    Serial.print(node.state.sequenceNumber);
+    Serial.print(",");
+    Serial.print(node.state.messageCount);
+    Serial.print(",");
+    Serial.print(getConnectionStateString(node.health.state));
+    Serial.print(",");
+    Serial.print(getPacketLoss(node.health), 2);
+    Serial.print(",");
+    Serial.print(node.state.ledState);
+    Serial.print(",");
+    Serial.println(node.state.touchState);
+  }
+}
+
+inline void printNodeTable(NodeTable& table) {
+  unsigned long now = millis();
+  Serial.println("\n╔══════════════ GATEWAY NODES ══════════════╗");
+  Serial.print("║ Nodes: ");
+  Serial.print(table.count);
+  Serial.print("/");
+  Serial.print(GATEWAY_MAX_NODES);
+  Serial.print(", online: ");
+  Serial.print(nodeTableOnline(table));
+  Serial.print(", rejected: ");
+  Serial.println(table.rejected);
+  Serial.println("║ ADDR STATE    RSSI  SNR    RX  LOSS%  AGE s");
+
+  char line[64];
+  for (uint8_t i = 0; i < table.count; i++) {
+    NodeEntry& node = table.nodes[i];
+    snprintf(line, sizeof(line), "║ %4u %-7s %5d %4d %5d %6.1f %6lu",
+             node.address, getConnectionStateString(node.health.state),
+             getRSSIAverage(node.health), node.state.snr,
+             node.health.packetsReceived, getPacketLoss(node.health),
+             (now - node.state.lastMessageTime) / 1000);
+    Serial.println(line);
+  }
+  Serial.println("╚═══════════════════════════════════════════╝\n");
+}
+
+#endif // NODE_TABLE_H
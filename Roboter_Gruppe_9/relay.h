@@ -0,0 +1,287 @@
+/*=====================================================================
+  relay.h - Store-and-Forward Relay (repeater role)
+
+  A sender beyond the receiver's range at SF12 is often in easy reach
+  of a node halfway there. The relay role (GPIO16 jumpered to 3V3)
+  carries its frames the rest of the way:
+
+    far sender ──hop 1──► relay ──hop 2──► (relay ──►) receiver
+               ◄─ ACK ──        ◄─ RELAY_ACK ─
+
+  - Far sender sends to LORA_UPLINK_VIA instead of the receiver; the
+    relay answers its ACK requests in the usual ACK slot (state ACK)
+  - Relay wraps the frame into an envelope (source, relay seq, TTL,
+    hop RSSI) and forwards it to RELAY_NEXT_HOP; every hop asks for a
+    RELAY_ACK in the slot and resends up to RELAY_MAX_TRIES times
+  - A relay that hears an envelope forwards it with one more hop RSSI
+    and TTL - 1; TTL 0 is dropped (routing loop guard)
+  - Relays and the receiver drop (source, seq) pairs seen in the last
+    RELAY_CACHE_SIZE envelopes - a resend after a lost RELAY_ACK is
+    answered again but delivered once
+  - Receiver unwraps the envelope in receiveLoRaPacket(): the source
+    becomes packet.sender, so node table, health and ACK logic see the
+    far sender as if it were in range
+
+  Envelope:
+
+  Byte   | Field
+  -------|------------------------------------------------------------
+  0      | type 0x8A
+  1      | source address (far sender)
+  2      | seq (first relay's counter, dedupe key with source)
+  3      | bits 0-2 hops, bits 3-6 TTL left, bit 7 RELAY_ACK request
+  4..    | RSSI per hop (-dBm, 1 byte each, oldest first)
+  4+hops | inner frame (telemetry, batch or legacy ASCII - unchanged)
+
+  RELAY_ACK: | 0 type 0x8B | 1 source | 2 seq |
+
+  All hops share one SF (loraParams). SF9 gives up 7.5 dB against
+  SF12 (airtime.h SNR floor); half the distance near the ground wins
+  back ~10 dB (path loss exponent ~3.5), so two SF9 hops keep the
+  margin of one SF12 link at well under half the air time.
+
+  Pure C++ (no String, no heap) - host-testable.
+=======================================================================*/
+
+#ifndef RELAY_H
+#define RELAY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define FRAME_TYPE_RELAY     0x8A
+#define FRAME_TYPE_RELAY_ACK 0x8B
+
+#define RELAY_HEADER_LEN 4
+#define RELAY_ACK_LEN 3
+#define RELAY_MAX_HOPS 7             // 3-bit hop count
+#if ENABLE_ENCRYPTION
+  #define RELAY_FRAME_MAX 230        // RYLR896 limit 240 - AES-CCM envelope (encryption.h)
+#else
+  #define RELAY_FRAME_MAX 240        // RYLR896 payload limit
+#endif
+#define RELAY_INNER_MAX (RELAY_FRAME_MAX - RELAY_HEADER_LEN - RELAY_MAX_HOPS)
+
+#define RELAY_FLAG_ACK_REQ 0x80
+
+// =============== ENVELOPE ================================
+struct RelayHeader {
+  uint8_t source;
+  uint8_t seq;
+  uint8_t hops;
+  uint8_t ttl;
+  bool ackRequest;
+  int16_t hopRssi[RELAY_MAX_HOPS];  // dBm, oldest hop first
+  const uint8_t* inner;
+  uint8_t innerLen;
+};
+
+inline bool isRelayFrame(const char* data, uint8_t len) {
+  return len > RELAY_HEADER_LEN && (uint8_t)data[0] == FRAME_TYPE_RELAY;
+}
+
+inline bool relayDecode(const uint8_t* data, uint8_t len, RelayHeader& h) {
+  if (len <= RELAY_HEADER_LEN || data[0] != FRAME_TYPE_RELAY) return false;
+  h.source = data[1];
+  h.seq = data[2];
+  h.hops = data[3] & 0x07;
+  h.ttl = (data[3] >> 3) & 0x0F;
+  h.ackRequest = (data[3] & RELAY_FLAG_ACK_REQ) != 0;
+  if (len <= RELAY_HEADER_LEN + h.hops) return false;
+  for (uint8_t i = 0; i < h.hops; i++) h.hopRssi[i] = -(int16_t)data[RELAY_HEADER_LEN + i];
+  h.inner = data + RELAY_HEADER_LEN + h.hops;
+  h.innerLen = len - RELAY_HEADER_LEN - h.hops;
+  return true;
+}
+
+// Envelope with h's hops plus one more (RSSI heard on this hop).
+// Returns length, 0 if the frame would not fit.
+inline uint8_t relayEncode(uint8_t* out, const RelayHeader& h, int16_t rssi, bool ackRequest) {
+  if (h.hops >= RELAY_MAX_HOPS || h.innerLen > RELAY_INNER_MAX) return 0;
+  out[0] = FRAME_TYPE_RELAY;
+  out[1] = h.source;
+  out[2] = h.seq;
+  out[3] = (h.hops + 1) | (h.ttl & 0x0F) << 3 | (ackRequest ? RELAY_FLAG_ACK_REQ : 0);
+  uint8_t n = RELAY_HEADER_LEN;
+  for (uint8_t i = 0; i < h.hops; i++) out[n++] = (uint8_t)-h.hopRssi[i];
+  out[n++] = rssi <= -255 ? 255 : rssi >= 0 ? 0 : (uint8_t)-rssi;
+  memcpy(out + n, h.inner, h.innerLen);
+  return n + h.innerLen;
+}
+
+inline uint8_t relayEncodeAck(uint8_t* out, uint8_t source, uint8_t seq) {
+  out[0] = FRAME_TYPE_RELAY_ACK;
+  out[1] = source;
+  out[2] = seq;
+  return RELAY_ACK_LEN;
+}
+
+inline bool relayDecodeAck(const char* data, uint8_t len, uint8_t& source, uint8_t& seq) {
+  if (len != RELAY_ACK_LEN || (uint8_t)data[0] != FRAME_TYPE_RELAY_ACK) return false;
+  source = (uint8_t)data[1];
+  seq = (uint8_t)data[2];
+  return true;
+}
+
+// =============== DUPLICATE CACHE ================================
+// Last RELAY_CACHE_SIZE (source, seq) pairs, oldest overwritten
+struct RelayCache {
+  uint16_t key[RELAY_CACHE_SIZE];
+  uint8_t head;
+  uint8_t count;
+  unsigned long duplicates;        // Frames dropped as seen before
+};
+
+inline void relayCacheInit(RelayCache& c) {
+  memset(&c, 0, sizeof(c));
+}
+
+// True if seen before; otherwise remembers it
+inline bool relayCacheSeen(RelayCache& c, uint8_t source, uint8_t seq) {
+  uint16_t key = (uint16_t)source << 8 | seq;
+  for (uint8_t i = 0; i < c.count; i++) {
+    if (c.key[i] == key) {
+      c.duplicates++;
+      return true;
+    }
+  }
+  c.key[c.head] = key;
+  c.head = (c.head + 1) % RELAY_CACHE_SIZE;
+  if (c.count < RELAY_CACHE_SIZE) c.count++;
+  return false;
+}
+
+// =============== FORWARDING QUEUE ================================
+struct RelayEntry {
+  uint8_t source;
+  uint8_t seq;
+  uint8_t len;
+  uint8_t tries;                   // Sends so far
+  uint8_t data[RELAY_FRAME_MAX];
+};
+
+struct RelayQueue {
+  RelayEntry ring[RELAY_QUEUE_SIZE];
+  uint8_t head;                    // Oldest = next to send
+  uint8_t count;
+  uint8_t nextSeq;                 // Seq for frames wrapped here
+
+  // Statistics
+  unsigned long received;          // Frames taken in (wrapped + forwarded)
+  unsigned long forwarded;         // Confirmed by the next hop
+  unsigned long expired;           // TTL used up
+  unsigned long overflows;         // Queue full on arrival
+  unsigned long failed;            // RELAY_MAX_TRIES without RELAY_ACK
+};
+
+inline void relayQueueInit(RelayQueue& q) {
+  memset(&q, 0, sizeof(q));
+}
+
+inline RelayEntry* relayFront(RelayQueue& q) {
+  return q.count ? &q.ring[q.head] : nullptr;
+}
+
+inline void relayPop(RelayQueue& q) {
+  if (!q.count) return;
+  q.head = (q.head + 1) % RELAY_QUEUE_SIZE;
+  q.count--;
+}
+
+// Queue h for the next hop with this hop's RSSI. Full queue drops the
+// newcomer - the frames ahead already have sends invested.
+inline bool relayEnqueue(RelayQueue& q, const RelayHeader& h, int16_t rssi) {
+  q.received++;
+  if (q.count >= RELAY_QUEUE_SIZE) {
+    q.overflows++;
+    return false;
+  }
+  RelayEntry& e = q.ring[(q.head + q.count) % RELAY_QUEUE_SIZE];
+  e.len = relayEncode(e.data, h, rssi, true);
+  if (!e.len) return false;
+  e.source = h.source;
+  e.seq = h.seq;
+  e.tries = 0;
+  q.count++;
+  return true;
+}
+
+// Raw frame from a far sender: first hop of a new envelope
+inline bool relayWrap(RelayQueue& q, uint8_t source, const uint8_t* frame, uint8_t len,
+                      int16_t rssi) {
+  RelayHeader h;
+  h.source = source;
+  h.seq = q.nextSeq++;
+  h.hops = 0;
+  h.ttl = RELAY_TTL;
+  h.ackRequest = true;
+  h.inner = frame;
+  h.innerLen = len;
+  return relayEnqueue(q, h, rssi);
+}
+
+// Envelope from an upstream relay: one hop more, TTL - 1
+inline bool relayForward(RelayQueue& q, RelayHeader h, int16_t rssi) {
+  if (h.ttl == 0) {
+    q.received++;
+    q.expired++;
+    return false;
+  }
+  h.ttl--;
+  return relayEnqueue(q, h, rssi);
+}
+
+// RELAY_ACK from the next hop: front entry delivered
+inline bool relayOnAck(RelayQueue& q, uint8_t source, uint8_t seq) {
+  RelayEntry* e = relayFront(q);
+  if (!e || e->source != source || e->seq != seq) return false;
+  relayPop(q);
+  q.forwarded++;
+  return true;
+}
+
+// RELAY_ACK slot closed empty: resend, or give up after RELAY_MAX_TRIES
+inline void relayOnAckMissed(RelayQueue& q) {
+  RelayEntry* e = relayFront(q);
+  if (e && e->tries >= RELAY_MAX_TRIES) {
+    relayPop(q);
+    q.failed++;
+  }
+}
+
+// =============== STATUS ================================
+// "🔁 Node 7 via 4: -118 → -96 dBm (2 hops)" - last value heard here
+inline void printRelayPath(const RelayHeader& h, uint16_t via, int16_t lastRssi) {
+  Serial.print("🔁 Node ");
+  Serial.print(h.source);
+  Serial.print(" via ");
+  Serial.print(via);
+  Serial.print(": ");
+  for (uint8_t i = 0; i < h.hops; i++) {
+    Serial.print(h.hopRssi[i]);
+    Serial.print(" → ");
+  }
+  Serial.print(lastRssi);
+  Serial.print(" dBm (");
+  Serial.print(h.hops + 1);
+  Serial.println(" hops)");
+}
+
+inline void printRelayStatus(const RelayQueue& q, const RelayCache& c) {
+  Serial.print("Relay: ");
+  Serial.print(q.forwarded);
+  Serial.print("/");
+  Serial.print(q.received);
+  Serial.print(" forwarded, queued: ");
+  Serial.print(q.count);
+  Serial.print(", duplicates: ");
+  Serial.print(c.duplicates);
+  Serial.print(", TTL expired: ");
+  Serial.print(q.expired);
+  Serial.print(", overflow: ");
+  Serial.print(q.overflows);
+  Serial.print(", failed: ");
+  Serial.println(q.failed);
+}
+
+#endif // RELAY_H
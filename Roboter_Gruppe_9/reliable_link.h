@@ -0,0 +1,283 @@
+/*=====================================================================
+  reliable_link.h - Selective-Repeat ARQ (guaranteed delivery channel)
+
+  Telemetry stays fire-and-forget: a lost snapshot is replaced by the
+  next one. Fire alarms and remote commands are different - they must
+  arrive. This channel gives them a guarantee:
+
+  - Sender keeps every message in a retransmit ring (REL_WINDOW
+    entries) until the receiver confirms it
+  - Every reliable frame asks for an ACK; the receiver answers in the
+    ACK slot (ack_slot.h) with a 32-bit bitmap of what it has seen
+  - Only the gaps are resent - a lost ACK does not force a resend when
+    a later bitmap confirms the frame anyway
+
+  Frame schemas:
+
+  Data  | 0 type 0x84 | 1 session | 2 seq | 3 kind | 4.. payload
+  ACK   | 0 type 0x85 | 1 session | 2 top | 3-6 bitmap (little endian)
+
+  top    = newest seq the receiver has seen
+  bitmap = bit i set → seq (top - i) received (bit 0 = top itself)
+
+  session: random byte chosen at sender boot. A new session resets the
+  receiver window, so a rebooted sender starting from seq 0 is not
+  mistaken for duplicates. ACKs of another session are ignored.
+
+  Retransmit order: alerts before commands (tx_queue.h priorities);
+  within each, bitmap gaps first, then new messages, then frames with
+  no answer for REL_RETRY_MS. After REL_MAX_TRIES sends the message is
+  given up (counted as failed).
+
+  Delivery is immediate and duplicate-free, not re-ordered: alerts and
+  commands are independent messages.
+
+  Pure C++ (no String, no heap) - host-testable: host/test_reliable_link.cpp
+  feeds relEncode() output through a lossy link into relAccept(), and
+  the receiver's relEncodeAck() back into relOnAck().
+=======================================================================*/
+
+#ifndef RELIABLE_LINK_H
+#define RELIABLE_LINK_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define FRAME_TYPE_RELIABLE 0x84
+#define FRAME_TYPE_REL_ACK  0x85
+
+#define REL_PAYLOAD_MAX 32         // Bytes per message
+#define REL_HEADER_LEN 4
+#define REL_FRAME_MAX (REL_HEADER_LEN + REL_PAYLOAD_MAX)
+#define REL_ACK_LEN 7
+#define REL_HISTORY 32             // Bitmap width
+
+// Message kinds
+#define REL_KIND_ALERT   1         // Fire alarm: [method bits][alert count varint]
+#define REL_KIND_COMMAND 2         // ASCII "CMD:..." (processRemoteKillSwitch etc.)
+
+#define REL_ALERT_AUDIO  0x01
+#define REL_ALERT_LIGHT  0x02
+
+// =============== SENDER ================================
+struct RelEntry {
+  uint8_t seq;
+  uint8_t kind;
+  uint8_t len;
+  uint8_t data[REL_PAYLOAD_MAX];
+  uint8_t tries;             // 0 = not sent yet
+  bool gap;                  // Receiver bitmap reports it missing
+  bool done;                 // Confirmed or given up
+  unsigned long queuedAt;    // Detection time (alert latency)
+  unsigned long sentAt;
+};
+
+struct ReliableSender {
+  RelEntry ring[REL_WINDOW];
+  uint8_t head;              // Oldest entry
+  uint8_t count;
+  uint8_t nextSeq;
+  uint8_t session;
+
+  // Statistics
+  unsigned long queued;
+  unsigned long delivered;
+  unsigned long retransmits;
+  unsigned long failed;      // Gave up after REL_MAX_TRIES
+  unsigned long rejected;    // Ring full
+};
+
+inline void relSenderInit(ReliableSender& s, uint8_t session) {
+  memset(&s, 0, sizeof(s));
+  s.session = session;
+}
+
+inline RelEntry& relEntry(ReliableSender& s, uint8_t i) {
+  return s.ring[(s.head + i) % REL_WINDOW];
+}
+
+// Drop confirmed/abandoned entries from the front of the ring
+inline void relCompact(ReliableSender& s) {
+  while (s.count > 0 && s.ring[s.head].done) {
+    s.head = (s.head + 1) % REL_WINDOW;
+    s.count--;
+  }
+}
+
+inline bool relQueue(ReliableSender& s, uint8_t kind, const uint8_t* data, uint8_t len) {
+  if (s.count >= REL_WINDOW || len > REL_PAYLOAD_MAX) {
+    s.rejected++;
+    return false;
+  }
+  RelEntry& e = relEntry(s, s.count);
+  e.seq = s.nextSeq++;
+  e.kind = kind;
+  e.len = len;
+  memcpy(e.data, data, len);
+  e.tries = 0;
+  e.gap = false;
+  e.done = false;
+  e.queuedAt = millis();
+  e.sentAt = 0;
+  s.count++;
+  s.queued++;
+  return true;
+}
+
+inline RelEntry* relFind(ReliableSender& s, uint8_t seq) {
+  for (uint8_t i = 0; i < s.count; i++) {
+    RelEntry& e = relEntry(s, i);
+    if (!e.done && e.seq == seq) return &e;
+  }
+  return nullptr;
+}
+
+// Entry to transmit now, nullptr if nothing is due
+inline RelEntry* relNextToSend(ReliableSender& s, unsigned long retryMs) {
+  unsigned long now = millis();
+
+  // Give up on messages that used all their tries
+  for (uint8_t i = 0; i < s.count; i++) {
+    RelEntry& e = relEntry(s, i);
+    if (!e.done && e.tries >= REL_MAX_TRIES && (e.gap || now - e.sentAt >= retryMs)) {
+      e.done = true;
+      s.failed++;
+    }
+  }
+  relCompact(s);
+
+  // Rank: alert before command, then gap → new → unanswered
+  RelEntry* best = nullptr;
+  uint8_t bestRank = 0xFF;
+  for (uint8_t i = 0; i < s.count; i++) {
+    RelEntry& e = relEntry(s, i);
+    if (e.done) continue;
+    uint8_t rank;
+    if (e.gap) rank = 0;                                // 1. Bitmap gaps
+    else if (e.tries == 0) rank = 1;                    // 2. New messages
+    else if (now - e.sentAt >= retryMs) rank = 2;       // 3. No answer at all
+    else continue;
+    if (e.kind != REL_KIND_ALERT) rank += 3;
+    if (rank < bestRank) {
+      best = &e;
+      bestRank = rank;
+    }
+  }
+  return best;
+}
+
+inline uint8_t relEncode(const ReliableSender& s, const RelEntry& e, uint8_t* out) {
+  out[0] = FRAME_TYPE_RELIABLE;
+  out[1] = s.session;
+  out[2] = e.seq;
+  out[3] = e.kind;
+  memcpy(out + REL_HEADER_LEN, e.data, e.len);
+  return REL_HEADER_LEN + e.len;
+}
+
+inline void relMarkSent(ReliableSender& s, RelEntry& e) {
+  if (e.tries > 0) s.retransmits++;
+  e.tries++;
+  e.gap = false;
+  e.sentAt = millis();
+}
+
+// Bitmap ACK: confirm what the receiver has, flag what it is missing
+inline void relOnAck(ReliableSender& s, uint8_t top, uint32_t bitmap) {
+  for (uint8_t i = 0; i < s.count; i++) {
+    RelEntry& e = relEntry(s, i);
+    if (e.done || e.tries == 0) continue;
+
+    uint8_t age = top - e.seq;        // mod 256
+    if (age >= REL_HISTORY) continue; // Newer than top (or out of history)
+
+    if (bitmap & ((uint32_t)1 << age)) {
+      e.done = true;
+      s.delivered++;
+    } else {
+      e.gap = true;                   // Sent before top, never arrived
+    }
+  }
+  relCompact(s);
+}
+
+inline bool relIdle(const ReliableSender& s) {
+  return s.count == 0;
+}
+
+// =============== RECEIVER ================================
+struct ReliableReceiver {
+  uint8_t session;
+  uint8_t top;
+  uint32_t bitmap;           // 0 = nothing received in this session
+  bool ackDue;               // Answer the next ACK slot with a bitmap
+
+  // Statistics
+  unsigned long received;
+  unsigned long duplicates;
+};
+
+inline void relReceiverInit(ReliableReceiver& r) {
+  memset(&r, 0, sizeof(r));
+}
+
+// Records seq; returns true the FIRST time a message arrives
+inline bool relAccept(ReliableReceiver& r, uint8_t session, uint8_t seq) {
+  r.ackDue = true;
+
+  if (session != r.session || r.bitmap == 0) {
+    // First frame, or sender rebooted: start a new window
+    r.session = session;
+    r.top = seq;
+    r.bitmap = 1;
+    r.received++;
+    return true;
+  }
+
+  uint8_t ahead = seq - r.top;
+  if (ahead != 0 && ahead < 128) {
+    r.bitmap = ahead >= REL_HISTORY ? 1 : (r.bitmap << ahead) | 1;
+    r.top = seq;
+    r.received++;
+    return true;
+  }
+
+  uint8_t age = r.top - seq;
+  if (age < REL_HISTORY && !(r.bitmap & ((uint32_t)1 << age))) {
+    r.bitmap |= (uint32_t)1 << age;   // Gap filled by a retransmission
+    r.received++;
+    return true;
+  }
+
+  r.duplicates++;  // Seen before (or older than the history)
+  return false;
+}
+
+inline uint8_t relEncodeAck(ReliableReceiver& r, uint8_t* out) {
+  out[0] = FRAME_TYPE_REL_ACK;
+  out[1] = r.session;
+  out[2] = r.top;
+  for (uint8_t i = 0; i < 4; i++) {
+    out[3 + i] = (uint8_t)(r.bitmap >> (8 * i));
+  }
+  r.ackDue = false;
+  return REL_ACK_LEN;
+}
+
+// =============== FRAME PARSING ================================
+inline bool isReliableFrame(const char* data, uint8_t len) {
+  return len >= REL_HEADER_LEN && (uint8_t)data[0] == FRAME_TYPE_RELIABLE;
+}
+
+inline bool decodeRelAck(const char* data, uint8_t len, uint8_t& session,
+                         uint8_t& top, uint32_t& bitmap) {
+  if (len != REL_ACK_LEN || (uint8_t)data[0] != FRAME_TYPE_REL_ACK) return false;
+  const uint8_t* p = (const uint8_t*)data;
+  session = p[1];
+  top = p[2];
+  bitmap = (uint32_t)p[3] | ((uint32_t)p[4] << 8) |
+           ((uint32_t)p[5] << 16) | ((uint32_t)p[6] << 24);
+  return true;
+}
+
+#endif // RELIABLE_LINK_H
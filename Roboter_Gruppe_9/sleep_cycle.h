@@ -0,0 +1,270 @@
+/*=====================================================================
+  sleep_cycle.h - Duty-Cycled Sleeping Sender
+
+  A sender was awake all the time for one uplink every 2 s - the ESP32
+  and the RYLR896 draw tens of mA between transmissions that take well
+  under a second. With ENABLE_SLEEP_SENDER a sender node runs in cycles
+  of SLEEP_INTERVAL_MS:
+
+    timer wake → AT+MODE=0 → sensors → uplink → [ACK slot] →
+    AT+MODE=1 → RTC save → deep sleep (SLEEP_LIGHT: light sleep)
+
+  - The RYLR896 keeps its settings in sleep mode (AT+MODE=1). The first
+    command after the wake may be lost, so AT+MODE=0 is tried twice;
+    only a module that stays silent gets the fast_boot.h check.
+  - Deep sleep restarts the sketch. Sequence number and message count,
+    SF (loraParams and ADR state), TX power control, duty-cycle budget,
+    AES TX counter, packet statistics and current-monitor counters stay
+    in RTC memory (SleepRetained). millis() starts from 0 after every
+    wake, so their timestamps are moved onto the new clock. The
+    receiver's trackPacket() sees one continuous sequence.
+  - Light sleep keeps RAM: nothing to save, loop() continues.
+  - Telemetry announces the cycle as its keepalive, so the receiver's
+    watchdog waits one cycle instead of reporting the link LOST.
+
+  Energy is booked per cycle under the SF it was sent with: awake time
+  and charge (INA219 samples via current_monitor.h, else the
+  SLEEP_AWAKE_MA model) and sleep time at SLEEP_CURRENT_UA - the INA219
+  cannot sample while the ESP32 sleeps. printSleepEnergy() gives the
+  average current of each configuration and the battery life it means.
+=======================================================================*/
+
+#ifndef SLEEP_CYCLE_H
+#define SLEEP_CYCLE_H
+
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include "config.h"
+#include "structs.h"
+#include "lora_handler.h"  // sendLoRaCommand(), atEnqueue(loraAT), loraParams
+#include "fast_boot.h"     // Module check when AT+MODE=0 goes unanswered
+
+#if ENABLE_ADAPTIVE_SF
+  #include "adaptive_sf.h"
+#endif
+#if ENABLE_TX_POWER_CONTROL
+  #include "tx_power.h"
+#endif
+#if ENABLE_PACKET_STATS || ENABLE_EXTENDED_TELEMETRY
+  #include "detailed_telemetry.h"
+#endif
+#if ENABLE_CURRENT_MONITOR
+  #include "current_monitor.h"
+#endif
+
+#define SLEEP_RTC_MAGIC 0x534C5031UL   // "SLP1"
+#define SLEEP_SF_MIN 7
+#define SLEEP_SF_COUNT 6               // SF7-SF12
+#define SLEEP_MIN_MS 100               // Shortest sleep after a long awake phase
+
+// Keepalive announced in telemetry: one cycle, rounded up
+#define SLEEP_KEEPALIVE_S ((SLEEP_INTERVAL_MS + 999) / 1000)
+
+// =============== RTC-RETAINED STATE ================================
+struct SleepEnergy {                   // Cycles sent at one SF
+  unsigned long cycles;
+  uint64_t awakeMs;
+  uint64_t sleepMs;
+  float awake_mAh;                     // Measured or modelled
+};
+
+struct SleepRetained {
+  uint32_t magic;                      // SLEEP_RTC_MAGIC ^ sizeof: layout changed = cold boot
+  unsigned long cycles;
+  unsigned long savedAtMs;             // millis() at the save (old clock)
+  unsigned long sleepMs;               // Requested sleep
+  SleepEnergy energy[SLEEP_SF_COUNT];
+
+  DeviceState local;                   // Sequence number, message count, LED
+  LoRaParams params;                   // SF/BW/CR the module is set to
+  DutyCycleBudget dutyCycle;
+  #if ENABLE_ENCRYPTION
+  bool encReady;                       // Counters valid (NVS reservation worked)
+  uint32_t encTxCounter;
+  uint32_t encTxReserved;
+  #endif
+  #if ENABLE_ADAPTIVE_SF
+  AdaptiveSF adr;
+  #endif
+  #if ENABLE_TX_POWER_CONTROL
+  TxPowerControl txPower;
+  #endif
+  #if ENABLE_PACKET_STATS || ENABLE_EXTENDED_TELEMETRY
+  PacketStatistics pktStats;
+  #endif
+  #if ENABLE_CURRENT_MONITOR
+  CurrentStatus current;
+  #endif
+};
+
+inline uint32_t sleepRtcMagic() {
+  return SLEEP_RTC_MAGIC ^ (uint32_t)sizeof(SleepRetained);
+}
+
+// Power-on, reset or re-flash: RTC memory is garbage
+inline bool sleepRetainedValid(const SleepRetained& r) {
+  return r.magic == sleepRtcMagic();
+}
+
+inline void sleepRetainedInit(SleepRetained& r) {
+  memset(&r, 0, sizeof(r));
+  r.magic = sleepRtcMagic();
+}
+
+// Deep-sleep timer wake (not power-on, reset or the kill-switch restart)
+inline bool sleepTimerWake() {
+  return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+}
+
+// Old-clock timestamp → new clock (0 = "never" stays 0)
+inline void sleepRebase(unsigned long& t, const SleepRetained& r) {
+  if (t) t -= r.savedAtMs + r.sleepMs;
+}
+
+// =============== CYCLE ================================
+enum SleepPhase {
+  SLEEP_AWAKE,                         // Sensors, uplink, ACK slot
+  SLEEP_RADIO_OFF,                     // AT+MODE=1 queued
+  SLEEP_READY                          // Module asleep (or no answer): sleep now
+};
+
+struct SleepCycle {
+  SleepPhase phase;
+  bool uplinkQueued;                   // This wake's uplink went to the AT queue
+  bool uplinkDone;                     // ... and was answered (+OK or error)
+  unsigned long startMs;               // Wake (0 after deep sleep)
+  unsigned long lastSampleMs;
+  float awake_mAh;
+};
+
+inline void sleepCycleInit(SleepCycle& c) {
+  memset(&c, 0, sizeof(c));
+  c.phase = SLEEP_AWAKE;
+  c.startMs = millis();
+  c.lastSampleMs = c.startMs;
+}
+
+// Awake charge since the last call (INA219, else the model)
+inline void sleepSampleCurrent(SleepCycle& c) {
+  unsigned long now = millis();
+  unsigned long dt = now - c.lastSampleMs;
+  if (dt == 0) return;
+  c.lastSampleMs = now;
+  #if ENABLE_CURRENT_MONITOR
+    float mA = sampleCurrent_mA();
+  #else
+    float mA = SLEEP_AWAKE_MA;
+  #endif
+  c.awake_mAh += mA * dt / 3600000.0f;
+}
+
+// Sleep: at least SLEEP_MIN_MS, else the rest of the cycle
+inline unsigned long sleepDurationMs(unsigned long awakeMs) {
+  if (awakeMs + SLEEP_MIN_MS >= SLEEP_INTERVAL_MS) return SLEEP_MIN_MS;
+  return SLEEP_INTERVAL_MS - awakeMs;
+}
+
+inline void sleepBook(SleepRetained& r, const SleepCycle& c, uint8_t sf,
+                      unsigned long awakeMs, unsigned long sleepMs) {
+  if (sf < SLEEP_SF_MIN || sf >= SLEEP_SF_MIN + SLEEP_SF_COUNT) return;
+  SleepEnergy& e = r.energy[sf - SLEEP_SF_MIN];
+  e.cycles++;
+  e.awakeMs += awakeMs;
+  e.sleepMs += sleepMs;
+  e.awake_mAh += c.awake_mAh;
+  r.cycles++;
+}
+
+// =============== RADIO ================================
+// Module out of AT+MODE=1 (blocking, two tries: the first byte wakes it)
+inline bool sleepRadioWake() {
+  for (uint8_t i = 0; i < 2; i++) {
+    if (sendLoRaCommand("AT+MODE=0", 200).indexOf("+OK") >= 0) return true;
+  }
+  return false;
+}
+
+// Deep-sleep wake, instead of bootRadioStart(): the module only needs
+// waking - a silent one gets the fast_boot.h check
+inline void sleepRadioStart(BootTimeline& boot, uint8_t myAddress, uint8_t networkID) {
+  loraPortBegin(myAddress, networkID, 0);
+  bootMark(boot, BOOT_RADIO_PORT);
+  if (sleepRadioWake()) {
+    boot.radioOk = true;
+    bootMark(boot, BOOT_RADIO_READY);
+  } else {
+    linkRecoveryStart(boot.radio, myAddress, networkID);
+  }
+}
+
+inline void onSleepRadioOff(ATResult result, const char* response, void* ctx) {
+  SleepCycle* c = (SleepCycle*)ctx;
+  if (result != AT_RESULT_OK) Serial.println("⚠️  LoRa: no answer to AT+MODE=1");
+  c->phase = SLEEP_READY;  // Sleep either way - the next wake retries AT+MODE=0
+}
+
+inline void sleepRadioOff(SleepCycle& c) {
+  c.phase = SLEEP_RADIO_OFF;
+  if (!atEnqueue(loraAT, "AT+MODE=1", 500, onSleepRadioOff, &c)) {
+    c.phase = SLEEP_READY;  // AT queue full: sleep with the radio on
+  }
+}
+
+// =============== SLEEP ================================
+// Deep sleep does not return (setup() runs on the wake); light sleep does
+inline void sleepEnter(unsigned long sleepMs) {
+  Serial.flush();
+  esp_sleep_enable_timer_wakeup((uint64_t)sleepMs * 1000ULL);
+  #if SLEEP_LIGHT
+    esp_light_sleep_start();
+  #else
+    esp_deep_sleep_start();
+  #endif
+}
+
+// =============== REPORT ================================
+inline void printSleepEnergy(const SleepRetained& r) {
+  Serial.print("\n🔋 Sleep cycle (");
+  Serial.print(SLEEP_LIGHT ? "light" : "deep");
+  Serial.print(" sleep, ");
+  Serial.print(SLEEP_INTERVAL_MS / 1000.0f, 1);
+  Serial.print(" s, ACK window ");
+  Serial.print(SLEEP_ACK_WINDOW ? "on" : "off");
+  #if ENABLE_TX_POWER_CONTROL
+    Serial.print(", TX power control");
+  #endif
+  Serial.print(", awake current ");
+  Serial.print(ENABLE_CURRENT_MONITOR ? "INA219" : "model");
+  Serial.println("):");
+
+  for (uint8_t i = 0; i < SLEEP_SF_COUNT; i++) {
+    const SleepEnergy& e = r.energy[i];
+    if (e.cycles == 0) continue;
+    float hours = (e.awakeMs + e.sleepMs) / 3600000.0f;
+    float sleep_mAh = SLEEP_CURRENT_UA / 1000.0f * e.sleepMs / 3600000.0f;
+    float avg_mA = hours > 0 ? (e.awake_mAh + sleep_mAh) / hours : 0;
+    float awake_mA = e.awakeMs ? e.awake_mAh * 3600000.0f / e.awakeMs : 0;
+
+    Serial.print("  SF");
+    Serial.print(SLEEP_SF_MIN + i);
+    Serial.print(": ");
+    Serial.print(e.cycles);
+    Serial.print(" cycles, awake ");
+    Serial.print((unsigned long)(e.awakeMs / e.cycles));
+    Serial.print(" ms at ");
+    Serial.print(awake_mA, 1);
+    Serial.print(" mA, average ");
+    Serial.print(avg_mA, 3);
+    Serial.print(" mA");
+    if (avg_mA > 0) {
+      Serial.print(" → ");
+      Serial.print(SLEEP_BATTERY_MAH / avg_mA / 24.0f, 0);
+      Serial.print(" days on ");
+      Serial.print(SLEEP_BATTERY_MAH);
+      Serial.print(" mAh");
+    }
+    Serial.println();
+  }
+}
+
+#endif // SLEEP_CYCLE_H
@@ -19,6 +19,7 @@ struct DeviceState {
   int messageCount;
   unsigned long lastMessageTime;
   int sequenceNumber;  // For packet tracking
+  unsigned long keepaliveMs;  // Advertised heartbeat interval (0 = fixed cadence)
 
   // Spinner animation
   int spinnerIndex;
@@ -33,11 +34,8 @@ struct TimingData {
   unsigned long lastLED;
   unsigned long lastLCD;
   unsigned long lastSensor;
-  unsigned long lastCheck;
   unsigned long lastSend;
   unsigned long lastSpinner;
-  unsigned long lastHealthReport;
-  unsigned long lastDataOutput;  // For CSV/JSON logging
 };
 
 // =============== SPINNER DATA STRUCTURE ================================
@@ -84,6 +82,17 @@ struct HealthMonitor {
   unsigned long startTime;
 };
 
+// =============== UI SNAPSHOT ================================
+// What the LCD and the display station show. With ENABLE_TASK_SPLIT the
+// radio task publishes it and the UI task reads a copy (task_split.h).
+struct UiSnapshot {
+  DeviceState local;
+  DeviceState remote;
+  HealthMonitor health;
+  uint8_t nodesOnline;  // Gateway mode
+  uint8_t nodeCount;
+};
+
 // =============== WATCHDOG CONFIGURATION ================================
 struct WatchdogConfig {
   unsigned long weakTimeout;      // Time to consider connection WEAK (ms)
@@ -0,0 +1,243 @@
+/*=====================================================================
+  task_split.h - Radio / Sensor / UI Tasks
+
+  One loop() with delay(10) did everything in turn: LCD I2C writes
+  (~25 ms for two lines), the display station UART message, sensor
+  ADC bursts and the LoRa AT exchange. Any of them delayed the others -
+  an ACK slot or a +RCV line waited behind the LCD.
+
+  With ENABLE_TASK_SPLIT each subsystem gets its own FreeRTOS task:
+
+    Task    | Core                 | Owns                     | Period
+    --------|----------------------|--------------------------|--------
+    radio   | ARDUINO_RUNNING_CORE | LoRaSerial, protocol,    | TASK_RADIO_PERIOD_MS
+            | (the loop() task)    | DeviceState, health      |
+    sensor  | TASK_SENSOR_CORE     | touch, ADC, INA219, fire | TASK_SENSOR_PERIOD_MS
+            |                      | alarm detectors          |
+    ui      | TASK_UI_CORE         | LCD, display station     | TASK_UI_PERIOD_MS
+
+  Nothing is shared by reference between them:
+
+    sensor ──SpscQueue<SensorEvent>──→ radio   (samples, fire alarms,
+                                                INA219 readings)
+    radio  ──SeqLock<UiSnapshot>─────→ ui      (local, remote, health)
+
+  Both are lock-free: a full queue drops (and counts) the newest event,
+  a snapshot reader retries while the radio task is mid-copy. The radio
+  task is never blocked by the UI or the sensors.
+
+  Every task runs with vTaskDelayUntil() and books per window
+  (TASK_STATS_WINDOW_MS): CPU share, longest run, worst lateness against
+  its period (jitter) and free stack (printTaskStats()).
+
+  SpscQueue and SeqLock are pure C++11 (<atomic>) - host-testable.
+=======================================================================*/
+
+#ifndef TASK_SPLIT_H
+#define TASK_SPLIT_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "config.h"
+#include "structs.h"
+
+// =============== SPSC RING QUEUE ================================
+// One producer task, one consumer task; N - 1 usable slots
+template <typename T, uint8_t N>
+struct SpscQueue {
+  T items[N];
+  std::atomic<uint8_t> head;         // Next to pop (consumer writes)
+  std::atomic<uint8_t> tail;         // Next free (producer writes)
+  unsigned long dropped;             // Producer: queue was full
+};
+
+template <typename T, uint8_t N>
+inline void spscInit(SpscQueue<T, N>& q) {
+  q.head.store(0, std::memory_order_relaxed);
+  q.tail.store(0, std::memory_order_relaxed);
+  q.dropped = 0;
+}
+
+// Producer side
+template <typename T, uint8_t N>
+inline bool spscPush(SpscQueue<T, N>& q, const T& item) {
+  uint8_t tail = q.tail.load(std::memory_order_relaxed);
+  uint8_t next = (tail + 1) % N;
+  if (next == q.head.load(std::memory_order_acquire)) {
+    q.dropped++;
+    return false;
+  }
+  q.items[tail] = item;
+  q.tail.store(next, std::memory_order_release);  // Item visible before the index
+  return true;
+}
+
+// Consumer side
+template <typename T, uint8_t N>
+inline bool spscPop(SpscQueue<T, N>& q, T& item) {
+  uint8_t head = q.head.load(std::memory_order_relaxed);
+  if (head == q.tail.load(std::memory_order_acquire)) return false;
+  item = q.items[head];
+  q.head.store((head + 1) % N, std::memory_order_release);  // Slot free after the copy
+  return true;
+}
+
+// =============== SEQLOCK SNAPSHOT ================================
+// One writer, any number of readers; T must be trivially copyable
+template <typename T>
+struct SeqLock {
+  std::atomic<uint32_t> seq;         // Odd while the writer copies
+  T value;
+  unsigned long retries;             // Reader: copy raced the writer
+};
+
+template <typename T>
+inline void seqlockInit(SeqLock<T>& s) {
+  s.seq.store(0, std::memory_order_relaxed);
+  memset(&s.value, 0, sizeof(s.value));
+  s.retries = 0;
+}
+
+inline void seqlockCopy(void* dst, const void* src, size_t size) {
+  // Byte-wise through volatile: the compiler may not merge or reorder
+  // it across the fences (a torn copy is detected and thrown away)
+  volatile uint8_t* d = (volatile uint8_t*)dst;
+  const volatile uint8_t* s = (const volatile uint8_t*)src;
+  for (size_t i = 0; i < size; i++) d[i] = s[i];
+}
+
+template <typename T>
+inline void seqlockWrite(SeqLock<T>& s, const T& value) {
+  uint32_t seq = s.seq.load(std::memory_order_relaxed);
+  s.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  seqlockCopy(&s.value, &value, sizeof(T));
+  s.seq.store(seq + 2, std::memory_order_release);
+}
+
+template <typename T>
+inline void seqlockRead(SeqLock<T>& s, T& out) {
+  for (;;) {
+    uint32_t before = s.seq.load(std::memory_order_acquire);
+    if (!(before & 1)) {
+      seqlockCopy(&out, &s.value, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (s.seq.load(std::memory_order_relaxed) == before) return;
+    }
+    s.retries++;
+  }
+}
+
+// =============== SENSOR → RADIO EVENTS ================================
+enum SensorEventKind : uint8_t {
+  SENSOR_EVENT_TOUCH,                // Periodic touch sample
+  SENSOR_EVENT_FIRE_ALARM,           // Detector fired (after its cooldown)
+  SENSOR_EVENT_CURRENT               // INA219 reading for transmit power control
+};
+
+struct SensorEvent {
+  SensorEventKind kind;
+  bool touchState;                   // TOUCH
+  bool audio;                        // FIRE_ALARM
+  bool light;
+  unsigned long value;               // TOUCH: raw reading, FIRE_ALARM: alert count
+  bool onAir;                        // CURRENT: the mid-uplink reading
+  float milliamps;
+  float volts;                       // Bus voltage (0 = not read)
+};
+
+// =============== PER-TASK STATISTICS ================================
+struct TaskStats {
+  const char* name;
+  uint8_t core;
+  unsigned long periodUs;
+
+  // Current window (owning task only)
+  unsigned long windowStartUs;
+  unsigned long busyUs;
+  unsigned long runStartUs;
+  unsigned long dueUs;               // Scheduled start of the next run
+  unsigned long maxRunUs;
+  unsigned long maxLateUs;
+
+  // Last finished window (read by printTaskStats())
+  uint16_t cpuPermille;
+  unsigned long windowMaxRunUs;
+  unsigned long windowMaxLateUs;
+  unsigned long runs;
+  unsigned long stackFreeBytes;
+};
+
+inline void taskStatsInit(TaskStats& t, const char* name, uint8_t core, unsigned long periodMs) {
+  memset(&t, 0, sizeof(t));
+  t.name = name;
+  t.core = core;
+  t.periodUs = periodMs * 1000UL;
+}
+
+// Lateness is measured against the fixed grid of the first run
+// (vTaskDelayUntil() keeps that grid - an overrun is caught up, not skipped)
+inline void taskRunBegin(TaskStats& t) {
+  unsigned long now = micros();
+  if (t.runs == 0) {
+    t.windowStartUs = now;
+    t.dueUs = now;
+  }
+  long late = (long)(now - t.dueUs);
+  if (late > 0 && (unsigned long)late > t.maxLateUs) t.maxLateUs = late;
+  t.runStartUs = now;
+  t.dueUs += t.periodUs;
+}
+
+inline void taskRunEnd(TaskStats& t) {
+  unsigned long now = micros();
+  unsigned long run = now - t.runStartUs;
+  t.busyUs += run;
+  if (run > t.maxRunUs) t.maxRunUs = run;
+  t.runs++;
+
+  unsigned long window = now - t.windowStartUs;
+  if (window >= TASK_STATS_WINDOW_MS * 1000UL) {
+    t.cpuPermille = (uint16_t)((uint64_t)t.busyUs * 1000 / window);
+    t.windowMaxRunUs = t.maxRunUs;
+    t.windowMaxLateUs = t.maxLateUs;
+    #if ENABLE_TASK_SPLIT
+      t.stackFreeBytes = uxTaskGetStackHighWaterMark(nullptr) * sizeof(StackType_t);
+    #endif
+    t.windowStartUs = now;
+    t.busyUs = 0;
+    t.maxRunUs = 0;
+    t.maxLateUs = 0;
+  }
+}
+
+inline void printTaskStats(const TaskStats& t) {
+  Serial.print("  ");
+  Serial.print(t.name);
+  Serial.print(" (core ");
+  Serial.print(t.core);
+  Serial.print("): CPU ");
+  Serial.print(t.cpuPermille / 10.0f, 1);
+  Serial.print("%, max run ");
+  Serial.print(t.windowMaxRunUs);
+  Serial.print(" us, jitter ");
+  Serial.print(t.windowMaxLateUs);
+  Serial.print(" us, stack free ");
+  Serial.println(t.stackFreeBytes);
+}
+
+// =============== TASKS ================================
+#if ENABLE_TASK_SPLIT
+// Sleep until the next period (fixed grid - a long run does not shift it)
+inline void taskWaitNext(TickType_t& lastWake, unsigned long periodMs) {
+  vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(periodMs));
+}
+
+// Pinned task; false if FreeRTOS has no memory for it
+inline bool taskStart(TaskFunction_t body, const char* name, uint32_t stackBytes,
+                      UBaseType_t priority, uint8_t core) {
+  return xTaskCreatePinnedToCore(body, name, stackBytes, nullptr, priority, nullptr, core) == pdPASS;
+}
+#endif
+
+#endif // TASK_SPLIT_H
@@ -0,0 +1,267 @@
+/*=====================================================================
+  telemetry_batch.h - Batched Multi-Sample Uplink
+
+  One LoRa packet per 2 s state snapshot pays the full preamble +
+  header (~0.5 s at SF12) every time. Batching collects K snapshots
+  and sends them in one delta-compressed frame (SF12 air time):
+
+    8 × single frames:              8 × 0.70 s = 5.6 s
+    1 × batch, 8 samples, state:    28 bytes  ≈ 1.5 s
+    1 × batch, 8 samples, + sensors: ~63 bytes ≈ 2.7 s
+
+  A batch is sent when it holds BATCH_SAMPLES samples or when its
+  oldest sample is BATCH_MAX_LATENCY old, whichever comes first.
+
+  Sample contents:
+  - DeviceState: seq, LED, touch, spinner
+  - sensors.h:   battery voltage (mV), current (0.1 mA)
+  - Fire alarm:  audio RMS, light (TCS34725 clear channel)
+  Only the fields enabled on the sender are sent (fields byte).
+
+  Frame schema:
+
+  Byte  | Field    | Encoding
+  ------|----------|---------------------------------------------
+  0     | type     | 0x83 (FRAME_TYPE_BATCH)
+  1     | count    | number of samples (1-BATCH_MAX_SAMPLES)
+  2     | fields   | bit0 battery, bit1 current, bit2 audio, bit3 light,
+        |          | bit7 ACK requested (ack_slot.h)
+  3..   | seq      | varint, seq of first sample (sample i = seq + i)
+  ..    | age      | varint, age of the NEWEST sample at send (10 ms)
+  Per sample:
+        | flags    | same bits as telemetry frame (LED/TOUCH/SPIN)
+        | dt       | varint, time since previous sample (10 ms),
+        |          | omitted for the first sample
+        | values   | first sample: zigzag varint of the value
+        |          | others: zigzag varint delta to previous sample
+
+  Slowly changing values cost 1 byte per field per sample.
+
+  Receiver: decodeTelemetryBatch() rebuilds per-sample records with
+  timestamps on the receiver's own millis() clock (newest sample =
+  RX time - age), ready for health_monitor.h and CSV output.
+
+  Pure C++ (no String, no heap) - host-testable.
+=======================================================================*/
+
+#ifndef TELEMETRY_BATCH_H
+#define TELEMETRY_BATCH_H
+
+#include <Arduino.h>
+#include "telemetry_frame.h"
+
+#define FRAME_TYPE_BATCH 0x83
+
+#define BATCH_MAX_SAMPLES 16     // Buffer capacity (samples)
+#define BATCH_FRAME_MAX 200      // Max frame bytes (RYLR896 limit 240)
+#define BATCH_TIME_UNIT 10       // Timestamp resolution (ms)
+
+// Field presence bits
+#define BATCH_FIELD_BATTERY 0x01
+#define BATCH_FIELD_CURRENT 0x02
+#define BATCH_FIELD_AUDIO   0x04
+#define BATCH_FIELD_LIGHT   0x08
+#define BATCH_FLAG_ACK_REQ  0x80  // Not a field: sender wants an ACK
+
+// Worst case bytes per sample: flags + dt + 4 values (5 B varints)
+#define BATCH_SAMPLE_WORST 26
+
+// One snapshot
+struct BatchSample {
+  unsigned long timestamp;  // millis() - sender clock, or receiver clock after decode
+  uint32_t seq;
+  bool led;
+  bool touch;
+  uint8_t spinner;
+  uint16_t batteryMv;
+  int32_t currentMa10;      // 0.1 mA units
+  uint16_t audioRms;
+  uint16_t light;
+};
+
+// Sender-side sample buffer
+struct TelemetryBatch {
+  BatchSample samples[BATCH_MAX_SAMPLES];
+  uint8_t count;
+  uint8_t inFlight;         // Samples in the frame being transmitted
+  uint8_t fields;           // BATCH_FIELD_* included in frames
+
+  // Statistics
+  unsigned long framesSent;
+  unsigned long samplesSent;
+  unsigned long samplesDropped;
+};
+
+// =============== BUFFER ================================
+inline void batchInit(TelemetryBatch& batch, uint8_t fields) {
+  batch.count = 0;
+  batch.inFlight = 0;
+  batch.fields = fields;
+  batch.framesSent = 0;
+  batch.samplesSent = 0;
+  batch.samplesDropped = 0;
+}
+
+inline void batchRemoveOldest(TelemetryBatch& batch, uint8_t n) {
+  if (n > batch.count) n = batch.count;
+  memmove(batch.samples, batch.samples + n, (batch.count - n) * sizeof(BatchSample));
+  batch.count -= n;
+}
+
+// Full buffer drops the oldest sample (also if it is in flight)
+inline void batchAdd(TelemetryBatch& batch, const BatchSample& sample) {
+  if (batch.count >= BATCH_MAX_SAMPLES) {
+    batchRemoveOldest(batch, 1);
+    if (batch.inFlight > 0) batch.inFlight--;
+    batch.samplesDropped++;
+  }
+  batch.samples[batch.count++] = sample;
+}
+
+// Full, or the oldest sample has waited long enough
+inline bool batchReady(const TelemetryBatch& batch, uint8_t target, unsigned long maxLatency) {
+  if (batch.count == 0 || batch.inFlight > 0) return false;
+  if (batch.count >= target) return true;
+  return millis() - batch.samples[0].timestamp >= maxLatency;
+}
+
+// Frame delivered: forget the samples it carried
+inline void batchCommit(TelemetryBatch& batch) {
+  batch.framesSent++;
+  batch.samplesSent += batch.inFlight;
+  batchRemoveOldest(batch, batch.inFlight);
+  batch.inFlight = 0;
+}
+
+// Frame not sent: keep samples for the next attempt
+inline void batchAbort(TelemetryBatch& batch) {
+  batch.inFlight = 0;
+}
+
+// =============== ENCODE ================================
+inline uint8_t batchPutValue(uint8_t* out, bool first, int32_t value, int32_t previous) {
+  return putVarint(out, first ? zigzagEncode(value) : zigzagEncode(value - previous));
+}
+
+// Encodes as many buffered samples as fit into maxLen bytes (oldest
+// first) and marks them in flight. Returns frame length, 0 if empty.
+inline uint8_t encodeTelemetryBatch(TelemetryBatch& batch, uint8_t* out, uint8_t maxLen,
+                                    bool ackRequest = false) {
+  if (batch.count == 0 || maxLen < 8 + BATCH_SAMPLE_WORST) return 0;
+
+  uint8_t n = 0;
+  out[n++] = FRAME_TYPE_BATCH;
+  out[n++] = 0;  // Count, filled in below
+  out[n++] = batch.fields | (ackRequest ? BATCH_FLAG_ACK_REQ : 0);
+  n += putVarint(out + n, batch.samples[0].seq);
+  uint8_t ageAt = n;
+  n += 5;        // Age placeholder, compacted below
+
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < batch.count && n + BATCH_SAMPLE_WORST <= maxLen; i++) {
+    const BatchSample& s = batch.samples[i];
+    const BatchSample& p = batch.samples[i > 0 ? i - 1 : 0];
+    bool first = (i == 0);
+
+    out[n++] = (s.led ? FRAME_FLAG_LED : 0) |
+               (s.touch ? FRAME_FLAG_TOUCH : 0) |
+               ((s.spinner << FRAME_SPIN_SHIFT) & FRAME_SPIN_MASK);
+    if (!first) {
+      // Quantize absolute times, not deltas → rounding never accumulates
+      n += putVarint(out + n, s.timestamp / BATCH_TIME_UNIT - p.timestamp / BATCH_TIME_UNIT);
+    }
+    if (batch.fields & BATCH_FIELD_BATTERY) n += batchPutValue(out + n, first, s.batteryMv, p.batteryMv);
+    if (batch.fields & BATCH_FIELD_CURRENT) n += batchPutValue(out + n, first, s.currentMa10, p.currentMa10);
+    if (batch.fields & BATCH_FIELD_AUDIO)   n += batchPutValue(out + n, first, s.audioRms, p.audioRms);
+    if (batch.fields & BATCH_FIELD_LIGHT)   n += batchPutValue(out + n, first, s.light, p.light);
+    count++;
+  }
+
+  // Age of the newest sample in the frame, then close the gap
+  uint8_t age[5];
+  uint8_t ageLen = putVarint(age, millis() / BATCH_TIME_UNIT -
+                                      batch.samples[count - 1].timestamp / BATCH_TIME_UNIT);
+  memmove(out + ageAt + ageLen, out + ageAt + 5, n - ageAt - 5);
+  memcpy(out + ageAt, age, ageLen);
+  n -= 5 - ageLen;
+
+  out[1] = count;
+  batch.inFlight = count;
+  return n;
+}
+
+// =============== DECODE ================================
+inline bool batchGetValue(const uint8_t*& p, const uint8_t* end, bool first,
+                          int32_t previous, int32_t& value) {
+  uint32_t raw;
+  if (!getVarint(p, end, raw)) return false;
+  value = first ? zigzagDecode(raw) : previous + zigzagDecode(raw);
+  return true;
+}
+
+// Unpacks a batch frame into out[] (up to maxOut samples). Timestamps
+// are rebuilt on the receiver clock from rxTime. Returns sample count,
+// 0 if the frame is malformed.
+inline uint8_t decodeTelemetryBatch(const uint8_t* data, uint8_t len, BatchSample* out,
+                                    uint8_t maxOut, unsigned long rxTime) {
+  const uint8_t* p = data;
+  const uint8_t* end = data + len;
+
+  if (len < 6 || p[0] != FRAME_TYPE_BATCH) return 0;
+  uint8_t count = p[1];
+  uint8_t fields = p[2];
+  p += 3;
+  if (count == 0 || count > maxOut) return 0;
+
+  uint32_t seq, age;
+  if (!getVarint(p, end, seq) || !getVarint(p, end, age)) return 0;
+
+  // Pass 1: relative timestamps (first sample = 0)
+  int32_t battery = 0, current = 0, audioRms = 0, light = 0;
+  unsigned long offset = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    bool first = (i == 0);
+    BatchSample& s = out[i];
+
+    if (p >= end) return 0;
+    uint8_t flags = *p++;
+    s.led = flags & FRAME_FLAG_LED;
+    s.touch = flags & FRAME_FLAG_TOUCH;
+    s.spinner = (flags & FRAME_SPIN_MASK) >> FRAME_SPIN_SHIFT;
+    s.seq = seq + i;
+
+    if (!first) {
+      uint32_t dt;
+      if (!getVarint(p, end, dt)) return 0;
+      offset += dt * BATCH_TIME_UNIT;
+    }
+    s.timestamp = offset;
+
+    if ((fields & BATCH_FIELD_BATTERY) && !batchGetValue(p, end, first, battery, battery)) return 0;
+    if ((fields & BATCH_FIELD_CURRENT) && !batchGetValue(p, end, first, current, current)) return 0;
+    if ((fields & BATCH_FIELD_AUDIO)   && !batchGetValue(p, end, first, audioRms, audioRms)) return 0;
+    if ((fields & BATCH_FIELD_LIGHT)   && !batchGetValue(p, end, first, light, light)) return 0;
+    s.batteryMv = (uint16_t)battery;
+    s.currentMa10 = current;
+    s.audioRms = (uint16_t)audioRms;
+    s.light = (uint16_t)light;
+  }
+  if (p != end) return 0;
+
+  // Pass 2: anchor the newest sample at rxTime - age
+  unsigned long newest = rxTime - age * BATCH_TIME_UNIT;
+  for (uint8_t i = 0; i < count; i++) {
+    out[i].timestamp = newest - (offset - out[i].timestamp);
+  }
+  return count;
+}
+
+inline bool isTelemetryBatch(const char* data, uint8_t len) {
+  return len > 0 && (uint8_t)data[0] == FRAME_TYPE_BATCH;
+}
+
+inline bool batchAckRequested(const char* data, uint8_t len) {
+  return isTelemetryBatch(data, len) && len > 2 && ((uint8_t)data[2] & BATCH_FLAG_ACK_REQ);
+}
+
+#endif // TELEMETRY_BATCH_H
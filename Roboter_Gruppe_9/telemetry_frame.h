@@ -0,0 +1,305 @@
+/*=====================================================================
+  telemetry_frame.h - Compact Binary Telemetry Frame
+
+  Replaces the ~40 byte ASCII payload
+    SEQ:123,LED:1,TOUCH:0,SPIN:2,COUNT:123
+  with a packed binary frame of 4-6 bytes (seq < 2^21).
+
+  Why (SF12, BW125, CR 4/5, preamble 4 - Semtech formula):
+  - 40 bytes ASCII ≈ 1.84 s air time
+  -  5 bytes binary ≈ 0.70 s air time (preamble + header dominate)
+  - Fewer bytes = more packets per duty-cycle budget
+
+  Frame schema (version 1):
+
+  Byte  | Field    | Encoding
+  ------|----------|---------------------------------------------
+  0     | type     | 0x81 = telemetry, 0x82 = ACK (bit 7 always set
+        |          | → never a printable ASCII char, so legacy
+        |          | "SEQ:..." / "ACK,..." payloads are unambiguous)
+  1     | flags    | bit0 LED, bit1 TOUCH, bit2-3 spinner (0-3),
+        |          | bit4 ACK requested (ack_slot.h),
+        |          | bit5 link report follows count (ACK only),
+        |          | bit6 keepalive follows count (telemetry only)
+  2..   | seq      | unsigned LEB128 varint (1 B < 128, 2 B < 16384)
+  ..    | count    | zigzag varint of (count - seq), usually 0 → 1 B
+  ..    | link     | ACK only, with bit5: varint -RSSI (dBm) + zigzag
+        |          | varint SNR (dB) of the answered uplink (tx_power.h)
+  ..    | keepalive| telemetry only, with bit6: varint, longest gap to
+        |          | the next uplink in s (uplink_policy.h)
+  ..    | slot     | ACK only, optional: varint, receiver's ACK slot
+        |          | offset in ms (ack_slot.h)
+  ..    | tdma     | ACK only, optional (needs slot): zigzag varint,
+        |          | sender's TDMA correction in ms (mac_layer.h)
+
+  Typical size: 1 + 1 + 2 + 1 = 5 bytes (+1-2 keepalive), ACK 6-12 bytes
+  (max 1 + 1 + 5 + 5 + 2 + 2 + 3 + 3 = 22)
+
+  Mixed fleets:
+  - Receiver decodes BOTH formats (decodeTelemetry())
+  - Sender format selected with TELEMETRY_BINARY_FORMAT in config.h
+  - Old firmware only understands ASCII → keep the flag false until
+    every receiver runs this version
+
+  Binary data over RYLR896:
+  - AT+SEND=<addr>,<len>,<data> - module takes <len> bytes verbatim
+  - RX side reads +RCV data by length (lora_rx.h), so bytes like
+    ',' '\r' '\n' inside the frame are safe
+
+  Pure C++ (no String, no heap) - host-testable
+  (host/test_telemetry_frame.cpp).
+=======================================================================*/
+
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <Arduino.h>
+
+// Frame types (first byte, bit 7 set = binary)
+#define FRAME_TYPE_TELEMETRY 0x81
+#define FRAME_TYPE_ACK       0x82
+#define FRAME_BINARY_BIT     0x80
+
+#define TELEMETRY_FRAME_MAX 22
+
+// Flag bits
+#define FRAME_FLAG_LED        0x01
+#define FRAME_FLAG_TOUCH      0x02
+#define FRAME_SPIN_SHIFT      2
+#define FRAME_SPIN_MASK       0x0C
+#define FRAME_FLAG_ACK_REQ    0x10
+#define FRAME_FLAG_LINK       0x20
+#define FRAME_FLAG_KEEPALIVE  0x40
+
+// Field presence bits (legacy ASCII payloads may omit fields)
+#define FIELD_SEQ    0x01
+#define FIELD_LED    0x02
+#define FIELD_TOUCH  0x04
+#define FIELD_SPIN   0x08
+#define FIELD_COUNT  0x10
+#define FIELD_ALL    0x1F
+#define FIELD_SLOT   0x20  // ACK carries slot offset (not part of FIELD_ALL)
+#define FIELD_TDMA   0x40  // ACK carries TDMA correction (binary frames only)
+#define FIELD_LINK   0x80  // ACK carries uplink RSSI/SNR (binary frames only)
+
+// Decoded telemetry (binary or legacy)
+struct TelemetryFrame {
+  uint8_t type;        // FRAME_TYPE_TELEMETRY or FRAME_TYPE_ACK
+  uint8_t fields;      // FIELD_* present
+  uint32_t seq;
+  bool led;
+  bool touch;
+  uint8_t spinner;
+  uint32_t count;
+  bool ackRequest;     // Sender wants an ACK in the scheduled slot
+  uint16_t slotOffset; // ACK: announced slot offset (ms), valid with FIELD_SLOT
+  int16_t tdmaShift;   // ACK: move next uplink by this (ms), valid with FIELD_TDMA
+  int16_t linkRssi;    // ACK: answered uplink's RSSI (dBm), valid with FIELD_LINK
+  int8_t linkSnr;      // ACK: answered uplink's SNR (dB), valid with FIELD_LINK
+  uint16_t keepaliveS; // Telemetry: advertised heartbeat (s), 0 = fixed cadence
+  bool legacy;         // Decoded from ASCII payload
+};
+
+// =============== VARINT HELPERS ================================
+inline uint8_t putVarint(uint8_t* out, uint32_t value) {
+  uint8_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint32_t& value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 35 && p < end; shift += 7) {
+    uint8_t b = *p++;
+    value |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;  // Truncated or too long
+}
+
+inline uint32_t zigzagEncode(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+inline int32_t zigzagDecode(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// =============== ENCODE ================================
+// Returns frame length (bytes written to out, ≤ TELEMETRY_FRAME_MAX).
+// slotOffset, tdmaShift and the link report are only written to ACK
+// frames (slotOffset 0 = not announced), keepaliveS only to telemetry
+// frames (0 = not advertised).
+inline uint8_t encodeTelemetryFrame(uint8_t* out, uint8_t type, uint32_t seq,
+                                    bool led, bool touch, uint8_t spinner,
+                                    uint32_t count, bool ackRequest = false,
+                                    uint16_t slotOffset = 0,
+                                    bool tdma = false, int16_t tdmaShift = 0,
+                                    bool link = false, int16_t linkRssi = 0,
+                                    int8_t linkSnr = 0, uint16_t keepaliveS = 0) {
+  link = link && type == FRAME_TYPE_ACK;
+  bool keepalive = keepaliveS > 0 && type == FRAME_TYPE_TELEMETRY;
+  uint8_t n = 0;
+  out[n++] = type;
+  out[n++] = (led ? FRAME_FLAG_LED : 0) |
+             (touch ? FRAME_FLAG_TOUCH : 0) |
+             ((spinner << FRAME_SPIN_SHIFT) & FRAME_SPIN_MASK) |
+             (ackRequest ? FRAME_FLAG_ACK_REQ : 0) |
+             (link ? FRAME_FLAG_LINK : 0) |
+             (keepalive ? FRAME_FLAG_KEEPALIVE : 0);
+  n += putVarint(out + n, seq);
+  n += putVarint(out + n, zigzagEncode((int32_t)(count - seq)));
+  if (link) {
+    n += putVarint(out + n, linkRssi < 0 ? (uint32_t)-linkRssi : 0);
+    n += putVarint(out + n, zigzagEncode(linkSnr));
+  }
+  if (keepalive) n += putVarint(out + n, keepaliveS);
+  if (type == FRAME_TYPE_ACK && (slotOffset > 0 || tdma)) {
+    n += putVarint(out + n, slotOffset);
+    if (tdma) n += putVarint(out + n, zigzagEncode(tdmaShift));
+  }
+  return n;
+}
+
+// =============== DECODE BINARY ================================
+inline bool decodeTelemetryFrame(const uint8_t* data, uint8_t len, TelemetryFrame& out) {
+  const uint8_t* p = data;
+  const uint8_t* end = data + len;
+
+  if (len < 4) return false;
+  if (p[0] != FRAME_TYPE_TELEMETRY && p[0] != FRAME_TYPE_ACK) return false;
+  out.type = *p++;
+
+  uint8_t flags = *p++;
+  out.led = flags & FRAME_FLAG_LED;
+  out.touch = flags & FRAME_FLAG_TOUCH;
+  out.spinner = (flags & FRAME_SPIN_MASK) >> FRAME_SPIN_SHIFT;
+  out.ackRequest = flags & FRAME_FLAG_ACK_REQ;
+
+  uint32_t delta;
+  if (!getVarint(p, end, out.seq)) return false;
+  if (!getVarint(p, end, delta)) return false;
+  out.count = out.seq + zigzagDecode(delta);
+
+  out.fields = FIELD_ALL;
+  out.slotOffset = 0;
+  out.tdmaShift = 0;
+  out.linkRssi = 0;
+  out.linkSnr = 0;
+  out.keepaliveS = 0;
+  if (out.type == FRAME_TYPE_TELEMETRY && (flags & FRAME_FLAG_KEEPALIVE)) {
+    uint32_t keepalive;
+    if (!getVarint(p, end, keepalive) || keepalive > 0xFFFF) return false;
+    out.keepaliveS = keepalive;
+  }
+  if (out.type == FRAME_TYPE_ACK && (flags & FRAME_FLAG_LINK)) {
+    uint32_t rssi, snr;
+    if (!getVarint(p, end, rssi) || rssi > 255) return false;
+    if (!getVarint(p, end, snr) || snr > 255) return false;
+    out.linkRssi = -(int16_t)rssi;
+    out.linkSnr = (int8_t)zigzagDecode(snr);
+    out.fields |= FIELD_LINK;
+  }
+  if (out.type == FRAME_TYPE_ACK && p < end) {
+    uint32_t slot;
+    if (!getVarint(p, end, slot) || slot > 0xFFFF) return false;
+    out.slotOffset = slot;
+    out.fields |= FIELD_SLOT;
+  }
+  if (out.type == FRAME_TYPE_ACK && p < end) {
+    uint32_t shift;
+    if (!getVarint(p, end, shift) || shift > 0xFFFF) return false;
+    out.tdmaShift = (int16_t)zigzagDecode(shift);
+    out.fields |= FIELD_TDMA;
+  }
+
+  out.legacy = false;
+  return p == end;
+}
+
+// =============== DECODE LEGACY ASCII ================================
+// "[ACK,]SEQ:x,LED:x,TOUCH:x,SPIN:x,COUNT:x[,REQ:1][,SLOT:x][,KA:x]" - single pass, no String
+inline bool decodeLegacyTelemetry(const char* data, uint8_t len, TelemetryFrame& out) {
+  const char* p = data;
+  const char* end = data + len;
+
+  out.type = FRAME_TYPE_TELEMETRY;
+  out.fields = 0;
+  out.ackRequest = false;
+  out.slotOffset = 0;
+  out.tdmaShift = 0;
+  out.linkRssi = 0;
+  out.linkSnr = 0;
+  out.keepaliveS = 0;
+  out.legacy = true;
+
+  if (len >= 4 && memcmp(p, "ACK,", 4) == 0) {
+    out.type = FRAME_TYPE_ACK;
+    p += 4;
+  }
+
+  while (p < end) {
+    // Key up to ':'
+    const char* key = p;
+    while (p < end && *p != ':' && *p != ',') p++;
+    uint8_t keyLen = p - key;
+    if (p >= end || *p != ':') {
+      if (p < end) p++;  // Skip unknown token
+      continue;
+    }
+    p++;
+
+    // Unsigned value up to ','
+    uint32_t value = 0;
+    bool digits = false;
+    while (p < end && *p >= '0' && *p <= '9') {
+      value = value * 10 + (*p - '0');
+      digits = true;
+      p++;
+    }
+    while (p < end && *p != ',') p++;  // Ignore trailing junk
+    if (p < end) p++;
+    if (!digits) continue;
+
+    if (keyLen == 3 && memcmp(key, "SEQ", 3) == 0) {
+      out.seq = value;
+      out.fields |= FIELD_SEQ;
+    } else if (keyLen == 3 && memcmp(key, "LED", 3) == 0) {
+      out.led = value != 0;
+      out.fields |= FIELD_LED;
+    } else if (keyLen == 5 && memcmp(key, "TOUCH", 5) == 0) {
+      out.touch = value != 0;
+      out.fields |= FIELD_TOUCH;
+    } else if (keyLen == 4 && memcmp(key, "SPIN", 4) == 0) {
+      // Bounds check to prevent buffer overflow!
+      out.spinner = (value < 4) ? value : 0;
+      out.fields |= FIELD_SPIN;
+    } else if (keyLen == 5 && memcmp(key, "COUNT", 5) == 0) {
+      out.count = value;
+      out.fields |= FIELD_COUNT;
+    } else if (keyLen == 3 && memcmp(key, "REQ", 3) == 0) {
+      out.ackRequest = value != 0;
+    } else if (keyLen == 4 && memcmp(key, "SLOT", 4) == 0 && value <= 0xFFFF) {
+      out.slotOffset = value;
+      out.fields |= FIELD_SLOT;
+    } else if (keyLen == 2 && memcmp(key, "KA", 2) == 0 && value <= 0xFFFF) {
+      out.keepaliveS = value;
+    }
+  }
+
+  return out.fields != 0 || out.type == FRAME_TYPE_ACK;
+}
+
+// =============== DECODE (either format) ================================
+inline bool decodeTelemetry(const char* data, uint8_t len, TelemetryFrame& out) {
+  if (len > 0 && ((uint8_t)data[0] & FRAME_BINARY_BIT)) {
+    return decodeTelemetryFrame((const uint8_t*)data, len, out);
+  }
+  return decodeLegacyTelemetry(data, len, out);
+}
+
+#endif // TELEMETRY_FRAME_H
@@ -0,0 +1,200 @@
+/*=====================================================================
+  time_sync.h - Gateway Time Beacons (shared clock for TDMA)
+
+  The receiver broadcasts a small beacon every BEACON_INTERVAL ms with
+  its millis() and the TDMA slot map. Senders turn the beacons into a
+  drift-corrected estimate of receiver time:
+
+    sample  = epoch + beacon air time + TIME_SYNC_LATENCY_MS - local rx
+    fit     = least squares over the last TIME_SYNC_HISTORY samples
+              → offset (ms) + drift (ms per ms, crystal ±50 ppm)
+    gateway = local + offset + drift × (local - last beacon)
+
+  Why a fit and not the last sample: one beacon carries ±5-10 ms of
+  UART/loop jitter. Drift from two beacons a minute apart would be off
+  by ~150 ppm (0.5 s per hour); the fit over 32 beacons (32 min at the
+  default interval) keeps the error after one hour without beacons
+  around 20 ms (±50 ppm crystals, ±8 ms jitter).
+
+  Beacon frame (broadcast to LORA_BROADCAST_ADDR):
+
+  Byte  | Field
+  ------|---------------------------------------------------
+  0     | type 0x86
+  1-4   | epoch: receiver millis() (little endian)
+  5     | slotCount
+  6-7   | slotMs (little endian)
+  8..   | slot map: sender address per slot (0-BEACON_MAP_MAX)
+
+  A sender finds its slot by its own address in the map (position %
+  slotCount); an empty map means a single sender in slot 0. With the
+  slot known, mac_layer.h schedules every uplink at the slot start in
+  receiver time - no ACK needed to stay aligned.
+
+  A jump of more than TIME_SYNC_RESET_MS (receiver rebooted) restarts
+  the fit.
+
+  Pure C++ (no String, no heap) - host-testable.
+=======================================================================*/
+
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define FRAME_TYPE_BEACON 0x86
+
+#define BEACON_HEADER_LEN 8
+#define BEACON_MAP_MAX 16            // Addresses in the slot map
+#define BEACON_FRAME_MAX (BEACON_HEADER_LEN + BEACON_MAP_MAX)
+#define TIME_SYNC_HISTORY 32         // Beacons in the drift fit (256 B)
+#define TIME_SYNC_RESET_MS 1000      // Larger jump = receiver restarted
+
+struct TimeSync {
+  // Samples: local rx time → (receiver - local) offset
+  unsigned long sampleLocal[TIME_SYNC_HISTORY];
+  int32_t sampleOffset[TIME_SYNC_HISTORY];
+  uint8_t head;
+  uint8_t count;
+
+  // Fit (valid after the first beacon, drift after the third)
+  bool valid;
+  unsigned long refLocal;          // Newest beacon (local millis)
+  int32_t offset;                  // Receiver - local at refLocal
+  float drift;                     // Receiver ms per local ms - 1
+
+  // Slot map from the newest beacon
+  uint8_t slotCount;
+  uint16_t slotMs;
+  int16_t mySlot;                  // -1 = not in the map
+
+  // Statistics
+  unsigned long beacons;
+  unsigned long resets;
+  int32_t lastResidual;            // Newest sample vs prediction (ms)
+};
+
+// =============== BEACON FRAME ================================
+inline uint8_t encodeBeacon(uint8_t* out, uint32_t epoch, uint8_t slotCount,
+                            uint16_t slotMs, const uint8_t* map, uint8_t mapLen) {
+  if (mapLen > BEACON_MAP_MAX) mapLen = BEACON_MAP_MAX;
+  out[0] = FRAME_TYPE_BEACON;
+  for (uint8_t i = 0; i < 4; i++) out[1 + i] = (uint8_t)(epoch >> (8 * i));
+  out[5] = slotCount;
+  out[6] = (uint8_t)slotMs;
+  out[7] = (uint8_t)(slotMs >> 8);
+  memcpy(out + BEACON_HEADER_LEN, map, mapLen);
+  return BEACON_HEADER_LEN + mapLen;
+}
+
+inline bool isBeaconFrame(const char* data, uint8_t len) {
+  return len >= BEACON_HEADER_LEN && len <= BEACON_FRAME_MAX &&
+         (uint8_t)data[0] == FRAME_TYPE_BEACON;
+}
+
+// =============== SENDER: CLOCK ESTIMATE ================================
+inline void timeSyncInit(TimeSync& ts) {
+  memset(&ts, 0, sizeof(ts));
+  ts.mySlot = -1;
+}
+
+inline unsigned long timeSyncGateway(const TimeSync& ts, unsigned long local) {
+  int32_t since = (int32_t)(local - ts.refLocal);
+  return local + ts.offset + (int32_t)(ts.drift * since);
+}
+
+inline unsigned long timeSyncLocal(const TimeSync& ts, unsigned long gateway) {
+  // Inverse of timeSyncGateway() (drift ≪ 1, one step is exact to µs)
+  unsigned long local = gateway - ts.offset;
+  int32_t since = (int32_t)(local - ts.refLocal);
+  return local - (int32_t)(ts.drift * since);
+}
+
+// Least squares over the sample ring, relative to the newest sample
+inline void timeSyncFit(TimeSync& ts) {
+  uint8_t newest = (ts.head + TIME_SYNC_HISTORY - 1) % TIME_SYNC_HISTORY;
+  ts.refLocal = ts.sampleLocal[newest];
+  int32_t y0 = ts.sampleOffset[newest];
+
+  if (ts.count < 3) {
+    ts.offset = y0;
+    ts.drift = 0;
+    return;
+  }
+
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for (uint8_t i = 0; i < ts.count; i++) {
+    double x = (int32_t)(ts.sampleLocal[i] - ts.refLocal);
+    double y = ts.sampleOffset[i] - y0;
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+  }
+  double n = ts.count;
+  double den = n * sxx - sx * sx;
+  double slope = den > 0 ? (n * sxy - sx * sy) / den : 0;
+  double intercept = (sy - slope * sx) / n;
+
+  ts.offset = y0 + (int32_t)lround(intercept);
+  ts.drift = (float)slope;
+}
+
+// Beacon heard at localRx (+RCV line time). Returns true if accepted.
+inline bool timeSyncOnBeacon(TimeSync& ts, unsigned long localRx, const char* data,
+                             uint8_t len, uint8_t myAddress, uint32_t airtimeMs) {
+  if (!isBeaconFrame(data, len)) return false;
+  const uint8_t* p = (const uint8_t*)data;
+
+  uint32_t epoch = (uint32_t)p[1] | ((uint32_t)p[2] << 8) |
+                   ((uint32_t)p[3] << 16) | ((uint32_t)p[4] << 24);
+  unsigned long gatewayAtRx = epoch + airtimeMs + TIME_SYNC_LATENCY_MS;
+  int32_t sample = (int32_t)(gatewayAtRx - localRx);
+
+  if (ts.valid) {
+    ts.lastResidual = (int32_t)(gatewayAtRx - timeSyncGateway(ts, localRx));
+    if (ts.lastResidual > TIME_SYNC_RESET_MS || ts.lastResidual < -TIME_SYNC_RESET_MS) {
+      ts.head = 0;  // Receiver restarted - old samples describe another clock
+      ts.count = 0;
+      ts.resets++;
+    }
+  }
+
+  ts.sampleLocal[ts.head] = localRx;
+  ts.sampleOffset[ts.head] = sample;
+  ts.head = (ts.head + 1) % TIME_SYNC_HISTORY;
+  if (ts.count < TIME_SYNC_HISTORY) ts.count++;
+  timeSyncFit(ts);
+  ts.valid = true;
+  ts.beacons++;
+
+  // Slot map
+  ts.slotCount = p[5] ? p[5] : 1;
+  ts.slotMs = (uint16_t)p[6] | ((uint16_t)p[7] << 8);
+  uint8_t mapLen = len - BEACON_HEADER_LEN;
+  ts.mySlot = mapLen ? -1 : 0;
+  for (uint8_t i = 0; i < mapLen; i++) {
+    if (p[BEACON_HEADER_LEN + i] == myAddress) {
+      ts.mySlot = i % ts.slotCount;
+      break;
+    }
+  }
+  return true;
+}
+
+inline bool timeSyncSlotKnown(const TimeSync& ts) {
+  return ts.valid && ts.mySlot >= 0 && ts.slotMs > 0;
+}
+
+// Local millis() of our next slot start at or after localEarliest
+inline unsigned long timeSyncNextSlot(const TimeSync& ts, unsigned long localEarliest) {
+  uint32_t frame = (uint32_t)ts.slotCount * ts.slotMs;
+  unsigned long gateway = timeSyncGateway(ts, localEarliest);
+  uint32_t slotStart = (uint32_t)ts.mySlot * ts.slotMs;
+  uint32_t phase = gateway % frame;
+  uint32_t wait = (slotStart + frame - phase) % frame;
+  return timeSyncLocal(ts, gateway + wait);
+}
+
+#endif // TIME_SYNC_H
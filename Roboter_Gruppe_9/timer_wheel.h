@@ -0,0 +1,343 @@
+/*=====================================================================
+  timer_wheel.h - Hierarchical Timer Wheel and Idle Sleep
+
+  loop() used to test a dozen "millis() - timing.lastX >= N" conditions
+  on every pass - spinner, touch, LCD, status, health report, data
+  output, display station, battery/current, packet stats - and then
+  delay(10) whether anything was due or not: 100 wakeups per second
+  for a handful of events.
+
+  Those periodic jobs are now timers in one wheel:
+
+    Level | Slot width | Covers
+    ------|------------|---------------------------------------
+    0     | 1 ms       | next 64 ms
+    1     | 64 ms      | next 4.1 s
+    2     | 4.1 s      | next 4.4 min
+    3     | 4.4 min    | next 4.7 h (later: parked in the last
+          |            | slot, placed again when it cascades)
+
+  A timer sits in the slot of its expiry on the lowest level that can
+  hold it; when level 0 wraps, the next level-1 slot is moved down (and
+  level 2 when level 1 wraps, ...). Insert and stop are O(1) (doubly
+  linked index lists); a bitmask of used slots per level lets
+  timerWheelRun() jump straight to the next used slot and
+  timerWheelNextMs() find the next deadline without walking empty ones.
+
+  A periodic timer is re-armed PERIOD after its callback returned - the
+  drift the old "timing.lastX = millis()" checks had, so the functions'
+  own rate limits (updateSpinner(), sampleTouch(), ...) still pass.
+
+  With ENABLE_IDLE_SLEEP loop() ends in idleWait(): blocked until the
+  next timer, the next uplink or a LoRa UART byte (idleWake() from the
+  UART event task) instead of delay(10). Every wait is booked in
+  IdleStats, so the idle budget is visible in both modes.
+
+  The wheel itself is plain C++ (millis() only) - host-testable.
+=======================================================================*/
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define TIMER_WHEEL_MAX 16           // Timers in the pool
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_BITS 6           // 64 slots per level
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_NONE 0xFF
+#define TIMER_NEVER 0xFFFFFFFFUL     // timerWheelNextMs(): nothing armed
+
+typedef void (*TimerCallback)(void* ctx);
+
+struct WheelTimer {
+  const char* name;
+  TimerCallback callback;
+  void* ctx;
+  uint32_t expires;                  // millis() of the next run
+  uint32_t periodMs;                 // 0 = one-shot
+  uint8_t next;                      // Slot list (TIMER_NONE = end)
+  uint8_t prev;
+  uint8_t level;                     // Slot it is linked into
+  uint8_t slot;
+  bool armed;
+
+  // Statistics
+  unsigned long runs;
+  unsigned long maxLateMs;           // Callback start after expiry
+};
+
+struct TimerWheel {
+  WheelTimer timers[TIMER_WHEEL_MAX];
+  uint8_t count;
+  uint8_t heads[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  uint64_t used[TIMER_WHEEL_LEVELS]; // Bit per non-empty slot
+  uint32_t now;                      // Last tick processed
+  uint8_t running;                   // Timer in its callback (TIMER_NONE)
+
+  // Statistics
+  unsigned long fired;
+  unsigned long cascaded;            // Timers moved down a level
+};
+
+inline void timerWheelInit(TimerWheel& w) {
+  memset(&w, 0, sizeof(w));
+  memset(w.heads, TIMER_NONE, sizeof(w.heads));
+  w.now = (uint32_t)millis();
+  w.running = TIMER_NONE;
+}
+
+// =============== SLOT LISTS ================================
+// Used slots from slot `from` on, wrapped round (bit 0 = slot `from`)
+inline uint64_t timerSlotsFrom(uint64_t used, uint8_t from) {
+  from &= TIMER_WHEEL_MASK;
+  return from ? (used >> from) | (used << (TIMER_WHEEL_SLOTS - from)) : used;
+}
+
+inline void timerLink(TimerWheel& w, uint8_t id, uint8_t level, uint8_t slot) {
+  WheelTimer& t = w.timers[id];
+  t.level = level;
+  t.slot = slot;
+  t.prev = TIMER_NONE;
+  t.next = w.heads[level][slot];
+  if (t.next != TIMER_NONE) w.timers[t.next].prev = id;
+  w.heads[level][slot] = id;
+  w.used[level] |= 1ULL << slot;
+  t.armed = true;
+}
+
+inline void timerUnlink(TimerWheel& w, uint8_t id) {
+  WheelTimer& t = w.timers[id];
+  if (!t.armed) return;
+  if (t.prev != TIMER_NONE) w.timers[t.prev].next = t.next;
+  else w.heads[t.level][t.slot] = t.next;
+  if (t.next != TIMER_NONE) w.timers[t.next].prev = t.prev;
+  if (w.heads[t.level][t.slot] == TIMER_NONE) w.used[t.level] &= ~(1ULL << t.slot);
+  t.armed = false;
+}
+
+// Lowest level whose range holds the expiry (relative to w.now)
+inline void timerPlace(TimerWheel& w, uint8_t id) {
+  WheelTimer& t = w.timers[id];
+  uint32_t delta = t.expires - w.now;
+  uint8_t level = 0;
+  while (level + 1 < TIMER_WHEEL_LEVELS &&
+         delta >= (1UL << (TIMER_WHEEL_BITS * (level + 1)))) {
+    level++;
+  }
+  uint8_t shift = TIMER_WHEEL_BITS * level;
+  uint32_t slot = t.expires >> shift;
+  if (delta >= (1UL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))) {
+    slot = (w.now >> shift) + TIMER_WHEEL_MASK;  // Beyond the top level
+  }
+  timerLink(w, id, level, slot & TIMER_WHEEL_MASK);
+}
+
+inline void timerArm(TimerWheel& w, uint8_t id, uint32_t expires) {
+  timerUnlink(w, id);
+  // Never into the tick being processed - the earliest is the next one
+  if ((int32_t)(expires - w.now) < 1) expires = w.now + 1;
+  w.timers[id].expires = expires;
+  timerPlace(w, id);
+}
+
+// =============== TIMERS ================================
+// Periodic (periodMs > 0) or one-shot (periodMs = 0) timer, first run
+// delayMs from now; TIMER_NONE if the pool is full
+inline uint8_t timerAdd(TimerWheel& w, const char* name, unsigned long delayMs,
+                        unsigned long periodMs, TimerCallback callback, void* ctx = nullptr) {
+  if (w.count >= TIMER_WHEEL_MAX) return TIMER_NONE;
+  uint8_t id = w.count++;
+  WheelTimer& t = w.timers[id];
+  t.name = name;
+  t.callback = callback;
+  t.ctx = ctx;
+  t.periodMs = periodMs;
+  timerArm(w, id, (uint32_t)millis() + delayMs);
+  return id;
+}
+
+// (Re)arm: next run delayMs from now (a periodic one keeps its period)
+inline void timerStart(TimerWheel& w, uint8_t id, unsigned long delayMs) {
+  if (id >= w.count) return;
+  timerArm(w, id, (uint32_t)millis() + delayMs);
+}
+
+// Disarm (also from its own callback: a periodic one is not re-armed)
+inline void timerStop(TimerWheel& w, uint8_t id) {
+  if (id >= w.count) return;
+  timerUnlink(w, id);
+  if (w.running == id) w.running = TIMER_NONE;
+}
+
+// =============== RUN ================================
+inline void timerFire(TimerWheel& w, uint8_t id) {
+  WheelTimer& t = w.timers[id];
+  unsigned long late = (uint32_t)millis() - t.expires;
+  if (late > t.maxLateMs) t.maxLateMs = late;
+  t.runs++;
+  w.fired++;
+
+  w.running = id;
+  t.callback(t.ctx);
+  // Not stopped or re-armed by the callback: the next period starts now
+  if (w.running == id && t.periodMs && !t.armed) {
+    timerArm(w, id, (uint32_t)millis() + t.periodMs);
+  }
+  w.running = TIMER_NONE;
+}
+
+// Level 0 wrapped: the next slot of level 1 moves down, level 2 when
+// level 1 wraps too, ...
+inline void timerCascade(TimerWheel& w) {
+  for (uint8_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+    uint8_t slot = (w.now >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    uint8_t id;
+    while ((id = w.heads[level][slot]) != TIMER_NONE) {
+      timerUnlink(w, id);
+      timerPlace(w, id);
+      w.cascaded++;
+    }
+    if (slot != 0) break;
+  }
+}
+
+// Run every timer due by now (call every loop pass); returns how many ran
+inline uint8_t timerWheelRun(TimerWheel& w) {
+  uint32_t target = (uint32_t)millis();
+  uint8_t ran = 0;
+  while ((int32_t)(target - w.now) > 0) {
+    // Next tick with work: a used level-0 slot or the level-0 wrap
+    uint32_t step = target - w.now;
+    uint32_t toWrap = TIMER_WHEEL_SLOTS - (w.now & TIMER_WHEEL_MASK);
+    if (toWrap < step) step = toWrap;
+    uint64_t ahead = timerSlotsFrom(w.used[0], w.now + 1);
+    if (ahead) {
+      uint32_t toSlot = __builtin_ctzll(ahead) + 1;
+      if (toSlot < step) step = toSlot;
+    }
+    w.now += step;
+
+    if ((w.now & TIMER_WHEEL_MASK) == 0) timerCascade(w);
+
+    // Level-0 slot = exactly this tick
+    uint8_t slot = w.now & TIMER_WHEEL_MASK;
+    uint8_t id;
+    while ((id = w.heads[0][slot]) != TIMER_NONE) {
+      timerUnlink(w, id);
+      timerFire(w, id);
+      ran++;
+    }
+  }
+  return ran;
+}
+
+// ms until the next timer is due (0 = due now, TIMER_NEVER = none armed).
+// Per level the first used slot after the current one holds that
+// level's earliest expiry; level 0 slots hold a single tick each.
+inline unsigned long timerWheelNextMs(const TimerWheel& w) {
+  uint32_t best = TIMER_NEVER;
+  for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    if (!w.used[level]) continue;
+    uint8_t shift = TIMER_WHEEL_BITS * level;
+    uint8_t from = ((w.now >> shift) + 1) & TIMER_WHEEL_MASK;
+    uint8_t slot = (from + __builtin_ctzll(timerSlotsFrom(w.used[level], from))) & TIMER_WHEEL_MASK;
+    for (uint8_t id = w.heads[level][slot]; id != TIMER_NONE; id = w.timers[id].next) {
+      uint32_t delta = w.timers[id].expires - w.now;
+      if (delta < best) best = delta;
+    }
+  }
+  if (best == TIMER_NEVER) return TIMER_NEVER;
+  int32_t wait = (int32_t)(w.now + best - (uint32_t)millis());
+  return wait > 0 ? wait : 0;
+}
+
+inline uint8_t timerWheelArmed(const TimerWheel& w) {
+  uint8_t armed = 0;
+  for (uint8_t i = 0; i < w.count; i++) {
+    if (w.timers[i].armed || w.running == i) armed++;  // Running: re-armed after it
+  }
+  return armed;
+}
+
+// =============== IDLE WAIT ================================
+struct IdleStats {
+  unsigned long windowStartUs;       // Since the last printIdleStats()
+  unsigned long sleptUs;
+  unsigned long waits;
+  unsigned long uartWakes;           // Ended early by a LoRa UART byte
+};
+
+inline void idleStatsInit(IdleStats& s) {
+  memset(&s, 0, sizeof(s));
+  s.windowStartUs = micros();
+}
+
+#if ENABLE_IDLE_SLEEP
+TaskHandle_t idleTask = nullptr;     // loop() task, woken by idleWake()
+
+// In setup(): from here on UART bytes wake loop()
+inline void idleSleepBegin() {
+  idleTask = xTaskGetCurrentTaskHandle();
+}
+
+// UART event task: bytes arrived (a wake before the wait is kept)
+inline void idleWake() {
+  if (idleTask) xTaskNotifyGive(idleTask);
+}
+#endif
+
+// loop() idle time: delay(ms), or with ENABLE_IDLE_SLEEP blocked until
+// ms passed or idleWake()
+inline void idleWait(IdleStats& s, unsigned long ms) {
+  unsigned long start = micros();
+  #if ENABLE_IDLE_SLEEP
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms)) > 0) s.uartWakes++;
+  #else
+    delay(ms);
+  #endif
+  s.sleptUs += micros() - start;
+  s.waits++;
+}
+
+// =============== STATUS ================================
+// Wakeups and sleep share since the last call (then a new window)
+inline void printIdleStats(IdleStats& s) {
+  unsigned long window = micros() - s.windowStartUs;
+  if (window == 0 || s.waits == 0) return;
+  Serial.print("💤 Loop: ");
+  Serial.print(s.waits * 1000000.0f / window, 1);
+  Serial.print(" wakeups/s, ");
+  Serial.print(s.sleptUs * 100.0f / window, 1);
+  Serial.print("% asleep, avg ");
+  Serial.print(s.sleptUs / s.waits / 1000.0f, 1);
+  Serial.print(" ms, UART wakes ");
+  Serial.println(s.uartWakes);
+  idleStatsInit(s);
+}
+
+inline void printTimerWheelStats(const TimerWheel& w) {
+  uint8_t worst = TIMER_NONE;
+  for (uint8_t i = 0; i < w.count; i++) {
+    if (worst == TIMER_NONE || w.timers[i].maxLateMs > w.timers[worst].maxLateMs) worst = i;
+  }
+  Serial.print("⏲️  Timers: ");
+  Serial.print(timerWheelArmed(w));
+  Serial.print(" armed, ");
+  Serial.print(w.fired);
+  Serial.print(" runs, ");
+  Serial.print(w.cascaded);
+  Serial.print(" cascaded");
+  if (worst != TIMER_NONE) {
+    Serial.print(", max late ");
+    Serial.print(w.timers[worst].maxLateMs);
+    Serial.print(" ms (");
+    Serial.print(w.timers[worst].name);
+    Serial.print(")");
+  }
+  Serial.println();
+}
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,219 @@
+/*=====================================================================
+  tx_power.h - Closed-Loop Transmit Power Control (sender)
+
+  A bench-close link has 40-60 dB more margin than it needs, yet the
+  sender transmits at full power all day. This loop keeps the uplink
+  just strong enough:
+
+    receiver ACK ── link report: RSSI/SNR of the answered uplink
+    margin = min(SNR - SNR floor, RSSI - sensitivity)   (airtime.h)
+
+  - Worst margin of the last TXP_SAMPLES reports below TXP_MARGIN_DB
+    → step up at once by the missing dB
+  - Worst margin ≥ TXP_MARGIN_DB + TXP_STEP_DB + TXP_HYSTERESIS_DB for
+    a full window and TXP_HOLD_MS → one step down
+  - Missed ACK slot → two steps up, TXP_LOSS_MISSES in a row → max
+    (fast attack, slow decay: a lost packet costs more than a few dB)
+  - Every change empties the window - old reports describe the old level
+
+  With ENABLE_ADAPTIVE_SF the SF goes down first: power only steps
+  down at ADR_SF_MIN with no switch running (LoRaWAN ADR order).
+
+  Energy per delivered packet (TX only, radio delta over idle):
+
+    E = V × I(dBm) × air time
+    delivered = uplinks × ACK hit rate (confirmed uplinks sample the link)
+
+  I(dBm) is measured with ENABLE_CURRENT_MONITOR (INA219 sampled in the
+  middle of the uplink, minus the idle current) and otherwise taken
+  from the SX1276 PA_BOOST curve below (supply current minus ~12 mA in
+  RX). The same uplinks at TXP_MAX_DBM give the baseline for the
+  savings figure.
+
+    dBm        | 0  | 5  | 10 | 15
+    mA over RX | 12 | 18 | 28 | 50   (model, TXP_SUPPLY_V)
+
+  AT+CRFOP goes through the AT engine; the level counts as changed only
+  after +OK.
+=======================================================================*/
+
+#ifndef TX_POWER_H
+#define TX_POWER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "lora_handler.h"  // atEnqueue(loraAT), loraParams, link budget
+
+#define TXP_SAMPLES 8                // ACK reports per decision
+#define TXP_LEVELS 16                // AT+CRFOP 0-15 dBm
+
+struct TxPowerControl {
+  int8_t dBm;                      // Level in use (module confirmed)
+  int8_t pendingDbm;               // AT+CRFOP in flight, -1 = none
+  float margin[TXP_SAMPLES];       // Link margins from ACK reports (dB)
+  uint8_t head;
+  uint8_t count;
+  uint8_t misses;                  // ACK slots missed in a row
+  unsigned long lastChange;
+
+  // Energy
+  float txDelta_mA[TXP_LEVELS];    // Measured TX current over idle, 0 = model
+  float idle_mA;                   // Measured idle current (EWMA)
+  float energy_mJ;                 // Uplink TX energy at the levels used
+  float energyMax_mJ;              // Same uplinks at TXP_MAX_DBM
+  unsigned long uplinks;
+  unsigned long ackHits;
+  unsigned long ackMisses;
+
+  // Statistics
+  unsigned long stepsDown;
+  unsigned long stepsUp;
+};
+
+inline void txPowerInit(TxPowerControl& tp) {
+  memset(&tp, 0, sizeof(tp));
+  tp.dBm = TXP_MAX_DBM;
+  tp.pendingDbm = -1;
+  tp.lastChange = millis();
+}
+
+// =============== ENERGY MODEL ================================
+// SX1276 PA_BOOST TX current over RX (mA), linear between 5 dB points
+inline float txPowerModel_mA(int8_t dBm) {
+  static const float points[4] = {12, 18, 28, 50};
+  if (dBm <= 0) return points[0];
+  if (dBm >= 15) return points[3];
+  uint8_t i = dBm / 5;
+  return points[i] + (points[i + 1] - points[i]) * (dBm - 5 * i) / 5.0f;
+}
+
+inline float txPowerCurrent_mA(const TxPowerControl& tp, int8_t dBm) {
+  float measured = tp.txDelta_mA[dBm];
+  return measured > 0 ? measured : txPowerModel_mA(dBm);
+}
+
+// Current monitor: one reading in the middle of an uplink, one while idle
+inline void txPowerOnCurrentSample(TxPowerControl& tp, float mA, bool transmitting) {
+  if (!transmitting) {
+    tp.idle_mA = tp.idle_mA > 0 ? 0.9f * tp.idle_mA + 0.1f * mA : mA;
+    return;
+  }
+  if (tp.idle_mA <= 0 || mA <= tp.idle_mA) return;
+  float delta = mA - tp.idle_mA;
+  float& level = tp.txDelta_mA[tp.dBm];
+  level = level > 0 ? 0.8f * level + 0.2f * delta : delta;
+}
+
+// Uplink left the air (+OK)
+inline void txPowerOnUplink(TxPowerControl& tp, uint32_t airtimeMs, float volts) {
+  tp.uplinks++;
+  tp.energy_mJ += volts * txPowerCurrent_mA(tp, tp.dBm) * airtimeMs / 1000.0f;
+  tp.energyMax_mJ += volts * txPowerCurrent_mA(tp, TXP_MAX_DBM) * airtimeMs / 1000.0f;
+}
+
+inline float txPowerDelivered(const TxPowerControl& tp) {
+  unsigned long slots = tp.ackHits + tp.ackMisses;
+  return slots ? (float)tp.uplinks * tp.ackHits / slots : (float)tp.uplinks;
+}
+
+inline float txPowerPerDelivered_mJ(const TxPowerControl& tp) {
+  float delivered = txPowerDelivered(tp);
+  return delivered > 0 ? tp.energy_mJ / delivered : 0;
+}
+
+inline float txPowerSavingsPct(const TxPowerControl& tp) {
+  return tp.energyMax_mJ > 0 ? 100.0f * (1 - tp.energy_mJ / tp.energyMax_mJ) : 0;
+}
+
+// =============== MODULE ================================
+inline void onTxPowerSet(ATResult result, const char* response, void* ctx) {
+  TxPowerControl& tp = *(TxPowerControl*)ctx;
+  if (result == AT_RESULT_OK && tp.pendingDbm >= 0) {
+    Serial.print("📶 TX power ");
+    Serial.print(tp.dBm);
+    Serial.print(" → ");
+    Serial.print(tp.pendingDbm);
+    Serial.println(" dBm");
+    if (tp.pendingDbm < tp.dBm) tp.stepsDown++;
+    else tp.stepsUp++;
+    tp.dBm = tp.pendingDbm;
+  } else {
+    Serial.println("❌ AT+CRFOP failed");
+  }
+  tp.pendingDbm = -1;
+  tp.lastChange = millis();
+  tp.count = 0;  // Reports so far describe the old level
+  tp.head = 0;
+}
+
+inline bool txPowerSet(TxPowerControl& tp, int8_t dBm) {
+  if (dBm < TXP_MIN_DBM) dBm = TXP_MIN_DBM;
+  if (dBm > TXP_MAX_DBM) dBm = TXP_MAX_DBM;
+  if (tp.pendingDbm >= 0 || dBm == tp.dBm) return false;
+
+  char cmd[16];
+  snprintf(cmd, sizeof(cmd), "AT+CRFOP=%d", dBm);
+  if (!atEnqueue(loraAT, cmd, 1000, onTxPowerSet, &tp)) return false;
+  tp.pendingDbm = dBm;
+  return true;
+}
+
+// =============== CONTROL LOOP ================================
+// ACK in slot with link report. allowDown = false holds the level
+// (ADR still moving the SF).
+inline void txPowerOnReport(TxPowerControl& tp, int16_t rssi, int8_t snr, bool allowDown) {
+  if (tp.pendingDbm >= 0) return;  // Uplink was sent before the change
+
+  tp.margin[tp.head] = loraLinkMargin(rssi, snr, loraParams);
+  tp.head = (tp.head + 1) % TXP_SAMPLES;
+  if (tp.count < TXP_SAMPLES) tp.count++;
+
+  float worst = tp.margin[0];
+  for (uint8_t i = 1; i < tp.count; i++) {
+    if (tp.margin[i] < worst) worst = tp.margin[i];
+  }
+
+  if (worst < TXP_MARGIN_DB) {
+    txPowerSet(tp, tp.dBm + (int8_t)ceilf(TXP_MARGIN_DB - worst));
+  } else if (allowDown && tp.count == TXP_SAMPLES &&
+             millis() - tp.lastChange >= TXP_HOLD_MS &&
+             worst >= TXP_MARGIN_DB + TXP_STEP_DB + TXP_HYSTERESIS_DB) {
+    txPowerSet(tp, tp.dBm - TXP_STEP_DB);
+  }
+}
+
+// Any ACK in its slot (state, bitmap or ADR command)
+inline void txPowerOnAck(TxPowerControl& tp) {
+  tp.ackHits++;
+  tp.misses = 0;
+}
+
+inline void txPowerOnAckMissed(TxPowerControl& tp) {
+  tp.ackMisses++;
+  tp.misses++;
+  if (tp.misses >= TXP_LOSS_MISSES) {
+    txPowerSet(tp, TXP_MAX_DBM);
+  } else {
+    txPowerSet(tp, tp.dBm + 2 * TXP_STEP_DB);
+  }
+}
+
+// =============== STATUS ================================
+inline void printTxPowerStatus(const TxPowerControl& tp) {
+  Serial.print("TX power: ");
+  Serial.print(tp.dBm);
+  Serial.print(" dBm (down ");
+  Serial.print(tp.stepsDown);
+  Serial.print(", up ");
+  Serial.print(tp.stepsUp);
+  Serial.print("), ");
+  Serial.print(txPowerPerDelivered_mJ(tp), 1);
+  Serial.print(" mJ/delivered, saved ");
+  Serial.print(txPowerSavingsPct(tp), 0);
+  Serial.print("% vs ");
+  Serial.print(TXP_MAX_DBM);
+  Serial.print(" dBm");
+  Serial.println(tp.txDelta_mA[tp.dBm] > 0 ? " (measured)" : " (model)");
+}
+
+#endif // TX_POWER_H
@@ -0,0 +1,280 @@
+/*=====================================================================
+  tx_queue.h - Priority Transmit Queue (alarms before telemetry)
+
+  The radio is half-duplex and one AT+SEND runs at a time. Before
+  this queue every sender path grabbed the radio when it found it
+  free, in code order, and a fire alarm without ENABLE_RELIABLE_LINK
+  was never sent at all.
+
+  Now the sender picks the next frame by priority whenever the radio
+  and the ACK slot are free:
+
+    Order | Frames                     | Queue policy (TXQ_SIZE entries)
+    ------|----------------------------|----------------------------------
+    1     | fire alerts (TXQ_ALARM)    | full: evicts the newest command,
+          |                            | then merges into the newest alert
+    2     | "CMD:..." (TXQ_COMMAND)    | full: newcomer dropped
+    3     | FEC parity, ADR accept     | state flags, one pending at most
+    4     | telemetry / batch          | snapshot built at send time - a
+          |                            | deferred one is simply rebuilt
+
+  Telemetry never waits in this queue: the newest state replaces any
+  snapshot that could not go, which is the coalescing low-priority
+  traffic needs. ACKs do not queue either: the receiver sends them at
+  a fixed slot (ack_slot.h) and the sender keeps the radio free until
+  that slot has closed, so an alert ranks above the next uplink, not
+  above an ACK exchange already running. With ENABLE_RELIABLE_LINK,
+  alerts and commands go through the ARQ ring (reliable_link.h) in the
+  same order.
+
+  Alert latency = detection → alert frame handed to the radio. Target:
+  below one air time of the longest uplink (telemetry frame or batch
+  at the current SF). A frame already on air cannot be aborted, so the
+  worst case is the rest of that frame; an ACK exchange adds
+  ACK_SLOT_OFFSET plus the ACK air time, and the duty cycle can hold
+  the alert back further. txqPrintStatus() counts alerts that missed
+  the target. The alert frame carries its queue age, so the receiver
+  logs detection → reception. `sent` and the latency are booked on
+  +OK; an AT+SEND that fails puts the entry back (txqRequeue()) without
+  counting it again.
+
+  Frames:
+
+  Alert    | 0 type 0x8C | 1 method bits (REL_ALERT_*) | count varint | age varint (10 ms)
+  Command  | 0 type 0x8D | 1.. ASCII "CMD:..."
+
+  Pure C++ (no String, no heap) - host-testable.
+=======================================================================*/
+
+#ifndef TX_QUEUE_H
+#define TX_QUEUE_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "telemetry_frame.h"  // putVarint() / getVarint()
+
+#define FRAME_TYPE_ALERT   0x8C
+#define FRAME_TYPE_COMMAND 0x8D
+
+#define TXQ_FRAME_MAX 40             // Alert or "CMD:..." line
+#define TXQ_AGE_UNIT 10              // Alert age resolution (ms)
+
+enum TxPriority {
+  TXQ_ALARM = 0,
+  TXQ_COMMAND = 1,
+  TXQ_LEVELS = 2
+};
+
+struct TxqItem {
+  uint8_t prio;
+  uint8_t len;
+  unsigned long queuedAt;
+  uint8_t data[TXQ_FRAME_MAX];
+};
+
+struct TxQueue {
+  TxqItem items[TXQ_SIZE];
+  uint8_t count;
+
+  // Statistics per level
+  unsigned long queued[TXQ_LEVELS];
+  unsigned long sent[TXQ_LEVELS];
+  unsigned long merged[TXQ_LEVELS];     // Folded into a queued frame
+  unsigned long dropped[TXQ_LEVELS];    // Evicted or rejected (queue full)
+
+  // Alert latency: detection → radio (queued and ARQ alerts)
+  unsigned long alarms;
+  unsigned long alarmMaxMs;
+  unsigned long alarmSumMs;
+  unsigned long alarmOverTarget;
+};
+
+inline void txqInit(TxQueue& q) {
+  memset(&q, 0, sizeof(q));
+}
+
+// Entry that leaves next: highest level, oldest first
+inline TxqItem* txqFront(TxQueue& q) {
+  TxqItem* best = nullptr;
+  for (uint8_t i = 0; i < q.count; i++) {
+    TxqItem& it = q.items[i];
+    if (!best || it.prio < best->prio ||
+        (it.prio == best->prio && (long)(it.queuedAt - best->queuedAt) < 0)) {
+      best = &it;
+    }
+  }
+  return best;
+}
+
+inline void txqRemove(TxQueue& q, TxqItem* it) {
+  uint8_t i = it - q.items;
+  q.count--;
+  if (i != q.count) q.items[i] = q.items[q.count];
+}
+
+// Newest entry of the lowest level below prio (eviction victim)
+inline TxqItem* txqVictim(TxQueue& q, uint8_t prio) {
+  TxqItem* victim = nullptr;
+  for (uint8_t i = 0; i < q.count; i++) {
+    TxqItem& it = q.items[i];
+    if (it.prio <= prio) continue;
+    if (!victim || it.prio > victim->prio ||
+        (it.prio == victim->prio && (long)(it.queuedAt - victim->queuedAt) > 0)) {
+      victim = &it;
+    }
+  }
+  return victim;
+}
+
+inline TxqItem* txqNewest(TxQueue& q, uint8_t prio) {
+  TxqItem* newest = nullptr;
+  for (uint8_t i = 0; i < q.count; i++) {
+    TxqItem& it = q.items[i];
+    if (it.prio == prio && (!newest || (long)(it.queuedAt - newest->queuedAt) > 0)) {
+      newest = &it;
+    }
+  }
+  return newest;
+}
+
+inline bool txqPush(TxQueue& q, uint8_t prio, const uint8_t* data, uint8_t len,
+                    unsigned long now) {
+  if (len > TXQ_FRAME_MAX) {
+    q.dropped[prio]++;
+    return false;
+  }
+  q.queued[prio]++;
+
+  TxqItem* slot = nullptr;
+  if (q.count < TXQ_SIZE) {
+    slot = &q.items[q.count++];
+  } else if ((slot = txqVictim(q, prio)) != nullptr) {
+    q.dropped[slot->prio]++;
+  } else if (prio == TXQ_ALARM) {
+    // Queue full of alerts: counts are cumulative, the newest says it all
+    slot = txqNewest(q, prio);
+    q.merged[prio]++;
+    now = slot->queuedAt;  // Latency runs from the older detection
+  } else {
+    q.dropped[prio]++;
+    return false;
+  }
+
+  slot->prio = prio;
+  slot->len = len;
+  slot->queuedAt = now;
+  memcpy(slot->data, data, len);
+  return true;
+}
+
+// Entry the radio confirmed (+OK); it left the queue at hand-off
+inline void txqOnSent(TxQueue& q, uint8_t prio) {
+  q.sent[prio]++;
+}
+
+// Entry the radio did not take: back in line with its first queue time.
+// Neither newly queued nor sent - only an eviction it causes is counted
+inline void txqRequeue(TxQueue& q, const TxqItem& item) {
+  TxqItem* slot = nullptr;
+  if (q.count < TXQ_SIZE) {
+    slot = &q.items[q.count++];
+  } else if ((slot = txqVictim(q, item.prio)) != nullptr) {
+    q.dropped[slot->prio]++;
+  } else if (item.prio == TXQ_ALARM) {
+    // Queue full of newer alerts: their count includes this one
+    slot = txqNewest(q, item.prio);
+    if ((long)(item.queuedAt - slot->queuedAt) < 0) slot->queuedAt = item.queuedAt;
+    q.merged[item.prio]++;
+    return;
+  } else {
+    q.dropped[item.prio]++;
+    return;
+  }
+  *slot = item;
+}
+
+// Alert detected at detectedAt went to the radio at now
+inline void txqOnAlarmSent(TxQueue& q, unsigned long detectedAt, unsigned long now,
+                           uint32_t targetMs) {
+  unsigned long latency = now - detectedAt;
+  q.alarms++;
+  q.alarmSumMs += latency;
+  if (latency > q.alarmMaxMs) q.alarmMaxMs = latency;
+  if (latency >= targetMs) q.alarmOverTarget++;
+}
+
+// =============== FRAMES ================================
+// Age is filled in when the frame goes to the radio (txqStampAlert)
+inline uint8_t txqEncodeAlert(uint8_t* out, uint8_t method, uint32_t alertCount) {
+  out[0] = FRAME_TYPE_ALERT;
+  out[1] = method;
+  return 2 + putVarint(out + 2, alertCount);
+}
+
+inline uint8_t txqStampAlert(uint8_t* frame, uint8_t len, unsigned long ageMs) {
+  return len + putVarint(frame + len, ageMs / TXQ_AGE_UNIT);
+}
+
+inline bool txqDecodeAlert(const char* data, uint8_t len, uint8_t& method,
+                           uint32_t& alertCount, uint32_t& ageMs) {
+  if (len < 4 || (uint8_t)data[0] != FRAME_TYPE_ALERT) return false;
+  const uint8_t* p = (const uint8_t*)data + 2;
+  const uint8_t* end = (const uint8_t*)data + len;
+  method = (uint8_t)data[1];
+  if (!getVarint(p, end, alertCount) || !getVarint(p, end, ageMs)) return false;
+  ageMs *= TXQ_AGE_UNIT;
+  return true;
+}
+
+inline bool isAlertFrame(const char* data, uint8_t len) {
+  return len >= 4 && (uint8_t)data[0] == FRAME_TYPE_ALERT;
+}
+
+inline bool isCommandFrame(const char* data, uint8_t len) {
+  return len > 1 && (uint8_t)data[0] == FRAME_TYPE_COMMAND;
+}
+
+// =============== STATUS ================================
+inline void txqPrintStatus(const TxQueue& q, uint32_t targetMs) {
+  static const char* const names[TXQ_LEVELS] = {"alert", "cmd"};
+  if (q.queued[TXQ_ALARM] || q.queued[TXQ_COMMAND]) {
+    Serial.print("TX queue: ");
+    Serial.print(q.count);
+    Serial.print("/");
+    Serial.print(TXQ_SIZE);
+    for (uint8_t p = 0; p < TXQ_LEVELS; p++) {
+      if (!q.queued[p]) continue;
+      Serial.print(", ");
+      Serial.print(names[p]);
+      Serial.print(" ");
+      Serial.print(q.sent[p]);
+      Serial.print("/");
+      Serial.print(q.queued[p]);
+      Serial.print(" sent");
+      if (q.merged[p]) {
+        Serial.print(", merged ");
+        Serial.print(q.merged[p]);
+      }
+      if (q.dropped[p]) {
+        Serial.print(", dropped ");
+        Serial.print(q.dropped[p]);
+      }
+    }
+    Serial.println();
+  }
+  if (q.alarms) {
+    Serial.print("Alert latency: avg ");
+    Serial.print(q.alarmSumMs / q.alarms);
+    Serial.print(" ms, max ");
+    Serial.print(q.alarmMaxMs);
+    Serial.print(" ms (target < ");
+    Serial.print(targetMs);
+    Serial.print(" ms, missed ");
+    Serial.print(q.alarmOverTarget);
+    Serial.print("/");
+    Serial.print(q.alarms);
+    Serial.println(")");
+  }
+}
+
+#endif // TX_QUEUE_H
@@ -0,0 +1,95 @@
+/*=====================================================================
+  uplink_policy.h - Send-on-Change / Heartbeat Uplinks (sender)
+
+  The fixed SEND_INTERVAL cadence sends the full state every 2 s even
+  when nothing a receiver cares about has changed. With
+  ENABLE_SEND_ON_CHANGE the sender transmits:
+
+  1. Event - a watched field moved past its deadband since the last
+     uplink; goes out as soon as UPLINK_MIN_GAP has passed
+  2. Heartbeat - nothing changed for HEARTBEAT_INTERVAL
+
+  Watched fields (snapshot of the last uplink, only fields the frame
+  carries - a new frame field adds its deadband here):
+
+    Field      | Trigger
+    -----------|------------------------------------------------
+    touch      | any edge (deadband 0)
+
+  LED (toggles with every uplink) and spinner (150 ms animation) are
+  display state only - they ride along but never trigger a send. Fire
+  alarms do not wait for this policy: they leave ahead of any uplink
+  (tx_queue.h). Battery readings are not part of
+  the telemetry frame, so they cannot trigger an uplink either.
+
+  Every frame advertises the heartbeat interval (telemetry_frame.h,
+  keepalive field) so the receiver's watchdog (health_monitor.h) waits
+  for two missed heartbeats instead of 8 s before calling the link LOST.
+
+  Stable deployment at SF12: 1 uplink / 60 s instead of 1 / 2 s
+  → 30× less air time and TX energy (plus touch events).
+
+  Pure C++ (no String, no heap) - host-testable.
+=======================================================================*/
+
+#ifndef UPLINK_POLICY_H
+#define UPLINK_POLICY_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "structs.h"
+
+// Longest gap to the next uplink the receiver should expect (s):
+// heartbeat plus MAC jitter
+#if ENABLE_TX_MAC
+  #define UPLINK_KEEPALIVE_S ((HEARTBEAT_INTERVAL * (100 + MAC_JITTER_PCT) / 100 + 999) / 1000)
+#else
+  #define UPLINK_KEEPALIVE_S ((HEARTBEAT_INTERVAL + 999) / 1000)
+#endif
+
+enum UplinkReason {
+  UPLINK_NONE = 0,
+  UPLINK_EVENT = 1,
+  UPLINK_HEARTBEAT = 2
+};
+
+struct UplinkPolicy {
+  // Snapshot at the last uplink
+  bool touchState;
+  unsigned long lastSend;
+
+  // Statistics
+  unsigned long events;
+  unsigned long heartbeats;
+};
+
+inline void uplinkPolicyInit(UplinkPolicy& p, const DeviceState& state, unsigned long now) {
+  memset(&p, 0, sizeof(p));
+  p.touchState = state.touchState;
+  p.lastSend = now - HEARTBEAT_INTERVAL;  // First uplink right after boot
+}
+
+// Watched field past its deadband since the last uplink
+inline bool uplinkChanged(const UplinkPolicy& p, const DeviceState& state) {
+  return state.touchState != p.touchState;
+}
+
+// What (if anything) is due now
+inline UplinkReason uplinkPolicyDue(const UplinkPolicy& p, const DeviceState& state,
+                                    unsigned long now) {
+  unsigned long since = now - p.lastSend;
+  if (since >= HEARTBEAT_INTERVAL) return UPLINK_HEARTBEAT;
+  if (since >= UPLINK_MIN_GAP && uplinkChanged(p, state)) return UPLINK_EVENT;
+  return UPLINK_NONE;
+}
+
+// Uplink queued: new snapshot, heartbeat timer restarts
+inline void uplinkPolicySent(UplinkPolicy& p, const DeviceState& state,
+                             unsigned long now, UplinkReason reason) {
+  p.touchState = state.touchState;
+  p.lastSend = now;
+  if (reason == UPLINK_HEARTBEAT) p.heartbeats++;
+  else p.events++;
+}
+
+#endif // UPLINK_POLICY_H
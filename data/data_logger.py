@@ -73,11 +73,17 @@ def create_database(db_file):
     return conn
 
 def parse_csv_line(line):
-    """Parse DATA_CSV line"""
+    """Parse DATA_CSV line (or the first 11 columns of a DATA_SAMPLE line)"""
     # Format: DATA_CSV,TIMESTAMP,ROLE,RSSI,SNR,SEQ,MSG_COUNT,CONN_STATE,PACKET_LOSS,LED,TOUCH
+    # DATA_SAMPLE adds BATT_V,CURRENT_MA,AUDIO_RMS,LIGHT (batched samples)
+    # DATA_NODE (gateway mode) has the sender address in place of ROLE
     parts = line.split(',')
+    if parts[0] == 'DATA_SAMPLE' and len(parts) == 15:
+        parts = parts[:11]
     if len(parts) != 11:
         return None
+    if parts[0] == 'DATA_NODE':
+        parts[2] = 'NODE' + parts[2]
 
     try:
         data = {
@@ -206,7 +212,7 @@ def main():
                         continue
 
                     # Check if it's CSV data
-                    if line.startswith('DATA_CSV,'):
+                    if line.startswith(('DATA_CSV,', 'DATA_SAMPLE,', 'DATA_NODE,')):
                         data = parse_csv_line(line)
                         if data:
                             log_data(conn, data)
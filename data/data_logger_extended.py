@@ -253,6 +253,34 @@ def parse_csv_extended(line):
     except (ValueError, IndexError) as e:
         return None
 
+def parse_csv_sample(line):
+    """Parse batched sample record:
+    DATA_SAMPLE,TIMESTAMP,ROLE,RSSI,SNR,SEQ,MSG_COUNT,CONN_STATE,PACKET_LOSS,LED,TOUCH,BATT_V,CURRENT_MA,AUDIO_RMS,LIGHT
+    One line per sample unpacked from a batch frame (telemetry_batch.h)"""
+    parts = line.split(',')
+    if len(parts) != 15:
+        return None
+
+    result = parse_csv_basic(','.join(parts[:11]))
+    if not result:
+        return None
+    data = result[1]
+
+    try:
+        # Zero = field not sent by this sender
+        battery_voltage = float(parts[11])
+        current_ma = float(parts[12])
+        audio_rms = int(parts[13])
+        light = int(parts[14])
+    except ValueError:
+        return None
+
+    data['battery_voltage'] = battery_voltage or None
+    data['current_ma'] = current_ma or None
+    data['audio_rms'] = audio_rms or None
+    data['light_clear'] = light or None
+    return ('sample', data)
+
 def log_data(conn, data, format_type):
     """Log data to database (handles both basic and extended formats)"""
     cursor = conn.cursor()
@@ -414,8 +442,17 @@ def main():
                     if not line:
                         continue
 
+                    # Batched sample record (one line per sample)
+                    if line.startswith('DATA_SAMPLE,'):
+                        result = parse_csv_sample(line)
+                        if result:
+                            format_type, data = result
+                            log_data(conn, data, format_type)
+                            message_count += 1
+                            print_data_summary(data, 'extended')
+
                     # Check if it's CSV data
-                    if line.startswith('DATA_CSV'):
+                    elif line.startswith('DATA_CSV'):
                         # Try extended format first, then basic
                         result = parse_csv_extended(line)
                         if not result: